@@ -0,0 +1,536 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Parameter sweep over the LWSN line scenario.
+//
+// Every combination of the comma-separated lists given for --sensors,
+// --readings, --window, --rounds and --timing is run for --runs
+// replications.
+// Each replication is simulated in its own worker process, with at most
+// --jobs of them alive at a time, and appends one line to the --output
+// CSV file as soon as it completes.
+//
+// A replication only depends on its parameters, --seed and its run
+// number, never on the other replications or on the number of workers.
+// Sensors are drawn uniformly from [1, sensors] and mapped onto the
+// --sources range with first + (r - 1) % count, so the former
+// lwsn-uniformrandom scenarios correspond to:
+//
+//   lwsn-uniformrandom    --sensors=48 --readings=30 --window=10
+//   lwsn-uniformrandom_1  --sensors=6 --readings=7 --window=10
+//   lwsn-uniformrandom_2  --sensors=48 --readings=50 --window=10 --sources=28-30
+//   lwsn-uniformrandom_3  --sensors=48 --readings=10 --window=20 --sources=25-30
+//   lwsn-uniformrandom_6  --sensors=6 --readings=45 --window=10
+//
+// Each --timing item is either "default" or the attributes of the
+// LwsnSlotTiming of the channel, as Name=Value|..., e.g.
+// --timing=default,SlotLength=10ms|Guard=1ms|DataRate=250kbps compares
+// the one-second slots with the airtime of a 250 kb/s radio.
+//
+// With --engine=kernel the replications run on LwsnLineKernel, which
+// models the same MAC without the simulator and is meant for large
+// sweeps; the default simulator engine remains the reference.  The
+// kernel only models the default slot timing.
+//
+// ./waf --run "lwsn-sweep --sensors=6,12,24,48 --readings=10,30 --runs=1000 --output=sweep.csv"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("LwsnSweep");
+
+/**
+ * Parameters of one replication.
+ */
+struct LwsnScenario
+{
+  uint32_t sensors;   //!< sensors between the two gateways
+  uint32_t readings;  //!< readings injected
+  uint32_t window;    //!< readings start uniformly in [0, window] s
+  uint32_t round;     //!< backoff rounds before a sensor gives up
+  std::string timing; //!< LwsnSlotTiming attributes, or "default"
+  uint32_t first;     //!< first sensor that originates readings
+  uint32_t last;      //!< last sensor that originates readings
+  uint32_t seed;      //!< RngSeedManager seed
+  uint32_t run;       //!< RngSeedManager run number
+  bool kernel;        //!< run on LwsnLineKernel instead of the simulator
+};
+
+/**
+ * Totals of one replication.
+ */
+struct LwsnResult
+{
+  uint32_t sent;         //!< channel transmissions of all sensors
+  uint32_t retrans;      //!< retransmissions of all sensors
+  uint32_t collisions;   //!< collisions seen by all devices
+  uint32_t gateway1;     //!< frames received by gateway 1
+  uint32_t gateway2;     //!< frames received by gateway 2
+  uint32_t delivered;    //!< distinct readings that reached a gateway
+  double latencyMean;    //!< mean gateway delivery latency (s)
+  double latencyP50;     //!< median gateway delivery latency (s)
+  double latencyP99;     //!< 99th percentile gateway delivery latency (s)
+  double latencyMax;     //!< worst gateway delivery latency (s)
+};
+
+static bool
+ParseList (const std::string &value, std::vector<uint32_t> &list)
+{
+  std::istringstream is (value);
+  std::string item;
+  list.clear ();
+  while (std::getline (is, item, ','))
+    {
+      char *end;
+      unsigned long v = std::strtoul (item.c_str (), &end, 10);
+      if (item.empty () || *end != '\0')
+        {
+          return false;
+        }
+      list.push_back (v);
+    }
+  return !list.empty ();
+}
+
+static bool
+ParseStringList (const std::string &value, std::vector<std::string> &list)
+{
+  std::istringstream is (value);
+  std::string item;
+  list.clear ();
+  while (std::getline (is, item, ','))
+    {
+      // keeps the CSV line of RunWorker within its buffer
+      if (item.empty () || item.size () > 256)
+        {
+          return false;
+        }
+      list.push_back (item);
+    }
+  return !list.empty ();
+}
+
+static bool
+ParseRange (const std::string &value, uint32_t &first, uint32_t &last)
+{
+  if (value.empty ())
+    {
+      return true;
+    }
+  char *end;
+  first = std::strtoul (value.c_str (), &end, 10);
+  if (*end == '\0')
+    {
+      last = first;
+      return true;
+    }
+  if (*end != '-')
+    {
+      return false;
+    }
+  last = std::strtoul (end + 1, &end, 10);
+  return *end == '\0' && first <= last;
+}
+
+/**
+ * Add the (Osid, Did) keys of the readings a gateway has queued.
+ */
+static void
+CollectDelivered (Ptr<SimpleNetDevice> gateway, std::set<uint32_t> &delivered)
+{
+  Ptr<Queue> queue = gateway->GetQueue ();
+  while (!queue->IsEmpty ())
+    {
+      Ptr<Packet> p = queue->Dequeue ()->GetPacket ();
+      LwsnHeader header;
+      p->PeekHeader (header);
+      delivered.insert ((static_cast<uint32_t> (header.GetOsid ()) << 16) | header.GetDid ());
+    }
+}
+
+/**
+ * Draw the readings of a replication: every sensor first, then every
+ * start time, as the former lwsn-uniformrandom scenarios did.  Streams 0
+ * and 1 are the traffic draws, stream 2 + i the backoff of node i.
+ */
+static void
+DrawReadings (const LwsnScenario &s, std::vector<uint32_t> &source, std::vector<uint32_t> &start)
+{
+  RngSeedManager::SetSeed (s.seed);
+  RngSeedManager::SetRun (s.run);
+
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  x->SetAttribute ("Min", DoubleValue (1.0));
+  x->SetAttribute ("Max", DoubleValue (s.sensors));
+  Ptr<UniformRandomVariable> t = CreateObject<UniformRandomVariable> ();
+  t->SetAttribute ("Min", DoubleValue (0.0));
+  t->SetAttribute ("Max", DoubleValue (s.window));
+  x->SetStream (0);
+  t->SetStream (1);
+  source.resize (s.readings);
+  start.resize (s.readings);
+  uint32_t count = s.last - s.first + 1;
+  for (uint32_t i = 0; i < s.readings; i++)
+    {
+      source[i] = s.first + (x->GetInteger () - 1) % count;
+    }
+  for (uint32_t i = 0; i < s.readings; i++)
+    {
+      start[i] = t->GetInteger ();
+    }
+}
+
+/**
+ * Fill the counters of a replication from the MAC statistics of the
+ * nodes of the line, gateways first and last.
+ */
+static LwsnResult
+Summarize (const std::vector<const LwsnMacStats *> &stats, uint32_t delivered)
+{
+  uint32_t numNode = stats.size ();
+  LwsnResult r;
+  std::memset (&r, 0, sizeof (r));
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      if (i != 0 && i != numNode - 1)
+        {
+          r.sent += stats[i]->GetNTx ();
+          r.retrans += stats[i]->GetNRetransmissions ();
+        }
+      r.collisions += stats[i]->GetNCollisions ();
+    }
+  r.gateway1 = stats[0]->GetNGatewayReceived ();
+  r.gateway2 = stats[numNode - 1]->GetNGatewayReceived ();
+
+  // latency of every gateway delivery, from the per-Osid histograms
+  LwsnLatencyHistogram latency;
+  for (uint32_t g = 0; g < numNode; g += numNode - 1)
+    {
+      const std::map<uint16_t, LwsnLatencyHistogram> &flows = stats[g]->GetFlows ();
+      for (std::map<uint16_t, LwsnLatencyHistogram>::const_iterator i = flows.begin (); i != flows.end (); ++i)
+        {
+          latency.Merge (i->second);
+        }
+    }
+  r.latencyMean = latency.GetMean ().GetSeconds ();
+  r.latencyP50 = latency.GetQuantile (0.5).GetSeconds ();
+  r.latencyP99 = latency.GetQuantile (0.99).GetSeconds ();
+  r.latencyMax = latency.GetMax ().GetSeconds ();
+  r.delivered = delivered;
+  return r;
+}
+
+static LwsnResult
+RunScenario (const LwsnScenario &s)
+{
+  std::vector<uint32_t> source, start;
+  DrawReadings (s, source, start);
+
+  LwsnTopologyHelper topology;
+  topology.SetDeviceAttribute ("Round", UintegerValue (s.round));
+  if (s.timing != "default")
+    {
+      topology.SetChannelAttribute ("SlotTiming", StringValue ("ns3::LwsnSlotTiming[" + s.timing + "]"));
+    }
+  NetDeviceContainer devices = topology.Install (s.sensors);
+  uint32_t numNode = devices.GetN ();
+  std::vector<Ptr<SimpleNetDevice> > dev (numNode);
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      dev[i] = DynamicCast<SimpleNetDevice> (devices.Get (i));
+    }
+  topology.AssignStreams (devices, 2);
+
+  Ptr<Packet> packet = Create<Packet> (100);
+  for (uint32_t i = 0; i < s.readings; i++)
+    {
+      Simulator::Schedule (Seconds (start[i]), &SimpleNetDevice::OriginalTransmission,
+                           dev[source[i]], packet, 0, false);
+    }
+
+  Simulator::Run ();
+
+  std::vector<const LwsnMacStats *> stats (numNode);
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      stats[i] = &dev[i]->GetStats ();
+    }
+  std::set<uint32_t> delivered;
+  CollectDelivered (dev[0], delivered);
+  CollectDelivered (dev[numNode - 1], delivered);
+  LwsnResult r = Summarize (stats, delivered.size ());
+
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      dev[i]->Dispose ();
+    }
+  Simulator::Destroy ();
+  return r;
+}
+
+/**
+ * Same replication as RunScenario, on the standalone line kernel.
+ */
+static LwsnResult
+RunKernelScenario (const LwsnScenario &s)
+{
+  std::vector<uint32_t> source, start;
+  DrawReadings (s, source, start);
+
+  LwsnLineKernel kernel (s.sensors);
+  kernel.SetRound (s.round);
+  kernel.AssignStreams (2);
+  for (uint32_t i = 0; i < s.readings; i++)
+    {
+      kernel.AddReading (source[i], Seconds (start[i]));
+    }
+  kernel.Run ();
+
+  std::vector<const LwsnMacStats *> stats (kernel.GetNNodes ());
+  for (uint32_t i = 0; i < stats.size (); i++)
+    {
+      stats[i] = &kernel.GetStats (i);
+    }
+  return Summarize (stats, kernel.GetNDelivered ());
+}
+
+/**
+ * Run one replication in the calling (worker) process and write its
+ * CSV line to fd in a single write, so that lines of concurrent
+ * workers sharing the pipe never interleave.
+ */
+static void
+RunWorker (const LwsnScenario &s, int fd)
+{
+  LwsnResult r = s.kernel ? RunKernelScenario (s) : RunScenario (s);
+  char line[1024];
+  int n = std::snprintf (line, sizeof (line),
+                         "%u,%u,%u,%u,%s,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%.6f,%.6f,%.6f,%.6f\n",
+                         s.sensors, s.readings, s.window, s.round, s.timing.c_str (), s.first, s.last, s.seed, s.run,
+                         r.sent, r.retrans, r.collisions, r.gateway1, r.gateway2,
+                         r.delivered, r.latencyMean, r.latencyP50, r.latencyP99, r.latencyMax);
+  while (write (fd, line, n) < 0 && errno == EINTR)
+    {
+    }
+}
+
+/**
+ * Move every complete line waiting in the pipe to the results file.
+ */
+static void
+Drain (int fd, std::string &pending, std::ostream &os)
+{
+  char buf[4096];
+  ssize_t n;
+  while ((n = read (fd, buf, sizeof (buf))) > 0)
+    {
+      pending.append (buf, n);
+    }
+  std::string::size_type end = pending.rfind ('\n');
+  if (end != std::string::npos)
+    {
+      os << pending.substr (0, end + 1);
+      os.flush ();
+      pending.erase (0, end + 1);
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  std::string sensors = "48";
+  std::string readings = "30";
+  std::string window = "10";
+  std::string rounds = "3";
+  std::string timing = "default";
+  std::string sources = "";
+  uint32_t seed = 10;
+  uint32_t firstRun = 1;
+  uint32_t runs = 1;
+  long cores = sysconf (_SC_NPROCESSORS_ONLN);
+  uint32_t jobs = cores > 0 ? cores : 1;
+  std::string output = "lwsn-sweep.csv";
+  std::string engine = "simulator";
+  bool verbose = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("sensors", "Comma-separated numbers of sensors between the gateways", sensors);
+  cmd.AddValue ("readings", "Comma-separated numbers of readings injected per run", readings);
+  cmd.AddValue ("window", "Comma-separated start time windows (s)", window);
+  cmd.AddValue ("rounds", "Comma-separated backoff round limits", rounds);
+  cmd.AddValue ("timing", "Comma-separated LwsnSlotTiming attributes, as Name=Value|..., or default", timing);
+  cmd.AddValue ("sources", "Sensors originating readings, as first-last (default: all)", sources);
+  cmd.AddValue ("seed", "RngSeedManager seed", seed);
+  cmd.AddValue ("firstRun", "Run number of the first replication", firstRun);
+  cmd.AddValue ("runs", "Replications per parameter combination", runs);
+  cmd.AddValue ("jobs", "Worker processes run at the same time", jobs);
+  cmd.AddValue ("output", "CSV results file", output);
+  cmd.AddValue ("engine", "simulator, or kernel for the standalone LwsnLineKernel", engine);
+  cmd.AddValue ("verbose", "Keep the output of the workers", verbose);
+  cmd.Parse (argc, argv);
+
+  std::vector<uint32_t> sensorList, readingList, windowList, roundList;
+  std::vector<std::string> timingList;
+  uint32_t first = 0, last = 0;
+  if (!ParseList (sensors, sensorList) || !ParseList (readings, readingList)
+      || !ParseList (window, windowList) || !ParseList (rounds, roundList)
+      || !ParseStringList (timing, timingList)
+      || !ParseRange (sources, first, last) || jobs == 0
+      || (engine != "simulator" && engine != "kernel"))
+    {
+      std::cerr << "invalid parameter list" << std::endl;
+      return 1;
+    }
+  if (engine == "kernel" && (timingList.size () > 1 || timingList[0] != "default"))
+    {
+      std::cerr << "the kernel engine only runs the default slot timing" << std::endl;
+      return 1;
+    }
+
+  std::vector<LwsnScenario> scenarios;
+  for (uint32_t a = 0; a < sensorList.size (); a++)
+    {
+      if (sensorList[a] < 2 || (!sources.empty () && (first == 0 || last > sensorList[a])))
+        {
+          std::cerr << "sources " << sources << " do not fit a line of " << sensorList[a] << " sensors" << std::endl;
+          return 1;
+        }
+      for (uint32_t b = 0; b < readingList.size (); b++)
+        {
+          for (uint32_t c = 0; c < windowList.size (); c++)
+            {
+              for (uint32_t d = 0; d < roundList.size (); d++)
+                {
+                  for (uint32_t e = 0; e < timingList.size (); e++)
+                    {
+                      for (uint32_t run = firstRun; run < firstRun + runs; run++)
+                        {
+                          LwsnScenario s;
+                          s.sensors = sensorList[a];
+                          s.readings = readingList[b];
+                          s.window = windowList[c];
+                          s.round = roundList[d];
+                          s.timing = timingList[e];
+                          s.first = sources.empty () ? 1 : first;
+                          s.last = sources.empty () ? s.sensors : last;
+                          s.seed = seed;
+                          s.run = run;
+                          s.kernel = engine == "kernel";
+                          scenarios.push_back (s);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+  std::ofstream os (output.c_str ());
+  if (!os)
+    {
+      std::cerr << "cannot open " << output << std::endl;
+      return 1;
+    }
+  os << "sensors,readings,window,round,timing,first,last,seed,run,"
+     << "sent,retrans,collisions,gateway1,gateway2,delivered,latencyMean,latencyP50,latencyP99,latencyMax" << std::endl;
+
+  int fds[2];
+  if (pipe (fds) != 0)
+    {
+      std::perror ("pipe");
+      return 1;
+    }
+  fcntl (fds[0], F_SETFL, fcntl (fds[0], F_GETFL) | O_NONBLOCK);
+
+  std::cout << scenarios.size () << " runs on " << jobs << " workers" << std::endl;
+  std::string pending;
+  uint32_t next = 0;
+  uint32_t active = 0;
+  uint32_t done = 0;
+  uint32_t failed = 0;
+  while (next < scenarios.size () || active > 0)
+    {
+      while (active < jobs && next < scenarios.size ())
+        {
+          pid_t pid = fork ();
+          if (pid < 0)
+            {
+              std::perror ("fork");
+              break;
+            }
+          if (pid == 0)
+            {
+              close (fds[0]);
+              if (!verbose)
+                {
+                  int null = open ("/dev/null", O_WRONLY);
+                  dup2 (null, STDOUT_FILENO);
+                  dup2 (null, STDERR_FILENO);
+                  close (null);
+                }
+              RunWorker (scenarios[next], fds[1]);
+              _exit (0);
+            }
+          active++;
+          next++;
+        }
+      if (active == 0)
+        {
+          // fork keeps failing with nothing left to wait for
+          break;
+        }
+
+      int status;
+      pid_t pid = waitpid (-1, &status, 0);
+      if (pid < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+          std::perror ("waitpid");
+          break;
+        }
+      active--;
+      done++;
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+        {
+          failed++;
+          NS_LOG_UNCOND ("worker " << pid << " failed");
+        }
+      // an exited worker has written its line, and at most jobs lines
+      // are ever waiting here, well below the pipe capacity.
+      Drain (fds[0], pending, os);
+      if (done % 100 == 0)
+        {
+          std::cout << done << "/" << scenarios.size () << std::endl;
+        }
+    }
+  Drain (fds[0], pending, os);
+  close (fds[0]);
+  close (fds[1]);
+
+  std::cout << done - failed << " runs written to " << output;
+  if (failed > 0)
+    {
+      std::cout << ", " << failed << " failed";
+    }
+  std::cout << std::endl;
+  return failed > 0 || done < scenarios.size () ? 1 : 0;
+}
@@ -171,5 +171,5 @@ int main(int argc, char *argv[]){
   RngSeedManager::SetSeed(10);
   Simulator::Run();
   Simulator::Destroy();
-  std::cout << " " <<(dev1->m_count+dev2->m_count+dev3->m_count+dev4->m_count+dev5->m_count+dev6->m_count)/2<<std::endl;
+  std::cout << " " <<(dev1->GetStats().GetNTx()+dev2->GetStats().GetNTx()+dev3->GetStats().GetNTx()+dev4->GetStats().GetNTx()+dev5->GetStats().GetNTx()+dev6->GetStats().GetNTx())/2<<std::endl;
 }
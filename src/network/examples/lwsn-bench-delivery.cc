@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Counts the Packet objects and Buffer::Data blocks created per frame
+// delivered to the gateways by a line of LWSN SimpleNetDevices, and per
+// frame put on their SimpleChannel.
+//
+// ./waf --run "lwsn-bench-delivery --sensors=48 --packets=30"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t numSensor = 48;
+  uint32_t numPacket = 30;
+  bool neighbourDelivery = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("sensors", "Number of sensors between the two gateways", numSensor);
+  cmd.AddValue ("packets", "Number of readings injected", numPacket);
+  cmd.AddValue ("neighbours", "Enable SimpleChannel neighbour delivery", neighbourDelivery);
+  cmd.Parse (argc, argv);
+
+  LwsnTopologyHelper topology;
+  if (neighbourDelivery)
+    {
+      topology.SetInterferenceRange (1);
+    }
+  NetDeviceContainer devices = topology.Install (numSensor);
+  uint32_t numNode = devices.GetN ();
+  std::vector<Ptr<SimpleNetDevice> > dev (numNode);
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      dev[i] = DynamicCast<SimpleNetDevice> (devices.Get (i));
+    }
+
+  Ptr<UniformRandomVariable> sid = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> start = CreateObject<UniformRandomVariable> ();
+  Ptr<Packet> packet = Create<Packet> (100);
+  for (uint32_t i = 0; i < numPacket; i++)
+    {
+      Simulator::Schedule (Seconds (start->GetInteger (0, 10)), &SimpleNetDevice::OriginalTransmission,
+                           dev[sid->GetInteger (1, numSensor)], packet, 0, false);
+    }
+
+  uint64_t packets = Packet::GetNCreated ();
+  uint64_t datas = Buffer::GetNDataCreated ();
+  Simulator::Run ();
+  packets = Packet::GetNCreated () - packets;
+  datas = Buffer::GetNDataCreated () - datas;
+
+  uint64_t frames = 0;
+  uint64_t delivered = 0;
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      frames += dev[i]->GetStats ().GetNTx ();
+      delivered += dev[i]->GetStats ().GetNGatewayReceived ();
+    }
+  Simulator::Destroy ();
+
+  std::cout << "frames delivered   " << delivered << std::endl;
+  std::cout << "frames sent        " << frames << std::endl;
+  std::cout << "Packet created     " << packets << std::endl;
+  std::cout << "Buffer::Data       " << datas << std::endl;
+  if (delivered > 0)
+    {
+      std::cout << "Packet per delivered frame  " << static_cast<double> (packets) / delivered << std::endl;
+      std::cout << "Data per delivered frame    " << static_cast<double> (datas) / delivered << std::endl;
+    }
+  if (frames > 0)
+    {
+      std::cout << "Packet per frame sent       " << static_cast<double> (packets) / frames << std::endl;
+      std::cout << "Data per frame sent         " << static_cast<double> (datas) / frames << std::endl;
+    }
+  return 0;
+}
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Decodes a file of LwsnMacTrace dumps (see LwsnMacTrace::Write and the
+// --mac-trace option of lwsn-traffic) into one line of text per event,
+// merged across devices in time order:
+//
+//   time(s) sid event osid did arg
+//
+// ./waf --run "lwsn-mac-trace-decode --file=mac.trace --event=COLLISION"
+// ./waf --run "lwsn-mac-trace-decode --file=mac.trace --summary"
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+bool
+EarlierThan (const LwsnMacTraceRecord &a, const LwsnMacTraceRecord &b)
+{
+  return a.time < b.time;
+}
+
+} // anonymous namespace
+
+int
+main (int argc, char *argv[])
+{
+  std::string file = "mac.trace";
+  int32_t sid = -1;
+  std::string event = "";
+  bool summary = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("file", "File written by LwsnMacTrace::Write", file);
+  cmd.AddValue ("sid", "Only print the events of this Sid, -1 for all", sid);
+  cmd.AddValue ("event", "Only print this event type, e.g. TX", event);
+  cmd.AddValue ("summary", "Print the number of events of each type instead", summary);
+  cmd.Parse (argc, argv);
+
+  std::ifstream is (file.c_str (), std::ios::binary);
+  if (!is)
+    {
+      std::cerr << "cannot open " << file << std::endl;
+      return 1;
+    }
+  std::vector<LwsnMacTraceRecord> records;
+  uint32_t blocks = 0;
+  while (LwsnMacTrace::Read (is, records))
+    {
+      blocks++;
+    }
+  if (!is.eof ())
+    {
+      std::cerr << file << ": malformed block after " << blocks << " devices" << std::endl;
+      return 1;
+    }
+  std::stable_sort (records.begin (), records.end (), &EarlierThan);
+
+  std::vector<uint64_t> counts (LwsnMacTrace::DUP + 1, 0);
+  for (std::vector<LwsnMacTraceRecord>::const_iterator i = records.begin (); i != records.end (); ++i)
+    {
+      if (sid >= 0 && i->sid != sid)
+        {
+          continue;
+        }
+      if (!event.empty () && event != LwsnMacTrace::GetEventName (i->event))
+        {
+          continue;
+        }
+      if (summary)
+        {
+          if (i->event < counts.size ())
+            {
+              counts[i->event]++;
+            }
+          continue;
+        }
+      LwsnMacTrace::Print (std::cout, *i);
+      std::cout << std::endl;
+    }
+  if (summary)
+    {
+      std::cout << records.size () << " events from " << blocks << " devices" << std::endl;
+      for (uint32_t e = 0; e < counts.size (); e++)
+        {
+          std::cout << LwsnMacTrace::GetEventName (e) << " " << counts[e] << std::endl;
+        }
+    }
+  return 0;
+}
@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Runs one LWSN line on a LwsnLineKernel in two phases: a warm-up with
+// a steady reading rate, then a traffic phase, and prints the statistics
+// of the whole run.
+//
+// The warm-up can be saved to a checkpoint and later runs can start
+// from it, each with its own traffic phase:
+//
+// ./waf --run "lwsn-soak --warmup=86400 --save=warm.ckpt"
+// ./waf --run "lwsn-soak --restore=warm.ckpt --readings=2000 --branch=1"
+// ./waf --run "lwsn-soak --restore=warm.ckpt --readings=4000 --branch=2"
+//
+// The seed must be the one the checkpoint was saved with.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <fstream>
+#include <iostream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t numSensor = 48;
+  double warmup = 3600;
+  double interval = 600;
+  uint32_t numReading = 1000;
+  double window = 3600;
+  uint32_t branch = 0;
+  uint32_t seed = 10;
+  std::string save = "";
+  std::string restore = "";
+
+  CommandLine cmd;
+  cmd.AddValue ("sensors", "Number of sensors between the two gateways", numSensor);
+  cmd.AddValue ("warmup", "Length of the warm-up, in s", warmup);
+  cmd.AddValue ("interval", "Time between the warm-up readings of a sensor, in s", interval);
+  cmd.AddValue ("readings", "Readings of the traffic phase", numReading);
+  cmd.AddValue ("window", "Length of the traffic phase, in s", window);
+  cmd.AddValue ("branch", "Stream offset of the traffic phase readings", branch);
+  cmd.AddValue ("seed", "RngSeedManager seed", seed);
+  cmd.AddValue ("save", "Write the state after the warm-up to this file", save);
+  cmd.AddValue ("restore", "Skip the warm-up and start from this checkpoint", restore);
+  cmd.Parse (argc, argv);
+
+  RngSeedManager::SetSeed (seed);
+  LwsnLineKernel line (numSensor);
+  line.AssignStreams (0);
+  SystemWallClockMs clock;
+  clock.Start ();
+  if (restore.empty ())
+    {
+      // the sensors take turns, one reading every interval / numSensor
+      double step = interval / numSensor;
+      uint32_t i = 0;
+      for (double t = 0; t < warmup; t += step, i++)
+        {
+          Time at = MilliSeconds (static_cast<int64_t> (t * 10) * 100);
+          line.AddReading (1 + i % numSensor, at);
+        }
+      line.RunUntil (Seconds (warmup));
+      if (!save.empty ())
+        {
+          std::ofstream os (save.c_str (), std::ios::binary);
+          line.Save (os);
+        }
+    }
+  else
+    {
+      std::ifstream is (restore.c_str (), std::ios::binary);
+      NS_ABORT_MSG_UNLESS (line.Restore (is), "not a checkpoint of " << numSensor << " sensors: " << restore);
+    }
+  int64_t warm = clock.End ();
+
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> t = CreateObject<UniformRandomVariable> ();
+  x->SetStream (numSensor + 2 + 2 * branch);
+  t->SetStream (numSensor + 3 + 2 * branch);
+  int64_t start = static_cast<int64_t> (line.GetNow ().GetSeconds ());
+  for (uint32_t i = 0; i < numReading; i++)
+    {
+      line.AddReading (x->GetInteger (1, numSensor),
+                       Seconds (start + t->GetInteger (0, static_cast<uint32_t> (window))));
+    }
+  clock.Start ();
+  line.Run ();
+  int64_t ms = clock.End ();
+
+  LwsnMacStats stats;
+  for (uint32_t i = 0; i < line.GetNNodes (); i++)
+    {
+      stats.Merge (line.GetStats (i));
+    }
+  LwsnMacStats::PrintCsvHeader (std::cout);
+  std::cout << std::endl;
+  stats.PrintCsv (std::cout);
+  std::cout << std::endl;
+  std::cout << "warm-up " << (restore.empty () ? "run" : "restored") << " in " << warm << " ms, "
+            << "traffic phase run in " << ms << " ms" << std::endl;
+  return 0;
+}
@@ -0,0 +1,163 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+// Feeds every sensor of a LWSN line from a LwsnTrafficApplication and
+// prints the merged MAC statistics.  Each source keeps one pending
+// arrival and one payload, so long runs do not pre-schedule readings.
+//
+// ./waf --run "lwsn-traffic --sensors=48 --process=Bursty --interval=60 --duration=3600"
+//
+// With --mac-trace, the last MAC events of every device are written to
+// that file for lwsn-mac-trace-decode; this needs a build configured
+// with --enable-lwsn-mac-trace.
+//
+// --implicit-ack drops the IACK frames of the relays; compare the
+// txIack, iacksSaved and collisions columns against a run without it.
+//
+// --routing=Nearest sends each reading towards the nearer gateway only,
+// Balanced also steers away from the side that loses ACKs; the load
+// split between the gateways is printed after the statistics.
+//
+// --queue=Age or --queue=Hops replaces the FIFO transmit queue with a
+// LwsnPriorityQueue; compare the p99 delivery latency printed last.
+//
+// --hops tags every frame with its path and prints, per sensor, the
+// delay and retry heatmaps the gateways built from the tags.
+//
+// --timing sets the attributes of the LwsnSlotTiming of the channel,
+// e.g. --timing="SlotLength=10ms|Guard=1ms|DataRate=250kbps" for
+// millisecond slots with the airtime of a 250 kb/s radio.
+//
+// --aggregation=K lets a relay bundle up to K queued readings in one
+// AGGREGATE frame; the number of frames sent drops under heavy load.
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace ns3;
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t numSensor = 48;
+  std::string process = "Poisson";
+  double interval = 60;
+  uint32_t burst = 5;
+  std::string traceFile = "";
+  double duration = 3600;
+  uint32_t seed = 10;
+  std::string macTrace = "";
+  uint32_t macTraceSize = 65536;
+  bool implicitAck = false;
+  std::string routing = "Both";
+  std::string queue = "Fifo";
+  bool hops = false;
+  std::string timing = "";
+  uint32_t aggregation = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("sensors", "Number of sensors between the two gateways", numSensor);
+  cmd.AddValue ("process", "Poisson, Periodic, Bursty or Trace", process);
+  cmd.AddValue ("interval", "Mean time between readings or bursts of a sensor, in s", interval);
+  cmd.AddValue ("burst", "Readings per burst", burst);
+  cmd.AddValue ("trace", "Arrival times file for the Trace process", traceFile);
+  cmd.AddValue ("duration", "Simulated time, in s", duration);
+  cmd.AddValue ("seed", "RngSeedManager seed", seed);
+  cmd.AddValue ("mac-trace", "Write the MAC event trace of every device to this file", macTrace);
+  cmd.AddValue ("mac-trace-size", "MAC events kept per device", macTraceSize);
+  cmd.AddValue ("implicit-ack", "Acknowledge forwarded packets by overhearing the next hop", implicitAck);
+  cmd.AddValue ("routing", "Both, Nearest or Balanced", routing);
+  cmd.AddValue ("queue", "Fifo, Age or Hops", queue);
+  cmd.AddValue ("hops", "Print the per-hop delay and retry heatmaps", hops);
+  cmd.AddValue ("timing", "Attributes of the LwsnSlotTiming, as Name=Value|...", timing);
+  cmd.AddValue ("aggregation", "Most readings a relay bundles in one frame", aggregation);
+  cmd.Parse (argc, argv);
+
+  RngSeedManager::SetSeed (seed);
+  LwsnTopologyHelper topology;
+  topology.SetInterferenceRange (1);
+  if (!timing.empty ())
+    {
+      topology.SetChannelAttribute ("SlotTiming", StringValue ("ns3::LwsnSlotTiming[" + timing + "]"));
+    }
+  topology.SetDeviceAttribute ("ImplicitAck", BooleanValue (implicitAck));
+  topology.SetDeviceAttribute ("Routing", StringValue (routing));
+  topology.SetDeviceAttribute ("RecordHops", BooleanValue (hops));
+  topology.SetDeviceAttribute ("Aggregation", UintegerValue (aggregation));
+  if (queue != "Fifo")
+    {
+      topology.SetDeviceAttribute ("TxQueue", StringValue ("ns3::LwsnPriorityQueue[Order=" + queue + "]"));
+    }
+  if (!macTrace.empty ())
+    {
+#ifndef NS3_LWSN_MAC_TRACE
+      std::cerr << "MAC events are not recorded: configure with --enable-lwsn-mac-trace" << std::endl;
+#endif
+      topology.SetDeviceAttribute ("MacTraceSize", UintegerValue (macTraceSize));
+    }
+  NetDeviceContainer devices = topology.Install (numSensor);
+  topology.AssignStreams (devices, 0);
+
+  LwsnTrafficHelper traffic;
+  traffic.SetAttribute ("Process", StringValue (process));
+  traffic.SetAttribute ("Interval", TimeValue (Seconds (interval)));
+  traffic.SetAttribute ("BurstSize", UintegerValue (burst));
+  traffic.SetAttribute ("TraceFile", StringValue (traceFile));
+  traffic.SetAttribute ("Granularity", TimeValue (MilliSeconds (100)));
+  ApplicationContainer sources = traffic.Install (devices);
+  traffic.AssignStreams (sources, devices.GetN ());
+
+  Simulator::Stop (Seconds (duration));
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t ms = clock.End ();
+
+  uint64_t injected = 0;
+  for (uint32_t i = 0; i < sources.GetN (); i++)
+    {
+      injected += DynamicCast<LwsnTrafficApplication> (sources.Get (i))->GetNSent ();
+    }
+  LwsnMacStats stats;
+  LwsnHopStats hopStats;
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      stats.Merge (DynamicCast<SimpleNetDevice> (devices.Get (i))->GetStats ());
+      hopStats.Merge (DynamicCast<SimpleNetDevice> (devices.Get (i))->GetHopStats ());
+    }
+  std::ostringstream load;
+  LwsnTopologyHelper::PrintGatewayLoad (devices, load);
+  if (!macTrace.empty ())
+    {
+      std::ofstream os (macTrace.c_str (), std::ios::binary);
+      for (uint32_t i = 0; i < devices.GetN (); i++)
+        {
+          DynamicCast<SimpleNetDevice> (devices.Get (i))->GetMacTrace ().Write (os);
+        }
+    }
+  Simulator::Destroy ();
+
+  LwsnMacStats::PrintCsvHeader (std::cout);
+  std::cout << std::endl;
+  stats.PrintCsv (std::cout);
+  std::cout << std::endl;
+  std::cout << injected << " readings injected in " << ms << " ms" << std::endl;
+  std::cout << load.str ();
+  LwsnLatencyHistogram latency;
+  for (std::map<uint16_t, LwsnLatencyHistogram>::const_iterator i = stats.GetFlows ().begin ();
+       i != stats.GetFlows ().end (); ++i)
+    {
+      latency.Merge (i->second);
+    }
+  std::cout << "p99 latency " << latency.GetQuantile (0.99).GetSeconds () << " s" << std::endl;
+  if (hops)
+    {
+      std::cout << hopStats.GetNPaths () << " paths, " << hopStats.GetNPartial () << " partial" << std::endl;
+      hopStats.PrintDelayCsv (std::cout);
+      hopStats.PrintRetryCsv (std::cout);
+    }
+  return 0;
+}
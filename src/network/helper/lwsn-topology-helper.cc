@@ -0,0 +1,264 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simulator.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/lwsn-checkpoint.h"
+#include "ns3/lwsn-slot-scheduler.h"
+#include "lwsn-topology-helper.h"
+
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnTopologyHelper");
+
+namespace {
+
+const uint32_t CHECKPOINT_MAGIC = 0x4c44574c; // "LWDL"
+const uint16_t CHECKPOINT_VERSION = 3;
+
+} // anonymous namespace
+
+LwsnTopologyHelper::LwsnTopologyHelper ()
+{
+  m_deviceFactory.SetTypeId ("ns3::SimpleNetDevice");
+  m_channelFactory.SetTypeId ("ns3::SimpleChannel");
+}
+
+void
+LwsnTopologyHelper::SetDeviceAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_deviceFactory.Set (n1, v1);
+}
+
+void
+LwsnTopologyHelper::SetChannelAttribute (std::string n1, const AttributeValue &v1)
+{
+  m_channelFactory.Set (n1, v1);
+}
+
+void
+LwsnTopologyHelper::SetInterferenceRange (uint32_t hops)
+{
+  m_channelFactory.Set ("NeighbourDelivery", BooleanValue (hops > 0));
+  if (hops > 0)
+    {
+      m_channelFactory.Set ("InterferenceRange", UintegerValue (hops));
+    }
+}
+
+uint32_t
+LwsnTopologyHelper::GetGatewayPosition (uint32_t numSensor, uint32_t numGateway, uint32_t gateway)
+{
+  NS_ASSERT (numGateway >= 2 && gateway < numGateway);
+  // the first numSensor % segments segments get one extra sensor
+  uint32_t segments = numGateway - 1;
+  uint32_t base = numSensor / segments;
+  uint32_t extra = numSensor % segments;
+  return gateway * (base + 1) + std::min (gateway, extra);
+}
+
+NetDeviceContainer
+LwsnTopologyHelper::Install (uint32_t numSensor, uint32_t numGateway) const
+{
+  NodeContainer c;
+  c.Create (numSensor + numGateway);
+  return Install (c, numGateway);
+}
+
+NetDeviceContainer
+LwsnTopologyHelper::Install (const NodeContainer &c, uint32_t numGateway) const
+{
+  uint32_t numNode = c.GetN ();
+  NS_ABORT_MSG_IF (numGateway < 2, "A line needs a gateway at each end");
+  NS_ABORT_MSG_IF (numNode < numGateway, "Fewer nodes than gateways");
+  NS_ABORT_MSG_IF (numNode > 0xffff, "Sids are 16 bits: build several lines instead");
+  uint32_t numSensor = numNode - numGateway;
+
+  Ptr<SimpleChannel> channel = m_channelFactory.Create<SimpleChannel> ();
+  std::vector<Ptr<SimpleNetDevice> > devices;
+  devices.reserve (numNode);
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      Ptr<SimpleNetDevice> device = m_deviceFactory.Create<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      device->SetSid (i);
+      device->SetGid (0);
+      c.Get (i)->AddDevice (device);
+      device->SetChannel (channel);
+      devices.push_back (device);
+    }
+
+  uint32_t gateway = 0;
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      if (gateway < numGateway && i == GetGatewayPosition (numSensor, numGateway, gateway))
+        {
+          gateway++;
+          devices[i]->SetSid (0);
+          devices[i]->SetGid (gateway);
+          continue;
+        }
+      // position 0 is a gateway, so gateway >= 1 here
+      devices[i]->SetSideAddress (devices[i - 1]->GetAddress (), devices[i + 1]->GetAddress ());
+      uint32_t left = i - GetGatewayPosition (numSensor, numGateway, gateway - 1);
+      uint32_t right = GetGatewayPosition (numSensor, numGateway, gateway) - i;
+      devices[i]->SetGatewayDistances (left, right);
+      if (left == 1 || right == 1)
+        {
+          devices[i]->SetLastNode (true);
+        }
+    }
+
+  NetDeviceContainer devs;
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      devs.Add (devices[i]);
+    }
+  return devs;
+}
+
+std::vector<NetDeviceContainer>
+LwsnTopologyHelper::InstallLines (uint32_t numLine, uint32_t numSensor, uint32_t numGateway) const
+{
+  std::vector<NetDeviceContainer> lines;
+  lines.reserve (numLine);
+  for (uint32_t i = 0; i < numLine; i++)
+    {
+      lines.push_back (Install (numSensor, numGateway));
+    }
+  return lines;
+}
+
+void
+LwsnTopologyHelper::PrintGatewayLoad (const NetDeviceContainer &c, std::ostream &os)
+{
+  uint64_t total = 0;
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice> (*i);
+      if (device && device->GetSid () == 0)
+        {
+          total += device->GetStats ().GetNDelivered ();
+        }
+    }
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice> (*i);
+      if (device && device->GetSid () == 0)
+        {
+          uint64_t delivered = device->GetStats ().GetNDelivered ();
+          os << "Gid " << device->GetGid () << ": " << delivered << " delivered ("
+             << (total > 0 ? 100.0 * delivered / total : 0.0) << "%)" << std::endl;
+        }
+    }
+}
+
+int64_t
+LwsnTopologyHelper::AssignStreams (NetDeviceContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice> (*i);
+      if (device)
+        {
+          currentStream += device->AssignStreams (currentStream);
+        }
+    }
+  return (currentStream - stream);
+}
+
+Ptr<LwsnSlotScheduler>
+LwsnTopologyHelper::GetLine (const NetDeviceContainer &c, std::vector<Ptr<SimpleNetDevice> > &devices)
+{
+  devices.clear ();
+  Ptr<Channel> channel;
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice> (*i);
+      if (device == 0 || (channel != 0 && device->GetChannel () != channel))
+        {
+          return 0;
+        }
+      channel = device->GetChannel ();
+      devices.push_back (device);
+    }
+  Ptr<SimpleChannel> line = DynamicCast<SimpleChannel> (channel);
+  if (line == 0)
+    {
+      return 0;
+    }
+  return line->GetSlotScheduler ();
+}
+
+bool
+LwsnTopologyHelper::Save (const NetDeviceContainer &c, std::ostream &os)
+{
+  NS_LOG_FUNCTION (c.GetN ());
+  std::vector<Ptr<SimpleNetDevice> > devices;
+  Ptr<LwsnSlotScheduler> scheduler = GetLine (c, devices);
+  NS_ABORT_MSG_IF (scheduler == 0, "LwsnTopologyHelper::Save: the devices must share a SimpleChannel "
+                   "with the SlotScheduling attribute");
+  LwsnCheckpoint::Write (os, CHECKPOINT_MAGIC);
+  LwsnCheckpoint::Write (os, CHECKPOINT_VERSION);
+  LwsnCheckpoint::Write (os, RngSeedManager::GetSeed ());
+  LwsnCheckpoint::Write (os, RngSeedManager::GetRun ());
+  LwsnCheckpoint::Write (os, Simulator::Now ().GetTimeStep ());
+  LwsnCheckpoint::Write<uint32_t> (os, devices.size ());
+  LwsnPacketTable packets;
+  for (std::vector<Ptr<SimpleNetDevice> >::const_iterator i = devices.begin (); i != devices.end (); ++i)
+    {
+      (*i)->Save (os, packets);
+    }
+  return scheduler->Save (os, devices, packets);
+}
+
+bool
+LwsnTopologyHelper::Restore (const NetDeviceContainer &c, std::istream &is)
+{
+  NS_LOG_FUNCTION (c.GetN ());
+  std::vector<Ptr<SimpleNetDevice> > devices;
+  Ptr<LwsnSlotScheduler> scheduler = GetLine (c, devices);
+  uint32_t magic;
+  uint16_t version;
+  uint32_t seed;
+  uint64_t run;
+  int64_t at;
+  uint32_t numNode;
+  if (scheduler == 0
+      || !LwsnCheckpoint::Read (is, magic) || magic != CHECKPOINT_MAGIC
+      || !LwsnCheckpoint::Read (is, version) || version != CHECKPOINT_VERSION
+      || !LwsnCheckpoint::Read (is, seed)
+      || !LwsnCheckpoint::Read (is, run)
+      || !LwsnCheckpoint::Read (is, at) || at < Simulator::Now ().GetTimeStep ()
+      || !LwsnCheckpoint::Read (is, numNode) || numNode != devices.size ())
+    {
+      return false;
+    }
+  NS_ABORT_MSG_IF (seed != RngSeedManager::GetSeed () || run != RngSeedManager::GetRun (),
+                   "checkpoint saved with seed " << seed << " run " << run);
+  if (at > Simulator::Now ().GetTimeStep ())
+    {
+      Simulator::Stop (TimeStep (at - Simulator::Now ().GetTimeStep ()));
+      Simulator::Run ();
+    }
+  LwsnPacketTable packets;
+  for (std::vector<Ptr<SimpleNetDevice> >::const_iterator i = devices.begin (); i != devices.end (); ++i)
+    {
+      if (!(*i)->Restore (is, packets))
+        {
+          return false;
+        }
+    }
+  return scheduler->Restore (is, devices, packets);
+}
+
+} // namespace ns3
@@ -0,0 +1,186 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_TOPOLOGY_HELPER_H
+#define LWSN_TOPOLOGY_HELPER_H
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "ns3/attribute.h"
+#include "ns3/object-factory.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+
+namespace ns3 {
+
+class SimpleNetDevice;
+class LwsnSlotScheduler;
+
+/**
+ * \brief build linear sensor networks of SimpleNetDevice objects
+ *
+ * A line is laid out as gateway, sensors, gateway, sensors, ...,
+ * gateway: the sensors are split as evenly as possible between the
+ * numGateway - 1 segments bounded by consecutive gateways.  Every device
+ * gets an address from Mac48Address::Allocate and its Sid is its
+ * position on the line; gateways have Sid 0 and Gid 1 to numGateway
+ * from left to right, sensors have Gid 0.  Each sensor points at its two
+ * neighbours with SetSideAddress, learns its distance to the gateways
+ * on either side with SetGatewayDistances, and the sensors next to a
+ * gateway are marked with SetLastNode.
+ *
+ * Since Sids are 16 bits, one line holds at most 65535 nodes; larger
+ * networks are built as several lines, each on its own SimpleChannel.
+ */
+class LwsnTopologyHelper
+{
+public:
+  /**
+   * Construct a LwsnTopologyHelper.
+   */
+  LwsnTopologyHelper ();
+  virtual ~LwsnTopologyHelper () {}
+
+  /**
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   *
+   * Set these attributes on each ns3::SimpleNetDevice created
+   * by LwsnTopologyHelper::Install
+   */
+  void SetDeviceAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * \param n1 the name of the attribute to set
+   * \param v1 the value of the attribute to set
+   *
+   * Set these attributes on each ns3::SimpleChannel created
+   * by LwsnTopologyHelper::Install
+   */
+  void SetChannelAttribute (std::string n1, const AttributeValue &v1);
+
+  /**
+   * Deliver each frame only to the devices within hops positions of the
+   * sender on the line (and to its destination), instead of to every
+   * device on the channel.  Zero restores the broadcast fan-out.
+   *
+   * \param hops interference range, in hops
+   */
+  void SetInterferenceRange (uint32_t hops);
+
+  /**
+   * Create numSensor + numGateway nodes and lay them out as one line on
+   * a new SimpleChannel.
+   *
+   * \param numSensor number of sensors
+   * \param numGateway number of gateways, at least 2
+   * \returns the devices, in line order
+   */
+  NetDeviceContainer Install (uint32_t numSensor, uint32_t numGateway = 2) const;
+
+  /**
+   * Lay out the nodes of c, in container order, as one line on a new
+   * SimpleChannel.
+   *
+   * \param c the nodes of the line
+   * \param numGateway number of gateways among them, at least 2
+   * \returns the devices, in line order
+   */
+  NetDeviceContainer Install (const NodeContainer &c, uint32_t numGateway = 2) const;
+
+  /**
+   * Build numLine independent lines, each on its own SimpleChannel.
+   *
+   * \param numLine number of lines
+   * \param numSensor number of sensors per line
+   * \param numGateway number of gateways per line, at least 2
+   * \returns the devices of each line, in line order
+   */
+  std::vector<NetDeviceContainer> InstallLines (uint32_t numLine, uint32_t numSensor,
+                                                uint32_t numGateway = 2) const;
+
+  /**
+   * \param numSensor number of sensors on the line
+   * \param numGateway number of gateways on the line
+   * \param gateway gateway index, from 0 to numGateway - 1
+   * \returns the position of the gateway on the line
+   */
+  static uint32_t GetGatewayPosition (uint32_t numSensor, uint32_t numGateway, uint32_t gateway);
+
+  /**
+   * Print, for each gateway in c, the distinct readings it delivered and
+   * its share of the total, one gateway per line.
+   *
+   * \param c the devices of one or more lines
+   * \param os output stream
+   */
+  static void PrintGatewayLoad (const NetDeviceContainer &c, std::ostream &os);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by the SimpleNetDevices in the container.  Return the number of
+   * streams (possibly zero) that have been assigned.
+   *
+   * \param c NetDeviceContainer of the set of net devices for which the
+   *          SimpleNetDevice should be modified to use a fixed stream
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this helper
+   */
+  int64_t AssignStreams (NetDeviceContainer c, int64_t stream);
+
+  /**
+   * Write the state of a line run with the SlotScheduling channel
+   * attribute to a binary checkpoint: the MAC state of each device, see
+   * SimpleNetDevice::Save, and the MAC actions pending in the
+   * LwsnSlotScheduler of the channel, with the time they are due.
+   * The backoff streams must have been fixed with AssignStreams.
+   *
+   * The other simulator events are not saved.  Save between two slots,
+   * once the frames sent in the last one are received, e.g. from an
+   * event half a slot after it; traffic applications, StatsSnapshot
+   * events and whatever else the scenario scheduled are left to the
+   * run that restores the checkpoint.
+   *
+   * Aborts if the devices do not share a channel with the SlotScheduling
+   * attribute, or if a MAC action off the slot grid is pending: such an
+   * action is a simulator event, which cannot be saved.
+   *
+   * \param c the devices of one line, in line order
+   * \param os output stream, opened in binary mode
+   * \returns false if a pending MAC action belongs to a device that is
+   * not in c
+   */
+  static bool Save (const NetDeviceContainer &c, std::ostream &os);
+  /**
+   * Replace the state of a line with one written by Save.  The line
+   * must have been built by the same helper configuration, with the
+   * streams assigned as for the saved line, and the RngSeedManager seed
+   * and run must be those of the saved run.  Call it before anything is
+   * scheduled for the line: the simulator is first run up to the time
+   * of the checkpoint.
+   *
+   * \param c the devices of the line, in line order
+   * \param is input stream, opened in binary mode
+   * \returns false if it does not hold a checkpoint of a line of this
+   * size saved no earlier than now, in which case the line is left in
+   * an undefined state
+   */
+  static bool Restore (const NetDeviceContainer &c, std::istream &is);
+
+private:
+  /**
+   * \param c the devices of one line
+   * \param devices set to the devices of c
+   * \returns the slot scheduler of their channel, or 0 if they are not
+   * all SimpleNetDevices on one channel with a slot scheduler
+   */
+  static Ptr<LwsnSlotScheduler> GetLine (const NetDeviceContainer &c, std::vector<Ptr<SimpleNetDevice> > &devices);
+
+  ObjectFactory m_deviceFactory; //!< NetDevice factory
+  ObjectFactory m_channelFactory; //!< Channel factory
+};
+
+} // namespace ns3
+
+#endif /* LWSN_TOPOLOGY_HELPER_H */
@@ -0,0 +1,60 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/lwsn-traffic-application.h"
+#include "lwsn-traffic-helper.h"
+
+namespace ns3 {
+
+LwsnTrafficHelper::LwsnTrafficHelper ()
+{
+  m_factory.SetTypeId ("ns3::LwsnTrafficApplication");
+}
+
+void
+LwsnTrafficHelper::SetAttribute (std::string name, const AttributeValue &value)
+{
+  m_factory.Set (name, value);
+}
+
+ApplicationContainer
+LwsnTrafficHelper::Install (Ptr<SimpleNetDevice> device) const
+{
+  Ptr<LwsnTrafficApplication> app = m_factory.Create<LwsnTrafficApplication> ();
+  app->SetDevice (device);
+  device->GetNode ()->AddApplication (app);
+  return ApplicationContainer (app);
+}
+
+ApplicationContainer
+LwsnTrafficHelper::Install (NetDeviceContainer c) const
+{
+  ApplicationContainer apps;
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice> (*i);
+      if (device != 0 && device->GetGid () == 0)
+        {
+          apps.Add (Install (device));
+        }
+    }
+  return apps;
+}
+
+int64_t
+LwsnTrafficHelper::AssignStreams (ApplicationContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (ApplicationContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<LwsnTrafficApplication> app = DynamicCast<LwsnTrafficApplication> (*i);
+      if (app)
+        {
+          currentStream += app->AssignStreams (currentStream);
+        }
+    }
+  return (currentStream - stream);
+}
+
+} // namespace ns3
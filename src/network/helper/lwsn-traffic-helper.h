@@ -0,0 +1,70 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_TRAFFIC_HELPER_H
+#define LWSN_TRAFFIC_HELPER_H
+
+#include <string>
+
+#include "ns3/attribute.h"
+#include "ns3/object-factory.h"
+#include "ns3/application-container.h"
+#include "ns3/net-device-container.h"
+
+namespace ns3 {
+
+class SimpleNetDevice;
+
+/**
+ * \brief install LwsnTrafficApplication sources on LWSN sensors
+ */
+class LwsnTrafficHelper
+{
+public:
+  /**
+   * Construct a LwsnTrafficHelper.
+   */
+  LwsnTrafficHelper ();
+
+  /**
+   * \param name the name of the attribute to set
+   * \param value the value of the attribute to set
+   *
+   * Set these attributes on each ns3::LwsnTrafficApplication created
+   * by LwsnTrafficHelper::Install
+   */
+  void SetAttribute (std::string name, const AttributeValue &value);
+
+  /**
+   * Install a source feeding one sensor, on the node of the sensor.
+   *
+   * \param device the sensor
+   * \returns the application
+   */
+  ApplicationContainer Install (Ptr<SimpleNetDevice> device) const;
+
+  /**
+   * Install a source on every sensor of c; gateways (non-zero Gid) and
+   * devices other than SimpleNetDevice are skipped.
+   *
+   * \param c the devices, typically a line from LwsnTopologyHelper
+   * \returns the applications, in device order
+   */
+  ApplicationContainer Install (NetDeviceContainer c) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by the LwsnTrafficApplications in the container.  Return the
+   * number of streams (possibly zero) that have been assigned.
+   *
+   * \param c the applications
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this helper
+   */
+  int64_t AssignStreams (ApplicationContainer c, int64_t stream);
+
+private:
+  ObjectFactory m_factory; //!< Application factory
+};
+
+} // namespace ns3
+
+#endif /* LWSN_TRAFFIC_HELPER_H */
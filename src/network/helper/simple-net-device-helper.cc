@@ -126,6 +126,21 @@ SimpleNetDeviceHelper::Install (const NodeContainer &c, Ptr<SimpleChannel> chann
   return devs;
 }
 
+int64_t
+SimpleNetDeviceHelper::AssignStreams (NetDeviceContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NetDeviceContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+    {
+      Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice> (*i);
+      if (device)
+        {
+          currentStream += device->AssignStreams (currentStream);
+        }
+    }
+  return (currentStream - stream);
+}
+
 Ptr<NetDevice>
 SimpleNetDeviceHelper::InstallPriv (Ptr<Node> node, Ptr<SimpleChannel> channel) const
 {
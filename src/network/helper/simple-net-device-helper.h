@@ -166,6 +166,18 @@ public:
    */
   NetDeviceContainer Install (const NodeContainer &c, Ptr<SimpleChannel> channel) const;
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by the SimpleNetDevices in the container.  Return the number of
+   * streams (possibly zero) that have been assigned.
+   *
+   * \param c NetDeviceContainer of the set of net devices for which the
+   *          SimpleNetDevice should be modified to use a fixed stream
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this helper
+   */
+  int64_t AssignStreams (NetDeviceContainer c, int64_t stream);
+
 private:
   /**
    * This method creates an ns3::SimpleNetDevice with the attributes configured by
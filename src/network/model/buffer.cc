@@ -51,6 +51,7 @@ NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
 uint32_t Buffer::g_recommendedStart = 0;
+uint64_t Buffer::g_nDataCreated = 0;
 #ifdef BUFFER_FREE_LIST
 /* The following macros are pretty evil but they are needed to allow us to
  * keep track of 3 possible states for the g_freeList variable:
@@ -119,6 +120,7 @@ Buffer::Data *
 Buffer::Create (uint32_t dataSize)
 {
   NS_LOG_FUNCTION (dataSize);
+  g_nDataCreated++;
   /* try to find a buffer correctly sized. */
   if (IS_UNINITIALIZED (g_freeList))
     {
@@ -155,10 +157,17 @@ Buffer::Data *
 Buffer::Create (uint32_t size)
 {
   NS_LOG_FUNCTION (size);
+  g_nDataCreated++;
   return Allocate (size);
 }
 #endif /* BUFFER_FREE_LIST */
 
+uint64_t
+Buffer::GetNDataCreated (void)
+{
+  return g_nDataCreated;
+}
+
 struct Buffer::Data *
 Buffer::Allocate (uint32_t reqSize)
 {
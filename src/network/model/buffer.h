@@ -641,6 +641,14 @@ private:
    */
   Buffer (uint32_t dataSize, bool initialize);
   ~Buffer ();
+
+  /**
+   * \brief Number of Buffer::Data blocks handed out so far, whether
+   * freshly allocated or taken from the free list.
+   *
+   * \returns the number of data blocks created
+   */
+  static uint64_t GetNDataCreated (void);
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -768,6 +776,8 @@ private:
    */
   static uint32_t g_recommendedStart;
 
+  static uint64_t g_nDataCreated; //!< Number of data blocks created
+
   /**
    * offset to the start of the virtual zero area from the start
    * of m_data->m_data
@@ -3,6 +3,16 @@
 namespace ns3{
 
 LwsnHeader::LwsnHeader()
+	: m_Type(0),
+	  m_Osid(0),
+	  m_Osid2(0),
+	  m_Psid(0),
+	  m_r(0),
+	  m_e(0),
+	  m_Did(0),
+	  m_Did2(0),
+	  m_StartTime(0),
+	  m_StartTime2(0)
 {
 }
 
@@ -92,6 +102,10 @@ LwsnHeader::GetType(void) const
 		return IACK;
 	else if(m_Type == 4)
 		return NETWORK_CODING;
+	else if(m_Type == 5)
+		return AGGREGATE;
+	else if(m_Type == 6)
+		return BLOCK_ACK;
 	else
 		return IACK;
 }
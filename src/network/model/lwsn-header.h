@@ -15,7 +15,9 @@ public:
     	ORIGINAL_TRANSMISSION = 1,
     	FORWARDING = 2,
     	IACK = 3,
-    	NETWORK_CODING = 4
+    	NETWORK_CODING = 4,
+    	AGGREGATE = 5,
+    	BLOCK_ACK = 6
     };
 
 	LwsnHeader ();
@@ -19,6 +19,7 @@
  */
 #include "packet.h"
 #include "ns3/assert.h"
+#include "ns3/abort.h"
 #include "ns3/log.h"
 #include "ns3/simulator.h"
 #include <string>
@@ -29,6 +30,7 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Packet");
 
 uint32_t Packet::m_globalUid = 0;
+uint64_t Packet::m_nCreated = 0;
 
 TypeId 
 ByteTagIterator::Item::GetTypeId (void) const
@@ -127,6 +129,12 @@ Packet::Copy (void) const
   return Ptr<Packet> (new Packet (*this), false);
 }
 
+uint64_t
+Packet::GetNCreated (void)
+{
+  return m_nCreated;
+}
+
 Packet::Packet ()
   : m_buffer (),
     m_byteTagList (),
@@ -140,6 +148,7 @@ Packet::Packet ()
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, 0),
     m_nixVector (0)
 {
+  m_nCreated++;
   m_globalUid++;
 }
 
@@ -149,6 +158,7 @@ Packet::Packet (const Packet &o)
     m_packetTagList (o.m_packetTagList),
     m_metadata (o.m_metadata)
 {
+  m_nCreated++;
   o.m_nixVector ? m_nixVector = o.m_nixVector->Copy ()
     : m_nixVector = 0;
 }
@@ -182,6 +192,7 @@ Packet::Packet (uint32_t size)
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
     m_nixVector (0)
 {
+  m_nCreated++;
   m_globalUid++;
 }
 Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
@@ -191,6 +202,7 @@ Packet::Packet (uint8_t const *buffer, uint32_t size, bool magic)
     m_metadata (0,0),
     m_nixVector (0)
 {
+  m_nCreated++;
   NS_ASSERT (magic);
   Deserialize (buffer, size);
 }
@@ -208,6 +220,7 @@ Packet::Packet (uint8_t const*buffer, uint32_t size)
     m_metadata (static_cast<uint64_t> (Simulator::GetSystemId ()) << 32 | m_globalUid, size),
     m_nixVector (0)
 {
+  m_nCreated++;
   m_globalUid++;
   m_buffer.AddAtStart (size);
   Buffer::Iterator i = m_buffer.Begin ();
@@ -222,6 +235,7 @@ Packet::Packet (const Buffer &buffer,  const ByteTagList &byteTagList,
     m_metadata (metadata),
     m_nixVector (0)
 {
+  m_nCreated++;
 }
 
 Ptr<Packet>
@@ -797,6 +811,17 @@ Packet::AddByteTag (const Tag &tag) const
                                 GetSize ());
   tag.Serialize (buffer);
 }
+void
+Packet::AddByteTag (const Tag &tag, uint32_t start, uint32_t end) const
+{
+  NS_LOG_FUNCTION (this << tag.GetInstanceTypeId ().GetName () << tag.GetSerializedSize () << start << end);
+  NS_ABORT_MSG_IF (end < start, "Invalid byte range");
+  ByteTagList *list = const_cast<ByteTagList *> (&m_byteTagList);
+  TagBuffer buffer = list->Add (tag.GetInstanceTypeId (), tag.GetSerializedSize (),
+                                static_cast<int32_t> (start),
+                                static_cast<int32_t> (end));
+  tag.Serialize (buffer);
+}
 ByteTagIterator 
 Packet::GetByteTagIterator (void) const
 {
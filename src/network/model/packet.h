@@ -502,6 +502,14 @@ public:
    */
   static void EnableChecking (void);
 
+  /**
+   * \brief Number of Packet objects constructed so far, including
+   * the ones made by Copy and CreateFragment.
+   *
+   * \returns the number of packets created
+   */
+  static uint64_t GetNCreated (void);
+
   /**
    * \brief Returns number of bytes required for packet
    * serialization.
@@ -542,6 +550,18 @@ public:
    * packet).
    */
   void AddByteTag (const Tag &tag) const;
+  /**
+   * \brief Tag the indicated bytes of this packet with a new byte tag.
+   *
+   * \param tag the new tag to add to this packet
+   * \param start the position of the first byte tagged by this tag
+   * \param end the position of the first byte not tagged by this tag
+   *
+   * The positions are those reported by ByteTagIterator::Item, so that
+   * the byte tags of a packet can be copied to another packet holding
+   * the same bytes.
+   */
+  void AddByteTag (const Tag &tag, uint32_t start, uint32_t end) const;
   /**
    * \brief Returns an iterator over the set of byte tags included in this packet
    *
@@ -728,6 +748,7 @@ private:
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
   static uint32_t m_globalUid; //!< Global counter of packets Uid
+  static uint64_t m_nCreated; //!< Number of Packet objects constructed
 };
 
 /**
@@ -0,0 +1,1719 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/callback.h"
+#include "ns3/boolean.h"
+#include "ns3/double.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/lwsn-header.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/lwsn-mac-stats.h"
+#include "ns3/lwsn-topology-helper.h"
+#include "ns3/lwsn-line-kernel.h"
+#include "ns3/lwsn-parallel-lines.h"
+#include "ns3/lwsn-interference-tracker.h"
+#include "ns3/lwsn-traffic-application.h"
+#include "ns3/lwsn-traffic-helper.h"
+#include "ns3/lwsn-mac-trace.h"
+#include "ns3/lwsn-radio-energy.h"
+#include "ns3/lwsn-backoff-policy.h"
+#include "ns3/lwsn-priority-queue.h"
+#include "ns3/lwsn-hop-tag.h"
+#include "ns3/lwsn-slot-timing.h"
+#include "ns3/lwsn-aggregate.h"
+#include "ns3/lwsn-timestamp-tag.h"
+#include "ns3/lwsn-profiler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
+using namespace ns3;
+
+static Ptr<Packet>
+CreateLwsnPacket (uint16_t osid, uint16_t did)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  LwsnHeader header;
+  header.SetType (LwsnHeader::FORWARDING);
+  header.SetOsid (osid);
+  header.SetPsid (osid);
+  header.SetE (0);
+  header.SetR (0);
+  header.SetDid (did);
+  header.SetStartTime (0);
+  p->AddHeader (header);
+  return p;
+}
+
+class LwsnQueueCheckTestCase : public TestCase
+{
+public:
+  LwsnQueueCheckTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnQueueCheckTestCase::LwsnQueueCheckTestCase ()
+  : TestCase ("QueueCheck suppresses duplicates without reordering the queue")
+{
+}
+
+void
+LwsnQueueCheckTestCase::DoRun (void)
+{
+  Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+  dev->SetSid (5);
+
+  dev->QueueCheck (CreateLwsnPacket (1, 1));
+  dev->QueueCheck (CreateLwsnPacket (2, 1));
+  dev->QueueCheck (CreateLwsnPacket (1, 2));
+  NS_TEST_EXPECT_MSG_EQ (dev->GetQueue ()->GetNPackets (), 3, "three distinct frames should be queued");
+
+  dev->QueueCheck (CreateLwsnPacket (2, 1));
+  dev->QueueCheck (CreateLwsnPacket (1, 1));
+  NS_TEST_EXPECT_MSG_EQ (dev->GetQueue ()->GetNPackets (), 3, "duplicates must not be queued");
+  NS_TEST_EXPECT_MSG_EQ (dev->IsQueued (2, 1), true, "(2, 1) should be indexed");
+  NS_TEST_EXPECT_MSG_EQ (dev->IsQueued (2, 2), false, "(2, 2) was never queued");
+  NS_TEST_EXPECT_MSG_EQ (dev->GetStats ().GetQueueHighWater (), 3, "wrong queue high-water mark");
+
+  uint16_t expected[3][2] = { { 1, 1 }, { 2, 1 }, { 1, 2 } };
+  for (uint32_t i = 0; i < 3; i++)
+    {
+      Ptr<Packet> p = dev->GetQueue ()->Dequeue ()->GetPacket ();
+      LwsnHeader header;
+      p->PeekHeader (header);
+      NS_TEST_EXPECT_MSG_EQ (header.GetOsid (), expected[i][0], "queue order changed");
+      NS_TEST_EXPECT_MSG_EQ (header.GetDid (), expected[i][1], "queue order changed");
+    }
+
+  dev->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * Totals collected from one run of a small line topology.
+ */
+struct LwsnLineResult
+{
+  uint32_t sent;        //!< channel transmissions of all sensors
+  uint32_t retrans;     //!< retransmissions of all sensors
+  uint32_t collisions;  //!< collisions seen by all devices
+  uint32_t gateway1;    //!< frames received by the first gateway
+  uint32_t gateway2;    //!< frames received by the last gateway
+  uint32_t delivered;   //!< distinct readings in the gateway stats
+  uint32_t queued;      //!< readings left in the gateway queues
+  uint64_t slotActions; //!< MAC actions run by the slot scheduler of the channel
+  LwsnMacStats stats;   //!< MAC counters of every device, merged
+};
+
+/**
+ * Start a reading on every sensor of a line of RunLwsnLine at once, so
+ * that the run is dominated by collisions and backoff draws.
+ */
+static void
+LoadBusy (NetDeviceContainer devices)
+{
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice> (devices.Get (i));
+      if (device->GetSid () != 0)
+        {
+          Simulator::Schedule (Seconds (0), &SimpleNetDevice::OriginalTransmission,
+                               device, Create<Packet> (100), 0, false);
+        }
+    }
+}
+
+/**
+ * Start one reading on the given device of a line of RunLwsnLine.
+ */
+static void
+LoadReading (uint32_t index, NetDeviceContainer devices)
+{
+  Simulator::Schedule (Seconds (0), &SimpleNetDevice::OriginalTransmission,
+                       DynamicCast<SimpleNetDevice> (devices.Get (index)), Create<Packet> (100), 0, false);
+}
+
+/**
+ * Queue eight readings from the sensors to the right of the given
+ * device of a line of RunLwsnLine back to back, then let it send them.
+ */
+static void
+LoadBurst (uint32_t index, NetDeviceContainer devices)
+{
+  Ptr<SimpleNetDevice> relay = DynamicCast<SimpleNetDevice> (devices.Get (index));
+  for (uint16_t i = 0; i < 8; i++)
+    {
+      relay->QueueCheck (CreateLwsnPacket (index + 1 + i % 3, 20 + i));
+    }
+  Simulator::Schedule (Seconds (0), &SimpleNetDevice::WaitSend, relay);
+}
+
+/**
+ * Start four readings on each end sensor of a line of RunLwsnLine at
+ * once, so that the two streams cross in the middle of the line.
+ */
+static void
+LoadEnds (NetDeviceContainer devices)
+{
+  uint32_t ends[2] = { 1, devices.GetN () - 2 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      for (uint32_t j = 0; j < 2; j++)
+        {
+          Simulator::Schedule (Seconds (0), &SimpleNetDevice::OriginalTransmission,
+                               DynamicCast<SimpleNetDevice> (devices.Get (ends[j])), Create<Packet> (100), 0, false);
+        }
+    }
+}
+
+/**
+ * Install a periodic LwsnTrafficApplication on every sensor of a line
+ * of RunLwsnLine, with its readings on the one-second slots.
+ */
+static void
+LoadPeriodic (NetDeviceContainer devices)
+{
+  LwsnTrafficHelper periodic;
+  periodic.SetAttribute ("Process", EnumValue (LwsnTrafficApplication::PERIODIC));
+  periodic.SetAttribute ("Interval", TimeValue (Seconds (7)));
+  periodic.SetAttribute ("Granularity", TimeValue (Seconds (1)));
+  periodic.SetAttribute ("MaxPackets", UintegerValue (3));
+  periodic.Install (devices);
+}
+
+/**
+ * Build a line of numSensor sensors and numGateway gateways with
+ * topology, which carries the device and channel attributes, let load
+ * inject the readings and run it to completion.
+ */
+static LwsnLineResult
+RunLwsnLine (uint32_t numSensor, LwsnTopologyHelper topology,
+             Callback<void, NetDeviceContainer> load, uint32_t numGateway = 2)
+{
+  NetDeviceContainer devices = topology.Install (numSensor, numGateway);
+  topology.AssignStreams (devices, 0);
+  uint32_t numNode = devices.GetN ();
+  std::vector<Ptr<SimpleNetDevice> > dev (numNode);
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      dev[i] = DynamicCast<SimpleNetDevice> (devices.Get (i));
+    }
+  load (devices);
+  Simulator::Run ();
+
+  LwsnLineResult result = { 0, 0, 0, 0, 0, 0, 0, 0, LwsnMacStats () };
+  Ptr<LwsnSlotScheduler> scheduler = DynamicCast<SimpleChannel> (dev[0]->GetChannel ())->GetSlotScheduler ();
+  if (scheduler != 0)
+    {
+      result.slotActions = scheduler->GetNActions ();
+    }
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      if (dev[i]->GetSid () != 0)
+        {
+          result.sent += dev[i]->GetStats ().GetNTx ();
+          result.retrans += dev[i]->GetStats ().GetNRetransmissions ();
+        }
+      result.collisions += dev[i]->GetStats ().GetNCollisions ();
+      result.stats.Merge (dev[i]->GetStats ());
+    }
+  result.gateway1 = dev[0]->GetStats ().GetNGatewayReceived ();
+  result.gateway2 = dev[numNode - 1]->GetStats ().GetNGatewayReceived ();
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      if (dev[i]->GetSid () == 0)
+        {
+          result.delivered += dev[i]->GetStats ().GetNDelivered ();
+          result.queued += dev[i]->GetQueue ()->GetNPackets ();
+        }
+    }
+
+  for (uint32_t i = 0; i < numNode; i++)
+    {
+      dev[i]->Dispose ();
+    }
+  Simulator::Destroy ();
+  return result;
+}
+
+class LwsnNeighbourDeliveryTestCase : public TestCase
+{
+public:
+  LwsnNeighbourDeliveryTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnNeighbourDeliveryTestCase::LwsnNeighbourDeliveryTestCase ()
+  : TestCase ("Neighbour-indexed channel delivery matches the broadcast fan-out")
+{
+}
+
+void
+LwsnNeighbourDeliveryTestCase::DoRun (void)
+{
+  // every sensor starts at once, so that the comparison covers the
+  // collisions and the backoff draws
+  LwsnLineResult all = RunLwsnLine (8, LwsnTopologyHelper (), MakeCallback (&LoadBusy));
+  LwsnTopologyHelper topology;
+  topology.SetChannelAttribute ("NeighbourDelivery", BooleanValue (true));
+  LwsnLineResult neighbours = RunLwsnLine (8, topology, MakeCallback (&LoadBusy));
+
+  NS_TEST_EXPECT_MSG_GT (all.gateway1 + all.gateway2, 0, "the readings should reach a gateway");
+  NS_TEST_EXPECT_MSG_GT (all.collisions, 0, "the busy line should collide");
+  NS_TEST_EXPECT_MSG_GT (all.retrans, 0, "the collisions should be retransmitted");
+  NS_TEST_EXPECT_MSG_EQ (neighbours.sent, all.sent, "transmission counts differ");
+  NS_TEST_EXPECT_MSG_EQ (neighbours.retrans, all.retrans, "retransmission counts differ");
+  NS_TEST_EXPECT_MSG_EQ (neighbours.collisions, all.collisions, "collision counts differ");
+  NS_TEST_EXPECT_MSG_EQ (neighbours.gateway1, all.gateway1, "gateway 1 delivery differs");
+  NS_TEST_EXPECT_MSG_EQ (neighbours.gateway2, all.gateway2, "gateway 2 delivery differs");
+  NS_TEST_EXPECT_MSG_EQ (neighbours.delivered, all.delivered, "distinct deliveries differ");
+}
+
+class LwsnSlotSchedulerTestCase : public TestCase
+{
+public:
+  LwsnSlotSchedulerTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Run a line with one event per MAC timer, then with the slot
+   * scheduler, and compare the two runs.
+   *
+   * \param numSensor number of sensors of the line
+   * \param topology the device and channel attributes of the line
+   * \param load injects the readings
+   * \param name name of the load, for the messages
+   * \returns the totals of the run with one event per timer
+   */
+  LwsnLineResult Compare (uint32_t numSensor, LwsnTopologyHelper topology,
+                          Callback<void, NetDeviceContainer> load, std::string name);
+};
+
+LwsnSlotSchedulerTestCase::LwsnSlotSchedulerTestCase ()
+  : TestCase ("Slot-driven MAC timers give the same run as one event per timer")
+{
+}
+
+LwsnLineResult
+LwsnSlotSchedulerTestCase::Compare (uint32_t numSensor, LwsnTopologyHelper topology,
+                                    Callback<void, NetDeviceContainer> load, std::string name)
+{
+  LwsnLineResult events = RunLwsnLine (numSensor, topology, load);
+  topology.SetChannelAttribute ("SlotScheduling", BooleanValue (true));
+  LwsnLineResult slots = RunLwsnLine (numSensor, topology, load);
+
+  NS_TEST_EXPECT_MSG_GT (slots.slotActions, 0, name << ": the slot scheduler should run the timers");
+  NS_TEST_EXPECT_MSG_EQ (slots.sent, events.sent, name << ": transmission counts differ");
+  NS_TEST_EXPECT_MSG_EQ (slots.retrans, events.retrans, name << ": retransmission counts differ");
+  NS_TEST_EXPECT_MSG_EQ (slots.collisions, events.collisions, name << ": collision counts differ");
+  NS_TEST_EXPECT_MSG_EQ (slots.gateway1, events.gateway1, name << ": gateway 1 delivery differs");
+  NS_TEST_EXPECT_MSG_EQ (slots.gateway2, events.gateway2, name << ": gateway 2 delivery differs");
+  NS_TEST_EXPECT_MSG_EQ (slots.delivered, events.delivered, name << ": distinct deliveries differ");
+  NS_TEST_EXPECT_MSG_EQ (slots.stats.GetNGiveUps (), events.stats.GetNGiveUps (), name << ": give-ups differ");
+  NS_TEST_EXPECT_MSG_EQ (slots.stats.GetBackoffHistogram () == events.stats.GetBackoffHistogram (), true,
+                         name << ": backoff draws differ");
+  return events;
+}
+
+void
+LwsnSlotSchedulerTestCase::DoRun (void)
+{
+  // every sensor starts at once: collisions, backoff and retransmissions
+  LwsnLineResult busy = Compare (8, LwsnTopologyHelper (), MakeCallback (&LoadBusy), "busy");
+  NS_TEST_EXPECT_MSG_GT (busy.collisions, 0, "the busy line should collide");
+  NS_TEST_EXPECT_MSG_GT (busy.retrans, 0, "the collisions should be retransmitted");
+
+  // a relay sending a queue of readings, bundled into AGGREGATE frames
+  LwsnTopologyHelper aggregation;
+  aggregation.SetDeviceAttribute ("Aggregation", UintegerValue (4));
+  Compare (6, aggregation, MakeBoundCallback (&LoadBurst, 2), "burst");
+
+  // receptions that start on the grid, a slot after their frame
+  LwsnTopologyHelper delayed;
+  delayed.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (100)));
+  LwsnLineResult late = Compare (8, delayed, MakeCallback (&LoadBusy), "delayed");
+  NS_TEST_EXPECT_MSG_GT (late.collisions, 0, "the delayed line should collide");
+
+  // readings injected by applications on the slot boundaries
+  LwsnLineResult periodic = Compare (8, LwsnTopologyHelper (), MakeCallback (&LoadPeriodic), "periodic");
+  NS_TEST_EXPECT_MSG_GT (periodic.collisions, 0, "the periodic readings should collide");
+}
+
+class LwsnBackoffStreamTestCase : public TestCase
+{
+public:
+  LwsnBackoffStreamTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnBackoffStreamTestCase::LwsnBackoffStreamTestCase ()
+  : TestCase ("Backoff draws are reproducible once the device streams are assigned")
+{
+}
+
+void
+LwsnBackoffStreamTestCase::DoRun (void)
+{
+  LwsnLineResult first = RunLwsnLine (8, LwsnTopologyHelper (), MakeCallback (&LoadBusy));
+  LwsnLineResult second = RunLwsnLine (8, LwsnTopologyHelper (), MakeCallback (&LoadBusy));
+
+  NS_TEST_EXPECT_MSG_GT (first.collisions, 0, "the busy line should collide");
+  NS_TEST_EXPECT_MSG_EQ (second.sent, first.sent, "transmission counts differ");
+  NS_TEST_EXPECT_MSG_EQ (second.retrans, first.retrans, "retransmission counts differ");
+  NS_TEST_EXPECT_MSG_EQ (second.collisions, first.collisions, "collision counts differ");
+  NS_TEST_EXPECT_MSG_EQ (second.gateway1, first.gateway1, "gateway 1 delivery differs");
+  NS_TEST_EXPECT_MSG_EQ (second.gateway2, first.gateway2, "gateway 2 delivery differs");
+}
+
+class LwsnMacStatsTestCase : public TestCase
+{
+public:
+  LwsnMacStatsTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnMacStatsTestCase::LwsnMacStatsTestCase ()
+  : TestCase ("MAC statistics count deliveries without draining the gateway queues")
+{
+}
+
+void
+LwsnMacStatsTestCase::DoRun (void)
+{
+  LwsnLineResult result = RunLwsnLine (8, LwsnTopologyHelper (), MakeCallback (&LoadBusy));
+
+  NS_TEST_EXPECT_MSG_GT (result.delivered, 0, "the readings should reach a gateway");
+  NS_TEST_EXPECT_MSG_EQ (result.queued, result.delivered, "the stats must leave the gateway queues untouched");
+
+  LwsnMacStats stats;
+  stats.NotifyTx (LwsnHeader::FORWARDING);
+  stats.NotifyTx (LwsnHeader::IACK);
+  stats.NotifyTx (LwsnHeader::IACK);
+  stats.NotifyBackoff (3);
+  stats.NotifyDelivery (4, Seconds (2.0));
+  stats.NotifyDelivery (4, Seconds (6.0));
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNTx (), 3, "wrong transmission total");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNTx (LwsnHeader::IACK), 2, "wrong IACK count");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetBackoffHistogram ().size (), 4, "histogram should cover slots 0 to 3");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetBackoffHistogram ()[3], 1, "wrong histogram bin");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNDelivered (), 2, "wrong delivery count");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetFlows ().find (4)->second.GetMax (), Seconds (6.0), "wrong flow latency");
+}
+
+class LwsnLatencyHistogramTestCase : public TestCase
+{
+public:
+  LwsnLatencyHistogramTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnLatencyHistogramTestCase::LwsnLatencyHistogramTestCase ()
+  : TestCase ("Latency histogram quantiles stay within the bin precision")
+{
+}
+
+void
+LwsnLatencyHistogramTestCase::DoRun (void)
+{
+  LwsnLatencyHistogram histogram;
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetQuantile (0.5), Time (0), "an empty histogram has no quantile");
+  for (uint32_t i = 1; i <= 1000; i++)
+    {
+      histogram.Add (MicroSeconds (1000 * i + 7));
+    }
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetCount (), 1000, "wrong sample count");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetMin (), MicroSeconds (1007), "min must be exact");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetMax (), MicroSeconds (1000007), "max must be exact");
+  NS_TEST_EXPECT_MSG_EQ_TOL (histogram.GetMean ().GetSeconds (), 0.500507, 1e-6, "mean must be exact");
+  NS_TEST_EXPECT_MSG_EQ_TOL (histogram.GetQuantile (0.5).GetSeconds (), 0.5, 0.5 * 0.03, "p50 out of precision");
+  NS_TEST_EXPECT_MSG_EQ_TOL (histogram.GetQuantile (0.99).GetSeconds (), 0.99, 0.99 * 0.03, "p99 out of precision");
+
+  LwsnLatencyHistogram other;
+  other.Add (Seconds (5));
+  histogram.Merge (other);
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetCount (), 1001, "merge lost samples");
+  NS_TEST_EXPECT_MSG_EQ (histogram.GetQuantile (1.0), Seconds (5), "merge lost the largest sample");
+}
+
+class LwsnTopologyHelperTestCase : public TestCase
+{
+public:
+  LwsnTopologyHelperTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnTopologyHelperTestCase::LwsnTopologyHelperTestCase ()
+  : TestCase ("LwsnTopologyHelper lays out gateways, sides and last nodes")
+{
+}
+
+void
+LwsnTopologyHelperTestCase::DoRun (void)
+{
+  // 5 sensors, 3 gateways: G S S S G S S G
+  LwsnTopologyHelper topology;
+  NetDeviceContainer devices = topology.Install (5, 3);
+  NS_TEST_ASSERT_MSG_EQ (devices.GetN (), 8, "wrong number of devices");
+  int gid[8] = { 1, 0, 0, 0, 2, 0, 0, 3 };
+  bool last[8] = { false, true, false, true, false, true, true, false };
+  for (uint32_t i = 0; i < 8; i++)
+    {
+      Ptr<SimpleNetDevice> dev = DynamicCast<SimpleNetDevice> (devices.Get (i));
+      NS_TEST_EXPECT_MSG_EQ (dev->GetGid (), gid[i], "wrong Gid at " << i);
+      NS_TEST_EXPECT_MSG_EQ (dev->GetSid (), gid[i] != 0 ? 0 : i, "wrong Sid at " << i);
+      NS_TEST_EXPECT_MSG_EQ (dev->IsLastNode (), last[i], "wrong last node at " << i);
+      if (gid[i] == 0)
+        {
+          NS_TEST_EXPECT_MSG_EQ (dev->GetLaddress (), Mac48Address::ConvertFrom (devices.Get (i - 1)->GetAddress ()), "wrong left side at " << i);
+          NS_TEST_EXPECT_MSG_EQ (dev->GetRaddress (), Mac48Address::ConvertFrom (devices.Get (i + 1)->GetAddress ()), "wrong right side at " << i);
+        }
+      NS_TEST_EXPECT_MSG_EQ (dev->GetChannel (), devices.Get (0)->GetChannel (), "a line shares one channel");
+    }
+
+  std::vector<NetDeviceContainer> lines = topology.InstallLines (2, 4);
+  NS_TEST_ASSERT_MSG_EQ (lines.size (), 2, "wrong number of lines");
+  NS_TEST_EXPECT_MSG_EQ (lines[0].GetN (), 6, "wrong line length");
+  NS_TEST_EXPECT_MSG_NE (lines[0].Get (0)->GetChannel (), lines[1].Get (0)->GetChannel (), "lines must not share a channel");
+
+  Simulator::Destroy ();
+
+  // the sensor right of the middle gateway waits for the IACK of its
+  // right neighbour only, as sensor 1 does at the first gateway
+  LwsnLineResult middle = RunLwsnLine (5, LwsnTopologyHelper (), MakeBoundCallback (&LoadReading, 5), 3);
+  NS_TEST_EXPECT_MSG_EQ (middle.delivered, 2, "the reading should reach the gateways on both sides");
+  NS_TEST_EXPECT_MSG_EQ (middle.retrans, 0, "nothing lost on a quiet line");
+  NS_TEST_EXPECT_MSG_EQ (middle.stats.GetNTx (LwsnHeader::IACK), 1, "only the sensor on the right acknowledges");
+}
+
+/**
+ * Run one lwsn-sweep replication of a sensors / readings / window
+ * scenario, on LwsnLineKernel or on a LwsnTopologyHelper line, with the
+ * same readings and backoff streams.
+ */
+static LwsnLineResult
+RunLwsnScenario (uint32_t sensors, uint32_t readings, uint32_t window, uint32_t run, bool kernel)
+{
+  RngSeedManager::SetSeed (10);
+  RngSeedManager::SetRun (run);
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  x->SetAttribute ("Min", DoubleValue (1.0));
+  x->SetAttribute ("Max", DoubleValue (sensors));
+  Ptr<UniformRandomVariable> t = CreateObject<UniformRandomVariable> ();
+  t->SetAttribute ("Min", DoubleValue (0.0));
+  t->SetAttribute ("Max", DoubleValue (window));
+  x->SetStream (0);
+  t->SetStream (1);
+  std::vector<uint32_t> source (readings);
+  for (uint32_t i = 0; i < readings; i++)
+    {
+      source[i] = x->GetInteger ();
+    }
+
+  std::vector<const LwsnMacStats *> stats (sensors + 2);
+  LwsnLineKernel line (sensors);
+  NetDeviceContainer devices;
+  if (kernel)
+    {
+      line.AssignStreams (2);
+      for (uint32_t i = 0; i < readings; i++)
+        {
+          line.AddReading (source[i], Seconds (t->GetInteger ()));
+        }
+      line.Run ();
+      for (uint32_t i = 0; i < stats.size (); i++)
+        {
+          stats[i] = &line.GetStats (i);
+        }
+    }
+  else
+    {
+      LwsnTopologyHelper topology;
+      devices = topology.Install (sensors);
+      topology.AssignStreams (devices, 2);
+      Ptr<Packet> packet = Create<Packet> (100);
+      for (uint32_t i = 0; i < readings; i++)
+        {
+          Simulator::Schedule (Seconds (t->GetInteger ()), &SimpleNetDevice::OriginalTransmission,
+                               DynamicCast<SimpleNetDevice> (devices.Get (source[i])), packet, 0, false);
+        }
+      Simulator::Run ();
+      for (uint32_t i = 0; i < stats.size (); i++)
+        {
+          stats[i] = &DynamicCast<SimpleNetDevice> (devices.Get (i))->GetStats ();
+        }
+    }
+
+  LwsnLineResult result = { 0, 0, 0, 0, 0, 0, 0 };
+  for (uint32_t i = 0; i < stats.size (); i++)
+    {
+      if (i != 0 && i != stats.size () - 1)
+        {
+          result.sent += stats[i]->GetNTx ();
+          result.retrans += stats[i]->GetNRetransmissions ();
+        }
+      result.collisions += stats[i]->GetNCollisions ();
+    }
+  result.gateway1 = stats[0]->GetNGatewayReceived ();
+  result.gateway2 = stats[sensors + 1]->GetNGatewayReceived ();
+  result.delivered = stats[0]->GetNDelivered () + stats[sensors + 1]->GetNDelivered ();
+
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      devices.Get (i)->Dispose ();
+    }
+  Simulator::Destroy ();
+  return result;
+}
+
+class LwsnLineKernelTestCase : public TestCase
+{
+public:
+  LwsnLineKernelTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnLineKernelTestCase::LwsnLineKernelTestCase ()
+  : TestCase ("LwsnLineKernel matches the event-driven MAC on the lwsn-uniformrandom scenarios")
+{
+}
+
+void
+LwsnLineKernelTestCase::DoRun (void)
+{
+  // lwsn-uniformrandom_1 and lwsn-uniformrandom_6; both sides draw the
+  // readings and the backoffs from the same streams, so every run must
+  // give the same counters
+  uint32_t scenarios[2][3] = { { 6, 7, 10 }, { 6, 45, 10 } };
+  const uint32_t runs = 10;
+  const char *names[6] = { "sent", "retrans", "collisions", "gateway1", "gateway2", "delivered" };
+  for (uint32_t s = 0; s < 2; s++)
+    {
+      uint32_t collisions = 0;
+      for (uint32_t run = 1; run <= runs; run++)
+        {
+          LwsnLineResult a = RunLwsnScenario (scenarios[s][0], scenarios[s][1], scenarios[s][2], run, false);
+          LwsnLineResult b = RunLwsnScenario (scenarios[s][0], scenarios[s][1], scenarios[s][2], run, true);
+          uint32_t av[6] = { a.sent, a.retrans, a.collisions, a.gateway1, a.gateway2, a.delivered };
+          uint32_t bv[6] = { b.sent, b.retrans, b.collisions, b.gateway1, b.gateway2, b.delivered };
+          NS_TEST_EXPECT_MSG_GT (a.delivered, 0, "the readings should reach a gateway in scenario " << s << " run " << run);
+          for (uint32_t i = 0; i < 6; i++)
+            {
+              NS_TEST_EXPECT_MSG_EQ (bv[i], av[i], names[i] << " differs in scenario " << s << " run " << run);
+            }
+          collisions += a.collisions;
+        }
+      if (s == 1)
+        {
+          NS_TEST_EXPECT_MSG_GT (collisions, 0, "45 readings in 10 s should contend");
+        }
+    }
+}
+
+class LwsnParallelLinesTestCase : public TestCase
+{
+public:
+  LwsnParallelLinesTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnParallelLinesTestCase::LwsnParallelLinesTestCase ()
+  : TestCase ("Lines run on several threads give the same result as on one")
+{
+}
+
+/**
+ * Set up numLine lines of 6 sensors, each with its own readings, on the
+ * same streams whatever the container.
+ */
+static void
+SetUpLwsnLines (LwsnParallelLines &lines, uint32_t numLine)
+{
+  Ptr<UniformRandomVariable> x = CreateObject<UniformRandomVariable> ();
+  Ptr<UniformRandomVariable> t = CreateObject<UniformRandomVariable> ();
+  x->SetStream (0);
+  t->SetStream (1);
+  for (uint32_t l = 0; l < numLine; l++)
+    {
+      LwsnLineKernel &line = lines.AddLine (6);
+      for (uint32_t i = 0; i < 20; i++)
+        {
+          line.AddReading (x->GetInteger (1, 6), Seconds (t->GetInteger (0, 10)));
+        }
+    }
+  lines.AssignStreams (2);
+}
+
+void
+LwsnParallelLinesTestCase::DoRun (void)
+{
+  LwsnParallelLines serial;
+  SetUpLwsnLines (serial, 8);
+  serial.Run (1);
+  LwsnParallelLines parallel;
+  SetUpLwsnLines (parallel, 8);
+  parallel.Run (4);
+
+  NS_TEST_ASSERT_MSG_EQ (parallel.GetNLines (), 8, "wrong number of lines");
+  for (uint32_t l = 0; l < 8; l++)
+    {
+      for (uint32_t i = 0; i < 8; i++)
+        {
+          const LwsnMacStats &a = serial.GetLine (l).GetStats (i);
+          const LwsnMacStats &b = parallel.GetLine (l).GetStats (i);
+          NS_TEST_EXPECT_MSG_EQ (b.GetNTx (), a.GetNTx (), "line " << l << " node " << i << " sent differently");
+          NS_TEST_EXPECT_MSG_EQ (b.GetNCollisions (), a.GetNCollisions (), "line " << l << " node " << i << " collided differently");
+          NS_TEST_EXPECT_MSG_EQ (b.GetNDelivered (), a.GetNDelivered (), "line " << l << " node " << i << " delivered differently");
+        }
+    }
+  LwsnMacStats merged = parallel.GetMergedStats ();
+  NS_TEST_EXPECT_MSG_EQ (merged.GetNTx (), serial.GetMergedStats ().GetNTx (), "merged counts differ");
+  NS_TEST_EXPECT_MSG_EQ (parallel.GetMergedGatewayStats ().GetNDelivered (), merged.GetNDelivered (),
+                         "only gateways deliver");
+  NS_TEST_EXPECT_MSG_GT (parallel.GetNDelivered (), 0, "the readings should reach a gateway");
+}
+
+class LwsnInterferenceTrackerTestCase : public TestCase
+{
+public:
+  LwsnInterferenceTrackerTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnInterferenceTrackerTestCase::LwsnInterferenceTrackerTestCase ()
+  : TestCase ("Overlapping receptions are resolved by the capture model")
+{
+}
+
+void
+LwsnInterferenceTrackerTestCase::DoRun (void)
+{
+  // A [0, 9) overlaps B [5, 14), B overlaps C [12, 21), D [30, 39) is alone;
+  // B is 10 dB stronger than the others
+  const LwsnInterferenceTracker::CaptureModel models[3] = {
+    LwsnInterferenceTracker::CAPTURE_NONE,
+    LwsnInterferenceTracker::CAPTURE_FIRST,
+    LwsnInterferenceTracker::CAPTURE_STRONGEST
+  };
+  const bool expected[3][4] = {
+    { false, false, false, true },
+    { true, false, false, true },
+    { false, true, false, true }
+  };
+  for (uint32_t m = 0; m < 3; m++)
+    {
+      LwsnInterferenceTracker tracker;
+      tracker.SetCaptureModel (models[m]);
+      tracker.SetCaptureThreshold (3.0);
+      uint32_t a = tracker.Add (0, 9, 0.0);
+      uint32_t b = tracker.Add (5, 14, 10.0);
+      bool received[4];
+      received[0] = tracker.End (a);
+      uint32_t c = tracker.Add (12, 21, 0.0);
+      received[1] = tracker.End (b);
+      received[2] = tracker.End (c);
+      uint32_t d = tracker.Add (30, 39, 0.0);
+      received[3] = tracker.End (d);
+      for (uint32_t i = 0; i < 4; i++)
+        {
+          NS_TEST_EXPECT_MSG_EQ (received[i], expected[m][i], "model " << m << " reception " << i);
+        }
+      NS_TEST_EXPECT_MSG_EQ (tracker.GetNActive (), 0, "every reception has ended");
+    }
+
+  // more receptions than the initial ring holds, ended out of order
+  LwsnInterferenceTracker tracker;
+  tracker.SetCaptureModel (LwsnInterferenceTracker::CAPTURE_FIRST);
+  std::vector<uint32_t> ids;
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      ids.push_back (tracker.Add (i, 100 - i, 0.0));
+    }
+  NS_TEST_EXPECT_MSG_EQ (tracker.GetNActive (), 10, "wrong number of receptions in progress");
+  for (uint32_t i = 1; i < 10; i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (tracker.End (ids[i]), false, "reception " << i << " started after another");
+    }
+  NS_TEST_EXPECT_MSG_EQ (tracker.End (ids[0]), true, "the first reception is captured");
+}
+
+class LwsnTrafficApplicationTestCase : public TestCase
+{
+public:
+  LwsnTrafficApplicationTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \param p the reading injected
+   */
+  void Tx (Ptr<const Packet> p);
+
+  std::vector<Time> m_arrivals; //!< injection times of the trace source
+};
+
+LwsnTrafficApplicationTestCase::LwsnTrafficApplicationTestCase ()
+  : TestCase ("LwsnTrafficApplication injects readings lazily from one payload")
+{
+}
+
+void
+LwsnTrafficApplicationTestCase::Tx (Ptr<const Packet> p)
+{
+  m_arrivals.push_back (Simulator::Now ());
+}
+
+void
+LwsnTrafficApplicationTestCase::DoRun (void)
+{
+  LwsnTopologyHelper topology;
+  NetDeviceContainer devices = topology.Install (3);
+
+  LwsnTrafficHelper poisson;
+  poisson.SetAttribute ("Interval", TimeValue (Seconds (5)));
+  poisson.SetAttribute ("MaxPackets", UintegerValue (3));
+  ApplicationContainer sources = poisson.Install (devices);
+  NS_TEST_EXPECT_MSG_EQ (sources.GetN (), 3, "one source per sensor, none on the gateways");
+  NS_TEST_EXPECT_MSG_EQ (poisson.AssignStreams (sources, 0), 3, "one stream per source");
+
+  LwsnTrafficHelper periodic;
+  periodic.SetAttribute ("Process", EnumValue (LwsnTrafficApplication::PERIODIC));
+  periodic.SetAttribute ("Interval", TimeValue (Seconds (2)));
+  periodic.SetAttribute ("MaxPackets", UintegerValue (4));
+  ApplicationContainer ticks = periodic.Install (DynamicCast<SimpleNetDevice> (devices.Get (1)));
+
+  LwsnTrafficHelper trace;
+  trace.SetAttribute ("Process", EnumValue (LwsnTrafficApplication::TRACE));
+  trace.SetAttribute ("Granularity", TimeValue (MilliSeconds (100)));
+  ApplicationContainer replay = trace.Install (DynamicCast<SimpleNetDevice> (devices.Get (2)));
+  Ptr<LwsnTrafficApplication> app = DynamicCast<LwsnTrafficApplication> (replay.Get (0));
+  std::vector<Time> arrivals;
+  arrivals.push_back (MilliSeconds (50));
+  arrivals.push_back (MilliSeconds (1230));
+  app->SetTrace (arrivals);
+  app->TraceConnectWithoutContext ("Tx", MakeCallback (&LwsnTrafficApplicationTestCase::Tx, this));
+
+  Simulator::Run ();
+  for (uint32_t i = 0; i < sources.GetN (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (DynamicCast<LwsnTrafficApplication> (sources.Get (i))->GetNSent (), 3,
+                             "source " << i << " stops at MaxPackets");
+    }
+  NS_TEST_EXPECT_MSG_EQ (DynamicCast<LwsnTrafficApplication> (ticks.Get (0))->GetNSent (), 4,
+                         "periodic source stops at MaxPackets");
+  NS_TEST_EXPECT_MSG_EQ (m_arrivals.size (), 2, "the trace source replays every arrival");
+  if (m_arrivals.size () == 2)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_arrivals[0], MilliSeconds (100), "arrival not moved to the grid");
+      NS_TEST_EXPECT_MSG_EQ (m_arrivals[1], MilliSeconds (1300), "arrival not moved to the grid");
+    }
+  NS_TEST_EXPECT_MSG_GT (DynamicCast<SimpleNetDevice> (devices.Get (2))->GetStats ().GetNTx (), 0,
+                         "the sensor should transmit the readings");
+  Simulator::Destroy ();
+}
+
+class LwsnMacTraceTestCase : public TestCase
+{
+public:
+  LwsnMacTraceTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnMacTraceTestCase::LwsnMacTraceTestCase ()
+  : TestCase ("The MAC trace keeps the last events and reads back what it writes")
+{
+}
+
+void
+LwsnMacTraceTestCase::DoRun (void)
+{
+  LwsnMacTrace trace;
+  trace.Record (0, LwsnMacTrace::TX, 1, 1, 1, 0);
+  NS_TEST_EXPECT_MSG_EQ (trace.GetNRecords (), 0, "a trace without capacity records nothing");
+
+  trace.SetCapacity (3);
+  NS_TEST_EXPECT_MSG_EQ (trace.GetCapacity (), 4, "capacity is rounded up to a power of two");
+  for (uint16_t i = 0; i < 6; i++)
+    {
+      trace.Record (i * 100, LwsnMacTrace::BACKOFF, 2, 0, i, 300);
+    }
+  NS_TEST_EXPECT_MSG_EQ (trace.GetNTotal (), 6, "wrong event count");
+  NS_TEST_EXPECT_MSG_EQ (trace.GetNRecords (), 4, "the ring keeps its capacity");
+  NS_TEST_EXPECT_MSG_EQ (trace.Get (0).did, 2, "the oldest events are overwritten");
+  NS_TEST_EXPECT_MSG_EQ (trace.Get (3).did, 5, "the newest event comes last");
+  NS_TEST_EXPECT_MSG_EQ (static_cast<uint32_t> (trace.Get (3).arg), 255, "the argument saturates");
+
+  std::stringstream ss;
+  trace.Write (ss);
+  trace.Write (ss);
+  std::vector<LwsnMacTraceRecord> records;
+  uint32_t blocks = 0;
+  while (LwsnMacTrace::Read (ss, records))
+    {
+      blocks++;
+    }
+  NS_TEST_EXPECT_MSG_EQ (blocks, 2, "both dumps should be read back");
+  NS_TEST_EXPECT_MSG_EQ (records.size (), 8, "wrong number of records read back");
+  NS_TEST_EXPECT_MSG_EQ (records[4].time, 200, "records differ once read back");
+  NS_TEST_EXPECT_MSG_EQ (std::string (LwsnMacTrace::GetEventName (records[4].event)), "BACKOFF",
+                         "wrong event name");
+}
+
+class LwsnRadioEnergyTestCase : public TestCase
+{
+public:
+  LwsnRadioEnergyTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /// EnergyDepleted sink
+  void Depleted (void);
+  Time m_depletedAt; //!< time EnergyDepleted fired
+};
+
+LwsnRadioEnergyTestCase::LwsnRadioEnergyTestCase ()
+  : TestCase ("The radio follows its wake schedule and runs its battery down")
+{
+}
+
+void
+LwsnRadioEnergyTestCase::Depleted (void)
+{
+  m_depletedAt = Simulator::Now ();
+}
+
+void
+LwsnRadioEnergyTestCase::DoRun (void)
+{
+  Ptr<LwsnRadioEnergy> duty = CreateObject<LwsnRadioEnergy> ();
+  duty->SetAttribute ("WakePeriod", TimeValue (Seconds (10)));
+  duty->SetAttribute ("WakeDuration", TimeValue (Seconds (2)));
+  Ptr<LwsnRadioEnergy> battery = CreateObject<LwsnRadioEnergy> ();
+  battery->SetAttribute ("InitialEnergy", DoubleValue (0.1));
+  battery->TraceConnectWithoutContext ("EnergyDepleted", MakeCallback (&LwsnRadioEnergyTestCase::Depleted, this));
+  m_depletedAt = Seconds (-1);
+  NS_TEST_EXPECT_MSG_EQ (duty->IsAwake (), true, "the schedule starts awake");
+
+  // 0.1 J at 0.0564 W lasts 1.773 s
+  double lifetime = 0.1 / 0.0564;
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (battery->IsDepleted (), false, "0.0564 J drawn out of 0.1 J");
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ_TOL (m_depletedAt.GetSeconds (), lifetime, 1e-6, "EnergyDepleted should fire when the battery runs out");
+  NS_TEST_EXPECT_MSG_EQ (battery->IsDepleted (), true, "the battery ran out before 2 s");
+  NS_TEST_EXPECT_MSG_EQ (battery->IsAwake (), false, "a dead radio hears nothing");
+  NS_TEST_EXPECT_MSG_EQ_TOL (battery->GetRemainingEnergy (), 0.0, 1e-9, "nothing left");
+  NS_TEST_EXPECT_MSG_EQ_TOL (battery->GetConsumedEnergy (), 0.1, 1e-9, "nothing drawn once OFF");
+
+  Simulator::Stop (Seconds (23));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (duty->IsAwake (), false, "asleep at 25 s");
+  NS_TEST_EXPECT_MSG_EQ (duty->GetStateTime (LwsnRadioEnergy::IDLE), Seconds (6), "awake [0,2), [10,12), [20,22)");
+  NS_TEST_EXPECT_MSG_EQ (duty->GetStateTime (LwsnRadioEnergy::SLEEP), Seconds (19), "asleep the rest of the time");
+  NS_TEST_EXPECT_MSG_EQ_TOL (duty->GetConsumedEnergy (), 6 * 0.0564 + 19 * 0.00006, 1e-9, "wrong energy");
+  NS_TEST_EXPECT_MSG_EQ_TOL (battery->GetStateTime (LwsnRadioEnergy::OFF).GetSeconds (), 25 - lifetime, 1e-6,
+                             "off since the battery ran out");
+
+  // a transmission is on the air whatever the schedule
+  duty->NotifyTx (MilliSeconds (900));
+  NS_TEST_EXPECT_MSG_EQ (duty->GetState (), LwsnRadioEnergy::TX, "sending");
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (duty->GetState (), LwsnRadioEnergy::SLEEP, "back to sleep after the frame");
+  NS_TEST_EXPECT_MSG_EQ (duty->GetStateTime (LwsnRadioEnergy::TX), MilliSeconds (900), "wrong TX time");
+  NS_TEST_EXPECT_MSG_EQ (duty->GetStateTime (LwsnRadioEnergy::SLEEP), MilliSeconds (19100), "wrong sleep time");
+  Simulator::Destroy ();
+}
+
+class LwsnBackoffPolicyTestCase : public TestCase
+{
+public:
+  LwsnBackoffPolicyTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \param policy the policy
+   * \param attempt failed attempts of the frame
+   * \returns the largest of 200 draws
+   */
+  uint32_t GetMaxDraw (Ptr<LwsnBackoffPolicy> policy, uint32_t attempt);
+};
+
+LwsnBackoffPolicyTestCase::LwsnBackoffPolicyTestCase ()
+  : TestCase ("Backoff policies bound their windows and give up explicitly")
+{
+}
+
+uint32_t
+LwsnBackoffPolicyTestCase::GetMaxDraw (Ptr<LwsnBackoffPolicy> policy, uint32_t attempt)
+{
+  uint32_t max = 0;
+  for (uint32_t i = 0; i < 200; i++)
+    {
+      LwsnBackoff backoff = policy->Next (attempt, 10);
+      max = std::max (max, backoff.slots);
+    }
+  return max;
+}
+
+void
+LwsnBackoffPolicyTestCase::DoRun (void)
+{
+  Ptr<LwsnBackoffPolicy> exponential = CreateObject<LwsnExponentialBackoffPolicy> ();
+  exponential->AssignStreams (0);
+  NS_TEST_EXPECT_MSG_EQ (exponential->Next (4, 3).giveUp, true, "the fourth failure of three rounds gives up");
+  NS_TEST_EXPECT_MSG_EQ (exponential->Next (3, 3).giveUp, false, "the third failure still retries");
+  NS_TEST_EXPECT_MSG_EQ (GetMaxDraw (exponential, 3), 7, "window 2^3 - 1");
+  uint32_t max = GetMaxDraw (exponential, 7);
+  NS_TEST_EXPECT_MSG_GT (max, 7, "window 2^7 - 1");
+  NS_TEST_EXPECT_MSG_LT (max, 128, "window 2^7 - 1");
+
+  Ptr<LwsnBackoffPolicy> linear = CreateObject<LwsnLinearBackoffPolicy> ();
+  linear->AssignStreams (1);
+  NS_TEST_EXPECT_MSG_EQ (GetMaxDraw (linear, 3), 6, "window Slope * 3");
+
+  Ptr<LwsnBackoffPolicy> position = CreateObject<LwsnPositionBackoffPolicy> ();
+  position->AssignStreams (2);
+  NS_TEST_EXPECT_MSG_EQ (GetMaxDraw (position, 3), 7, "unknown distance: full window");
+  position->SetGatewayHops (1);
+  NS_TEST_EXPECT_MSG_EQ (GetMaxDraw (position, 3), 2, "next to a gateway: a quarter of the window");
+
+  Ptr<LwsnAdaptiveBackoffPolicy> adaptive = CreateObject<LwsnAdaptiveBackoffPolicy> ();
+  adaptive->AssignStreams (3);
+  NS_TEST_EXPECT_MSG_EQ (GetMaxDraw (adaptive, 3), 7, "no reception yet: full window");
+  for (uint32_t i = 0; i < 50; i++)
+    {
+      adaptive->NotifyReception (false);
+    }
+  NS_TEST_EXPECT_MSG_LT (adaptive->GetCollisionRate (), 0.01, "the rate follows the receptions");
+  NS_TEST_EXPECT_MSG_EQ (GetMaxDraw (adaptive, 3), 1, "quiet channel: MinWindow");
+
+  LwsnTopologyHelper topology;
+  NetDeviceContainer devices = topology.Install (5, 2);
+  uint16_t hops[] = { 0, 1, 2, 3, 2, 1, 0 };
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice> (devices.Get (i));
+      NS_TEST_EXPECT_MSG_EQ (device->GetGatewayHops (), hops[i], "wrong distance at position " << i);
+      NS_TEST_EXPECT_MSG_EQ (device->GetBackoffPolicy ()->GetGatewayHops (), hops[i],
+                             "the policy does not know the distance at position " << i);
+    }
+  Simulator::Destroy ();
+}
+
+class LwsnImplicitAckTestCase : public TestCase
+{
+public:
+  LwsnImplicitAckTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnImplicitAckTestCase::LwsnImplicitAckTestCase ()
+  : TestCase ("Overheard forwards replace the IACK frames")
+{
+}
+
+void
+LwsnImplicitAckTestCase::DoRun (void)
+{
+  // one reading from the middle of a line of six sensors
+  LwsnTopologyHelper topology;
+  LwsnMacStats explicitAck = RunLwsnLine (6, topology, MakeBoundCallback (&LoadReading, 3)).stats;
+  topology.SetDeviceAttribute ("ImplicitAck", BooleanValue (true));
+  LwsnMacStats implicitAck = RunLwsnLine (6, topology, MakeBoundCallback (&LoadReading, 3)).stats;
+
+  NS_TEST_EXPECT_MSG_EQ (explicitAck.GetNIacksSaved (), 0, "every IACK is sent by default");
+  NS_TEST_EXPECT_MSG_GT (explicitAck.GetNTx (LwsnHeader::IACK), 0, "the relays acknowledge explicitly");
+  NS_TEST_EXPECT_MSG_GT (implicitAck.GetNIacksSaved (), 0, "no IACK left out");
+  NS_TEST_EXPECT_MSG_GT (implicitAck.GetNImplicitAcks (), 0, "no forward overheard");
+  NS_TEST_EXPECT_MSG_LT (implicitAck.GetNTx (LwsnHeader::IACK), explicitAck.GetNTx (LwsnHeader::IACK),
+                         "the IACK frames should go");
+  NS_TEST_EXPECT_MSG_LT (implicitAck.GetNTx (), explicitAck.GetNTx (), "fewer frames on the channel");
+  NS_TEST_EXPECT_MSG_EQ (implicitAck.GetNDelivered (), explicitAck.GetNDelivered (),
+                         "the reading should reach both gateways either way");
+}
+
+class LwsnNetworkCodingTestCase : public TestCase
+{
+public:
+  LwsnNetworkCodingTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnNetworkCodingTestCase::LwsnNetworkCodingTestCase ()
+  : TestCase ("Relays code readings crossing each other into one frame")
+{
+}
+
+void
+LwsnNetworkCodingTestCase::DoRun (void)
+{
+  LwsnTopologyHelper topology;
+  LwsnLineResult plain = RunLwsnLine (7, topology, MakeCallback (&LoadEnds));
+  topology.SetDeviceAttribute ("NetworkCoding", BooleanValue (true));
+  LwsnLineResult coded = RunLwsnLine (7, topology, MakeCallback (&LoadEnds));
+
+  NS_TEST_EXPECT_MSG_EQ (plain.stats.GetNCoded (), 0, "nothing coded by default");
+  NS_TEST_EXPECT_MSG_GT (coded.stats.GetNCoded (), 0, "the relays should code the crossing readings");
+  NS_TEST_EXPECT_MSG_GT (coded.stats.GetNDecoded (), 0, "the neighbours should decode them");
+  NS_TEST_EXPECT_MSG_EQ (coded.stats.GetNCodingFailures (), 0, "every neighbour holds its half");
+  // the neighbours acknowledge the decoded halves, so the relays do not
+  // fall back to plain retransmissions
+  NS_TEST_EXPECT_MSG_LT (coded.sent, plain.sent, "fewer frames on the channel");
+  NS_TEST_EXPECT_MSG_EQ (coded.delivered, plain.delivered, "the readings should reach the gateways either way");
+  NS_TEST_EXPECT_MSG_GT (plain.delivered, 0, "the readings should reach the gateways");
+}
+
+class LwsnRoutingTestCase : public TestCase
+{
+public:
+  LwsnRoutingTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnRoutingTestCase::LwsnRoutingTestCase ()
+  : TestCase ("Readings go to the nearer gateway and G_ANC frames give the distances")
+{
+}
+
+void
+LwsnRoutingTestCase::DoRun (void)
+{
+  // one reading from the second sensor of a line of six
+  LwsnTopologyHelper routed;
+  LwsnMacStats both = RunLwsnLine (6, routed, MakeBoundCallback (&LoadReading, 2)).stats;
+  routed.SetDeviceAttribute ("Routing", EnumValue (SimpleNetDevice::ROUTING_NEAREST));
+  LwsnMacStats nearest = RunLwsnLine (6, routed, MakeBoundCallback (&LoadReading, 2)).stats;
+
+  NS_TEST_EXPECT_MSG_EQ (both.GetNDelivered (), 2, "the reading should reach both gateways");
+  NS_TEST_EXPECT_MSG_EQ (nearest.GetNDelivered (), 1, "the reading should reach the nearer gateway only");
+  NS_TEST_EXPECT_MSG_LT (nearest.GetNTx (), both.GetNTx (), "fewer frames on the channel");
+  NS_TEST_EXPECT_MSG_EQ (nearest.GetNFailovers (), 0, "nothing lost on a quiet line");
+
+  // forget the distances set by the helper and learn them from G_ANC
+  LwsnTopologyHelper topology;
+  NetDeviceContainer devices = topology.Install (6);
+  for (uint32_t i = 1; i + 1 < devices.GetN (); i++)
+    {
+      DynamicCast<SimpleNetDevice> (devices.Get (i))->SetGatewayDistances (0, 0);
+    }
+  Simulator::Schedule (Seconds (0), &SimpleNetDevice::AnnounceGateway,
+                       DynamicCast<SimpleNetDevice> (devices.Get (0)));
+  Simulator::Schedule (Seconds (100), &SimpleNetDevice::AnnounceGateway,
+                       DynamicCast<SimpleNetDevice> (devices.Get (devices.GetN () - 1)));
+  Simulator::Run ();
+  for (uint32_t i = 1; i + 1 < devices.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> device = DynamicCast<SimpleNetDevice> (devices.Get (i));
+      NS_TEST_EXPECT_MSG_EQ (device->GetLeftGatewayHops (), i, "wrong distance to the left gateway");
+      NS_TEST_EXPECT_MSG_EQ (device->GetRightGatewayHops (), devices.GetN () - 1 - i,
+                             "wrong distance to the right gateway");
+    }
+  Simulator::Destroy ();
+}
+
+class LwsnPriorityQueueTestCase : public TestCase
+{
+public:
+  LwsnPriorityQueueTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \param queue the queue
+   * \param osid Osid of the packet
+   * \param did Did of the packet
+   * \param start StartTime of the packet
+   * \returns true if the queue accepted it
+   */
+  static bool Enqueue (Ptr<Queue> queue, uint16_t osid, uint16_t did, uint16_t start);
+  /**
+   * \param queue the queue
+   * \returns the Did of the dequeued packet
+   */
+  static uint16_t Dequeue (Ptr<Queue> queue);
+};
+
+LwsnPriorityQueueTestCase::LwsnPriorityQueueTestCase ()
+  : TestCase ("LwsnPriorityQueue serves the oldest or nearest packet first")
+{
+}
+
+bool
+LwsnPriorityQueueTestCase::Enqueue (Ptr<Queue> queue, uint16_t osid, uint16_t did, uint16_t start)
+{
+  LwsnHeader header;
+  header.SetType (LwsnHeader::FORWARDING);
+  header.SetOsid (osid);
+  header.SetDid (did);
+  header.SetStartTime (start);
+  Ptr<Packet> p = Create<Packet> (10);
+  p->AddHeader (header);
+  return queue->Enqueue (Create<QueueItem> (p));
+}
+
+uint16_t
+LwsnPriorityQueueTestCase::Dequeue (Ptr<Queue> queue)
+{
+  LwsnHeader header;
+  queue->Dequeue ()->GetPacket ()->PeekHeader (header);
+  return header.GetDid ();
+}
+
+void
+LwsnPriorityQueueTestCase::DoRun (void)
+{
+  Ptr<LwsnPriorityQueue> queue = CreateObject<LwsnPriorityQueue> ();
+  queue->SetMaxPackets (4);
+  Enqueue (queue, 5, 1, 300);
+  Enqueue (queue, 2, 2, 100);
+  Enqueue (queue, 7, 3, 200);
+  Enqueue (queue, 3, 4, 100);
+  NS_TEST_EXPECT_MSG_EQ (Enqueue (queue, 1, 5, 0), false, "the queue is full");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPackets (), 1, "the Queue drop accounting");
+
+  NS_TEST_EXPECT_MSG_EQ (queue->MoveToFront (7, 3), true, "packet (7, 3) is waiting");
+  NS_TEST_EXPECT_MSG_EQ (queue->MoveToFront (7, 9), false, "packet (7, 9) is not");
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (queue), 3, "the packet moved to the front");
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (queue), 2, "oldest first, arrival order on ties");
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (queue), 4, "oldest first, arrival order on ties");
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (queue), 1, "the freshest last");
+  NS_TEST_EXPECT_MSG_EQ (queue->IsEmpty (), true, "every packet dequeued");
+
+  // StartTime wraps after 65535 s
+  Enqueue (queue, 5, 1, 5);
+  Enqueue (queue, 5, 2, 65530);
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (queue), 2, "the packet from before the wrap is older");
+  Dequeue (queue);
+
+  // sensor 4 of a line: 4 hops to the left gateway, 2 to the right one
+  queue = CreateObject<LwsnPriorityQueue> ();
+  queue->SetAttribute ("Order", EnumValue (LwsnPriorityQueue::ORDER_HOPS));
+  queue->SetPosition (4, 4, 2);
+  Enqueue (queue, 6, 1, 100); // going left
+  Enqueue (queue, 4, 2, 300); // own reading, both ways
+  Enqueue (queue, 1, 3, 200); // going right
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (queue), 3, "two hops to go, the older one");
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (queue), 2, "two hops to go");
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (queue), 1, "four hops to go");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalReceivedPackets (), 3, "the Queue statistics");
+
+  // a copy made from GetItem and Serialize serves in the same order, even
+  // once the sensor has moved
+  Enqueue (queue, 6, 1, 100);
+  Enqueue (queue, 1, 3, 200);
+  Enqueue (queue, 6, 4, 50);
+  queue->MoveToFront (6, 1);
+  std::stringstream ranking;
+  Ptr<LwsnPriorityQueue> copy = CreateObject<LwsnPriorityQueue> ();
+  copy->SetAttribute ("Order", EnumValue (LwsnPriorityQueue::ORDER_HOPS));
+  copy->SetPosition (4, 1, 1);
+  for (uint32_t i = 0; i < queue->GetNPackets (); i++)
+    {
+      copy->Enqueue (Create<QueueItem> (queue->GetItem (i)->GetPacket ()));
+    }
+  queue->Serialize (ranking);
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalReceivedPackets (), 6, "reading the queue enqueues nothing");
+  NS_TEST_ASSERT_MSG_EQ (copy->Deserialize (ranking), true, "the ranking of three packets");
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (copy), 1, "the packet moved to the front");
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (copy), 3, "two hops to go when it arrived");
+  NS_TEST_EXPECT_MSG_EQ (Dequeue (copy), 4, "four hops to go when it arrived");
+}
+
+class LwsnCheckpointTestCase : public TestCase
+{
+public:
+  LwsnCheckpointTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * Add the same random readings to a kernel each time.
+   *
+   * \param kernel a line of 12 sensors
+   */
+  static void AddReadings (LwsnLineKernel &kernel);
+  /**
+   * \param kernel a kernel
+   * \returns every counter of the kernel as text
+   */
+  static std::string Dump (const LwsnLineKernel &kernel);
+};
+
+LwsnCheckpointTestCase::LwsnCheckpointTestCase ()
+  : TestCase ("A restored LwsnLineKernel runs as the one it was saved from")
+{
+}
+
+void
+LwsnCheckpointTestCase::AddReadings (LwsnLineKernel &kernel)
+{
+  kernel.AssignStreams (0);
+  Ptr<UniformRandomVariable> rv = CreateObject<UniformRandomVariable> ();
+  rv->SetStream (100);
+  for (uint32_t i = 0; i < 150; i++)
+    {
+      kernel.AddReading (rv->GetInteger (1, 12), Seconds (rv->GetInteger (0, 300)));
+    }
+}
+
+std::string
+LwsnCheckpointTestCase::Dump (const LwsnLineKernel &kernel)
+{
+  std::ostringstream os;
+  for (uint32_t i = 0; i < kernel.GetNNodes (); i++)
+    {
+      kernel.GetStats (i).PrintJson (os);
+    }
+  os << " " << kernel.GetNActions () << " " << kernel.GetNDelivered () << " " << kernel.GetNow ();
+  return os.str ();
+}
+
+void
+LwsnCheckpointTestCase::DoRun (void)
+{
+  LwsnLineKernel whole (12);
+  AddReadings (whole);
+  whole.Run ();
+
+  LwsnLineKernel first (12);
+  AddReadings (first);
+  first.RunUntil (Seconds (120));
+  std::stringstream checkpoint;
+  first.Save (checkpoint);
+
+  LwsnLineKernel second (12);
+  NS_TEST_ASSERT_MSG_EQ (second.Restore (checkpoint), true, "the checkpoint should load");
+  NS_TEST_EXPECT_MSG_EQ (second.GetNow (), Seconds (120), "the run resumes where it stopped");
+  second.Run ();
+  NS_TEST_EXPECT_MSG_GT (whole.GetNActions (), 0, "the line should be busy");
+  NS_TEST_EXPECT_MSG_EQ (Dump (second), Dump (whole), "the restored run differs");
+
+  LwsnLineKernel other (13);
+  checkpoint.clear ();
+  checkpoint.seekg (0);
+  NS_TEST_EXPECT_MSG_EQ (other.Restore (checkpoint), false, "a line of another size");
+}
+
+/**
+ * A checkpoint of a line of RunLwsnLine, taken by SaveLine and loaded
+ * by RestoreLine.
+ */
+struct LwsnLineCheckpoint
+{
+  std::stringstream stream; //!< the checkpoint
+  bool saved;               //!< LwsnTopologyHelper::Save succeeded
+  bool restored;            //!< LwsnTopologyHelper::Restore succeeded
+  uint64_t pending;         //!< MAC actions pending in the slot scheduler when saved
+  uint32_t queued;          //!< packets waiting in the queues of the line when saved
+  uint32_t enqueued;        //!< packets the queues counted in while saving
+};
+
+/**
+ * Save a line of RunLwsnLine, once the frames of the slot are received.
+ */
+static void
+SaveLine (LwsnLineCheckpoint *checkpoint, NetDeviceContainer devices)
+{
+  uint32_t received = 0;
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      Ptr<Queue> queue = DynamicCast<SimpleNetDevice> (devices.Get (i))->GetQueue ();
+      checkpoint->queued += queue->GetNPackets ();
+      received += queue->GetTotalReceivedPackets ();
+    }
+  checkpoint->saved = LwsnTopologyHelper::Save (devices, checkpoint->stream);
+  for (uint32_t i = 0; i < devices.GetN (); i++)
+    {
+      checkpoint->enqueued += DynamicCast<SimpleNetDevice> (devices.Get (i))->GetQueue ()->GetTotalReceivedPackets ();
+    }
+  checkpoint->enqueued -= received;
+  Ptr<SimpleChannel> channel = DynamicCast<SimpleChannel> (devices.Get (0)->GetChannel ());
+  if (checkpoint->saved)
+    {
+      checkpoint->pending = channel->GetSlotScheduler ()->GetNPending ();
+    }
+}
+
+/**
+ * LoadBusy, with a checkpoint in the middle of the run.
+ */
+static void
+LoadBusyAndSave (LwsnLineCheckpoint *checkpoint, NetDeviceContainer devices)
+{
+  LoadBusy (devices);
+  Simulator::Schedule (Seconds (4.95), &SaveLine, checkpoint, devices);
+}
+
+/**
+ * Resume a line of RunLwsnLine from a checkpoint of SaveLine.
+ */
+static void
+RestoreLine (LwsnLineCheckpoint *checkpoint, NetDeviceContainer devices)
+{
+  checkpoint->restored = LwsnTopologyHelper::Restore (devices, checkpoint->stream);
+}
+
+class LwsnDeviceCheckpointTestCase : public TestCase
+{
+public:
+  LwsnDeviceCheckpointTestCase ();
+  virtual void DoRun (void);
+
+private:
+  /**
+   * \param result a run of RunLwsnLine
+   * \returns every counter of the run as text
+   */
+  static std::string Dump (const LwsnLineResult &result);
+  /**
+   * Save a busy line in the middle of its run, restore it on another
+   * one and compare both with an uninterrupted run.
+   *
+   * \param topology line configuration, with SlotScheduling
+   * \param name the configuration, for the messages
+   */
+  void Check (LwsnTopologyHelper topology, std::string name);
+};
+
+LwsnDeviceCheckpointTestCase::LwsnDeviceCheckpointTestCase ()
+  : TestCase ("A restored line of SimpleNetDevices runs as the one it was saved from")
+{
+}
+
+std::string
+LwsnDeviceCheckpointTestCase::Dump (const LwsnLineResult &result)
+{
+  std::ostringstream os;
+  result.stats.PrintJson (os);
+  os << " " << result.sent << " " << result.retrans << " " << result.collisions << " " << result.gateway1
+     << " " << result.gateway2 << " " << result.delivered;
+  return os.str ();
+}
+
+void
+LwsnDeviceCheckpointTestCase::Check (LwsnTopologyHelper topology, std::string name)
+{
+  LwsnLineResult whole = RunLwsnLine (8, topology, MakeCallback (&LoadBusy));
+
+  LwsnLineCheckpoint checkpoint;
+  checkpoint.saved = false;
+  checkpoint.restored = false;
+  checkpoint.pending = 0;
+  checkpoint.queued = 0;
+  checkpoint.enqueued = 0;
+  LwsnLineResult first = RunLwsnLine (8, topology, MakeBoundCallback (&LoadBusyAndSave, &checkpoint));
+  NS_TEST_ASSERT_MSG_EQ (checkpoint.saved, true, name << ": the line should be saved between two slots");
+  NS_TEST_EXPECT_MSG_GT (checkpoint.pending, 0, name << ": MAC actions should be pending at the checkpoint");
+  NS_TEST_EXPECT_MSG_GT (checkpoint.queued, 0, name << ": packets should be queued at the checkpoint");
+  NS_TEST_EXPECT_MSG_EQ (checkpoint.enqueued, 0, name << ": saving the line enqueued packets");
+  NS_TEST_EXPECT_MSG_EQ (Dump (first), Dump (whole), name << ": saving the line changed its run");
+
+  LwsnLineResult second = RunLwsnLine (8, topology, MakeBoundCallback (&RestoreLine, &checkpoint));
+  NS_TEST_ASSERT_MSG_EQ (checkpoint.restored, true, name << ": the checkpoint should load");
+  NS_TEST_EXPECT_MSG_GT (whole.collisions, 0, name << ": the line should be busy");
+  NS_TEST_EXPECT_MSG_EQ (Dump (second), Dump (whole), name << ": the restored run differs");
+
+  checkpoint.stream.clear ();
+  checkpoint.stream.seekg (0);
+  RunLwsnLine (9, topology, MakeBoundCallback (&RestoreLine, &checkpoint));
+  NS_TEST_EXPECT_MSG_EQ (checkpoint.restored, false, name << ": a line of another size");
+}
+
+void
+LwsnDeviceCheckpointTestCase::DoRun (void)
+{
+  LwsnTopologyHelper topology;
+  topology.SetChannelAttribute ("SlotScheduling", BooleanValue (true));
+  Check (topology, "drop tail");
+  // the queue also saves how it ranks its packets, e.g. those moved to
+  // the front to be dropped
+  topology.SetDeviceAttribute ("TxQueue", StringValue ("ns3::LwsnPriorityQueue[Order=Hops]"));
+  Check (topology, "priority");
+}
+
+class LwsnHopTagTestCase : public TestCase
+{
+public:
+  LwsnHopTagTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnHopTagTestCase::LwsnHopTagTestCase ()
+  : TestCase ("Frames carry their path and the gateway charges each hop")
+{
+}
+
+void
+LwsnHopTagTestCase::DoRun (void)
+{
+  Ptr<Packet> p = Create<Packet> (10);
+  LwsnHopTag::Append (p, 3);
+  LwsnHopTag::Append (p, 3);
+  LwsnHopTag::Append (p, 2);
+  std::vector<LwsnHopTag> path;
+  LwsnHopTag::GetPath (p, path);
+  NS_TEST_ASSERT_MSG_EQ (path.size (), 2, "one record per hop");
+  NS_TEST_EXPECT_MSG_EQ (path[0].GetSid (), 3, "the origin comes first");
+  NS_TEST_EXPECT_MSG_EQ (path[0].GetRetries (), 1, "the second send of the origin is a retry");
+  NS_TEST_EXPECT_MSG_EQ (path[1].GetRetries (), 0, "the relay sent once");
+  LwsnHopStats partial;
+  partial.NotifyDelivery (p, 4, Seconds (0));
+  NS_TEST_EXPECT_MSG_EQ (partial.GetNPartial (), 1, "the path does not start at Osid 4");
+  NS_TEST_EXPECT_MSG_EQ (LwsnHopStats::GetDelayBin (MilliSeconds (1500)), 11, "1.5 s is below 2048 ms");
+
+  // sensor 2 sends towards the nearer gateway, through sensor 1
+  LwsnTopologyHelper topology;
+  topology.SetDeviceAttribute ("Routing", EnumValue (SimpleNetDevice::ROUTING_NEAREST));
+  topology.SetDeviceAttribute ("RecordHops", BooleanValue (true));
+  NetDeviceContainer devices = topology.Install (6);
+  Simulator::Schedule (Seconds (0), &SimpleNetDevice::OriginalTransmission,
+                       DynamicCast<SimpleNetDevice> (devices.Get (2)), Create<Packet> (100), 0, false);
+  Simulator::Run ();
+  LwsnHopStats stats = DynamicCast<SimpleNetDevice> (devices.Get (0))->GetHopStats ();
+  Simulator::Destroy ();
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNPaths (), 1, "the reading should arrive with its path");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNPartial (), 0, "nothing coded on this line");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNHops (2), 1, "the origin is charged");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNHops (1), 1, "the relay is charged");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNHops (3), 0, "sensor 3 is off the path");
+  NS_TEST_EXPECT_MSG_EQ (stats.GetNRetries (1, 0), 1, "nothing lost on a quiet line");
+  NS_TEST_EXPECT_MSG_GT (stats.GetMeanDelay (1), Seconds (0), "the relay holds the reading for its reception");
+}
+
+class LwsnSlotTimingTestCase : public TestCase
+{
+public:
+  LwsnSlotTimingTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnSlotTimingTestCase::LwsnSlotTimingTestCase ()
+  : TestCase ("The MAC runs on the slots of its LwsnSlotTiming")
+{
+}
+
+void
+LwsnSlotTimingTestCase::DoRun (void)
+{
+  Ptr<LwsnSlotTiming> timing = CreateObject<LwsnSlotTiming> ();
+  NS_TEST_EXPECT_MSG_EQ (timing->GetAirtime (100), MilliSeconds (900), "a frame fills the slot up to the guard");
+  NS_TEST_EXPECT_MSG_EQ (timing->GetReplyDelay (100), MilliSeconds (100), "replies start the next slot");
+  NS_TEST_EXPECT_MSG_EQ (timing->GetAckOffset (), Seconds (1), "the second reply waits a slot");
+  timing->SetAttribute ("DataRate", DataRateValue (DataRate ("8kbps")));
+  NS_TEST_EXPECT_MSG_EQ (timing->GetAirtime (100), MilliSeconds (100), "100 bytes at 8 kb/s");
+  NS_TEST_EXPECT_MSG_EQ (timing->GetReplyDelay (100), MilliSeconds (900), "replies still start the next slot");
+  NS_TEST_EXPECT_MSG_EQ (timing->GetReplyDelay (100, MilliSeconds (50)), MilliSeconds (850),
+                         "the propagation delay is taken out of the reply delay");
+
+  // the slot scheduler runs on the grid of the slot timing of its channel
+  Ptr<LwsnSlotScheduler> scheduler = CreateObject<LwsnSlotScheduler> ();
+  scheduler->SetSlotTiming (timing);
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetGrid (), MilliSeconds (100), "slots of 1 s with a guard of 100 ms");
+  timing->SetAttribute ("SlotLength", TimeValue (MilliSeconds (10)));
+  timing->SetAttribute ("Guard", TimeValue (MicroSeconds (1500)));
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetGrid (), MicroSeconds (500), "slots of 10 ms with a guard of 1.5 ms");
+  scheduler->SetAttribute ("SlotLength", TimeValue (MilliSeconds (5)));
+  NS_TEST_EXPECT_MSG_EQ (scheduler->GetGrid (), MilliSeconds (5), "the attribute overrides the slot timing");
+  scheduler->Dispose ();
+
+  // one reading from the third sensor of a line of six
+  LwsnTopologyHelper topology;
+  LwsnMacStats seconds = RunLwsnLine (6, topology, MakeBoundCallback (&LoadReading, 2)).stats;
+  topology.SetChannelAttribute ("SlotTiming", StringValue ("ns3::LwsnSlotTiming[SlotLength=10ms|Guard=1ms|DataRate=250kbps]"));
+  LwsnMacStats milliseconds = RunLwsnLine (6, topology, MakeBoundCallback (&LoadReading, 2)).stats;
+  NS_TEST_EXPECT_MSG_EQ (seconds.GetNDelivered (), 2, "the reading should reach both gateways");
+  NS_TEST_ASSERT_MSG_EQ (milliseconds.GetNDelivered (), 2, "the reading should reach both gateways");
+  NS_TEST_EXPECT_MSG_LT (milliseconds.GetFlows ().begin ()->second.GetMax (), Seconds (1),
+                         "three hops of 10 ms slots");
+
+  // the millisecond slots are run by the slot scheduler too
+  topology.SetChannelAttribute ("SlotScheduling", BooleanValue (true));
+  LwsnLineResult slots = RunLwsnLine (6, topology, MakeBoundCallback (&LoadReading, 2));
+  NS_TEST_EXPECT_MSG_GT (slots.slotActions, 0, "the MAC timers should be on the grid of the slot timing");
+  NS_TEST_EXPECT_MSG_EQ (slots.stats.GetNDelivered (), 2, "the reading should reach both gateways");
+  NS_TEST_EXPECT_MSG_EQ (slots.stats.GetFlows ().begin ()->second.GetMax (),
+                         milliseconds.GetFlows ().begin ()->second.GetMax (), "the slot scheduler changed the run");
+
+  // the frames arrive later, and the replies still leave on the slot
+  LwsnTopologyHelper delayed;
+  delayed.SetChannelAttribute ("Delay", TimeValue (MilliSeconds (50)));
+  LwsnMacStats late = RunLwsnLine (6, delayed, MakeBoundCallback (&LoadReading, 2)).stats;
+  NS_TEST_ASSERT_MSG_EQ (late.GetNDelivered (), 2, "the reading should reach both gateways");
+  NS_TEST_EXPECT_MSG_EQ (late.GetFlows ().begin ()->second.GetMax (),
+                         seconds.GetFlows ().begin ()->second.GetMax () + MilliSeconds (50),
+                         "the delay should be paid once, not at every hop");
+}
+
+class LwsnAggregateTestCase : public TestCase
+{
+public:
+  LwsnAggregateTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnAggregateTestCase::LwsnAggregateTestCase ()
+  : TestCase ("Readings bundled in an AGGREGATE frame come out whole")
+{
+}
+
+void
+LwsnAggregateTestCase::DoRun (void)
+{
+  std::vector<Ptr<Packet> > frames;
+  for (uint16_t i = 0; i < 3; i++)
+    {
+      Ptr<Packet> p = CreateLwsnPacket (4 + i, 10 + i);
+      p->AddPacketTag (LwsnTimestampTag (Seconds (i + 1)));
+      frames.push_back (p);
+    }
+  Ptr<Packet> aggregate = LwsnAggregate::Build (frames, 3, false);
+  LwsnHeader header;
+  aggregate->PeekHeader (header);
+  NS_TEST_EXPECT_MSG_EQ (header.GetType (), LwsnHeader::AGGREGATE, "wrong frame type");
+  NS_TEST_EXPECT_MSG_EQ (header.GetE (), 3, "E counts the readings");
+  NS_TEST_EXPECT_MSG_EQ (header.GetOsid (), 4, "the aggregate is named after its first reading");
+  NS_TEST_EXPECT_MSG_EQ (aggregate->GetSize (), header.GetSerializedSize () + 3 * LwsnAggregate::GetFrameSize (frames[0]),
+                         "one subframe header per reading");
+
+  std::vector<Ptr<Packet> > split;
+  NS_TEST_ASSERT_MSG_EQ (LwsnAggregate::Split (aggregate, split), true, "a whole aggregate should split");
+  NS_TEST_ASSERT_MSG_EQ (split.size (), 3, "one frame per reading");
+  for (uint16_t i = 0; i < 3; i++)
+    {
+      LwsnHeader bundled;
+      split[i]->PeekHeader (bundled);
+      NS_TEST_EXPECT_MSG_EQ (bundled.GetOsid (), 4 + i, "the readings keep their order");
+      NS_TEST_EXPECT_MSG_EQ (split[i]->GetSize (), frames[i]->GetSize (), "the reading lost bytes");
+      LwsnTimestampTag timestamp;
+      NS_TEST_EXPECT_MSG_EQ (split[i]->PeekPacketTag (timestamp), true, "the origin time should survive");
+      NS_TEST_EXPECT_MSG_EQ (timestamp.GetOrigin (), Seconds (i + 1), "wrong origin time");
+    }
+  Ptr<Packet> truncated = aggregate->CreateFragment (0, aggregate->GetSize () - 1);
+  NS_TEST_EXPECT_MSG_EQ (LwsnAggregate::Split (truncated, split), false, "a truncated aggregate should not split");
+
+  Ptr<Packet> blockack = LwsnAggregate::BuildBlockAck (header, 2, 5);
+  LwsnHeader ackheader;
+  blockack->PeekHeader (ackheader);
+  NS_TEST_EXPECT_MSG_EQ (ackheader.GetType (), LwsnHeader::BLOCK_ACK, "wrong frame type");
+  NS_TEST_EXPECT_MSG_EQ (ackheader.GetE (), 5, "E carries the bitmap");
+  NS_TEST_EXPECT_MSG_EQ (ackheader.GetDid (), header.GetDid (), "the BLOCK_ACK names the aggregate");
+
+  Ptr<LwsnSlotTiming> timing = CreateObject<LwsnSlotTiming> ();
+  timing->SetAttribute ("DataRate", DataRateValue (DataRate ("8kbps")));
+  NS_TEST_EXPECT_MSG_EQ (timing->GetMaxBytes (), 900, "900 ms at 8 kb/s");
+
+  // sensor 2 relays a burst of readings to the left gateway through
+  // sensor 1, which acknowledges each AGGREGATE frame with a BLOCK_ACK
+  LwsnTopologyHelper topology;
+  topology.SetDeviceAttribute ("Aggregation", UintegerValue (4));
+  LwsnLineResult burst = RunLwsnLine (6, topology, MakeBoundCallback (&LoadBurst, 2));
+  NS_TEST_EXPECT_MSG_GT (burst.stats.GetNTx (LwsnHeader::AGGREGATE), 0, "the queued readings should be bundled");
+  NS_TEST_EXPECT_MSG_GT (burst.stats.GetNTx (LwsnHeader::BLOCK_ACK), 0, "the relay should send a BLOCK_ACK");
+  NS_TEST_EXPECT_MSG_GT (burst.stats.GetNAggregated (), burst.stats.GetNTx (LwsnHeader::AGGREGATE),
+                         "an AGGREGATE frame carries several readings");
+  NS_TEST_EXPECT_MSG_EQ (burst.delivered, 8, "every reading of the burst should be delivered");
+}
+
+class LwsnProfilerTestCase : public TestCase
+{
+public:
+  LwsnProfilerTestCase ();
+  virtual void DoRun (void);
+};
+
+LwsnProfilerTestCase::LwsnProfilerTestCase ()
+  : TestCase ("The profiler counts handler calls and samples the pending MAC actions")
+{
+}
+
+void
+LwsnProfilerTestCase::DoRun (void)
+{
+  // called directly, as the LWSN_PROFILE macros are only compiled in
+  // with --enable-lwsn-profile
+  LwsnProfiler &profiler = LwsnProfiler::Get ();
+  profiler.Reset ();
+  profiler.Record (LwsnProfiler::AGGREGATE_SEND, LwsnHeader::AGGREGATE, 100);
+  profiler.Record (LwsnProfiler::AGGREGATE_SEND, LwsnHeader::AGGREGATE, 100);
+  profiler.Record (LwsnProfiler::RECEIVE_FRAME, LwsnProfiler::N_TYPES + 3, 10);
+  NS_TEST_EXPECT_MSG_EQ (profiler.GetNCalls (LwsnProfiler::AGGREGATE_SEND), 2, "wrong call count");
+  NS_TEST_EXPECT_MSG_EQ (profiler.GetNCalls (LwsnProfiler::CODED_SEND), 0, "CodedSend did not run");
+  NS_TEST_EXPECT_MSG_EQ (std::string (LwsnProfiler::GetHandlerName (LwsnProfiler::RECEIVE_AGGREGATE)),
+                         "ReceiveAggregate", "wrong handler name");
+
+  // two actions left to the simulator count in the depth until they run
+  profiler.SetDepthInterval (1.0);
+  profiler.RecordDefer ();
+  profiler.RecordDefer ();
+  Simulator::Schedule (Seconds (0), &LwsnProfiler::RecordDepth, &profiler, 3);
+  Simulator::Schedule (Seconds (0.5), &LwsnProfiler::RecordDepth, &profiler, 5);
+  Simulator::Schedule (Seconds (1.5), &LwsnProfiler::RecordDepth, &profiler, 2);
+  Simulator::Schedule (Seconds (2), &LwsnProfiler::RecordDeferredRun, &profiler);
+  Simulator::Schedule (Seconds (3.5), &LwsnProfiler::RecordDeferredRun, &profiler);
+  Simulator::Run ();
+
+  std::ostringstream depth;
+  profiler.PrintDepth (depth);
+  NS_TEST_EXPECT_MSG_EQ (depth.str (), "0,3\n1.5,2\n3.5,1\n", "one sample per DepthInterval");
+  std::ostringstream summary;
+  profiler.Print (summary);
+  NS_TEST_EXPECT_MSG_NE (summary.str ().find ("AggregateSend"), std::string::npos, "the handlers should be listed");
+  NS_TEST_EXPECT_MSG_NE (summary.str ().find ("max 5, mean 2.6 over 5 samples"), std::string::npos,
+                         "every depth counts in the summary");
+  NS_TEST_EXPECT_MSG_NE (summary.str ().find ("profiler overhead"), std::string::npos,
+                         "the overhead estimate should be printed");
+
+  profiler.Reset ();
+  NS_TEST_EXPECT_MSG_EQ (profiler.GetNCalls (LwsnProfiler::AGGREGATE_SEND), 0, "Reset should clear the calls");
+  depth.str ("");
+  profiler.PrintDepth (depth);
+  NS_TEST_EXPECT_MSG_EQ (depth.str (), "", "Reset should clear the depth samples");
+  profiler.SetDepthInterval (60.0);
+  Simulator::Destroy ();
+}
+
+static class LwsnTestSuite : public TestSuite
+{
+public:
+  LwsnTestSuite ()
+    : TestSuite ("lwsn", UNIT)
+  {
+    AddTestCase (new LwsnQueueCheckTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnNeighbourDeliveryTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnSlotSchedulerTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnBackoffStreamTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnMacStatsTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnLatencyHistogramTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnTopologyHelperTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnLineKernelTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnParallelLinesTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnInterferenceTrackerTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnTrafficApplicationTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnMacTraceTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnRadioEnergyTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnBackoffPolicyTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnImplicitAckTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnNetworkCodingTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnRoutingTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnPriorityQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnCheckpointTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnDeviceCheckpointTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnHopTagTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnSlotTimingTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnAggregateTestCase (), TestCase::QUICK);
+    AddTestCase (new LwsnProfilerTestCase (), TestCase::QUICK);
+  }
+} g_lwsnTestSuite;
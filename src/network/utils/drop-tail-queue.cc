@@ -53,7 +53,7 @@ DropTailQueue::DoEnqueue (Ptr<QueueItem> item)
   NS_LOG_FUNCTION (this << item);
   NS_ASSERT (m_packets.size () == GetNPackets ());
 
-  m_packets.push (item);
+  m_packets.push_back (item);
 
   return true;
 }
@@ -65,7 +65,7 @@ DropTailQueue::DoDequeue (void)
   NS_ASSERT (m_packets.size () == GetNPackets ());
 
   Ptr<QueueItem> item = m_packets.front ();
-  m_packets.pop ();
+  m_packets.pop_front ();
 
   NS_LOG_LOGIC ("Popped " << item);
 
@@ -79,7 +79,7 @@ DropTailQueue::DoRemove (void)
   NS_ASSERT (m_packets.size () == GetNPackets ());
 
   Ptr<QueueItem> item = m_packets.front ();
-  m_packets.pop ();
+  m_packets.pop_front ();
 
   NS_LOG_LOGIC ("Removed " << item);
 
@@ -95,5 +95,14 @@ DropTailQueue::DoPeek (void) const
   return m_packets.front ();
 }
 
+Ptr<const QueueItem>
+DropTailQueue::GetItem (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (i < m_packets.size ());
+
+  return m_packets[i];
+}
+
 } // namespace ns3
 
@@ -19,7 +19,7 @@
 #ifndef DROPTAIL_H
 #define DROPTAIL_H
 
-#include <queue>
+#include <deque>
 #include "ns3/queue.h"
 
 namespace ns3 {
@@ -46,13 +46,21 @@ public:
 
   virtual ~DropTailQueue();
 
+  /**
+   * Read a waiting packet without dequeuing it, e.g. to save the queue.
+   *
+   * \param i position in the queue, 0 for the head, below GetNPackets
+   * \returns the item at that position
+   */
+  Ptr<const QueueItem> GetItem (uint32_t i) const;
+
 private:
   virtual bool DoEnqueue (Ptr<QueueItem> item);
   virtual Ptr<QueueItem> DoDequeue (void);
   virtual Ptr<QueueItem> DoRemove (void);
   virtual Ptr<const QueueItem> DoPeek (void) const;
 
-  std::queue<Ptr<QueueItem> > m_packets; //!< the items in the queue
+  std::deque<Ptr<QueueItem> > m_packets; //!< the items in the queue
 };
 
 } // namespace ns3
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-aggregate.h"
+#include "lwsn-timestamp-tag.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnAggregate");
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnSubframeHeader);
+
+TypeId
+LwsnSubframeHeader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnSubframeHeader")
+    .SetParent<Header> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnSubframeHeader> ()
+  ;
+  return tid;
+}
+TypeId
+LwsnSubframeHeader::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+void
+LwsnSubframeHeader::Print (std::ostream &os) const
+{
+  os << "Length=" << m_length;
+}
+void
+LwsnSubframeHeader::Serialize (Buffer::Iterator start) const
+{
+  start.WriteHtonU16 (m_length);
+}
+uint32_t
+LwsnSubframeHeader::Deserialize (Buffer::Iterator start)
+{
+  m_length = start.ReadNtohU16 ();
+  return 2;
+}
+uint32_t
+LwsnSubframeHeader::GetSerializedSize (void) const
+{
+  return 2;
+}
+LwsnSubframeHeader::LwsnSubframeHeader ()
+  : m_length (0)
+{
+}
+
+void
+LwsnSubframeHeader::SetLength (uint16_t length)
+{
+  m_length = length;
+}
+uint16_t
+LwsnSubframeHeader::GetLength (void) const
+{
+  return m_length;
+}
+
+namespace {
+
+/**
+ * \param p a packet
+ * \param timestamp set to the first LwsnTimestampTag byte tag of p
+ * \returns true if p has one
+ */
+bool
+PeekTimestampByteTag (Ptr<const Packet> p, LwsnTimestampTag &timestamp)
+{
+  ByteTagIterator i = p->GetByteTagIterator ();
+  while (i.HasNext ())
+    {
+      ByteTagIterator::Item item = i.Next ();
+      if (item.GetTypeId () == LwsnTimestampTag::GetTypeId ())
+        {
+          item.GetTag (timestamp);
+          return true;
+        }
+    }
+  return false;
+}
+
+} // anonymous namespace
+
+const uint32_t LwsnAggregate::MAX_FRAMES;
+
+Ptr<Packet>
+LwsnAggregate::Build (const std::vector<Ptr<Packet> > &frames, uint16_t psid, bool retransmission)
+{
+  NS_ASSERT (!frames.empty () && frames.size () <= MAX_FRAMES);
+  Ptr<Packet> aggregate = Create<Packet> ();
+  for (std::vector<Ptr<Packet> >::const_iterator i = frames.begin (); i != frames.end (); ++i)
+    {
+      Ptr<Packet> frame = (*i)->Copy ();
+      LwsnTimestampTag timestamp;
+      // a reading bundled again keeps the byte tag of its first bundle
+      if (frame->PeekPacketTag (timestamp) && !PeekTimestampByteTag (frame, timestamp))
+        {
+          frame->AddByteTag (timestamp);
+        }
+      NS_ASSERT (frame->GetSize () <= 0xffff);
+      LwsnSubframeHeader subframe;
+      subframe.SetLength (frame->GetSize ());
+      frame->AddHeader (subframe);
+      aggregate->AddAtEnd (frame);
+    }
+
+  LwsnHeader first;
+  frames.front ()->PeekHeader (first);
+  LwsnHeader header;
+  header.SetType (LwsnHeader::AGGREGATE);
+  header.SetOsid (first.GetOsid ());
+  header.SetPsid (psid);
+  header.SetE (frames.size ());
+  header.SetR (retransmission ? 1 : 0);
+  header.SetDid (first.GetDid ());
+  header.SetStartTime (first.GetStartTime ());
+  aggregate->AddHeader (header);
+  return aggregate;
+}
+
+bool
+LwsnAggregate::Split (Ptr<const Packet> aggregate, std::vector<Ptr<Packet> > &frames)
+{
+  frames.clear ();
+  Ptr<Packet> p = aggregate->Copy ();
+  LwsnHeader header;
+  p->RemoveHeader (header);
+  NS_ASSERT (header.GetType () == LwsnHeader::AGGREGATE);
+  LwsnSubframeHeader subframe;
+  while (p->GetSize () > 0)
+    {
+      if (p->GetSize () < subframe.GetSerializedSize ())
+        {
+          return false;
+        }
+      p->RemoveHeader (subframe);
+      if (subframe.GetLength () > p->GetSize ())
+        {
+          NS_LOG_WARN ("truncated AGGREGATE frame from " << header.GetPsid ());
+          return false;
+        }
+      Ptr<Packet> frame = p->CreateFragment (0, subframe.GetLength ());
+      p->RemoveAtStart (subframe.GetLength ());
+      LwsnTimestampTag timestamp;
+      if (PeekTimestampByteTag (frame, timestamp))
+        {
+          frame->ReplacePacketTag (timestamp);
+        }
+      frames.push_back (frame);
+    }
+  return frames.size () == header.GetE ();
+}
+
+Ptr<Packet>
+LwsnAggregate::BuildBlockAck (const LwsnHeader &header, uint16_t psid, uint16_t bitmap)
+{
+  LwsnHeader ackheader;
+  ackheader.SetType (LwsnHeader::BLOCK_ACK);
+  ackheader.SetOsid (header.GetOsid ());
+  ackheader.SetPsid (psid);
+  ackheader.SetE (bitmap);
+  ackheader.SetR (0);
+  ackheader.SetDid (header.GetDid ());
+  ackheader.SetStartTime (header.GetStartTime ());
+  Ptr<Packet> blockack = Create<Packet> ();
+  blockack->AddHeader (ackheader);
+  return blockack;
+}
+
+uint32_t
+LwsnAggregate::GetFrameSize (Ptr<const Packet> frame)
+{
+  return frame->GetSize () + LwsnSubframeHeader ().GetSerializedSize ();
+}
+
+} // namespace ns3
@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_AGGREGATE_H
+#define LWSN_AGGREGATE_H
+
+#include <stdint.h>
+#include <vector>
+#include "ns3/header.h"
+#include "ns3/ptr.h"
+#include "ns3/lwsn-header.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * \brief Length of one frame bundled in an LWSN AGGREGATE frame.
+ */
+class LwsnSubframeHeader : public Header
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual void Print (std::ostream &os) const;
+  virtual void Serialize (Buffer::Iterator start) const;
+  virtual uint32_t Deserialize (Buffer::Iterator start);
+  virtual uint32_t GetSerializedSize (void) const;
+  LwsnSubframeHeader ();
+
+  /**
+   * \param length size of the frame that follows, header included
+   */
+  void SetLength (uint16_t length);
+  /// \returns the size of the frame that follows, header included
+  uint16_t GetLength (void) const;
+
+private:
+  uint16_t m_length; //!< size of the frame that follows
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Payload of an LWSN AGGREGATE frame.
+ *
+ * A relay with several readings queued for the same neighbour sends
+ * them in one AGGREGATE frame.  Its LwsnHeader takes the Osid, Did and
+ * StartTime of the first reading and the number of readings in E; the
+ * payload is the frame of each reading, LwsnHeader included, behind a
+ * LwsnSubframeHeader.  The next hop answers with one BLOCK_ACK frame
+ * whose Osid and Did name the aggregate and whose E is a bitmap of the
+ * readings it took, bit i for the i-th one.  E is 16 bits wide, hence
+ * MAX_FRAMES.
+ *
+ * The origin time of each reading rides along as a LwsnTimestampTag
+ * byte tag over its frame, since the packet tags of a frame do not
+ * survive the bundling; Split turns it back into a packet tag.
+ */
+class LwsnAggregate
+{
+public:
+  /// Most readings in one AGGREGATE frame
+  static const uint32_t MAX_FRAMES = 16;
+
+  /**
+   * \param frames the frames to bundle, each starting with its LwsnHeader
+   * \param psid Sid of the sender
+   * \param retransmission true if the frames were sent before
+   * \returns the AGGREGATE frame, LwsnHeader included
+   */
+  static Ptr<Packet> Build (const std::vector<Ptr<Packet> > &frames, uint16_t psid, bool retransmission);
+  /**
+   * \param aggregate an AGGREGATE frame, LwsnHeader included
+   * \param frames set to the frames it holds, in order
+   * \returns false if the frame is truncated or does not hold E frames
+   */
+  static bool Split (Ptr<const Packet> aggregate, std::vector<Ptr<Packet> > &frames);
+  /**
+   * \param header the LwsnHeader of the AGGREGATE frame acknowledged
+   * \param psid Sid of the sender of the BLOCK_ACK
+   * \param bitmap bit i set for the i-th reading taken
+   * \returns the BLOCK_ACK frame
+   */
+  static Ptr<Packet> BuildBlockAck (const LwsnHeader &header, uint16_t psid, uint16_t bitmap);
+  /**
+   * \param frame a frame, LwsnHeader included
+   * \returns the bytes it adds to an AGGREGATE frame
+   */
+  static uint32_t GetFrameSize (Ptr<const Packet> frame);
+};
+
+} // namespace ns3
+
+#endif /* LWSN_AGGREGATE_H */
@@ -0,0 +1,287 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-backoff-policy.h"
+#include "lwsn-checkpoint.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnBackoffPolicy");
+
+namespace {
+
+/**
+ * \param attempt number of failed attempts, from 1
+ * \returns the binary exponential window 2^attempt - 1
+ */
+uint32_t
+GetExponentialWindow (uint32_t attempt)
+{
+  return attempt < 32 ? (1u << attempt) - 1 : 0xffffffffu;
+}
+
+} // anonymous namespace
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnBackoffPolicy);
+
+TypeId
+LwsnBackoffPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnBackoffPolicy")
+    .SetParent<Object> ()
+    .SetGroupName ("Network")
+  ;
+  return tid;
+}
+
+LwsnBackoffPolicy::LwsnBackoffPolicy ()
+  : m_gatewayHops (0),
+    m_draws (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_rv = CreateObject<UniformRandomVariable> ();
+}
+
+LwsnBackoffPolicy::~LwsnBackoffPolicy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LwsnBackoffPolicy::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_rv = 0;
+  Object::DoDispose ();
+}
+
+LwsnBackoff
+LwsnBackoffPolicy::Next (uint32_t attempt, uint32_t maxRounds)
+{
+  LwsnBackoff backoff;
+  backoff.giveUp = attempt > maxRounds;
+  backoff.slots = 0;
+  if (!backoff.giveUp)
+    {
+      backoff.slots = m_rv->GetInteger (0, GetWindow (attempt));
+      m_draws++;
+    }
+  NS_LOG_LOGIC ("attempt " << attempt << "/" << maxRounds << ": "
+                << (backoff.giveUp ? "give up" : "wait ") << backoff.slots);
+  return backoff;
+}
+
+void
+LwsnBackoffPolicy::SetGatewayHops (uint16_t hops)
+{
+  NS_LOG_FUNCTION (this << hops);
+  m_gatewayHops = hops;
+}
+
+uint16_t
+LwsnBackoffPolicy::GetGatewayHops (void) const
+{
+  return m_gatewayHops;
+}
+
+void
+LwsnBackoffPolicy::NotifyReception (bool collided)
+{
+}
+
+int64_t
+LwsnBackoffPolicy::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_rv->SetStream (stream);
+  m_draws = 0;
+  return 1;
+}
+
+void
+LwsnBackoffPolicy::Serialize (std::ostream &os) const
+{
+  NS_ABORT_MSG_IF (m_rv->GetStream () < 0, "Serialize needs the backoff stream fixed by AssignStreams");
+  LwsnCheckpoint::Write (os, m_rv->GetStream ());
+  LwsnCheckpoint::Write (os, m_draws);
+}
+
+bool
+LwsnBackoffPolicy::Deserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this);
+  int64_t stream;
+  uint64_t draws;
+  if (!LwsnCheckpoint::Read (is, stream) || stream < 0
+      || !LwsnCheckpoint::Read (is, draws))
+    {
+      return false;
+    }
+  // a stream is only known by its index: replay the draws already made
+  m_rv->SetStream (stream);
+  for (m_draws = 0; m_draws < draws; m_draws++)
+    {
+      m_rv->GetValue ();
+    }
+  return true;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnExponentialBackoffPolicy);
+
+TypeId
+LwsnExponentialBackoffPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnExponentialBackoffPolicy")
+    .SetParent<LwsnBackoffPolicy> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnExponentialBackoffPolicy> ()
+  ;
+  return tid;
+}
+
+LwsnExponentialBackoffPolicy::LwsnExponentialBackoffPolicy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+LwsnExponentialBackoffPolicy::GetWindow (uint32_t attempt) const
+{
+  return GetExponentialWindow (attempt);
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnLinearBackoffPolicy);
+
+TypeId
+LwsnLinearBackoffPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnLinearBackoffPolicy")
+    .SetParent<LwsnBackoffPolicy> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnLinearBackoffPolicy> ()
+    .AddAttribute ("Slope",
+                   "Growth of the backoff window per failed attempt, in slots.",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&LwsnLinearBackoffPolicy::m_slope),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+LwsnLinearBackoffPolicy::LwsnLinearBackoffPolicy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+LwsnLinearBackoffPolicy::GetWindow (uint32_t attempt) const
+{
+  uint64_t window = static_cast<uint64_t> (m_slope) * attempt;
+  return window < 0xffffffffu ? window : 0xffffffffu;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnPositionBackoffPolicy);
+
+TypeId
+LwsnPositionBackoffPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnPositionBackoffPolicy")
+    .SetParent<LwsnBackoffPolicy> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnPositionBackoffPolicy> ()
+    .AddAttribute ("Horizon",
+                   "Distance to the nearest gateway, in hops, from which the "
+                   "full exponential window is used.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&LwsnPositionBackoffPolicy::m_horizon),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+  return tid;
+}
+
+LwsnPositionBackoffPolicy::LwsnPositionBackoffPolicy ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+uint32_t
+LwsnPositionBackoffPolicy::GetWindow (uint32_t attempt) const
+{
+  uint64_t window = GetExponentialWindow (attempt);
+  uint32_t hops = GetGatewayHops ();
+  if (hops == 0 || hops >= m_horizon)
+    {
+      return window;
+    }
+  return (window * hops + m_horizon - 1) / m_horizon;
+}
+
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnAdaptiveBackoffPolicy);
+
+TypeId
+LwsnAdaptiveBackoffPolicy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnAdaptiveBackoffPolicy")
+    .SetParent<LwsnBackoffPolicy> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnAdaptiveBackoffPolicy> ()
+    .AddAttribute ("Weight",
+                   "Weight of the newest reception in the average collision rate.",
+                   DoubleValue (0.1),
+                   MakeDoubleAccessor (&LwsnAdaptiveBackoffPolicy::m_weight),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("MinWindow",
+                   "Smallest backoff window, in slots.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&LwsnAdaptiveBackoffPolicy::m_minWindow),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+LwsnAdaptiveBackoffPolicy::LwsnAdaptiveBackoffPolicy ()
+  : m_collisionRate (1.0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LwsnAdaptiveBackoffPolicy::NotifyReception (bool collided)
+{
+  m_collisionRate += m_weight * ((collided ? 1.0 : 0.0) - m_collisionRate);
+}
+
+double
+LwsnAdaptiveBackoffPolicy::GetCollisionRate (void) const
+{
+  return m_collisionRate;
+}
+
+void
+LwsnAdaptiveBackoffPolicy::Serialize (std::ostream &os) const
+{
+  LwsnBackoffPolicy::Serialize (os);
+  LwsnCheckpoint::Write (os, m_collisionRate);
+}
+
+bool
+LwsnAdaptiveBackoffPolicy::Deserialize (std::istream &is)
+{
+  return LwsnBackoffPolicy::Deserialize (is) && LwsnCheckpoint::Read (is, m_collisionRate);
+}
+
+uint32_t
+LwsnAdaptiveBackoffPolicy::GetWindow (uint32_t attempt) const
+{
+  double window = std::ceil (GetExponentialWindow (attempt) * m_collisionRate);
+  return window > m_minWindow ? static_cast<uint32_t> (window) : m_minWindow;
+}
+
+} // namespace ns3
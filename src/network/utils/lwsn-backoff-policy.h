@@ -0,0 +1,219 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_BACKOFF_POLICY_H
+#define LWSN_BACKOFF_POLICY_H
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include "ns3/object.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * Outcome of a backoff draw: either wait some slots and retransmit,
+ * or give the frame up.
+ */
+struct LwsnBackoff
+{
+  bool giveUp;    //!< no more attempts: drop the frame
+  uint32_t slots; //!< slots to wait before the retransmission
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Retransmission backoff of a LWSN SimpleNetDevice.
+ *
+ * After the a-th failed attempt of a frame the device calls Next.  A
+ * frame is given up once its attempts exceed the Round attribute of the
+ * device; otherwise the backoff is drawn uniformly from [0, window],
+ * where the window is chosen by the subclass.  Each device owns its
+ * policy, set through its BackoffPolicy attribute.
+ */
+class LwsnBackoffPolicy : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LwsnBackoffPolicy ();
+  virtual ~LwsnBackoffPolicy ();
+
+  /**
+   * \param attempt number of failed attempts of the frame, from 1
+   * \param maxRounds attempts allowed before the frame is dropped
+   * \returns the backoff to apply
+   */
+  LwsnBackoff Next (uint32_t attempt, uint32_t maxRounds);
+
+  /**
+   * \param hops distance of the device to the nearest gateway, 0 if
+   * unknown
+   */
+  void SetGatewayHops (uint16_t hops);
+  /// \returns the distance to the nearest gateway, 0 if unknown
+  uint16_t GetGatewayHops (void) const;
+
+  /**
+   * A reception addressed to the device has ended.
+   *
+   * \param collided true if it was lost to an overlapping one
+   */
+  virtual void NotifyReception (bool collided);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * Write the stream index and the number of draws made so far as
+   * LwsnCheckpoint fields, with the state of the policy if it has any.
+   * The stream must have been fixed with AssignStreams.
+   *
+   * \param os output stream
+   */
+  virtual void Serialize (std::ostream &os) const;
+  /**
+   * Move the stream to the position written by Serialize, replaying the
+   * draws already made.  The RngSeedManager seed and run must be those
+   * of the saved policy.
+   *
+   * \param is input stream
+   * \returns false if it does not hold a policy written by Serialize
+   */
+  virtual bool Deserialize (std::istream &is);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * \param attempt number of failed attempts of the frame, from 1
+   * \returns the largest backoff that may be drawn, in slots
+   */
+  virtual uint32_t GetWindow (uint32_t attempt) const = 0;
+
+  uint16_t m_gatewayHops;          //!< distance to the nearest gateway
+  Ptr<UniformRandomVariable> m_rv; //!< backoff draws
+  uint64_t m_draws;                //!< draws made from m_rv
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Binary exponential backoff: window 2^a - 1.
+ *
+ * This is the historical backoff of SimpleNetDevice and the default.
+ */
+class LwsnExponentialBackoffPolicy : public LwsnBackoffPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LwsnExponentialBackoffPolicy ();
+
+private:
+  virtual uint32_t GetWindow (uint32_t attempt) const;
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Linear backoff: window Slope * a.
+ */
+class LwsnLinearBackoffPolicy : public LwsnBackoffPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LwsnLinearBackoffPolicy ();
+
+private:
+  virtual uint32_t GetWindow (uint32_t attempt) const;
+
+  uint32_t m_slope; //!< window growth per attempt, in slots
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Exponential backoff shortened near the gateways.
+ *
+ * The 2^a - 1 window is scaled by min (hops, Horizon) / Horizon, rounded
+ * up, so the sensors next to a gateway, which carry the traffic of the
+ * whole segment, retry sooner than the ones far away.  A device whose
+ * distance is unknown uses the full window.
+ */
+class LwsnPositionBackoffPolicy : public LwsnBackoffPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LwsnPositionBackoffPolicy ();
+
+private:
+  virtual uint32_t GetWindow (uint32_t attempt) const;
+
+  uint32_t m_horizon; //!< distance from which the full window is used
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Exponential backoff scaled by the observed collision rate.
+ *
+ * The policy keeps an exponentially weighted average of the fraction of
+ * receptions lost to collisions at the device and scales the 2^a - 1
+ * window by it, rounded up and at least MinWindow: a quiet neighbourhood
+ * retries at once, a congested one backs off as far as plain binary
+ * exponential backoff.  Until the first reception the rate is taken to
+ * be 1, i.e. the policy starts as binary exponential backoff.
+ */
+class LwsnAdaptiveBackoffPolicy : public LwsnBackoffPolicy
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LwsnAdaptiveBackoffPolicy ();
+
+  virtual void NotifyReception (bool collided);
+  /// \returns the current estimate of the collision rate
+  double GetCollisionRate (void) const;
+
+  virtual void Serialize (std::ostream &os) const;
+  virtual bool Deserialize (std::istream &is);
+
+private:
+  virtual uint32_t GetWindow (uint32_t attempt) const;
+
+  double m_weight;        //!< weight of the newest reception in the average
+  uint32_t m_minWindow;   //!< smallest window, in slots
+  double m_collisionRate; //!< average fraction of receptions lost
+};
+
+} // namespace ns3
+
+#endif /* LWSN_BACKOFF_POLICY_H */
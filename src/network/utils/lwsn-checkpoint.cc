@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-checkpoint.h"
+#include "ns3/packet.h"
+#include "ns3/tag.h"
+#include "ns3/type-id.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include <string>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnCheckpoint");
+
+namespace {
+
+/**
+ * \param tid the TypeId of a tag
+ * \returns a new tag of that type, to delete after use, or 0 if the
+ * TypeId has no constructor
+ */
+Tag *
+CreateTag (TypeId tid)
+{
+  if (!tid.HasConstructor ())
+    {
+      return 0;
+    }
+  ObjectBase *base = tid.GetConstructor () ();
+  Tag *tag = dynamic_cast<Tag *> (base);
+  if (tag == 0)
+    {
+      delete base;
+    }
+  return tag;
+}
+
+/**
+ * Write the TypeId name and the serialized bytes of a tag.
+ *
+ * \param os output stream
+ * \param tag the tag
+ */
+void
+WriteTag (std::ostream &os, const Tag &tag)
+{
+  std::string name = tag.GetInstanceTypeId ().GetName ();
+  LwsnCheckpoint::WriteVector (os, std::vector<char> (name.begin (), name.end ()));
+  std::vector<uint8_t> bytes (tag.GetSerializedSize () + 1);
+  tag.Serialize (TagBuffer (&bytes[0], &bytes[0] + bytes.size () - 1));
+  bytes.pop_back ();
+  LwsnCheckpoint::WriteVector (os, bytes);
+}
+
+/**
+ * Read a tag written by WriteTag.
+ *
+ * \param is input stream
+ * \returns the tag, to delete after use, or 0 if the stream does not
+ * hold a tag of a known type
+ */
+Tag *
+ReadTag (std::istream &is)
+{
+  std::vector<char> name;
+  std::vector<uint8_t> bytes;
+  TypeId tid;
+  if (!LwsnCheckpoint::ReadVector (is, name)
+      || !LwsnCheckpoint::ReadVector (is, bytes)
+      || !TypeId::LookupByNameFailSafe (std::string (name.begin (), name.end ()), &tid))
+    {
+      return 0;
+    }
+  Tag *tag = CreateTag (tid);
+  if (tag == 0 || tag->GetSerializedSize () != bytes.size ())
+    {
+      delete tag;
+      return 0;
+    }
+  bytes.push_back (0);
+  tag->Deserialize (TagBuffer (&bytes[0], &bytes[0] + bytes.size () - 1));
+  return tag;
+}
+
+} // anonymous namespace
+
+void
+LwsnPacketTable::Write (std::ostream &os, Ptr<const Packet> p)
+{
+  if (p == 0)
+    {
+      LwsnCheckpoint::Write<uint32_t> (os, 0);
+      return;
+    }
+  std::map<const Packet *, uint32_t>::const_iterator it = m_written.find (PeekPointer (p));
+  if (it != m_written.end ())
+    {
+      LwsnCheckpoint::Write (os, it->second);
+      return;
+    }
+  uint32_t id = m_written.size () + 1;
+  m_written[PeekPointer (p)] = id;
+  LwsnCheckpoint::Write (os, id);
+
+  std::vector<uint8_t> bytes (p->GetSerializedSize ());
+  uint32_t done = p->Serialize (&bytes[0], bytes.size ());
+  NS_ABORT_MSG_IF (done == 0, "cannot serialize packet " << p->GetUid ());
+  LwsnCheckpoint::WriteVector (os, bytes);
+
+  // the packet tags are listed newest first; write them oldest first
+  std::vector<Tag *> tags;
+  PacketTagIterator pi = p->GetPacketTagIterator ();
+  while (pi.HasNext ())
+    {
+      PacketTagIterator::Item item = pi.Next ();
+      Tag *tag = CreateTag (item.GetTypeId ());
+      NS_ABORT_MSG_IF (tag == 0, "packet tag " << item.GetTypeId ().GetName () << " has no constructor");
+      item.GetTag (*tag);
+      tags.push_back (tag);
+    }
+  LwsnCheckpoint::Write<uint32_t> (os, tags.size ());
+  for (std::vector<Tag *>::reverse_iterator i = tags.rbegin (); i != tags.rend (); ++i)
+    {
+      WriteTag (os, **i);
+      delete *i;
+    }
+
+  tags.clear ();
+  std::vector<uint32_t> ranges;
+  ByteTagIterator bi = p->GetByteTagIterator ();
+  while (bi.HasNext ())
+    {
+      ByteTagIterator::Item item = bi.Next ();
+      Tag *tag = CreateTag (item.GetTypeId ());
+      NS_ABORT_MSG_IF (tag == 0, "byte tag " << item.GetTypeId ().GetName () << " has no constructor");
+      item.GetTag (*tag);
+      tags.push_back (tag);
+      ranges.push_back (item.GetStart ());
+      ranges.push_back (item.GetEnd ());
+    }
+  LwsnCheckpoint::Write<uint32_t> (os, tags.size ());
+  for (uint32_t i = 0; i < tags.size (); i++)
+    {
+      LwsnCheckpoint::Write (os, ranges[2 * i]);
+      LwsnCheckpoint::Write (os, ranges[2 * i + 1]);
+      WriteTag (os, *tags[i]);
+      delete tags[i];
+    }
+}
+
+bool
+LwsnPacketTable::Read (std::istream &is, Ptr<Packet> &p)
+{
+  uint32_t id;
+  if (!LwsnCheckpoint::Read (is, id) || id > m_read.size () + 1)
+    {
+      return false;
+    }
+  if (id == 0)
+    {
+      p = 0;
+      return true;
+    }
+  if (id <= m_read.size ())
+    {
+      p = m_read[id - 1];
+      return true;
+    }
+
+  std::vector<uint8_t> bytes;
+  if (!LwsnCheckpoint::ReadVector (is, bytes) || bytes.empty () || bytes.size () % 4 != 0)
+    {
+      return false;
+    }
+  p = Create<Packet> (&bytes[0], bytes.size (), true);
+
+  uint32_t count;
+  if (!LwsnCheckpoint::Read (is, count))
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < count; i++)
+    {
+      Tag *tag = ReadTag (is);
+      if (tag == 0)
+        {
+          return false;
+        }
+      p->AddPacketTag (*tag);
+      delete tag;
+    }
+  if (!LwsnCheckpoint::Read (is, count))
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < count; i++)
+    {
+      uint32_t start;
+      uint32_t end;
+      if (!LwsnCheckpoint::Read (is, start) || !LwsnCheckpoint::Read (is, end) || end < start)
+        {
+          return false;
+        }
+      Tag *tag = ReadTag (is);
+      if (tag == 0)
+        {
+          return false;
+        }
+      p->AddByteTag (*tag, start, end);
+      delete tag;
+    }
+  m_read.push_back (p);
+  return true;
+}
+
+} // namespace ns3
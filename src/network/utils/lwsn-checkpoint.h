@@ -0,0 +1,118 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_CHECKPOINT_H
+#define LWSN_CHECKPOINT_H
+
+#include <stdint.h>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * \brief Field encoding of the LWSN checkpoints.
+ *
+ * Values are copied as they sit in memory, in the byte order of the
+ * writer, as for LwsnMacTrace: a checkpoint is meant to be restored by
+ * the same build on the same kind of host.  Vectors are a 64-bit
+ * element count followed by the elements.
+ */
+class LwsnCheckpoint
+{
+public:
+  /**
+   * \param os output stream
+   * \param value a plain value
+   */
+  template <typename T>
+  static void Write (std::ostream &os, const T &value)
+  {
+    os.write (reinterpret_cast<const char *> (&value), sizeof (T));
+  }
+  /**
+   * \param is input stream
+   * \param value set to the value read
+   * \returns false if the stream ended
+   */
+  template <typename T>
+  static bool Read (std::istream &is, T &value)
+  {
+    return !is.read (reinterpret_cast<char *> (&value), sizeof (T)).fail ();
+  }
+  /**
+   * \param os output stream
+   * \param v a vector of plain values
+   */
+  template <typename T>
+  static void WriteVector (std::ostream &os, const std::vector<T> &v)
+  {
+    Write<uint64_t> (os, v.size ());
+    if (!v.empty ())
+      {
+        os.write (reinterpret_cast<const char *> (&v[0]), v.size () * sizeof (T));
+      }
+  }
+  /**
+   * \param is input stream
+   * \param v set to the vector read
+   * \returns false if the stream ended
+   */
+  template <typename T>
+  static bool ReadVector (std::istream &is, std::vector<T> &v)
+  {
+    uint64_t size;
+    if (!Read (is, size) || size > MAX_ELEMENTS)
+      {
+        return false;
+      }
+    v.resize (size);
+    return size == 0 || !is.read (reinterpret_cast<char *> (&v[0]), size * sizeof (T)).fail ();
+  }
+
+private:
+  /// Largest vector accepted, against corrupt counts
+  static const uint64_t MAX_ELEMENTS = 1ULL << 32;
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Packets of one LWSN checkpoint.
+ *
+ * A packet is written with Packet::Serialize the first time it is met
+ * and as a reference to that copy afterwards, so that a packet held in
+ * several places, e.g. by the MAC and by one of its pending actions, is
+ * still a single packet once restored.  The packet and byte tags, which
+ * Packet::Serialize leaves out, are written after it by TypeId name;
+ * their TypeId must have a constructor.  Use one table for the whole
+ * checkpoint, either to write it or to read it.
+ */
+class LwsnPacketTable
+{
+public:
+  /**
+   * \param os output stream
+   * \param p the packet, or 0
+   */
+  void Write (std::ostream &os, Ptr<const Packet> p);
+  /**
+   * \param is input stream
+   * \param p set to the packet read, or 0
+   * \returns false if the stream does not hold a packet written by Write
+   */
+  bool Read (std::istream &is, Ptr<Packet> &p);
+
+private:
+  std::map<const Packet *, uint32_t> m_written; //!< ids of the packets written
+  std::vector<Ptr<Packet> > m_read;             //!< packets read, by id
+};
+
+} // namespace ns3
+
+#endif /* LWSN_CHECKPOINT_H */
@@ -0,0 +1,303 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-hop-tag.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/log.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnHopTag");
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnHopTag);
+
+const uint32_t LwsnHopTag::MAX_RECORDS;
+
+TypeId
+LwsnHopTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnHopTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnHopTag> ()
+  ;
+  return tid;
+}
+TypeId
+LwsnHopTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+LwsnHopTag::GetSerializedSize (void) const
+{
+  return 12;
+}
+void
+LwsnHopTag::Serialize (TagBuffer buf) const
+{
+  buf.WriteU16 (m_sid);
+  buf.WriteU64 (m_sent.GetTimeStep ());
+  buf.WriteU16 (m_retries);
+}
+void
+LwsnHopTag::Deserialize (TagBuffer buf)
+{
+  m_sid = buf.ReadU16 ();
+  m_sent = TimeStep (buf.ReadU64 ());
+  m_retries = buf.ReadU16 ();
+}
+void
+LwsnHopTag::Print (std::ostream &os) const
+{
+  os << "Sid=" << m_sid << " Sent=" << m_sent << " Retries=" << m_retries;
+}
+LwsnHopTag::LwsnHopTag ()
+  : Tag (),
+    m_sid (0),
+    m_retries (0)
+{
+}
+
+LwsnHopTag::LwsnHopTag (uint16_t sid, Time sent, uint16_t retries)
+  : Tag (),
+    m_sid (sid),
+    m_sent (sent),
+    m_retries (retries)
+{
+}
+
+uint16_t
+LwsnHopTag::GetSid (void) const
+{
+  return m_sid;
+}
+Time
+LwsnHopTag::GetSent (void) const
+{
+  return m_sent;
+}
+uint16_t
+LwsnHopTag::GetRetries (void) const
+{
+  return m_retries;
+}
+
+void
+LwsnHopTag::Append (Ptr<Packet> p, uint16_t sid)
+{
+  NS_LOG_FUNCTION (p << sid);
+  LwsnHopTag last;
+  uint32_t records = 0;
+  ByteTagIterator i = p->GetByteTagIterator ();
+  while (i.HasNext ())
+    {
+      ByteTagIterator::Item item = i.Next ();
+      if (item.GetTypeId () == GetTypeId ())
+        {
+          item.GetTag (last);
+          records++;
+        }
+    }
+  if (records >= MAX_RECORDS)
+    {
+      return;
+    }
+  uint16_t retries = records > 0 && last.m_sid == sid ? last.m_retries + 1 : 0;
+  p->AddByteTag (LwsnHopTag (sid, Simulator::Now (), retries));
+}
+
+void
+LwsnHopTag::GetPath (Ptr<const Packet> p, std::vector<LwsnHopTag> &path)
+{
+  path.clear ();
+  ByteTagIterator i = p->GetByteTagIterator ();
+  while (i.HasNext ())
+    {
+      ByteTagIterator::Item item = i.Next ();
+      if (item.GetTypeId () != GetTypeId ())
+        {
+          continue;
+        }
+      LwsnHopTag record;
+      item.GetTag (record);
+      if (!path.empty () && path.back ().m_sid == record.m_sid)
+        {
+          path.back () = record;
+        }
+      else
+        {
+          path.push_back (record);
+        }
+    }
+}
+
+const uint32_t LwsnHopStats::N_DELAY_BINS;
+const uint32_t LwsnHopStats::N_RETRY_BINS;
+
+LwsnHopStats::Hop::Hop ()
+  : count (0),
+    delaySum (0)
+{
+  std::fill (delay, delay + N_DELAY_BINS, 0);
+  std::fill (retries, retries + N_RETRY_BINS, 0);
+}
+
+LwsnHopStats::LwsnHopStats ()
+{
+  Reset ();
+}
+
+void
+LwsnHopStats::Reset (void)
+{
+  m_hops.clear ();
+  m_paths = 0;
+  m_partial = 0;
+}
+
+void
+LwsnHopStats::Merge (const LwsnHopStats &other)
+{
+  for (std::map<uint16_t, Hop>::const_iterator i = other.m_hops.begin (); i != other.m_hops.end (); ++i)
+    {
+      Hop &hop = m_hops[i->first];
+      hop.count += i->second.count;
+      hop.delaySum += i->second.delaySum;
+      for (uint32_t b = 0; b < N_DELAY_BINS; b++)
+        {
+          hop.delay[b] += i->second.delay[b];
+        }
+      for (uint32_t b = 0; b < N_RETRY_BINS; b++)
+        {
+          hop.retries[b] += i->second.retries[b];
+        }
+    }
+  m_paths += other.m_paths;
+  m_partial += other.m_partial;
+}
+
+uint32_t
+LwsnHopStats::GetDelayBin (Time delay)
+{
+  int64_t ms = delay.GetMilliSeconds ();
+  uint32_t bin = 0;
+  while (ms > 0 && bin + 1 < N_DELAY_BINS)
+    {
+      ms >>= 1;
+      bin++;
+    }
+  return bin;
+}
+
+void
+LwsnHopStats::NotifyDelivery (Ptr<const Packet> p, uint16_t osid, Time origin)
+{
+  std::vector<LwsnHopTag> path;
+  LwsnHopTag::GetPath (p, path);
+  if (path.empty () || path.front ().GetSid () != osid)
+    {
+      m_partial++;
+      return;
+    }
+  Time received = origin;
+  for (std::vector<LwsnHopTag>::const_iterator i = path.begin (); i != path.end (); ++i)
+    {
+      Time delay = Max (i->GetSent () - received, Time (0));
+      Hop &hop = m_hops[i->GetSid ()];
+      hop.count++;
+      hop.delaySum += delay.GetTimeStep ();
+      hop.delay[GetDelayBin (delay)]++;
+      hop.retries[std::min<uint32_t> (i->GetRetries (), N_RETRY_BINS - 1)]++;
+      received = i->GetSent ();
+    }
+  m_paths++;
+}
+
+uint64_t
+LwsnHopStats::GetNPaths (void) const
+{
+  return m_paths;
+}
+
+uint64_t
+LwsnHopStats::GetNPartial (void) const
+{
+  return m_partial;
+}
+
+uint64_t
+LwsnHopStats::GetNHops (uint16_t sid) const
+{
+  std::map<uint16_t, Hop>::const_iterator i = m_hops.find (sid);
+  return i != m_hops.end () ? i->second.count : 0;
+}
+
+Time
+LwsnHopStats::GetMeanDelay (uint16_t sid) const
+{
+  std::map<uint16_t, Hop>::const_iterator i = m_hops.find (sid);
+  if (i == m_hops.end () || i->second.count == 0)
+    {
+      return Time (0);
+    }
+  return TimeStep (i->second.delaySum / static_cast<int64_t> (i->second.count));
+}
+
+uint64_t
+LwsnHopStats::GetNDelay (uint16_t sid, uint32_t bin) const
+{
+  NS_ASSERT (bin < N_DELAY_BINS);
+  std::map<uint16_t, Hop>::const_iterator i = m_hops.find (sid);
+  return i != m_hops.end () ? i->second.delay[bin] : 0;
+}
+
+uint64_t
+LwsnHopStats::GetNRetries (uint16_t sid, uint32_t retries) const
+{
+  NS_ASSERT (retries < N_RETRY_BINS);
+  std::map<uint16_t, Hop>::const_iterator i = m_hops.find (sid);
+  return i != m_hops.end () ? i->second.retries[retries] : 0;
+}
+
+void
+LwsnHopStats::PrintDelayCsv (std::ostream &os) const
+{
+  os << "sid,readings,mean_s";
+  for (uint32_t b = 0; b + 1 < N_DELAY_BINS; b++)
+    {
+      os << ",lt_" << (static_cast<uint64_t> (1) << b) << "ms";
+    }
+  os << ",more" << std::endl;
+  for (std::map<uint16_t, Hop>::const_iterator i = m_hops.begin (); i != m_hops.end (); ++i)
+    {
+      os << i->first << "," << i->second.count << "," << GetMeanDelay (i->first).GetSeconds ();
+      for (uint32_t b = 0; b < N_DELAY_BINS; b++)
+        {
+          os << "," << i->second.delay[b];
+        }
+      os << std::endl;
+    }
+}
+
+void
+LwsnHopStats::PrintRetryCsv (std::ostream &os) const
+{
+  os << "sid";
+  for (uint32_t b = 0; b + 1 < N_RETRY_BINS; b++)
+    {
+      os << ",r" << b;
+    }
+  os << ",more" << std::endl;
+  for (std::map<uint16_t, Hop>::const_iterator i = m_hops.begin (); i != m_hops.end (); ++i)
+    {
+      os << i->first;
+      for (uint32_t b = 0; b < N_RETRY_BINS; b++)
+        {
+          os << "," << i->second.retries[b];
+        }
+      os << std::endl;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,198 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_HOP_TAG_H
+#define LWSN_HOP_TAG_H
+
+#include <stdint.h>
+#include <map>
+#include <ostream>
+#include <vector>
+#include "ns3/tag.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * \brief One transmission of an LWSN reading on its way to a gateway.
+ *
+ * Every time a sensor puts a reading on the channel, as its origin or
+ * as a relay, it appends a record of its Sid, the time and the number
+ * of retries it has spent on the reading so far.  The records of a
+ * frame are its path: the time of the last record of a sensor is when
+ * the next hop received the reading, so the time between the last
+ * records of two consecutive sensors is what the second one spent
+ * queueing and retrying.
+ *
+ * The records are byte tags, because a path does not fit in the 21
+ * bytes of a packet tag.  They ride on the payload, which keeps them
+ * through the header rewrites of each hop.  Coded frames are built from
+ * fresh payloads, so a reading that went through a NETWORK_CODING frame
+ * reaches the gateway without the start of its path.  An AGGREGATE
+ * frame keeps the records of each reading it bundles.
+ */
+class LwsnHopTag : public Tag
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  LwsnHopTag ();
+
+  /**
+   * \param sid Sid of the sensor that sent the frame
+   * \param sent time the frame was sent
+   * \param retries retries the sensor spent on the frame before
+   */
+  LwsnHopTag (uint16_t sid, Time sent, uint16_t retries);
+
+  /// \returns the Sid of the sensor that sent the frame
+  uint16_t GetSid (void) const;
+  /// \returns the time the frame was sent
+  Time GetSent (void) const;
+  /// \returns the retries the sensor spent on the frame before
+  uint16_t GetRetries (void) const;
+
+  /**
+   * Record a transmission of p by the sensor sid, now.  The retries are
+   * counted from the records of p: one more than the last one if it is
+   * from the same sensor, none otherwise.  Nothing is recorded past
+   * MAX_RECORDS.
+   *
+   * \param p the frame about to be sent, header included
+   * \param sid Sid of the sender
+   */
+  static void Append (Ptr<Packet> p, uint16_t sid);
+  /**
+   * \param p a frame
+   * \param path set to one record per hop, in path order: the last
+   * transmission of each sensor the frame went through
+   */
+  static void GetPath (Ptr<const Packet> p, std::vector<LwsnHopTag> &path);
+
+  /// Most records appended to one frame
+  static const uint32_t MAX_RECORDS = 128;
+
+private:
+  uint16_t m_sid;     //!< Sid of the sender
+  Time m_sent;        //!< time of the transmission
+  uint16_t m_retries; //!< retries of the sender before this transmission
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Per-hop delay and retry heatmaps, built at a gateway.
+ *
+ * The gateway hands every reading it delivers to NotifyDelivery, which
+ * reads the LwsnHopTag path and charges each sensor on it with its
+ * delay, from the time it received the reading (the origin time for the
+ * originating sensor) to the time it last sent it, and with its
+ * retries.  Only fixed-size counters per Sid are kept, whatever the
+ * number of readings.  Delays are binned by powers of two of a
+ * millisecond, and retries one by one up to N_RETRY_BINS - 1.
+ */
+class LwsnHopStats
+{
+public:
+  /// Number of delay bins: below 1 ms, then one per power of two, the last one open
+  static const uint32_t N_DELAY_BINS = 24;
+  /// Number of retry bins, the last one open
+  static const uint32_t N_RETRY_BINS = 9;
+
+  LwsnHopStats ();
+
+  /// Clear every counter
+  void Reset (void);
+  /**
+   * Add the counters of another gateway.
+   *
+   * \param other the block to merge
+   */
+  void Merge (const LwsnHopStats &other);
+
+  /**
+   * \param p the reading delivered, header included
+   * \param osid its originating sensor
+   * \param origin the time it was generated
+   */
+  void NotifyDelivery (Ptr<const Packet> p, uint16_t osid, Time origin);
+
+  /// \returns the readings whose whole path was charged
+  uint64_t GetNPaths (void) const;
+  /// \returns the readings delivered without the start of their path
+  uint64_t GetNPartial (void) const;
+  /**
+   * \param sid a sensor
+   * \returns the readings it was charged with
+   */
+  uint64_t GetNHops (uint16_t sid) const;
+  /**
+   * \param sid a sensor
+   * \returns its mean delay, zero if it was never charged
+   */
+  Time GetMeanDelay (uint16_t sid) const;
+  /**
+   * \param sid a sensor
+   * \param bin a delay bin
+   * \returns the readings it held for a delay of that bin
+   */
+  uint64_t GetNDelay (uint16_t sid, uint32_t bin) const;
+  /**
+   * \param sid a sensor
+   * \param retries a retry count, N_RETRY_BINS - 1 for that many or more
+   * \returns the readings it sent after that many retries
+   */
+  uint64_t GetNRetries (uint16_t sid, uint32_t retries) const;
+
+  /**
+   * \param delay a delay
+   * \returns its bin
+   */
+  static uint32_t GetDelayBin (Time delay);
+
+  /**
+   * Print the delay heatmap as CSV, one line per sensor: the Sid, the
+   * readings charged, the mean delay in s, then the count of each delay
+   * bin, headed by the bin upper bound.
+   *
+   * \param os output stream
+   */
+  void PrintDelayCsv (std::ostream &os) const;
+  /**
+   * Print the retry heatmap as CSV, one line per sensor: the Sid, then
+   * the count of each retry bin.
+   *
+   * \param os output stream
+   */
+  void PrintRetryCsv (std::ostream &os) const;
+
+private:
+  /// Counters of one sensor
+  struct Hop
+  {
+    Hop ();
+    uint64_t count;                  //!< readings charged
+    int64_t delaySum;                //!< sum of the delays, in time steps
+    uint64_t delay[N_DELAY_BINS];    //!< readings per delay bin
+    uint64_t retries[N_RETRY_BINS];  //!< readings per retry bin
+  };
+
+  std::map<uint16_t, Hop> m_hops; //!< counters by Sid
+  uint64_t m_paths;               //!< readings charged
+  uint64_t m_partial;             //!< readings without the start of their path
+};
+
+} // namespace ns3
+
+#endif /* LWSN_HOP_TAG_H */
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-interference-tracker.h"
+#include "ns3/assert.h"
+#include "lwsn-checkpoint.h"
+
+namespace ns3 {
+
+LwsnInterferenceTracker::LwsnInterferenceTracker ()
+  : m_model (CAPTURE_NONE),
+    m_threshold (0.0),
+    m_ring (4),
+    m_head (0),
+    m_count (0),
+    m_nextId (0)
+{
+}
+
+void
+LwsnInterferenceTracker::SetCaptureModel (CaptureModel model)
+{
+  m_model = model;
+}
+
+LwsnInterferenceTracker::CaptureModel
+LwsnInterferenceTracker::GetCaptureModel (void) const
+{
+  return m_model;
+}
+
+void
+LwsnInterferenceTracker::SetCaptureThreshold (double threshold)
+{
+  m_threshold = threshold;
+}
+
+double
+LwsnInterferenceTracker::GetCaptureThreshold (void) const
+{
+  return m_threshold;
+}
+
+LwsnInterferenceTracker::Reception &
+LwsnInterferenceTracker::At (uint32_t i)
+{
+  return m_ring[(m_head + i) % m_ring.size ()];
+}
+
+uint32_t
+LwsnInterferenceTracker::Add (int64_t start, int64_t end, double power)
+{
+  NS_ASSERT (start < end);
+  Reception rx;
+  rx.id = m_nextId++;
+  rx.start = start;
+  rx.end = end;
+  rx.power = power;
+  rx.overlaps = 0;
+  rx.earlierOverlap = false;
+  rx.maxOther = 0.0;
+  for (uint32_t i = 0; i < m_count; i++)
+    {
+      Reception &other = At (i);
+      if (other.start >= end || start >= other.end)
+        {
+          continue;
+        }
+      if (rx.overlaps == 0 || other.power > rx.maxOther)
+        {
+          rx.maxOther = other.power;
+        }
+      if (other.overlaps == 0 || power > other.maxOther)
+        {
+          other.maxOther = power;
+        }
+      rx.overlaps++;
+      other.overlaps++;
+      if (other.start <= start)
+        {
+          rx.earlierOverlap = true;
+        }
+      if (start <= other.start)
+        {
+          other.earlierOverlap = true;
+        }
+    }
+
+  if (m_count == m_ring.size ())
+    {
+      std::vector<Reception> ring (2 * m_ring.size ());
+      for (uint32_t i = 0; i < m_count; i++)
+        {
+          ring[i] = At (i);
+        }
+      m_ring.swap (ring);
+      m_head = 0;
+    }
+  // keep the ring sorted by end: the new reception usually ends last
+  uint32_t pos = m_count;
+  while (pos > 0 && At (pos - 1).end > end)
+    {
+      At (pos) = At (pos - 1);
+      pos--;
+    }
+  At (pos) = rx;
+  m_count++;
+  return rx.id;
+}
+
+bool
+LwsnInterferenceTracker::End (uint32_t id)
+{
+  uint32_t pos = 0;
+  while (pos < m_count && At (pos).id != id)
+    {
+      pos++;
+    }
+  NS_ASSERT_MSG (pos < m_count, "Reception " << id << " is not in progress");
+  Reception rx = At (pos);
+  for (uint32_t i = pos; i + 1 < m_count; i++)
+    {
+      At (i) = At (i + 1);
+    }
+  m_count--;
+
+  if (rx.overlaps == 0)
+    {
+      return true;
+    }
+  switch (m_model)
+    {
+    case CAPTURE_FIRST:
+      return !rx.earlierOverlap;
+    case CAPTURE_STRONGEST:
+      return rx.power > rx.maxOther + m_threshold;
+    case CAPTURE_NONE:
+    default:
+      return false;
+    }
+}
+
+uint32_t
+LwsnInterferenceTracker::GetNActive (void) const
+{
+  return m_count;
+}
+
+void
+LwsnInterferenceTracker::Clear (void)
+{
+  m_head = 0;
+  m_count = 0;
+}
+
+void
+LwsnInterferenceTracker::Serialize (std::ostream &os) const
+{
+  LwsnCheckpoint::Write<uint32_t> (os, m_model);
+  LwsnCheckpoint::Write (os, m_threshold);
+  LwsnCheckpoint::WriteVector (os, m_ring);
+  LwsnCheckpoint::Write (os, m_head);
+  LwsnCheckpoint::Write (os, m_count);
+  LwsnCheckpoint::Write (os, m_nextId);
+}
+
+bool
+LwsnInterferenceTracker::Deserialize (std::istream &is)
+{
+  uint32_t model;
+  if (!LwsnCheckpoint::Read (is, model) || model > CAPTURE_STRONGEST)
+    {
+      return false;
+    }
+  m_model = static_cast<CaptureModel> (model);
+  return LwsnCheckpoint::Read (is, m_threshold)
+         && LwsnCheckpoint::ReadVector (is, m_ring)
+         && LwsnCheckpoint::Read (is, m_head)
+         && LwsnCheckpoint::Read (is, m_count)
+         && LwsnCheckpoint::Read (is, m_nextId)
+         && !m_ring.empty () && m_count <= m_ring.size ();
+}
+
+} // namespace ns3
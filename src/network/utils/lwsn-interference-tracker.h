@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_INTERFERENCE_TRACKER_H
+#define LWSN_INTERFERENCE_TRACKER_H
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Receptions overlapping at one receiver, and which of them survive.
+ *
+ * Each reception is a half-open interval [start, end) of time, in any
+ * unit as long as it is the same for every call.  The receptions in
+ * progress are kept in a small ring sorted by end time; when one is
+ * added, the overlap with each reception in progress is recorded on
+ * both sides, so that a reception can be resolved by End once it is
+ * over, however many frames it overlapped and in whatever order they
+ * ended.
+ *
+ * Whether an overlapped reception survives depends on the capture
+ * model:
+ *  - CAPTURE_NONE: any overlap destroys the reception;
+ *  - CAPTURE_FIRST: the reception survives as long as every reception
+ *    it overlaps started strictly after it;
+ *  - CAPTURE_STRONGEST: the reception survives if its power exceeds
+ *    that of every reception it overlaps by more than the threshold.
+ */
+class LwsnInterferenceTracker
+{
+public:
+  /// How overlapping receptions are resolved
+  enum CaptureModel
+  {
+    CAPTURE_NONE,
+    CAPTURE_FIRST,
+    CAPTURE_STRONGEST
+  };
+
+  LwsnInterferenceTracker ();
+
+  /// \param model the capture model
+  void SetCaptureModel (CaptureModel model);
+  /// \returns the capture model
+  CaptureModel GetCaptureModel (void) const;
+  /// \param threshold capture threshold, in dB (CAPTURE_STRONGEST only)
+  void SetCaptureThreshold (double threshold);
+  /// \returns the capture threshold, in dB
+  double GetCaptureThreshold (void) const;
+
+  /**
+   * \param start time the reception starts
+   * \param end time the reception ends, after start
+   * \param power received power, in dBm
+   * \returns an id to pass to End
+   */
+  uint32_t Add (int64_t start, int64_t end, double power);
+  /**
+   * Forget a reception and tell whether it survived its overlaps.
+   *
+   * \param id the id returned by Add
+   * \returns true if the frame is received
+   */
+  bool End (uint32_t id);
+
+  /// \returns the number of receptions added and not ended
+  uint32_t GetNActive (void) const;
+  /// Forget every reception
+  void Clear (void);
+
+  /**
+   * Write the receptions in progress as LwsnCheckpoint fields.
+   *
+   * \param os output stream
+   */
+  void Serialize (std::ostream &os) const;
+  /**
+   * \param is input stream
+   * \returns false if it does not hold a tracker written by Serialize
+   */
+  bool Deserialize (std::istream &is);
+
+private:
+  /// One reception in progress
+  struct Reception
+  {
+    uint32_t id;          //!< id returned by Add
+    int64_t start;        //!< start time
+    int64_t end;          //!< end time
+    double power;         //!< received power, dBm
+    uint32_t overlaps;    //!< receptions overlapped so far
+    bool earlierOverlap;  //!< overlapped one that started no later
+    double maxOther;      //!< strongest power overlapped, dBm
+  };
+
+  /**
+   * \param i position in the ring, from the head
+   * \returns the reception at that position
+   */
+  Reception &At (uint32_t i);
+
+  CaptureModel m_model;          //!< capture model
+  double m_threshold;            //!< capture threshold, dB
+  std::vector<Reception> m_ring; //!< receptions, sorted by end from m_head
+  uint32_t m_head;               //!< ring index of the first reception
+  uint32_t m_count;              //!< receptions in the ring
+  uint32_t m_nextId;             //!< id of the next reception
+};
+
+} // namespace ns3
+
+#endif /* LWSN_INTERFERENCE_TRACKER_H */
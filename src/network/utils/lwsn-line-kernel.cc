@@ -0,0 +1,888 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-line-kernel.h"
+#include "ns3/assert.h"
+#include "ns3/abort.h"
+#include "ns3/log.h"
+#include "ns3/lwsn-header.h"
+#include "ns3/rng-seed-manager.h"
+#include "lwsn-checkpoint.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnLineKernel");
+
+namespace {
+
+// MAC timers of SimpleNetDevice, in slots
+const int64_t ACK_DELAY_FROM_RIGHT = 1;  // ACK_SEND / FORWARDING after a frame from the right
+const int64_t ACK_DELAY_FROM_LEFT = 11;  // same, original transmission from the left
+const int64_t RECEIVE_DELAY = 9;         // ReceiveStart to ReceiveEnd
+const int64_t SLEEP_DELAY = 10;          // ChannelSend to SetSleep
+const int64_t ACK_CHECK_DELAY = 20;      // WaitAck to AckCheck or WaitSend
+const int64_t ORIGINAL_ACK_CHECK_DELAY = 30; // OriginalWaitAck to OriginalAckCheck
+const int64_t BACKOFF_UNIT = 10;         // one RandTime unit is a second
+
+const uint32_t EMPTY_KEY = 0xffffffff;   // free queue entry; no sensor has Sid 0xffff
+const uint32_t WHEEL_SIZE = 1024;        // power of two
+
+const uint32_t CHECKPOINT_MAGIC = 0x4b43574c; // "LWCK"
+const uint16_t CHECKPOINT_VERSION = 2;
+
+inline uint16_t
+Osid (uint32_t key)
+{
+  return key >> 16;
+}
+
+inline uint16_t
+Did (uint32_t key)
+{
+  return key & 0xffff;
+}
+
+inline uint32_t
+Key (uint32_t osid, uint32_t did)
+{
+  return ((osid & 0xffff) << 16) | (did & 0xffff);
+}
+
+} // anonymous namespace
+
+LwsnLineKernel::LwsnLineKernel (uint32_t numSensor)
+  : m_numNode (numSensor + 2),
+    m_slotTimeStep (GetSlotLength ().GetTimeStep ()),
+    m_round (3),
+    m_queueSize (0),
+    m_now (0),
+    m_nActions (0),
+    m_pending (0),
+    m_wheel (WHEEL_SIZE),
+    m_sendFlag (m_numNode, 0),
+    m_waitAck (m_numNode, 0),
+    m_rackFlag (m_numNode, 0),
+    m_lackFlag (m_numNode, 0),
+    m_lastNode (m_numNode, 0),
+    m_hasTx (m_numNode, 0),
+    m_txKey (m_numNode, 0),
+    m_txArray (m_numNode, 0),
+    m_k (m_numNode, 1),
+    m_ndid (m_numNode, 1),
+    m_interference (m_numNode),
+    m_queueHead (m_numNode, 0),
+    m_queueCount (m_numNode, 0),
+    m_backoff (m_numNode),
+    m_stream (m_numNode, -1),
+    m_draws (m_numNode, 0),
+    m_stats (m_numNode)
+{
+  NS_ABORT_MSG_IF (numSensor == 0, "A line needs at least one sensor");
+  NS_ABORT_MSG_IF (m_numNode > 0xffff, "Sids are 16 bits");
+  m_lastNode[1] = 1;
+  m_lastNode[numSensor] = 1;
+  for (uint32_t i = 0; i < m_numNode; i++)
+    {
+      m_backoff[i] = CreateObject<UniformRandomVariable> ();
+    }
+  SetQueueSize (100);
+}
+
+void
+LwsnLineKernel::SetRound (uint16_t round)
+{
+  m_round = round;
+}
+
+void
+LwsnLineKernel::SetCaptureModel (LwsnInterferenceTracker::CaptureModel model)
+{
+  for (uint32_t i = 0; i < m_numNode; i++)
+    {
+      m_interference[i].SetCaptureModel (model);
+    }
+}
+
+void
+LwsnLineKernel::SetQueueSize (uint32_t packets)
+{
+  NS_ASSERT_MSG (m_pending == 0, "SetQueueSize must come before AddReading");
+  NS_ABORT_MSG_IF (packets == 0, "Queues need room for one frame");
+  m_queueSize = packets;
+  m_queueKey.assign (m_numNode * packets, EMPTY_KEY);
+  m_queueType.assign (m_numNode * packets, 0);
+  m_queueOrigin.assign (m_numNode * packets, 0);
+  std::fill (m_queueHead.begin (), m_queueHead.end (), 0);
+  std::fill (m_queueCount.begin (), m_queueCount.end (), 0);
+}
+
+int64_t
+LwsnLineKernel::AssignStreams (int64_t stream)
+{
+  for (uint32_t i = 0; i < m_numNode; i++)
+    {
+      m_backoff[i]->SetStream (stream + i);
+      m_stream[i] = stream + i;
+      m_draws[i] = 0;
+    }
+  return m_numNode;
+}
+
+void
+LwsnLineKernel::AddReading (uint32_t sensor, Time at)
+{
+  NS_ASSERT_MSG (sensor >= 1 && sensor + 1 < m_numNode, "not a sensor position: " << sensor);
+  int64_t slot = at.GetTimeStep () / m_slotTimeStep;
+  NS_ABORT_MSG_IF (slot * m_slotTimeStep != at.GetTimeStep (), "reading off the slot grid at " << at);
+  NS_ABORT_MSG_IF (slot < m_now, "reading in the past at " << at);
+  Frame none = { 0, 0, 0 };
+  Schedule (slot - m_now, sensor, ORIGINAL_TRANSMISSION, LEFT, none);
+}
+
+uint32_t
+LwsnLineKernel::GetNNodes (void) const
+{
+  return m_numNode;
+}
+
+Time
+LwsnLineKernel::GetSlotLength (void)
+{
+  return MilliSeconds (100);
+}
+
+Time
+LwsnLineKernel::GetNow (void) const
+{
+  return TimeStep (m_now * m_slotTimeStep);
+}
+
+uint64_t
+LwsnLineKernel::GetNActions (void) const
+{
+  return m_nActions;
+}
+
+const LwsnMacStats &
+LwsnLineKernel::GetStats (uint32_t node) const
+{
+  NS_ASSERT (node < m_numNode);
+  return m_stats[node];
+}
+
+uint32_t
+LwsnLineKernel::GetNDelivered (void) const
+{
+  std::vector<uint32_t> keys;
+  for (uint32_t g = 0; g < m_numNode; g += m_numNode - 1)
+    {
+      for (uint32_t i = 0; i < m_queueCount[g]; i++)
+        {
+          keys.push_back (m_queueKey[g * m_queueSize + (m_queueHead[g] + i) % m_queueSize]);
+        }
+    }
+  std::sort (keys.begin (), keys.end ());
+  return std::unique (keys.begin (), keys.end ()) - keys.begin ();
+}
+
+void
+LwsnLineKernel::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (m_pending > 0)
+    {
+      RunSlot ();
+      m_now++;
+    }
+}
+
+void
+LwsnLineKernel::RunUntil (Time stop)
+{
+  NS_LOG_FUNCTION (this << stop);
+  int64_t slot = stop.GetTimeStep () / m_slotTimeStep;
+  NS_ABORT_MSG_IF (slot * m_slotTimeStep != stop.GetTimeStep (), "stop off the slot grid at " << stop);
+  while (m_now < slot)
+    {
+      if (m_pending == 0)
+        {
+          m_now = slot;
+          break;
+        }
+      RunSlot ();
+      m_now++;
+    }
+}
+
+void
+LwsnLineKernel::Save (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  LwsnCheckpoint::Write (os, CHECKPOINT_MAGIC);
+  LwsnCheckpoint::Write (os, CHECKPOINT_VERSION);
+  LwsnCheckpoint::Write (os, m_numNode);
+  LwsnCheckpoint::Write (os, m_slotTimeStep);
+  LwsnCheckpoint::Write (os, RngSeedManager::GetSeed ());
+  LwsnCheckpoint::Write (os, RngSeedManager::GetRun ());
+  LwsnCheckpoint::Write (os, m_round);
+  LwsnCheckpoint::Write (os, m_queueSize);
+  LwsnCheckpoint::Write (os, m_now);
+  LwsnCheckpoint::Write (os, m_nActions);
+  LwsnCheckpoint::Write (os, m_pending);
+
+  // only the buckets in use, each in its run order
+  uint32_t buckets = 0;
+  for (uint32_t i = 0; i < WHEEL_SIZE; i++)
+    {
+      buckets += !m_wheel[i].empty ();
+    }
+  LwsnCheckpoint::Write (os, buckets);
+  for (uint32_t i = 0; i < WHEEL_SIZE; i++)
+    {
+      if (!m_wheel[i].empty ())
+        {
+          LwsnCheckpoint::Write (os, i);
+          LwsnCheckpoint::WriteVector (os, m_wheel[i]);
+        }
+    }
+
+  LwsnCheckpoint::WriteVector (os, m_sendFlag);
+  LwsnCheckpoint::WriteVector (os, m_waitAck);
+  LwsnCheckpoint::WriteVector (os, m_rackFlag);
+  LwsnCheckpoint::WriteVector (os, m_lackFlag);
+  LwsnCheckpoint::WriteVector (os, m_lastNode);
+  LwsnCheckpoint::WriteVector (os, m_hasTx);
+  LwsnCheckpoint::WriteVector (os, m_txKey);
+  LwsnCheckpoint::WriteVector (os, m_txArray);
+  LwsnCheckpoint::WriteVector (os, m_k);
+  LwsnCheckpoint::WriteVector (os, m_ndid);
+  LwsnCheckpoint::WriteVector (os, m_queueKey);
+  LwsnCheckpoint::WriteVector (os, m_queueType);
+  LwsnCheckpoint::WriteVector (os, m_queueOrigin);
+  LwsnCheckpoint::WriteVector (os, m_queueHead);
+  LwsnCheckpoint::WriteVector (os, m_queueCount);
+  for (uint32_t i = 0; i < m_numNode; i++)
+    {
+      NS_ABORT_MSG_IF (m_stream[i] < 0, "Save needs the backoff streams fixed by AssignStreams");
+      m_interference[i].Serialize (os);
+      m_stats[i].Serialize (os);
+    }
+  LwsnCheckpoint::WriteVector (os, m_stream);
+  LwsnCheckpoint::WriteVector (os, m_draws);
+}
+
+bool
+LwsnLineKernel::Restore (std::istream &is)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t magic;
+  uint16_t version;
+  uint32_t numNode;
+  int64_t slotTimeStep;
+  uint32_t seed;
+  uint64_t run;
+  if (!LwsnCheckpoint::Read (is, magic) || magic != CHECKPOINT_MAGIC
+      || !LwsnCheckpoint::Read (is, version) || version != CHECKPOINT_VERSION
+      || !LwsnCheckpoint::Read (is, numNode) || numNode != m_numNode
+      || !LwsnCheckpoint::Read (is, slotTimeStep) || slotTimeStep != m_slotTimeStep
+      || !LwsnCheckpoint::Read (is, seed)
+      || !LwsnCheckpoint::Read (is, run))
+    {
+      return false;
+    }
+  NS_ABORT_MSG_IF (seed != RngSeedManager::GetSeed () || run != RngSeedManager::GetRun (),
+                   "checkpoint saved with seed " << seed << " run " << run);
+  uint32_t buckets;
+  if (!LwsnCheckpoint::Read (is, m_round)
+      || !LwsnCheckpoint::Read (is, m_queueSize)
+      || !LwsnCheckpoint::Read (is, m_now)
+      || !LwsnCheckpoint::Read (is, m_nActions)
+      || !LwsnCheckpoint::Read (is, m_pending)
+      || !LwsnCheckpoint::Read (is, buckets)
+      || buckets > WHEEL_SIZE)
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < WHEEL_SIZE; i++)
+    {
+      m_wheel[i].clear ();
+    }
+  for (uint32_t b = 0; b < buckets; b++)
+    {
+      uint32_t i;
+      if (!LwsnCheckpoint::Read (is, i) || i >= WHEEL_SIZE
+          || !LwsnCheckpoint::ReadVector (is, m_wheel[i]))
+        {
+          return false;
+        }
+    }
+
+  if (!LwsnCheckpoint::ReadVector (is, m_sendFlag)
+      || !LwsnCheckpoint::ReadVector (is, m_waitAck)
+      || !LwsnCheckpoint::ReadVector (is, m_rackFlag)
+      || !LwsnCheckpoint::ReadVector (is, m_lackFlag)
+      || !LwsnCheckpoint::ReadVector (is, m_lastNode)
+      || !LwsnCheckpoint::ReadVector (is, m_hasTx)
+      || !LwsnCheckpoint::ReadVector (is, m_txKey)
+      || !LwsnCheckpoint::ReadVector (is, m_txArray)
+      || !LwsnCheckpoint::ReadVector (is, m_k)
+      || !LwsnCheckpoint::ReadVector (is, m_ndid)
+      || !LwsnCheckpoint::ReadVector (is, m_queueKey)
+      || !LwsnCheckpoint::ReadVector (is, m_queueType)
+      || !LwsnCheckpoint::ReadVector (is, m_queueOrigin)
+      || !LwsnCheckpoint::ReadVector (is, m_queueHead)
+      || !LwsnCheckpoint::ReadVector (is, m_queueCount))
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < m_numNode; i++)
+    {
+      if (!m_interference[i].Deserialize (is) || !m_stats[i].Deserialize (is))
+        {
+          return false;
+        }
+    }
+  if (!LwsnCheckpoint::ReadVector (is, m_stream)
+      || !LwsnCheckpoint::ReadVector (is, m_draws)
+      || m_stream.size () != m_numNode || m_draws.size () != m_numNode
+      || m_queueKey.size () != static_cast<uint64_t> (m_numNode) * m_queueSize)
+    {
+      return false;
+    }
+
+  // a stream is only known by its index: replay the draws already made
+  for (uint32_t i = 0; i < m_numNode; i++)
+    {
+      m_backoff[i]->SetStream (m_stream[i]);
+      for (uint64_t d = 0; d < m_draws[i]; d++)
+        {
+          m_backoff[i]->GetValue ();
+        }
+    }
+  return true;
+}
+
+void
+LwsnLineKernel::Schedule (int64_t delay, uint32_t node, Action action, Side side, const Frame &frame,
+                          uint32_t reception)
+{
+  Event ev;
+  ev.slot = m_now + delay;
+  ev.node = node;
+  ev.action = action;
+  ev.side = side;
+  ev.frame = frame;
+  ev.reception = reception;
+  m_wheel[ev.slot & (WHEEL_SIZE - 1)].push_back (ev);
+  m_pending++;
+}
+
+void
+LwsnLineKernel::Schedule (int64_t delay, uint32_t node, Action action)
+{
+  Frame none = { 0, 0, 0 };
+  Schedule (delay, node, action, LEFT, none);
+}
+
+void
+LwsnLineKernel::RunSlot (void)
+{
+  // actions scheduled for now while the slot runs are appended to the
+  // same bucket and run after the others, like zero-delay events.
+  // Actions due a wheel turn later are compacted to the front in order.
+  std::vector<Event> &bucket = m_wheel[m_now & (WHEEL_SIZE - 1)];
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < bucket.size (); i++)
+    {
+      if (bucket[i].slot != m_now)
+        {
+          bucket[kept++] = bucket[i];
+          continue;
+        }
+      // bucket may grow while the action runs
+      Event ev = bucket[i];
+      m_pending--;
+      m_nActions++;
+      RunAction (ev);
+    }
+  bucket.resize (kept);
+}
+
+void
+LwsnLineKernel::RunAction (const Event &ev)
+{
+  Side side = static_cast<Side> (ev.side);
+  switch (ev.action)
+    {
+    case ORIGINAL_TRANSMISSION:
+      OriginalTransmission (ev.node, ev.frame, false);
+      break;
+    case RECEIVE_START:
+      ReceiveStart (ev.node, ev.frame, side);
+      break;
+    case RECEIVE_END:
+      ReceiveEnd (ev.node, ev.frame, side, ev.reception);
+      break;
+    case SET_SLEEP:
+      m_sendFlag[ev.node] = 0;
+      break;
+    case ACK_CHECK:
+      AckCheck (ev.node, ev.frame, side);
+      break;
+    case ORIGINAL_ACK_CHECK:
+      OriginalAckCheck (ev.node, ev.frame);
+      break;
+    case WAIT_SEND:
+      WaitSend (ev.node);
+      break;
+    case RESEND:
+      ReSend (ev.node, ev.frame, side);
+      break;
+    case REORIGINAL_SEND:
+      ReOriginalSend (ev.node, ev.frame);
+      break;
+    case ACK_SEND:
+      AckSend (ev.node, ev.frame, side);
+      break;
+    case FORWARDING:
+      Forwarding (ev.node, ev.frame, side);
+      break;
+    }
+}
+
+bool
+LwsnLineKernel::IsGateway (uint32_t node) const
+{
+  return node == 0 || node + 1 == m_numNode;
+}
+
+bool
+LwsnLineKernel::IsQueued (uint32_t node, uint32_t key) const
+{
+  // free entries hold EMPTY_KEY, so the whole ring can be scanned
+  // without a branch per entry
+  const uint32_t *keys = &m_queueKey[node * m_queueSize];
+  uint32_t hits = 0;
+  for (uint32_t i = 0; i < m_queueSize; i++)
+    {
+      hits += keys[i] == key;
+    }
+  return hits > 0;
+}
+
+bool
+LwsnLineKernel::Enqueue (uint32_t node, const Frame &frame)
+{
+  if (m_queueCount[node] == m_queueSize)
+    {
+      return false;
+    }
+  uint32_t i = node * m_queueSize + (m_queueHead[node] + m_queueCount[node]) % m_queueSize;
+  m_queueKey[i] = frame.key;
+  m_queueType[i] = frame.type;
+  m_queueOrigin[i] = frame.origin;
+  m_queueCount[node]++;
+  m_stats[node].NotifyQueueLength (m_queueCount[node]);
+  return true;
+}
+
+LwsnLineKernel::Frame
+LwsnLineKernel::Dequeue (uint32_t node)
+{
+  NS_ASSERT (m_queueCount[node] > 0);
+  uint32_t i = node * m_queueSize + m_queueHead[node];
+  Frame frame = { m_queueKey[i], m_queueType[i], m_queueOrigin[i] };
+  m_queueKey[i] = EMPTY_KEY;
+  m_queueHead[node] = (m_queueHead[node] + 1) % m_queueSize;
+  m_queueCount[node]--;
+  return frame;
+}
+
+uint32_t
+LwsnLineKernel::PeekKey (uint32_t node) const
+{
+  return m_queueCount[node] > 0 ? m_queueKey[node * m_queueSize + m_queueHead[node]] : EMPTY_KEY;
+}
+
+void
+LwsnLineKernel::QueueCheck (uint32_t node, const Frame &frame)
+{
+  if (IsQueued (node, frame.key))
+    {
+      return;
+    }
+  if (Enqueue (node, frame) && IsGateway (node))
+    {
+      m_stats[node].NotifyDeliveryTimeStep (Osid (frame.key), (m_now - frame.origin) * m_slotTimeStep);
+    }
+}
+
+LwsnBackoff
+LwsnLineKernel::RandTime (uint32_t node)
+{
+  uint32_t &k = m_k[node];
+  LwsnBackoff backoff;
+  backoff.giveUp = k > m_round;
+  backoff.slots = 0;
+  if (backoff.giveUp)
+    {
+      k = 1;
+      m_stats[node].NotifyGiveUp ();
+      return backoff;
+    }
+  uint32_t window = k < 32 ? (1u << k) - 1 : 0xffffffffu;
+  k++;
+  backoff.slots = m_backoff[node]->GetInteger (0, window);
+  m_draws[node]++;
+  m_stats[node].NotifyBackoff (backoff.slots);
+  return backoff;
+}
+
+void
+LwsnLineKernel::ChannelSend (uint32_t node, const Frame &frame, Side to)
+{
+  m_stats[node].NotifyTx (frame.type);
+  // only the addressed neighbour acts on a frame
+  if (to == RIGHT)
+    {
+      Schedule (0, node + 1, RECEIVE_START, LEFT, frame);
+    }
+  else
+    {
+      Schedule (0, node - 1, RECEIVE_START, RIGHT, frame);
+    }
+  Schedule (SLEEP_DELAY, node, SET_SLEEP);
+}
+
+void
+LwsnLineKernel::ReceiveStart (uint32_t node, const Frame &frame, Side from)
+{
+  uint32_t reception = m_interference[node].Add (m_now, m_now + RECEIVE_DELAY, 0.0);
+  Schedule (RECEIVE_DELAY, node, RECEIVE_END, from, frame, reception);
+}
+
+void
+LwsnLineKernel::ReceiveEnd (uint32_t node, const Frame &frame, Side from, uint32_t reception)
+{
+  if (m_interference[node].End (reception))
+    {
+      ReceiveFrame (node, frame, from);
+    }
+  else
+    {
+      m_stats[node].NotifyCollision ();
+    }
+}
+
+void
+LwsnLineKernel::ReceiveFrame (uint32_t node, const Frame &frame, Side from)
+{
+  if (m_sendFlag[node])
+    {
+      m_stats[node].NotifyCollision ();
+      return;
+    }
+  if (IsGateway (node))
+    {
+      if (frame.type == LwsnHeader::ORIGINAL_TRANSMISSION || frame.type == LwsnHeader::FORWARDING)
+        {
+          m_stats[node].NotifyGatewayReceive ();
+          QueueCheck (node, frame);
+        }
+      return;
+    }
+
+  Side away = from == RIGHT ? LEFT : RIGHT;
+  bool inFlight = m_hasTx[node] && m_txKey[node] == frame.key;
+  switch (frame.type)
+    {
+    case LwsnHeader::ORIGINAL_TRANSMISSION:
+      if (!m_waitAck[node])
+        {
+          m_sendFlag[node] = 1;
+          int64_t delay = from == RIGHT ? ACK_DELAY_FROM_RIGHT : ACK_DELAY_FROM_LEFT;
+          Schedule (delay, node, ACK_SEND, from, frame);
+          Schedule (delay, node, FORWARDING, away, frame);
+        }
+      else if (!inFlight)
+        {
+          QueueCheck (node, frame);
+        }
+      break;
+    case LwsnHeader::IACK:
+      if (m_waitAck[node])
+        {
+          if (inFlight)
+            {
+              (from == RIGHT ? m_rackFlag : m_lackFlag)[node] = 1;
+            }
+        }
+      else if (PeekKey (node) == frame.key)
+        {
+          Dequeue (node);
+        }
+      break;
+    case LwsnHeader::FORWARDING:
+      if (!m_waitAck[node])
+        {
+          if (PeekKey (node) == frame.key)
+            {
+              Dequeue (node);
+            }
+          m_sendFlag[node] = 1;
+          Schedule (ACK_DELAY_FROM_RIGHT, node, ACK_SEND, from, frame);
+          Schedule (ACK_DELAY_FROM_RIGHT, node, FORWARDING, away, frame);
+        }
+      else if (!inFlight)
+        {
+          QueueCheck (node, frame);
+        }
+      break;
+    default:
+      break;
+    }
+}
+
+void
+LwsnLineKernel::OriginalTransmission (uint32_t node, const Frame &frame, bool header)
+{
+  Frame sent;
+  sent.type = LwsnHeader::ORIGINAL_TRANSMISSION;
+  if (!header)
+    {
+      sent.key = Key (node, m_ndid[node]++);
+      sent.origin = m_now;
+    }
+  else
+    {
+      sent.key = Key (node, Did (frame.key));
+      sent.origin = frame.origin;
+    }
+
+  if (m_sendFlag[node] || m_waitAck[node])
+    {
+      Enqueue (node, sent);
+      return;
+    }
+  if (Enqueue (node, sent))
+    {
+      // the head of the queue goes out, which is not always this reading
+      m_sendFlag[node] = 1;
+      Frame head = Dequeue (node);
+      m_hasTx[node] = 1;
+      m_txKey[node] = head.key;
+      m_txArray[node] = Key (node, m_ndid[node] - 1);
+      ChannelSend (node, head, RIGHT);
+      ChannelSend (node, head, LEFT);
+      OriginalWaitAck (node, head);
+    }
+}
+
+void
+LwsnLineKernel::OriginalWaitAck (uint32_t node, const Frame &frame)
+{
+  m_waitAck[node] = 1;
+  // a last node expects no IACK from its gateway
+  bool leftEnd = m_lastNode[node] && node == 1;
+  bool rightEnd = m_lastNode[node] && node != 1;
+  m_lackFlag[node] = leftEnd;
+  m_rackFlag[node] = rightEnd;
+  Schedule (ORIGINAL_ACK_CHECK_DELAY, node, ORIGINAL_ACK_CHECK, LEFT, frame);
+}
+
+void
+LwsnLineKernel::Done (uint32_t node)
+{
+  m_k[node] = 1;
+  m_waitAck[node] = 0;
+  m_hasTx[node] = 0;
+}
+
+void
+LwsnLineKernel::OriginalAckCheck (uint32_t node, const Frame &frame)
+{
+  bool rack = m_rackFlag[node];
+  bool lack = m_lackFlag[node];
+  if (rack && lack)
+    {
+      m_rackFlag[node] = 0;
+      m_lackFlag[node] = 0;
+      Done (node);
+      WaitSend (node);
+      return;
+    }
+  LwsnBackoff delay = RandTime (node);
+  if (delay.giveUp)
+    {
+      Done (node);
+      WaitSend (node);
+      if (!rack && !lack)
+        {
+          m_rackFlag[node] = 0;
+          m_lackFlag[node] = 0;
+        }
+      return;
+    }
+  if (!rack && !lack)
+    {
+      Schedule (delay.slots * BACKOFF_UNIT, node, REORIGINAL_SEND, LEFT, frame);
+    }
+  else
+    {
+      Schedule (delay.slots * BACKOFF_UNIT, node, RESEND, rack ? LEFT : RIGHT, frame);
+    }
+}
+
+void
+LwsnLineKernel::ReOriginalSend (uint32_t node, const Frame &frame)
+{
+  if (m_lackFlag[node] && m_rackFlag[node])
+    {
+      m_rackFlag[node] = 0;
+      m_lackFlag[node] = 0;
+      Done (node);
+      WaitSend (node);
+      return;
+    }
+  if (m_lackFlag[node])
+    {
+      m_lackFlag[node] = 0;
+      ReSend (node, frame, RIGHT);
+      return;
+    }
+  if (m_rackFlag[node])
+    {
+      m_rackFlag[node] = 0;
+      ReSend (node, frame, LEFT);
+      return;
+    }
+
+  m_sendFlag[node] = 1;
+  m_stats[node].NotifyRetransmission ();
+  Frame sent = frame;
+  sent.type = LwsnHeader::ORIGINAL_TRANSMISSION;
+  ChannelSend (node, sent, RIGHT);
+  ChannelSend (node, sent, LEFT);
+  OriginalWaitAck (node, sent);
+}
+
+void
+LwsnLineKernel::Forwarding (uint32_t node, const Frame &frame, Side to)
+{
+  m_sendFlag[node] = 1;
+  if (m_txArray[node] == frame.key)
+    {
+      m_stats[node].NotifyRetransmission ();
+      AckSend (node, frame, to);
+      return;
+    }
+  Frame sent = frame;
+  sent.type = LwsnHeader::FORWARDING;
+  m_txArray[node] = sent.key;
+  m_hasTx[node] = 1;
+  m_txKey[node] = sent.key;
+  ChannelSend (node, sent, to);
+  WaitAck (node, sent, to);
+}
+
+void
+LwsnLineKernel::AckSend (uint32_t node, const Frame &frame, Side to)
+{
+  m_sendFlag[node] = 1;
+  Frame ack = frame;
+  ack.type = LwsnHeader::IACK;
+  ChannelSend (node, ack, to);
+}
+
+void
+LwsnLineKernel::WaitAck (uint32_t node, const Frame &frame, Side to)
+{
+  m_lackFlag[node] = 0;
+  m_rackFlag[node] = 0;
+  // the last node waits for no IACK from its gateway
+  bool toGateway = m_lastNode[node] && (node == 1 ? to == LEFT : to == RIGHT);
+  if (!toGateway)
+    {
+      m_waitAck[node] = 1;
+      Schedule (ACK_CHECK_DELAY, node, ACK_CHECK, to, frame);
+    }
+  else
+    {
+      m_hasTx[node] = 0;
+      Schedule (ACK_CHECK_DELAY, node, WAIT_SEND);
+    }
+}
+
+void
+LwsnLineKernel::AckCheck (uint32_t node, const Frame &frame, Side to)
+{
+  std::vector<uint8_t> &flag = to == RIGHT ? m_rackFlag : m_lackFlag;
+  if (flag[node])
+    {
+      flag[node] = 0;
+      Done (node);
+      WaitSend (node);
+      return;
+    }
+  LwsnBackoff delay = RandTime (node);
+  if (delay.giveUp)
+    {
+      flag[node] = 0;
+      Done (node);
+      WaitSend (node);
+      return;
+    }
+  Schedule (delay.slots * BACKOFF_UNIT, node, RESEND, to, frame);
+}
+
+void
+LwsnLineKernel::ReSend (uint32_t node, const Frame &frame, Side to)
+{
+  std::vector<uint8_t> &flag = to == RIGHT ? m_rackFlag : m_lackFlag;
+  if (flag[node])
+    {
+      flag[node] = 0;
+      Done (node);
+      WaitSend (node);
+      return;
+    }
+
+  m_sendFlag[node] = 1;
+  m_stats[node].NotifyRetransmission ();
+  // the IACK goes again to the previous hop, in case the first was lost
+  Frame ack = frame;
+  ack.type = LwsnHeader::IACK;
+  Frame sent = frame;
+  sent.type = LwsnHeader::FORWARDING;
+  ChannelSend (node, ack, to == LEFT ? RIGHT : LEFT);
+  ChannelSend (node, sent, to);
+  WaitAck (node, sent, to);
+}
+
+void
+LwsnLineKernel::WaitSend (uint32_t node)
+{
+  if (m_sendFlag[node] || m_queueCount[node] == 0)
+    {
+      return;
+    }
+  Frame frame = Dequeue (node);
+  if (frame.type == LwsnHeader::ORIGINAL_TRANSMISSION && Osid (frame.key) != node)
+    {
+      frame.type = LwsnHeader::FORWARDING;
+    }
+  m_hasTx[node] = 1;
+  m_txKey[node] = frame.key;
+
+  if (frame.type == LwsnHeader::ORIGINAL_TRANSMISSION)
+    {
+      OriginalTransmission (node, frame, true);
+    }
+  else if (frame.type == LwsnHeader::FORWARDING)
+    {
+      Side to = Osid (frame.key) > node ? LEFT : RIGHT;
+      Forwarding (node, frame, to);
+      AckSend (node, frame, to == LEFT ? RIGHT : LEFT);
+    }
+}
+
+} // namespace ns3
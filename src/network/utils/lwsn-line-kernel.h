@@ -0,0 +1,258 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_LINE_KERNEL_H
+#define LWSN_LINE_KERNEL_H
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/random-variable-stream.h"
+#include "lwsn-mac-stats.h"
+#include "lwsn-interference-tracker.h"
+#include "lwsn-backoff-policy.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Standalone slot-stepped model of one LWSN line.
+ *
+ * The kernel runs the slotted-ALOHA MAC of SimpleNetDevice on a line of
+ * numSensor sensors between two gateways (positions 0 and numSensor + 1)
+ * without the simulator, packets, headers or channel: a frame is an
+ * (Osid, Did, type, origin slot) record and every MAC timer is an entry
+ * in a timing wheel of 100 ms slots.  It reproduces original
+ * transmission towards both sides, forwarding with the IACK sent back to
+ * the previous hop, the RandTime exponential backoff bounded by Round,
+ * and the resolution of overlapping receptions by a
+ * LwsnInterferenceTracker per node.
+ *
+ * The per-node MAC state is kept as one array per field, and actions due
+ * in the same slot run in the order they were scheduled, as the
+ * simulator runs events with equal time stamps.  Given the same readings
+ * and backoff streams, the counters come out as those of a
+ * LwsnTopologyHelper line with a zero-delay channel, network coding
+ * off and no aggregation, in a fraction of the time.
+ *
+ * Run touches neither the simulator nor any other global state, so the
+ * kernels of different lines can run on different threads once they
+ * are set up; see LwsnParallelLines.
+ *
+ * A kernel stopped by RunUntil can be saved and restored into another
+ * kernel of the same size, e.g. to fork several traffic phases from one
+ * warmed-up line.  The checkpoint holds the MAC state, the transmit
+ * queues, the pending actions, the receptions in progress, the counters
+ * and the position of every backoff stream, so the restored kernel runs
+ * exactly as the saved one would have.
+ */
+class LwsnLineKernel
+{
+public:
+  /**
+   * \param numSensor number of sensors between the two gateways
+   */
+  LwsnLineKernel (uint32_t numSensor);
+
+  /**
+   * \param round backoff rounds a frame is retried before it is dropped,
+   * as the SimpleNetDevice Round attribute
+   */
+  void SetRound (uint16_t round);
+  /**
+   * Must be called before any reading is added.
+   *
+   * \param packets capacity of every transmit queue, as the MaxPackets
+   * attribute of the SimpleNetDevice DropTailQueue
+   */
+  void SetQueueSize (uint32_t packets);
+  /**
+   * Every node transmits with the same power, so with
+   * CAPTURE_STRONGEST overlapping frames are all lost, as with
+   * CAPTURE_NONE.
+   *
+   * \param model how overlapping receptions are resolved, as the
+   * SimpleNetDevice CaptureModel attribute
+   */
+  void SetCaptureModel (LwsnInterferenceTracker::CaptureModel model);
+  /**
+   * Use a fixed stream for the backoff of each node, node i getting
+   * stream + i as with LwsnTopologyHelper::AssignStreams.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * Schedule SimpleNetDevice::OriginalTransmission of a new reading.
+   * Readings added for the same time start in the order they were added,
+   * before any MAC action due then.
+   *
+   * \param sensor position of the originating sensor, from 1 to numSensor
+   * \param at start time, a multiple of the slot length
+   */
+  void AddReading (uint32_t sensor, Time at);
+
+  /**
+   * Run until no action is left.  No Time object is constructed here:
+   * until the simulator has run, ns-3 keeps track of every Time in a
+   * global set.
+   */
+  void Run (void);
+  /**
+   * Run the slots before stop, then stop there even if actions are
+   * left, so that the kernel can be saved.
+   *
+   * \param stop time to stop at, a multiple of the slot length
+   */
+  void RunUntil (Time stop);
+
+  /**
+   * Write the state of the kernel to a binary checkpoint.  The backoff
+   * streams must have been fixed with AssignStreams.
+   *
+   * \param os output stream, opened in binary mode
+   */
+  void Save (std::ostream &os) const;
+  /**
+   * Replace the state of the kernel with one written by Save.  The
+   * RngSeedManager seed and run must be those of the saved kernel.
+   *
+   * \param is input stream, opened in binary mode
+   * \returns false if it does not hold a checkpoint of a line of this
+   * size, in which case the kernel is left in an undefined state
+   */
+  bool Restore (std::istream &is);
+
+  /// \returns the number of nodes, gateways included
+  uint32_t GetNNodes (void) const;
+  /// \returns the length of one slot
+  static Time GetSlotLength (void);
+  /// \returns the time of the slot being run, or after Run the end of the run
+  Time GetNow (void) const;
+  /// \returns the number of MAC actions run so far
+  uint64_t GetNActions (void) const;
+  /**
+   * \param node position on the line
+   * \returns the MAC counters of the node
+   */
+  const LwsnMacStats &GetStats (uint32_t node) const;
+  /// \returns the distinct readings queued by either gateway
+  uint32_t GetNDelivered (void) const;
+
+private:
+  /// Side of a node a frame is sent to or received from
+  enum Side
+  {
+    LEFT = 0,
+    RIGHT = 1
+  };
+
+  /// The SimpleNetDevice method an action stands for
+  enum Action
+  {
+    ORIGINAL_TRANSMISSION,
+    RECEIVE_START,
+    RECEIVE_END,
+    SET_SLEEP,
+    ACK_CHECK,
+    ORIGINAL_ACK_CHECK,
+    WAIT_SEND,
+    RESEND,
+    REORIGINAL_SEND,
+    ACK_SEND,
+    FORWARDING
+  };
+
+  /// A frame: what the LwsnHeader and LwsnTimestampTag of a packet carry
+  struct Frame
+  {
+    uint32_t key;   //!< Osid << 16 | Did
+    uint16_t type;  //!< LwsnHeader type
+    int64_t origin; //!< slot the reading was generated in
+  };
+
+  /// A scheduled action
+  struct Event
+  {
+    int64_t slot;  //!< slot the action is due in
+    uint32_t node; //!< node the action runs on
+    uint8_t action; //!< Action
+    uint8_t side;  //!< Side the frame goes to, or comes from for receptions
+    Frame frame;   //!< frame argument
+    uint32_t reception; //!< interference tracker id (RECEIVE_END only)
+  };
+
+  void Schedule (int64_t delay, uint32_t node, Action action, Side side, const Frame &frame,
+                 uint32_t reception = 0);
+  void Schedule (int64_t delay, uint32_t node, Action action);
+  void RunSlot (void);
+  void RunAction (const Event &ev);
+
+  bool IsGateway (uint32_t node) const;
+  bool IsQueued (uint32_t node, uint32_t key) const;
+  bool Enqueue (uint32_t node, const Frame &frame);
+  Frame Dequeue (uint32_t node);
+  uint32_t PeekKey (uint32_t node) const;
+  void QueueCheck (uint32_t node, const Frame &frame);
+  LwsnBackoff RandTime (uint32_t node);
+
+  void ChannelSend (uint32_t node, const Frame &frame, Side to);
+  void ReceiveStart (uint32_t node, const Frame &frame, Side from);
+  void ReceiveEnd (uint32_t node, const Frame &frame, Side from, uint32_t reception);
+  void ReceiveFrame (uint32_t node, const Frame &frame, Side from);
+  void OriginalTransmission (uint32_t node, const Frame &frame, bool header);
+  void OriginalWaitAck (uint32_t node, const Frame &frame);
+  void OriginalAckCheck (uint32_t node, const Frame &frame);
+  void ReOriginalSend (uint32_t node, const Frame &frame);
+  void Forwarding (uint32_t node, const Frame &frame, Side to);
+  void AckSend (uint32_t node, const Frame &frame, Side to);
+  void WaitAck (uint32_t node, const Frame &frame, Side to);
+  void AckCheck (uint32_t node, const Frame &frame, Side to);
+  void ReSend (uint32_t node, const Frame &frame, Side to);
+  void WaitSend (uint32_t node);
+  /// Clear the frame in flight after it is acked or given up
+  void Done (uint32_t node);
+
+  uint32_t m_numNode;    //!< sensors and gateways
+  int64_t m_slotTimeStep; //!< slot length, in time steps
+  uint16_t m_round;      //!< backoff rounds
+  uint32_t m_queueSize;  //!< capacity of each queue
+  int64_t m_now;         //!< slot being run
+  uint64_t m_nActions;   //!< actions run
+  uint64_t m_pending;    //!< actions scheduled and not run yet
+
+  std::vector<std::vector<Event> > m_wheel; //!< pending actions by slot modulo the wheel size
+
+  // MAC state of SimpleNetDevice, one entry per node
+  std::vector<uint8_t> m_sendFlag;     //!< send_flag
+  std::vector<uint8_t> m_waitAck;      //!< wait_ack
+  std::vector<uint8_t> m_rackFlag;     //!< rack_flag
+  std::vector<uint8_t> m_lackFlag;     //!< lack_flag
+  std::vector<uint8_t> m_lastNode;     //!< last_node
+  std::vector<uint8_t> m_hasTx;        //!< m_txPacket != 0
+  std::vector<uint32_t> m_txKey;       //!< key of m_txPacket
+  std::vector<uint32_t> m_txArray;     //!< txarray, as a key
+  std::vector<uint32_t> m_k;           //!< backoff round
+  std::vector<uint16_t> m_ndid;        //!< next Did
+  std::vector<LwsnInterferenceTracker> m_interference; //!< receptions in progress, in slots
+
+  // transmit queues, m_queueSize entries per node used as a ring
+  std::vector<uint32_t> m_queueKey;    //!< frame keys, EMPTY_KEY when free
+  std::vector<uint16_t> m_queueType;   //!< frame types
+  std::vector<int64_t> m_queueOrigin;  //!< frame origins
+  std::vector<uint32_t> m_queueHead;   //!< ring index of the head
+  std::vector<uint32_t> m_queueCount;  //!< frames queued
+
+  std::vector<Ptr<UniformRandomVariable> > m_backoff; //!< backoff draws
+  std::vector<int64_t> m_stream;       //!< stream of each m_backoff, -1 if not fixed
+  std::vector<uint64_t> m_draws;       //!< values drawn from each m_backoff
+  std::vector<LwsnMacStats> m_stats;   //!< counters
+};
+
+} // namespace ns3
+
+#endif /* LWSN_LINE_KERNEL_H */
@@ -0,0 +1,486 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-mac-stats.h"
+#include "lwsn-checkpoint.h"
+#include <algorithm>
+
+namespace ns3 {
+
+LwsnLatencyHistogram::LwsnLatencyHistogram ()
+  : m_count (0),
+    m_sum (0),
+    m_min (0),
+    m_max (0)
+{
+}
+
+uint32_t
+LwsnLatencyHistogram::GetBin (uint64_t ts)
+{
+  if (ts < 32)
+    {
+      return ts;
+    }
+  uint32_t exponent = 5;
+  while ((ts >> (exponent + 1)) != 0)
+    {
+      exponent++;
+    }
+  return (exponent - 4) * 32 + ((ts >> (exponent - 5)) & 31);
+}
+
+uint64_t
+LwsnLatencyHistogram::GetBinStart (uint32_t bin, uint64_t &width)
+{
+  if (bin < 32)
+    {
+      width = 1;
+      return bin;
+    }
+  uint32_t exponent = bin / 32 + 4;
+  width = static_cast<uint64_t> (1) << (exponent - 5);
+  return (32 + bin % 32) * width;
+}
+
+void
+LwsnLatencyHistogram::Add (Time latency)
+{
+  AddTimeStep (latency.GetTimeStep ());
+}
+
+void
+LwsnLatencyHistogram::AddTimeStep (int64_t ts)
+{
+  if (ts < 0)
+    {
+      ts = 0;
+    }
+  uint32_t bin = GetBin (ts);
+  if (bin >= m_bins.size ())
+    {
+      m_bins.resize (bin + 1, 0);
+    }
+  m_bins[bin]++;
+  if (m_count == 0 || ts < m_min)
+    {
+      m_min = ts;
+    }
+  if (m_count == 0 || ts > m_max)
+    {
+      m_max = ts;
+    }
+  m_count++;
+  m_sum += ts;
+}
+
+void
+LwsnLatencyHistogram::Merge (const LwsnLatencyHistogram &other)
+{
+  if (other.m_count == 0)
+    {
+      return;
+    }
+  if (other.m_bins.size () > m_bins.size ())
+    {
+      m_bins.resize (other.m_bins.size (), 0);
+    }
+  for (uint32_t i = 0; i < other.m_bins.size (); i++)
+    {
+      m_bins[i] += other.m_bins[i];
+    }
+  if (m_count == 0 || other.m_min < m_min)
+    {
+      m_min = other.m_min;
+    }
+  if (m_count == 0 || other.m_max > m_max)
+    {
+      m_max = other.m_max;
+    }
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+}
+
+uint64_t
+LwsnLatencyHistogram::GetCount (void) const
+{
+  return m_count;
+}
+
+Time
+LwsnLatencyHistogram::GetMean (void) const
+{
+  return m_count > 0 ? TimeStep (m_sum / static_cast<int64_t> (m_count)) : Time (0);
+}
+
+Time
+LwsnLatencyHistogram::GetMin (void) const
+{
+  return TimeStep (m_min);
+}
+
+Time
+LwsnLatencyHistogram::GetMax (void) const
+{
+  return TimeStep (m_max);
+}
+
+Time
+LwsnLatencyHistogram::GetQuantile (double q) const
+{
+  if (m_count == 0)
+    {
+      return Time (0);
+    }
+  // rank of the sample wanted, counted from 1
+  uint64_t rank = static_cast<uint64_t> (q * m_count + 0.5);
+  rank = std::max<uint64_t> (1, std::min (rank, m_count));
+  uint64_t seen = 0;
+  for (uint32_t bin = 0; bin < m_bins.size (); bin++)
+    {
+      seen += m_bins[bin];
+      if (seen >= rank)
+        {
+          uint64_t width;
+          int64_t value = GetBinStart (bin, width) + width / 2;
+          return TimeStep (std::max (m_min, std::min (value, m_max)));
+        }
+    }
+  return TimeStep (m_max);
+}
+
+void
+LwsnLatencyHistogram::Serialize (std::ostream &os) const
+{
+  LwsnCheckpoint::WriteVector (os, m_bins);
+  LwsnCheckpoint::Write (os, m_count);
+  LwsnCheckpoint::Write (os, m_sum);
+  LwsnCheckpoint::Write (os, m_min);
+  LwsnCheckpoint::Write (os, m_max);
+}
+
+bool
+LwsnLatencyHistogram::Deserialize (std::istream &is)
+{
+  return LwsnCheckpoint::ReadVector (is, m_bins)
+         && LwsnCheckpoint::Read (is, m_count)
+         && LwsnCheckpoint::Read (is, m_sum)
+         && LwsnCheckpoint::Read (is, m_min)
+         && LwsnCheckpoint::Read (is, m_max);
+}
+
+const uint32_t LwsnMacStats::N_TYPES;
+
+LwsnMacStats::LwsnMacStats ()
+{
+  Reset ();
+}
+
+void
+LwsnMacStats::Reset (void)
+{
+  for (uint32_t i = 0; i <= N_TYPES; i++)
+    {
+      m_tx[i] = 0;
+    }
+  m_retransmissions = 0;
+  m_collisions = 0;
+  m_giveUps = 0;
+  m_backoff.clear ();
+  m_queueHighWater = 0;
+  m_gatewayReceived = 0;
+  m_flows.clear ();
+  m_coded = 0;
+  m_decoded = 0;
+  m_codingFailures = 0;
+  m_iacksSaved = 0;
+  m_implicitAcks = 0;
+  m_failovers = 0;
+  m_aggregated = 0;
+}
+
+void
+LwsnMacStats::Merge (const LwsnMacStats &other)
+{
+  for (uint32_t i = 0; i <= N_TYPES; i++)
+    {
+      m_tx[i] += other.m_tx[i];
+    }
+  m_retransmissions += other.m_retransmissions;
+  m_collisions += other.m_collisions;
+  m_giveUps += other.m_giveUps;
+  if (other.m_backoff.size () > m_backoff.size ())
+    {
+      m_backoff.resize (other.m_backoff.size (), 0);
+    }
+  for (uint32_t i = 0; i < other.m_backoff.size (); i++)
+    {
+      m_backoff[i] += other.m_backoff[i];
+    }
+  m_queueHighWater = std::max (m_queueHighWater, other.m_queueHighWater);
+  m_gatewayReceived += other.m_gatewayReceived;
+  for (std::map<uint16_t, LwsnLatencyHistogram>::const_iterator i = other.m_flows.begin (); i != other.m_flows.end (); ++i)
+    {
+      m_flows[i->first].Merge (i->second);
+    }
+  m_coded += other.m_coded;
+  m_decoded += other.m_decoded;
+  m_codingFailures += other.m_codingFailures;
+  m_iacksSaved += other.m_iacksSaved;
+  m_implicitAcks += other.m_implicitAcks;
+  m_failovers += other.m_failovers;
+  m_aggregated += other.m_aggregated;
+}
+
+void
+LwsnMacStats::NotifyDelivery (uint16_t osid, Time latency)
+{
+  m_flows[osid].Add (latency);
+}
+
+void
+LwsnMacStats::NotifyDeliveryTimeStep (uint16_t osid, int64_t ts)
+{
+  m_flows[osid].AddTimeStep (ts);
+}
+
+uint64_t
+LwsnMacStats::GetNTx (uint16_t type) const
+{
+  return m_tx[type < N_TYPES ? type : N_TYPES];
+}
+
+uint64_t
+LwsnMacStats::GetNTx (void) const
+{
+  uint64_t total = 0;
+  for (uint32_t i = 0; i <= N_TYPES; i++)
+    {
+      total += m_tx[i];
+    }
+  return total;
+}
+
+uint64_t
+LwsnMacStats::GetNRetransmissions (void) const
+{
+  return m_retransmissions;
+}
+
+uint64_t
+LwsnMacStats::GetNCollisions (void) const
+{
+  return m_collisions;
+}
+
+uint64_t
+LwsnMacStats::GetNGiveUps (void) const
+{
+  return m_giveUps;
+}
+
+const std::vector<uint64_t> &
+LwsnMacStats::GetBackoffHistogram (void) const
+{
+  return m_backoff;
+}
+
+uint32_t
+LwsnMacStats::GetQueueHighWater (void) const
+{
+  return m_queueHighWater;
+}
+
+uint64_t
+LwsnMacStats::GetNGatewayReceived (void) const
+{
+  return m_gatewayReceived;
+}
+
+uint64_t
+LwsnMacStats::GetNDelivered (void) const
+{
+  uint64_t total = 0;
+  for (std::map<uint16_t, LwsnLatencyHistogram>::const_iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+    {
+      total += i->second.GetCount ();
+    }
+  return total;
+}
+
+const std::map<uint16_t, LwsnLatencyHistogram> &
+LwsnMacStats::GetFlows (void) const
+{
+  return m_flows;
+}
+
+uint64_t
+LwsnMacStats::GetNCoded (void) const
+{
+  return m_coded;
+}
+
+uint64_t
+LwsnMacStats::GetNDecoded (void) const
+{
+  return m_decoded;
+}
+
+uint64_t
+LwsnMacStats::GetNCodingFailures (void) const
+{
+  return m_codingFailures;
+}
+
+uint64_t
+LwsnMacStats::GetNIacksSaved (void) const
+{
+  return m_iacksSaved;
+}
+
+uint64_t
+LwsnMacStats::GetNImplicitAcks (void) const
+{
+  return m_implicitAcks;
+}
+
+uint64_t
+LwsnMacStats::GetNFailovers (void) const
+{
+  return m_failovers;
+}
+
+uint64_t
+LwsnMacStats::GetNAggregated (void) const
+{
+  return m_aggregated;
+}
+
+void
+LwsnMacStats::PrintCsvHeader (std::ostream &os)
+{
+  os << "txGAnc,txOriginal,txForwarding,txIack,txNetworkCoding,txAggregate,txBlockAck,txOther,"
+     << "retransmissions,collisions,giveUps,queueHighWater,gatewayReceived,delivered,"
+     << "coded,decoded,codingFailures,iacksSaved,implicitAcks,failovers,aggregated";
+}
+
+void
+LwsnMacStats::PrintCsv (std::ostream &os) const
+{
+  for (uint32_t i = 0; i <= N_TYPES; i++)
+    {
+      os << m_tx[i] << ",";
+    }
+  os << m_retransmissions << "," << m_collisions << "," << m_giveUps << ","
+     << m_queueHighWater << "," << m_gatewayReceived << "," << GetNDelivered () << ","
+     << m_coded << "," << m_decoded << "," << m_codingFailures << ","
+     << m_iacksSaved << "," << m_implicitAcks << "," << m_failovers << "," << m_aggregated;
+}
+
+void
+LwsnMacStats::PrintJson (std::ostream &os) const
+{
+  os << "{\"tx\":[";
+  for (uint32_t i = 0; i <= N_TYPES; i++)
+    {
+      os << (i > 0 ? "," : "") << m_tx[i];
+    }
+  os << "],\"retransmissions\":" << m_retransmissions
+     << ",\"collisions\":" << m_collisions
+     << ",\"giveUps\":" << m_giveUps
+     << ",\"backoff\":[";
+  for (uint32_t i = 0; i < m_backoff.size (); i++)
+    {
+      os << (i > 0 ? "," : "") << m_backoff[i];
+    }
+  os << "],\"queueHighWater\":" << m_queueHighWater
+     << ",\"gatewayReceived\":" << m_gatewayReceived
+     << ",\"coded\":" << m_coded
+     << ",\"decoded\":" << m_decoded
+     << ",\"codingFailures\":" << m_codingFailures
+     << ",\"iacksSaved\":" << m_iacksSaved
+     << ",\"implicitAcks\":" << m_implicitAcks
+     << ",\"failovers\":" << m_failovers
+     << ",\"aggregated\":" << m_aggregated
+     << ",\"flows\":[";
+  for (std::map<uint16_t, LwsnLatencyHistogram>::const_iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+    {
+      const LwsnLatencyHistogram &flow = i->second;
+      os << (i != m_flows.begin () ? "," : "")
+         << "{\"osid\":" << i->first
+         << ",\"delivered\":" << flow.GetCount ()
+         << ",\"latencyMean\":" << flow.GetMean ().GetSeconds ()
+         << ",\"latencyMin\":" << flow.GetMin ().GetSeconds ()
+         << ",\"latencyP50\":" << flow.GetQuantile (0.5).GetSeconds ()
+         << ",\"latencyP99\":" << flow.GetQuantile (0.99).GetSeconds ()
+         << ",\"latencyMax\":" << flow.GetMax ().GetSeconds () << "}";
+    }
+  os << "]}";
+}
+
+void
+LwsnMacStats::Serialize (std::ostream &os) const
+{
+  for (uint32_t i = 0; i <= N_TYPES; i++)
+    {
+      LwsnCheckpoint::Write (os, m_tx[i]);
+    }
+  LwsnCheckpoint::Write (os, m_retransmissions);
+  LwsnCheckpoint::Write (os, m_collisions);
+  LwsnCheckpoint::Write (os, m_giveUps);
+  LwsnCheckpoint::WriteVector (os, m_backoff);
+  LwsnCheckpoint::Write (os, m_queueHighWater);
+  LwsnCheckpoint::Write (os, m_gatewayReceived);
+  LwsnCheckpoint::Write<uint64_t> (os, m_flows.size ());
+  for (std::map<uint16_t, LwsnLatencyHistogram>::const_iterator i = m_flows.begin (); i != m_flows.end (); ++i)
+    {
+      LwsnCheckpoint::Write (os, i->first);
+      i->second.Serialize (os);
+    }
+  LwsnCheckpoint::Write (os, m_coded);
+  LwsnCheckpoint::Write (os, m_decoded);
+  LwsnCheckpoint::Write (os, m_codingFailures);
+  LwsnCheckpoint::Write (os, m_iacksSaved);
+  LwsnCheckpoint::Write (os, m_implicitAcks);
+  LwsnCheckpoint::Write (os, m_failovers);
+  LwsnCheckpoint::Write (os, m_aggregated);
+}
+
+bool
+LwsnMacStats::Deserialize (std::istream &is)
+{
+  Reset ();
+  for (uint32_t i = 0; i <= N_TYPES; i++)
+    {
+      if (!LwsnCheckpoint::Read (is, m_tx[i]))
+        {
+          return false;
+        }
+    }
+  uint64_t flows;
+  if (!LwsnCheckpoint::Read (is, m_retransmissions)
+      || !LwsnCheckpoint::Read (is, m_collisions)
+      || !LwsnCheckpoint::Read (is, m_giveUps)
+      || !LwsnCheckpoint::ReadVector (is, m_backoff)
+      || !LwsnCheckpoint::Read (is, m_queueHighWater)
+      || !LwsnCheckpoint::Read (is, m_gatewayReceived)
+      || !LwsnCheckpoint::Read (is, flows))
+    {
+      return false;
+    }
+  for (uint64_t i = 0; i < flows; i++)
+    {
+      uint16_t osid;
+      if (!LwsnCheckpoint::Read (is, osid) || !m_flows[osid].Deserialize (is))
+        {
+          return false;
+        }
+    }
+  return LwsnCheckpoint::Read (is, m_coded)
+         && LwsnCheckpoint::Read (is, m_decoded)
+         && LwsnCheckpoint::Read (is, m_codingFailures)
+         && LwsnCheckpoint::Read (is, m_iacksSaved)
+         && LwsnCheckpoint::Read (is, m_implicitAcks)
+         && LwsnCheckpoint::Read (is, m_failovers)
+         && LwsnCheckpoint::Read (is, m_aggregated);
+}
+
+} // namespace ns3
@@ -0,0 +1,317 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_MAC_STATS_H
+#define LWSN_MAC_STATS_H
+
+#include <stdint.h>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Streaming latency histogram with bounded relative error.
+ *
+ * Latencies are binned on a log-linear scale: exact below 32 time
+ * steps, then 32 bins per power of two, so that a quantile read back is
+ * within about 3% of the true value.  Only the bins in use are stored,
+ * whatever the number of samples.
+ */
+class LwsnLatencyHistogram
+{
+public:
+  LwsnLatencyHistogram ();
+
+  /**
+   * \param latency latency to add
+   */
+  void Add (Time latency);
+  /**
+   * Same as Add, without constructing a Time, so that it can be called
+   * away from the simulator thread.
+   *
+   * \param ts latency, in time steps
+   */
+  void AddTimeStep (int64_t ts);
+  /**
+   * Add every sample of another histogram.
+   *
+   * \param other the histogram to merge
+   */
+  void Merge (const LwsnLatencyHistogram &other);
+
+  /// \returns the number of samples
+  uint64_t GetCount (void) const;
+  /// \returns the mean latency, zero if empty
+  Time GetMean (void) const;
+  /// \returns the smallest latency, zero if empty
+  Time GetMin (void) const;
+  /// \returns the largest latency, zero if empty
+  Time GetMax (void) const;
+  /**
+   * \param q quantile, between 0 and 1
+   * \returns the latency below which a fraction q of the samples lie,
+   * zero if empty
+   */
+  Time GetQuantile (double q) const;
+
+  /**
+   * Write the histogram as a LwsnCheckpoint field.
+   *
+   * \param os output stream
+   */
+  void Serialize (std::ostream &os) const;
+  /**
+   * \param is input stream
+   * \returns false if it does not hold a histogram written by Serialize
+   */
+  bool Deserialize (std::istream &is);
+
+private:
+  /**
+   * \param ts latency in time steps
+   * \returns the bin of ts
+   */
+  static uint32_t GetBin (uint64_t ts);
+  /**
+   * \param bin a bin index
+   * \param width set to the width of the bin
+   * \returns the lowest value of the bin, in time steps
+   */
+  static uint64_t GetBinStart (uint32_t bin, uint64_t &width);
+
+  std::vector<uint64_t> m_bins; //!< samples per bin
+  uint64_t m_count;             //!< number of samples
+  int64_t m_sum;                //!< sum of the samples, in time steps
+  int64_t m_min;                //!< smallest sample, in time steps
+  int64_t m_max;                //!< largest sample, in time steps
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Counters of the LWSN MAC of one SimpleNetDevice.
+ *
+ * The Notify methods are inline and non-virtual so that the MAC can
+ * update them on every frame.  The block is exported once at the end of
+ * a run with PrintCsv or PrintJson, or periodically through the
+ * StatsSnapshot trace source of the device.
+ */
+class LwsnMacStats
+{
+public:
+  /// Number of LwsnHeader frame types counted separately
+  static const uint32_t N_TYPES = 7;
+
+  LwsnMacStats ();
+
+  /**
+   * Clear every counter.
+   */
+  void Reset (void);
+  /**
+   * Add the counters of another block: counts and histograms are
+   * summed, the queue high-water mark is the larger one and flows of the
+   * same Osid are merged.
+   *
+   * \param other the block to merge
+   */
+  void Merge (const LwsnMacStats &other);
+
+  /**
+   * \param type LwsnHeader type of the frame put on the channel
+   */
+  void NotifyTx (uint16_t type)
+  {
+    m_tx[type < N_TYPES ? type : N_TYPES]++;
+  }
+  /// A frame is sent again after a backoff
+  void NotifyRetransmission (void)
+  {
+    m_retransmissions++;
+  }
+  /// Two frames overlapped at this receiver
+  void NotifyCollision (void)
+  {
+    m_collisions++;
+  }
+  /**
+   * \param slots backoff drawn, in slots
+   */
+  void NotifyBackoff (uint32_t slots)
+  {
+    if (slots >= m_backoff.size ())
+      {
+        m_backoff.resize (slots + 1, 0);
+      }
+    m_backoff[slots]++;
+  }
+  /// The backoff rounds are exhausted and the frame is dropped
+  void NotifyGiveUp (void)
+  {
+    m_giveUps++;
+  }
+  /**
+   * \param length queue length after an enqueue
+   */
+  void NotifyQueueLength (uint32_t length)
+  {
+    if (length > m_queueHighWater)
+      {
+        m_queueHighWater = length;
+      }
+  }
+  /// A gateway received an ORIGINAL_TRANSMISSION or FORWARDING frame
+  void NotifyGatewayReceive (void)
+  {
+    m_gatewayReceived++;
+  }
+  /**
+   * A gateway queued a reading it had not received before.
+   *
+   * \param osid originating sensor of the reading
+   * \param latency delivery latency
+   */
+  void NotifyDelivery (uint16_t osid, Time latency);
+  /**
+   * Same as NotifyDelivery, without constructing a Time.
+   *
+   * \param osid originating sensor of the reading
+   * \param ts delivery latency, in time steps
+   */
+  void NotifyDeliveryTimeStep (uint16_t osid, int64_t ts);
+  /// A NETWORK_CODING frame was built; its retransmissions are not counted
+  void NotifyCoded (void)
+  {
+    m_coded++;
+  }
+  /// A NETWORK_CODING frame was decoded
+  void NotifyDecoded (void)
+  {
+    m_decoded++;
+  }
+  /// A NETWORK_CODING frame could not be decoded
+  void NotifyCodingFailure (void)
+  {
+    m_codingFailures++;
+  }
+  /// An IACK was not sent since the forward of the frame acknowledges it
+  void NotifyIackSaved (void)
+  {
+    m_iacksSaved++;
+  }
+  /// An overheard forward acknowledged the frame in flight
+  void NotifyImplicitAck (void)
+  {
+    m_implicitAcks++;
+  }
+  /// A reading was resent towards the other gateway after its route failed
+  void NotifyFailover (void)
+  {
+    m_failovers++;
+  }
+  /**
+   * \param readings readings bundled in the AGGREGATE frame sent
+   */
+  void NotifyAggregate (uint32_t readings)
+  {
+    m_aggregated += readings;
+  }
+
+  /**
+   * \param type LwsnHeader frame type
+   * \returns the frames of this type put on the channel
+   */
+  uint64_t GetNTx (uint16_t type) const;
+  /**
+   * \returns the frames put on the channel, all types together
+   */
+  uint64_t GetNTx (void) const;
+  /// \returns the retransmissions
+  uint64_t GetNRetransmissions (void) const;
+  /// \returns the collisions seen by this receiver
+  uint64_t GetNCollisions (void) const;
+  /// \returns the frames dropped after the last backoff round
+  uint64_t GetNGiveUps (void) const;
+  /// \returns the backoff histogram, indexed by slots drawn
+  const std::vector<uint64_t> &GetBackoffHistogram (void) const;
+  /// \returns the largest queue length seen
+  uint32_t GetQueueHighWater (void) const;
+  /// \returns the frames received as a gateway, duplicates included
+  uint64_t GetNGatewayReceived (void) const;
+  /// \returns the distinct readings delivered to this gateway
+  uint64_t GetNDelivered (void) const;
+  /// \returns the delivery latency histogram by originating sensor
+  const std::map<uint16_t, LwsnLatencyHistogram> &GetFlows (void) const;
+  /// \returns the NETWORK_CODING frames built, retransmissions left out
+  uint64_t GetNCoded (void) const;
+  /// \returns the NETWORK_CODING frames decoded
+  uint64_t GetNDecoded (void) const;
+  /// \returns the NETWORK_CODING frames that could not be decoded
+  uint64_t GetNCodingFailures (void) const;
+  /// \returns the IACK frames left out in implicit-ACK mode
+  uint64_t GetNIacksSaved (void) const;
+  /// \returns the frames in flight acknowledged by an overheard forward
+  uint64_t GetNImplicitAcks (void) const;
+  /// \returns the readings resent towards the other gateway
+  uint64_t GetNFailovers (void) const;
+  /// \returns the readings sent in AGGREGATE frames, retransmissions included
+  uint64_t GetNAggregated (void) const;
+
+  /**
+   * Print the column names matching PrintCsv, without a newline.
+   *
+   * \param os output stream
+   */
+  static void PrintCsvHeader (std::ostream &os);
+  /**
+   * Print the scalar counters as one CSV record, without a newline.
+   *
+   * \param os output stream
+   */
+  void PrintCsv (std::ostream &os) const;
+  /**
+   * Print every counter, the backoff histogram and the flows as one
+   * JSON object.
+   *
+   * \param os output stream
+   */
+  void PrintJson (std::ostream &os) const;
+
+  /**
+   * Write every counter as LwsnCheckpoint fields.
+   *
+   * \param os output stream
+   */
+  void Serialize (std::ostream &os) const;
+  /**
+   * \param is input stream
+   * \returns false if it does not hold counters written by Serialize
+   */
+  bool Deserialize (std::istream &is);
+
+private:
+  uint64_t m_tx[N_TYPES + 1];          //!< frames sent by type, unknown types last
+  uint64_t m_retransmissions;          //!< retransmissions
+  uint64_t m_collisions;               //!< collisions
+  uint64_t m_giveUps;                  //!< frames dropped after the last round
+  std::vector<uint64_t> m_backoff;     //!< backoff histogram
+  uint32_t m_queueHighWater;           //!< largest queue length
+  uint64_t m_gatewayReceived;          //!< frames received as a gateway
+  std::map<uint16_t, LwsnLatencyHistogram> m_flows; //!< delivery latency by Osid
+  uint64_t m_coded;                    //!< NETWORK_CODING frames built
+  uint64_t m_decoded;                  //!< NETWORK_CODING frames decoded
+  uint64_t m_codingFailures;           //!< undecodable NETWORK_CODING frames
+  uint64_t m_iacksSaved;               //!< IACK frames left out
+  uint64_t m_implicitAcks;             //!< overheard forwards taken as IACK
+  uint64_t m_failovers;                //!< readings rerouted to the other gateway
+  uint64_t m_aggregated;               //!< readings sent in AGGREGATE frames
+};
+
+} // namespace ns3
+
+#endif /* LWSN_MAC_STATS_H */
@@ -0,0 +1,147 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-mac-trace.h"
+#include "ns3/assert.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+namespace {
+
+/// Header in front of the records of one device
+struct LwsnMacTraceHeader
+{
+  uint32_t magic;      //!< MAGIC, in the byte order of the writer
+  uint16_t version;    //!< format version
+  uint16_t recordSize; //!< sizeof (LwsnMacTraceRecord)
+  uint32_t count;      //!< number of records that follow
+  uint32_t reserved;   //!< zero
+};
+
+const uint32_t MAGIC = 0x544d574c; // "LWMT"
+const uint16_t VERSION = 1;
+
+} // anonymous namespace
+
+LwsnMacTrace::LwsnMacTrace ()
+  : m_total (0)
+{
+}
+
+void
+LwsnMacTrace::SetCapacity (uint32_t capacity)
+{
+  uint32_t size = 0;
+  if (capacity > 0)
+    {
+      size = 1;
+      while (size < capacity)
+        {
+          size <<= 1;
+        }
+    }
+  m_ring.assign (size, LwsnMacTraceRecord ());
+  m_total = 0;
+}
+
+uint32_t
+LwsnMacTrace::GetCapacity (void) const
+{
+  return m_ring.size ();
+}
+
+uint64_t
+LwsnMacTrace::GetNTotal (void) const
+{
+  return m_total;
+}
+
+uint32_t
+LwsnMacTrace::GetNRecords (void) const
+{
+  return m_total < m_ring.size () ? m_total : m_ring.size ();
+}
+
+const LwsnMacTraceRecord &
+LwsnMacTrace::Get (uint32_t i) const
+{
+  NS_ASSERT (i < GetNRecords ());
+  uint64_t first = m_total - GetNRecords ();
+  return m_ring[(first + i) & (m_ring.size () - 1)];
+}
+
+void
+LwsnMacTrace::Write (std::ostream &os) const
+{
+  LwsnMacTraceHeader header;
+  header.magic = MAGIC;
+  header.version = VERSION;
+  header.recordSize = sizeof (LwsnMacTraceRecord);
+  header.count = GetNRecords ();
+  header.reserved = 0;
+  os.write (reinterpret_cast<const char *> (&header), sizeof (header));
+  for (uint32_t i = 0; i < header.count; i++)
+    {
+      os.write (reinterpret_cast<const char *> (&Get (i)), sizeof (LwsnMacTraceRecord));
+    }
+}
+
+bool
+LwsnMacTrace::Read (std::istream &is, std::vector<LwsnMacTraceRecord> &records)
+{
+  LwsnMacTraceHeader header;
+  if (!is.read (reinterpret_cast<char *> (&header), sizeof (header)))
+    {
+      return false;
+    }
+  if (header.magic != MAGIC || header.version != VERSION
+      || header.recordSize != sizeof (LwsnMacTraceRecord))
+    {
+      return false;
+    }
+  uint32_t first = records.size ();
+  records.resize (first + header.count);
+  if (header.count > 0
+      && !is.read (reinterpret_cast<char *> (&records[first]), header.count * sizeof (LwsnMacTraceRecord)))
+    {
+      records.resize (first);
+      return false;
+    }
+  return true;
+}
+
+const char *
+LwsnMacTrace::GetEventName (uint8_t event)
+{
+  switch (event)
+    {
+    case TX:
+      return "TX";
+    case RX:
+      return "RX";
+    case COLLISION:
+      return "COLLISION";
+    case BACKOFF:
+      return "BACKOFF";
+    case ACK:
+      return "ACK";
+    case DROP:
+      return "DROP";
+    case DUP:
+      return "DUP";
+    default:
+      return "UNKNOWN";
+    }
+}
+
+void
+LwsnMacTrace::Print (std::ostream &os, const LwsnMacTraceRecord &record)
+{
+  os << TimeStep (record.time).GetSeconds ()
+     << " " << record.sid
+     << " " << GetEventName (record.event)
+     << " " << record.osid
+     << " " << record.did
+     << " " << static_cast<uint32_t> (record.arg);
+}
+
+} // namespace ns3
@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_MAC_TRACE_H
+#define LWSN_MAC_TRACE_H
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+/**
+ * \ingroup network
+ *
+ * Record a MAC event in a LwsnMacTrace at the current simulation time.
+ * Expands to nothing unless NS3_LWSN_MAC_TRACE is defined (waf configure
+ * --enable-lwsn-mac-trace), so that none of the arguments is evaluated
+ * in a normal build.
+ *
+ * \param trace the LwsnMacTrace
+ * \param event a LwsnMacTrace::Event
+ * \param sid Sid of the device
+ * \param osid Osid of the frame, 0 if the event is not about one frame
+ * \param did Did of the frame, 0 if the event is not about one frame
+ * \param arg event argument, see LwsnMacTrace::Event
+ */
+#ifdef NS3_LWSN_MAC_TRACE
+#define LWSN_MAC_TRACE(trace, event, sid, osid, did, arg)                \
+  (trace).Record (ns3::Simulator::Now ().GetTimeStep (), event, sid, osid, did, arg)
+#else
+#define LWSN_MAC_TRACE(trace, event, sid, osid, did, arg)
+#endif
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * One MAC event: 16 bytes, written to disk as is.
+ */
+struct LwsnMacTraceRecord
+{
+  int64_t time;  //!< simulation time, in time steps
+  uint16_t sid;  //!< Sid of the device
+  uint16_t osid; //!< Osid of the frame
+  uint16_t did;  //!< Did of the frame
+  uint8_t event; //!< LwsnMacTrace::Event
+  uint8_t arg;   //!< event argument
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Binary ring buffer of the MAC events of one SimpleNetDevice.
+ *
+ * Keeps the last Capacity events as fixed-size records; older ones are
+ * overwritten.  Write dumps them, oldest first, behind a small header
+ * so that the dumps of several devices can be concatenated into one
+ * file and read back with Read, e.g. by the lwsn-mac-trace-decode
+ * program.  Records are only produced through LWSN_MAC_TRACE, which
+ * compiles to nothing unless NS3_LWSN_MAC_TRACE is defined.
+ */
+class LwsnMacTrace
+{
+public:
+  /// MAC event types
+  enum Event
+  {
+    TX,        //!< frame sent; arg is the LwsnHeader type
+    RX,        //!< frame received intact; arg is the LwsnHeader type
+    COLLISION, //!< frame lost to an overlap or received while sending
+    BACKOFF,   //!< backoff drawn; arg is the number of units, at most 255
+    ACK,       //!< frame in flight acknowledged; arg is 1 for an overheard forward
+    DROP,      //!< frame dropped; arg is 0 for a full queue, 1 after the last round
+    DUP        //!< frame already queued
+  };
+
+  LwsnMacTrace ();
+
+  /**
+   * Forget the recorded events and keep at most capacity of them from
+   * now on; zero turns recording off.
+   *
+   * \param capacity number of records, rounded up to a power of two
+   */
+  void SetCapacity (uint32_t capacity);
+  /// \returns the number of records kept
+  uint32_t GetCapacity (void) const;
+
+  /**
+   * \param time simulation time, in time steps
+   * \param event the event
+   * \param sid Sid of the device
+   * \param osid Osid of the frame
+   * \param did Did of the frame
+   * \param arg event argument
+   */
+  void Record (int64_t time, Event event, uint16_t sid, uint16_t osid, uint16_t did, uint32_t arg)
+  {
+    if (m_ring.empty ())
+      {
+        return;
+      }
+    LwsnMacTraceRecord &r = m_ring[m_total & (m_ring.size () - 1)];
+    r.time = time;
+    r.sid = sid;
+    r.osid = osid;
+    r.did = did;
+    r.event = event;
+    r.arg = arg > 0xff ? 0xff : arg;
+    m_total++;
+  }
+
+  /// \returns the number of events recorded since the last SetCapacity
+  uint64_t GetNTotal (void) const;
+  /// \returns the number of records kept, at most the capacity
+  uint32_t GetNRecords (void) const;
+  /**
+   * \param i record index, 0 for the oldest kept
+   * \returns the record
+   */
+  const LwsnMacTraceRecord &Get (uint32_t i) const;
+
+  /**
+   * Write the records kept, oldest first, behind a header.
+   *
+   * \param os a binary output stream
+   */
+  void Write (std::ostream &os) const;
+
+  /**
+   * Read one block written by Write and append its records.
+   *
+   * \param is a binary input stream
+   * \param records the records read
+   * \returns false at the end of the stream or on a malformed block
+   */
+  static bool Read (std::istream &is, std::vector<LwsnMacTraceRecord> &records);
+
+  /**
+   * \param event an event type
+   * \returns its name, e.g. "TX"
+   */
+  static const char *GetEventName (uint8_t event);
+
+  /**
+   * Print a record as one line of text:
+   * time in seconds, Sid, event, Osid, Did and argument.
+   *
+   * \param os the output stream
+   * \param record the record
+   */
+  static void Print (std::ostream &os, const LwsnMacTraceRecord &record);
+
+private:
+  std::vector<LwsnMacTraceRecord> m_ring; //!< records, a power of two of them
+  uint64_t m_total;                       //!< events recorded
+};
+
+} // namespace ns3
+
+#endif /* LWSN_MAC_TRACE_H */
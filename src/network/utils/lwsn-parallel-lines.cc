@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-parallel-lines.h"
+#include "ns3/core-config.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#ifdef HAVE_PTHREAD_H
+#include "ns3/callback.h"
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnParallelLines");
+
+#ifdef HAVE_PTHREAD_H
+namespace {
+
+/// Lines waiting for a worker
+struct LwsnLinePool
+{
+  std::vector<LwsnLineKernel *> *lines; //!< every line
+  uint32_t next;                        //!< first line not handed out
+  SystemMutex mutex;                    //!< protects next
+};
+
+void
+RunLines (LwsnLinePool *pool)
+{
+  for (;;)
+    {
+      uint32_t i;
+      {
+        CriticalSection cs (pool->mutex);
+        if (pool->next == pool->lines->size ())
+          {
+            return;
+          }
+        i = pool->next++;
+      }
+      (*pool->lines)[i]->Run ();
+    }
+}
+
+} // anonymous namespace
+#endif /* HAVE_PTHREAD_H */
+
+LwsnParallelLines::LwsnParallelLines ()
+{
+}
+
+LwsnParallelLines::~LwsnParallelLines ()
+{
+  for (uint32_t i = 0; i < m_lines.size (); i++)
+    {
+      delete m_lines[i];
+    }
+}
+
+LwsnLineKernel &
+LwsnParallelLines::AddLine (uint32_t numSensor)
+{
+  m_lines.push_back (new LwsnLineKernel (numSensor));
+  return *m_lines.back ();
+}
+
+uint32_t
+LwsnParallelLines::GetNLines (void) const
+{
+  return m_lines.size ();
+}
+
+LwsnLineKernel &
+LwsnParallelLines::GetLine (uint32_t i)
+{
+  NS_ASSERT (i < m_lines.size ());
+  return *m_lines[i];
+}
+
+const LwsnLineKernel &
+LwsnParallelLines::GetLine (uint32_t i) const
+{
+  NS_ASSERT (i < m_lines.size ());
+  return *m_lines[i];
+}
+
+int64_t
+LwsnParallelLines::AssignStreams (int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (uint32_t i = 0; i < m_lines.size (); i++)
+    {
+      currentStream += m_lines[i]->AssignStreams (currentStream);
+    }
+  return (currentStream - stream);
+}
+
+void
+LwsnParallelLines::Run (uint32_t threads)
+{
+  NS_LOG_FUNCTION (this << threads);
+#ifdef HAVE_PTHREAD_H
+  if (threads > m_lines.size ())
+    {
+      threads = m_lines.size ();
+    }
+  if (threads > 1)
+    {
+      LwsnLinePool pool;
+      pool.lines = &m_lines;
+      pool.next = 0;
+      std::vector<Ptr<SystemThread> > workers;
+      for (uint32_t i = 0; i < threads; i++)
+        {
+          workers.push_back (Create<SystemThread> (MakeBoundCallback (&RunLines, &pool)));
+          workers.back ()->Start ();
+        }
+      for (uint32_t i = 0; i < workers.size (); i++)
+        {
+          workers[i]->Join ();
+        }
+      return;
+    }
+#endif /* HAVE_PTHREAD_H */
+  for (uint32_t i = 0; i < m_lines.size (); i++)
+    {
+      m_lines[i]->Run ();
+    }
+}
+
+LwsnMacStats
+LwsnParallelLines::GetMergedStats (void) const
+{
+  LwsnMacStats merged;
+  for (uint32_t i = 0; i < m_lines.size (); i++)
+    {
+      for (uint32_t j = 0; j < m_lines[i]->GetNNodes (); j++)
+        {
+          merged.Merge (m_lines[i]->GetStats (j));
+        }
+    }
+  return merged;
+}
+
+LwsnMacStats
+LwsnParallelLines::GetMergedGatewayStats (void) const
+{
+  LwsnMacStats merged;
+  for (uint32_t i = 0; i < m_lines.size (); i++)
+    {
+      merged.Merge (m_lines[i]->GetStats (0));
+      merged.Merge (m_lines[i]->GetStats (m_lines[i]->GetNNodes () - 1));
+    }
+  return merged;
+}
+
+uint64_t
+LwsnParallelLines::GetNDelivered (void) const
+{
+  uint64_t total = 0;
+  for (uint32_t i = 0; i < m_lines.size (); i++)
+    {
+      total += m_lines[i]->GetNDelivered ();
+    }
+  return total;
+}
+
+} // namespace ns3
@@ -0,0 +1,89 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_PARALLEL_LINES_H
+#define LWSN_PARALLEL_LINES_H
+
+#include <stdint.h>
+#include <vector>
+#include "lwsn-line-kernel.h"
+#include "lwsn-mac-stats.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Run independent LWSN lines on several threads.
+ *
+ * Lines on different channels never interfere, so each one is its own
+ * simulation context: a LwsnLineKernel with its own timing wheel,
+ * backoff streams and statistics.  Lines are set up on the calling
+ * thread, then Run hands them out to a pool of worker threads one line
+ * at a time; nothing is shared between lines while they run, so the
+ * result of each line depends only on its own readings and streams,
+ * whatever the number of threads.  The statistics are merged once every
+ * line is done.
+ *
+ * Without thread support in the core module, Run runs the lines one
+ * after the other on the calling thread.
+ */
+class LwsnParallelLines
+{
+public:
+  LwsnParallelLines ();
+  ~LwsnParallelLines ();
+
+  /**
+   * \param numSensor number of sensors of the new line
+   * \returns the new line, to be set up before Run
+   */
+  LwsnLineKernel &AddLine (uint32_t numSensor);
+  /// \returns the number of lines
+  uint32_t GetNLines (void) const;
+  /**
+   * \param i line index, in the order the lines were added
+   * \returns the line
+   */
+  LwsnLineKernel &GetLine (uint32_t i);
+  /**
+   * \param i line index, in the order the lines were added
+   * \returns the line
+   */
+  const LwsnLineKernel &GetLine (uint32_t i) const;
+
+  /**
+   * Assign consecutive stream blocks to the lines, in the order they
+   * were added.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * Run every line to completion.
+   *
+   * \param threads number of worker threads, at most one per line is used
+   */
+  void Run (uint32_t threads);
+
+  /// \returns the statistics of every node of every line, merged
+  LwsnMacStats GetMergedStats (void) const;
+  /**
+   * \returns the statistics of the gateways of every line, merged
+   */
+  LwsnMacStats GetMergedGatewayStats (void) const;
+  /// \returns the distinct readings delivered, summed over the lines
+  uint64_t GetNDelivered (void) const;
+
+private:
+  /// Not copyable: the lines are owned
+  LwsnParallelLines (const LwsnParallelLines &);
+  /// Not copyable: the lines are owned
+  LwsnParallelLines &operator = (const LwsnParallelLines &);
+
+  std::vector<LwsnLineKernel *> m_lines; //!< the lines
+};
+
+} // namespace ns3
+
+#endif /* LWSN_PARALLEL_LINES_H */
@@ -0,0 +1,323 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-priority-queue.h"
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/assert.h"
+#include "ns3/lwsn-header.h"
+#include "lwsn-checkpoint.h"
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnPriorityQueue");
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnPriorityQueue);
+
+TypeId
+LwsnPriorityQueue::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnPriorityQueue")
+    .SetParent<Queue> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnPriorityQueue> ()
+    .AddAttribute ("Order",
+                   "Which packet leaves first: the one with the earliest "
+                   "StartTime, or the one with the fewest hops to its gateway.",
+                   EnumValue (LwsnPriorityQueue::ORDER_AGE),
+                   MakeEnumAccessor (&LwsnPriorityQueue::m_order),
+                   MakeEnumChecker (LwsnPriorityQueue::ORDER_AGE, "Age",
+                                    LwsnPriorityQueue::ORDER_HOPS, "Hops"))
+  ;
+  return tid;
+}
+
+LwsnPriorityQueue::LwsnPriorityQueue ()
+  : Queue (),
+    m_sid (0),
+    m_leftHops (0),
+    m_rightHops (0),
+    m_seq (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LwsnPriorityQueue::~LwsnPriorityQueue ()
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_heap.size (); i++)
+    {
+      delete m_heap[i];
+    }
+}
+
+void
+LwsnPriorityQueue::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t i = 0; i < m_heap.size (); i++)
+    {
+      delete m_heap[i];
+    }
+  m_heap.clear ();
+  m_index.clear ();
+  Queue::DoDispose ();
+}
+
+void
+LwsnPriorityQueue::SetPosition (uint16_t sid, uint16_t leftHops, uint16_t rightHops)
+{
+  m_sid = sid;
+  m_leftHops = leftHops;
+  m_rightHops = rightHops;
+}
+
+uint16_t
+LwsnPriorityQueue::GetHopsLeft (uint16_t osid) const
+{
+  if (osid < m_sid)
+    {
+      return m_rightHops;
+    }
+  if (osid > m_sid)
+    {
+      return m_leftHops;
+    }
+  if (m_leftHops == 0 || m_rightHops == 0)
+    {
+      return std::max (m_leftHops, m_rightHops);
+    }
+  return std::min (m_leftHops, m_rightHops);
+}
+
+bool
+LwsnPriorityQueue::SeqBefore (const Entry *a, const Entry *b)
+{
+  return a->seq < b->seq;
+}
+
+bool
+LwsnPriorityQueue::Before (const Entry *a, const Entry *b) const
+{
+  if (a->front != b->front)
+    {
+      return a->front;
+    }
+  if (m_order == ORDER_HOPS && a->hops != b->hops)
+    {
+      return a->hops < b->hops;
+    }
+  if (a->start != b->start)
+    {
+      return static_cast<int16_t> (a->start - b->start) < 0;
+    }
+  return a->seq < b->seq;
+}
+
+void
+LwsnPriorityQueue::Swap (uint32_t i, uint32_t j)
+{
+  std::swap (m_heap[i], m_heap[j]);
+  m_heap[i]->pos = i;
+  m_heap[j]->pos = j;
+}
+
+void
+LwsnPriorityQueue::SiftUp (uint32_t i)
+{
+  while (i > 0)
+    {
+      uint32_t parent = (i - 1) / 2;
+      if (!Before (m_heap[i], m_heap[parent]))
+        {
+          break;
+        }
+      Swap (i, parent);
+      i = parent;
+    }
+}
+
+void
+LwsnPriorityQueue::SiftDown (uint32_t i)
+{
+  uint32_t n = m_heap.size ();
+  while (true)
+    {
+      uint32_t best = i;
+      uint32_t left = 2 * i + 1;
+      uint32_t right = left + 1;
+      if (left < n && Before (m_heap[left], m_heap[best]))
+        {
+          best = left;
+        }
+      if (right < n && Before (m_heap[right], m_heap[best]))
+        {
+          best = right;
+        }
+      if (best == i)
+        {
+          break;
+        }
+      Swap (i, best);
+      i = best;
+    }
+}
+
+bool
+LwsnPriorityQueue::DoEnqueue (Ptr<QueueItem> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  NS_ASSERT (m_heap.size () == GetNPackets ());
+
+  LwsnHeader header;
+  item->GetPacket ()->PeekHeader (header);
+  Entry *entry = new Entry;
+  entry->item = item;
+  entry->key = (static_cast<uint32_t> (header.GetOsid ()) << 16) | header.GetDid ();
+  entry->start = header.GetStartTime ();
+  entry->hops = GetHopsLeft (header.GetOsid ());
+  entry->front = false;
+  entry->seq = m_seq++;
+  entry->pos = m_heap.size ();
+  m_heap.push_back (entry);
+  m_index.insert (std::make_pair (entry->key, entry));
+  SiftUp (entry->pos);
+  return true;
+}
+
+Ptr<QueueItem>
+LwsnPriorityQueue::Pop (void)
+{
+  Entry *top = m_heap[0];
+  Swap (0, m_heap.size () - 1);
+  m_heap.pop_back ();
+  if (!m_heap.empty ())
+    {
+      SiftDown (0);
+    }
+  std::pair<std::multimap<uint32_t, Entry *>::iterator,
+            std::multimap<uint32_t, Entry *>::iterator> range = m_index.equal_range (top->key);
+  for (std::multimap<uint32_t, Entry *>::iterator i = range.first; i != range.second; ++i)
+    {
+      if (i->second == top)
+        {
+          m_index.erase (i);
+          break;
+        }
+    }
+  Ptr<QueueItem> item = top->item;
+  delete top;
+  return item;
+}
+
+Ptr<QueueItem>
+LwsnPriorityQueue::DoDequeue (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_heap.size () == GetNPackets ());
+
+  Ptr<QueueItem> item = Pop ();
+
+  NS_LOG_LOGIC ("Popped " << item);
+
+  return item;
+}
+
+Ptr<QueueItem>
+LwsnPriorityQueue::DoRemove (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_heap.size () == GetNPackets ());
+
+  Ptr<QueueItem> item = Pop ();
+
+  NS_LOG_LOGIC ("Removed " << item);
+
+  return item;
+}
+
+Ptr<const QueueItem>
+LwsnPriorityQueue::DoPeek (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_heap.size () == GetNPackets ());
+
+  return m_heap[0]->item;
+}
+
+bool
+LwsnPriorityQueue::MoveToFront (uint16_t osid, uint16_t did)
+{
+  NS_LOG_FUNCTION (this << osid << did);
+  std::multimap<uint32_t, Entry *>::iterator i =
+    m_index.find ((static_cast<uint32_t> (osid) << 16) | did);
+  if (i == m_index.end ())
+    {
+      return false;
+    }
+  i->second->front = true;
+  SiftUp (i->second->pos);
+  return true;
+}
+
+Ptr<const QueueItem>
+LwsnPriorityQueue::GetItem (uint32_t i) const
+{
+  NS_LOG_FUNCTION (this << i);
+  NS_ASSERT (i < m_heap.size ());
+
+  return m_heap[i]->item;
+}
+
+void
+LwsnPriorityQueue::Serialize (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  LwsnCheckpoint::Write<uint32_t> (os, m_heap.size ());
+  for (std::vector<Entry *>::const_iterator i = m_heap.begin (); i != m_heap.end (); ++i)
+    {
+      LwsnCheckpoint::Write (os, (*i)->hops);
+      LwsnCheckpoint::Write (os, (*i)->front);
+      LwsnCheckpoint::Write (os, (*i)->seq);
+    }
+  LwsnCheckpoint::Write (os, m_seq);
+}
+
+bool
+LwsnPriorityQueue::Deserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t count;
+  if (!LwsnCheckpoint::Read (is, count) || count != m_heap.size ())
+    {
+      return false;
+    }
+  // the entries were all enqueued since the queue was empty, so their
+  // arrival numbers give the order of GetItem at the time of Serialize
+  std::vector<Entry *> entries (m_heap);
+  std::sort (entries.begin (), entries.end (), SeqBefore);
+  for (std::vector<Entry *>::iterator i = entries.begin (); i != entries.end (); ++i)
+    {
+      if (!LwsnCheckpoint::Read (is, (*i)->hops)
+          || !LwsnCheckpoint::Read (is, (*i)->front)
+          || !LwsnCheckpoint::Read (is, (*i)->seq))
+        {
+          return false;
+        }
+    }
+  if (!LwsnCheckpoint::Read (is, m_seq))
+    {
+      return false;
+    }
+  m_heap = entries;
+  for (uint32_t i = 0; i < m_heap.size (); i++)
+    {
+      m_heap[i]->pos = i;
+    }
+  for (uint32_t i = m_heap.size () / 2; i > 0; i--)
+    {
+      SiftDown (i - 1);
+    }
+  return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_PRIORITY_QUEUE_H
+#define LWSN_PRIORITY_QUEUE_H
+
+#include <iostream>
+#include <map>
+#include <vector>
+#include "ns3/queue.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup queue
+ *
+ * \brief Transmit queue of a LWSN relay that serves the oldest packet,
+ * or the one closest to its gateway, first.
+ *
+ * The packets carry a LwsnHeader.  With Order Age the packet with the
+ * earliest StartTime is dequeued first, so readings that have already
+ * crossed many hops no longer wait behind fresh local ones.  StartTime
+ * is in whole seconds modulo 2^16, so the queue compares it as a serial
+ * number and assumes no two waiting packets are more than nine hours
+ * apart.  With Order Hops the packet with the fewest hops left to its
+ * gateway goes first, then the oldest; the distances come from
+ * SetPosition.  Packets of the same rank leave in arrival order.
+ *
+ * The packets sit in a binary heap indexed by (Osid, Did), so enqueue,
+ * dequeue and MoveToFront are O(log n).  Drops and statistics are those
+ * of the Queue base class.  Plug it in through the TxQueue attribute of
+ * SimpleNetDevice, e.g. "ns3::LwsnPriorityQueue[Order=Hops]".
+ */
+class LwsnPriorityQueue : public Queue
+{
+public:
+  /// Service order
+  enum Order
+  {
+    ORDER_AGE,  //!< earliest StartTime first
+    ORDER_HOPS  //!< fewest hops to the gateway first, then earliest StartTime
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LwsnPriorityQueue ();
+  virtual ~LwsnPriorityQueue ();
+
+  /**
+   * Position of the owning sensor, used by ORDER_HOPS for the packets
+   * enqueued from now on.  A packet with a lower Osid travels right, one
+   * with a higher Osid left, and an own reading both ways.
+   *
+   * \param sid Sid of the owning sensor
+   * \param leftHops hops to the gateway on the left, 0 if unknown
+   * \param rightHops hops to the gateway on the right, 0 if unknown
+   */
+  void SetPosition (uint16_t sid, uint16_t leftHops, uint16_t rightHops);
+
+  /**
+   * Make the packet (Osid, Did) the next one to leave, e.g. to drop it
+   * with Queue::Dequeue once a neighbour is seen forwarding it.
+   *
+   * \param osid Osid of the packet
+   * \param did Did of the packet
+   * \returns false if no such packet is waiting
+   */
+  bool MoveToFront (uint16_t osid, uint16_t did);
+
+  /**
+   * Read a waiting packet without dequeuing it, e.g. to save the queue.
+   * The positions follow the heap, not the service order.
+   *
+   * \param i position in the heap, below GetNPackets
+   * \returns the item at that position
+   */
+  Ptr<const QueueItem> GetItem (uint32_t i) const;
+
+  /**
+   * Write, as LwsnCheckpoint fields, what ranks the waiting packets
+   * besides their headers: for each position of GetItem its hops left,
+   * MoveToFront flag and arrival number, then the arrival counter.  The
+   * packets themselves are saved by the caller.
+   *
+   * \param os output stream
+   */
+  void Serialize (std::ostream &os) const;
+  /**
+   * Rank the waiting packets as when Serialize wrote them.  Call it
+   * once the saved packets have been enqueued again, in the order of
+   * GetItem when they were saved, on a queue that was empty.
+   *
+   * \param is input stream
+   * \returns false if it does not hold a ranking of that many packets
+   */
+  bool Deserialize (std::istream &is);
+
+private:
+  /// A waiting packet
+  struct Entry
+  {
+    Ptr<QueueItem> item; //!< the packet
+    uint32_t key;        //!< Osid << 16 | Did
+    uint16_t start;      //!< StartTime of the packet
+    uint16_t hops;       //!< hops left when enqueued, ORDER_HOPS only
+    bool front;          //!< moved to the front by MoveToFront
+    uint64_t seq;        //!< arrival order
+    uint32_t pos;        //!< index in m_heap
+  };
+
+  virtual bool DoEnqueue (Ptr<QueueItem> item);
+  virtual Ptr<QueueItem> DoDequeue (void);
+  virtual Ptr<QueueItem> DoRemove (void);
+  virtual Ptr<const QueueItem> DoPeek (void) const;
+  virtual void DoDispose (void);
+
+  /**
+   * \param a an entry
+   * \param b another entry
+   * \returns true if a leaves before b
+   */
+  bool Before (const Entry *a, const Entry *b) const;
+  /**
+   * \param a an entry
+   * \param b another entry
+   * \returns true if a arrived before b
+   */
+  static bool SeqBefore (const Entry *a, const Entry *b);
+  /**
+   * \param osid Osid of a packet
+   * \returns the hops it has left to travel from here, 0 if unknown
+   */
+  uint16_t GetHopsLeft (uint16_t osid) const;
+  /**
+   * Swap two heap slots and keep the entries' positions up to date.
+   *
+   * \param i a heap index
+   * \param j another heap index
+   */
+  void Swap (uint32_t i, uint32_t j);
+  /**
+   * \param i heap index of an entry that may be ahead of its parent
+   */
+  void SiftUp (uint32_t i);
+  /**
+   * \param i heap index of an entry that may be behind its children
+   */
+  void SiftDown (uint32_t i);
+  /**
+   * Take the entry at the top of the heap out of the heap and the index.
+   *
+   * \returns its packet
+   */
+  Ptr<QueueItem> Pop (void);
+
+  Order m_order;          //!< service order
+  uint16_t m_sid;         //!< Sid of the owning sensor
+  uint16_t m_leftHops;    //!< hops to the gateway on the left
+  uint16_t m_rightHops;   //!< hops to the gateway on the right
+  uint64_t m_seq;         //!< arrival counter
+  std::vector<Entry *> m_heap;                //!< binary heap, next packet at 0
+  std::multimap<uint32_t, Entry *> m_index;   //!< entries by (Osid, Did)
+};
+
+} // namespace ns3
+
+#endif /* LWSN_PRIORITY_QUEUE_H */
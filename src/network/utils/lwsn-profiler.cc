@@ -0,0 +1,312 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-profiler.h"
+#include "ns3/simulator.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sys/time.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace ns3 {
+
+namespace {
+
+/// \returns the wall clock, in s
+double
+GetWallSeconds (void)
+{
+  struct timeval tv;
+  gettimeofday (&tv, 0);
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+const char *g_typeNames[LwsnProfiler::N_TYPES + 1] = {
+  "G_ANC", "ORIGINAL_TRANSMISSION", "FORWARDING", "IACK", "NETWORK_CODING", "AGGREGATE", "BLOCK_ACK",
+  "other"
+};
+
+} // anonymous namespace
+
+const uint32_t LwsnProfiler::N_TYPES;
+
+LwsnProfiler &
+LwsnProfiler::Get (void)
+{
+  static LwsnProfiler profiler;
+  return profiler;
+}
+
+LwsnProfiler::LwsnProfiler ()
+  : m_armed (false),
+    m_depthInterval (60.0),
+    m_nDeferred (0),
+    m_scopeTicks (MeasureScopeTicks ())
+{
+  Reset ();
+}
+
+uint64_t
+LwsnProfiler::GetTicks (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc ();
+#else
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t> (ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+uint64_t
+LwsnProfiler::MeasureScopeTicks (void)
+{
+  // the same work as a LwsnProfileScope, on counters of our own that
+  // the compiler may not leave out; the fastest of a few rounds leaves
+  // out the interruptions
+  const uint32_t nCalls = 1000;
+  volatile uint64_t calls = 0;
+  volatile uint64_t total = 0;
+  uint64_t best = 0;
+  for (uint32_t round = 0; round < 5; round++)
+    {
+      uint64_t start = GetTicks ();
+      for (uint32_t i = 0; i < nCalls; i++)
+        {
+          uint64_t begin = GetTicks ();
+          calls = calls + 1;
+          total = total + (GetTicks () - begin);
+        }
+      uint64_t ticks = GetTicks () - start;
+      if (round == 0 || ticks < best)
+        {
+          best = ticks;
+        }
+    }
+  return best / nCalls;
+}
+
+void
+LwsnProfiler::Reset (void)
+{
+  for (uint32_t i = 0; i < N_HANDLERS; i++)
+    {
+      m_handlers[i].calls = 0;
+      m_handlers[i].ticks = 0;
+    }
+  for (uint32_t i = 0; i <= N_TYPES; i++)
+    {
+      m_types[i].calls = 0;
+      m_types[i].ticks = 0;
+    }
+  m_startTicks = GetTicks ();
+  m_startWall = GetWallSeconds ();
+  m_nextDepth = 0;
+  m_depthMax = 0;
+  m_depthSum = 0;
+  m_depthCount = 0;
+  m_depth.clear ();
+}
+
+void
+LwsnProfiler::Arm (void)
+{
+  if (!m_armed)
+    {
+      m_armed = true;
+      Simulator::ScheduleDestroy (&LwsnProfiler::DoDestroy, this);
+    }
+}
+
+void
+LwsnProfiler::Record (Handler handler, uint32_t type, uint64_t ticks)
+{
+  Arm ();
+  m_handlers[handler].calls++;
+  m_handlers[handler].ticks += ticks;
+  if (type < N_TYPES || handler == RECEIVE_FRAME)
+    {
+      Slot &slot = m_types[type < N_TYPES ? type : N_TYPES];
+      slot.calls++;
+      slot.ticks += ticks;
+    }
+}
+
+void
+LwsnProfiler::RecordDepth (uint64_t depth)
+{
+  Arm ();
+  m_depthMax = std::max (m_depthMax, depth);
+  m_depthSum += depth;
+  m_depthCount++;
+  double now = Simulator::Now ().GetSeconds ();
+  if (now >= m_nextDepth)
+    {
+      m_depth.push_back (std::make_pair (now, depth));
+      m_nextDepth = now + m_depthInterval;
+    }
+}
+
+void
+LwsnProfiler::RecordDefer (void)
+{
+  Arm ();
+  m_nDeferred++;
+}
+
+void
+LwsnProfiler::RecordDeferredRun (void)
+{
+  if (m_nDeferred > 0)
+    {
+      RecordDepth (m_nDeferred);
+      m_nDeferred--;
+    }
+}
+
+void
+LwsnProfiler::SetDepthInterval (double interval)
+{
+  m_depthInterval = interval;
+}
+
+uint64_t
+LwsnProfiler::GetNCalls (Handler handler) const
+{
+  return m_handlers[handler].calls;
+}
+
+double
+LwsnProfiler::GetTicksPerSecond (void) const
+{
+  double wall = GetWallSeconds () - m_startWall;
+  if (wall <= 0)
+    {
+      return 1e9;
+    }
+  return (GetTicks () - m_startTicks) / wall;
+}
+
+double
+LwsnProfiler::GetSeconds (Handler handler) const
+{
+  return m_handlers[handler].ticks / GetTicksPerSecond ();
+}
+
+const char *
+LwsnProfiler::GetHandlerName (Handler handler)
+{
+  switch (handler)
+    {
+    case RECEIVE_START:
+      return "ReceiveStart";
+    case RECEIVE_END:
+      return "ReceiveEnd";
+    case RECEIVE_FRAME:
+      return "ReceiveFrame";
+    case QUEUE_CHECK:
+      return "QueueCheck";
+    case WAIT_SEND:
+      return "WaitSend";
+    case ACK_CHECK:
+      return "AckCheck";
+    case ORIGINAL_ACK_CHECK:
+      return "OriginalAckCheck";
+    case RESEND:
+      return "ReSend";
+    case ORIGINAL_TRANSMISSION:
+      return "OriginalTransmission";
+    case FORWARDING:
+      return "Forwarding";
+    case ACK_SEND:
+      return "AckSend";
+    case AGGREGATE_SEND:
+      return "AggregateSend";
+    case RECEIVE_AGGREGATE:
+      return "ReceiveAggregate";
+    case CODED_SEND:
+      return "CodedSend";
+    case CHANNEL_SEND:
+      return "SimpleChannel::Send";
+    case SLOT_TICK:
+      return "LwsnSlotScheduler::Tick";
+    default:
+      return "UNKNOWN";
+    }
+}
+
+void
+LwsnProfiler::Print (std::ostream &os) const
+{
+  double perSecond = GetTicksPerSecond ();
+  std::ios::fmtflags flags = os.flags ();
+  std::streamsize precision = os.precision ();
+  os << std::left << std::setw (26) << "handler" << std::right << std::setw (12) << "calls"
+     << std::setw (12) << "total ms" << std::setw (12) << "ns/call" << std::endl;
+  for (uint32_t i = 0; i < N_HANDLERS; i++)
+    {
+      const Slot &slot = m_handlers[i];
+      double seconds = slot.ticks / perSecond;
+      os << std::left << std::setw (26) << GetHandlerName (static_cast<Handler> (i))
+         << std::right << std::setw (12) << slot.calls
+         << std::fixed << std::setprecision (3) << std::setw (12) << seconds * 1e3
+         << std::setprecision (0) << std::setw (12) << (slot.calls > 0 ? seconds * 1e9 / slot.calls : 0.0)
+         << std::endl;
+      os.flags (flags);
+      os.precision (precision);
+    }
+  os << std::left << std::setw (26) << "frame type" << std::right << std::setw (12) << "calls"
+     << std::setw (12) << "total ms" << std::setw (12) << "ns/call" << std::endl;
+  for (uint32_t i = 0; i <= N_TYPES; i++)
+    {
+      const Slot &slot = m_types[i];
+      double seconds = slot.ticks / perSecond;
+      os << std::left << std::setw (26) << g_typeNames[i]
+         << std::right << std::setw (12) << slot.calls
+         << std::fixed << std::setprecision (3) << std::setw (12) << seconds * 1e3
+         << std::setprecision (0) << std::setw (12) << (slot.calls > 0 ? seconds * 1e9 / slot.calls : 0.0)
+         << std::endl;
+      os.flags (flags);
+      os.precision (precision);
+    }
+  os << "pending MAC actions: max " << m_depthMax << ", mean "
+     << (m_depthCount > 0 ? static_cast<double> (m_depthSum) / m_depthCount : 0.0)
+     << " over " << m_depthCount << " samples" << std::endl;
+
+  // each handler call and each depth sample pays for the profiler once
+  uint64_t nScopes = m_depthCount;
+  for (uint32_t i = 0; i < N_HANDLERS; i++)
+    {
+      nScopes += m_handlers[i].calls;
+    }
+  double overhead = nScopes * m_scopeTicks / perSecond;
+  double wall = GetWallSeconds () - m_startWall;
+  os << "profiler overhead: about " << std::fixed << std::setprecision (3) << overhead * 1e3
+     << " ms over " << nScopes << " calls, " << std::setprecision (2)
+     << (wall > 0 ? 100 * overhead / wall : 0.0) << "% of the run" << std::endl;
+  os.flags (flags);
+  os.precision (precision);
+}
+
+void
+LwsnProfiler::PrintDepth (std::ostream &os) const
+{
+  for (std::vector<std::pair<double, uint64_t> >::const_iterator i = m_depth.begin (); i != m_depth.end (); ++i)
+    {
+      os << i->first << "," << i->second << std::endl;
+    }
+}
+
+void
+LwsnProfiler::DoDestroy (void)
+{
+  m_armed = false;
+  Print (std::clog);
+  Reset ();
+  // the events of the actions left to the simulator go with it
+  m_nDeferred = 0;
+}
+
+} // namespace ns3
@@ -0,0 +1,263 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_PROFILER_H
+#define LWSN_PROFILER_H
+
+#include <stdint.h>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+/**
+ * \ingroup network
+ *
+ * Charge the rest of the enclosing block to a MAC handler of the
+ * LwsnProfiler.  Expands to nothing unless NS3_LWSN_PROFILE is defined
+ * (waf configure --enable-lwsn-profile).
+ *
+ * \param handler a LwsnProfiler::Handler, without the class name
+ */
+#define LWSN_PROFILE(handler) LWSN_PROFILE_FRAME (handler, ns3::LwsnProfiler::N_TYPES)
+
+/**
+ * \ingroup network
+ *
+ * Same as LWSN_PROFILE, and also charge the block to a frame type.
+ *
+ * \param handler a LwsnProfiler::Handler, without the class name
+ * \param type LwsnHeader type of the frame being handled
+ */
+#ifdef NS3_LWSN_PROFILE
+#define LWSN_PROFILE_FRAME(handler, type)                                \
+  ns3::LwsnProfileScope lwsnProfileScope (ns3::LwsnProfiler::handler, type)
+#else
+#define LWSN_PROFILE_FRAME(handler, type)
+#endif
+
+/**
+ * \ingroup network
+ *
+ * Record the number of pending MAC actions at the current simulation
+ * time.  Expands to nothing unless NS3_LWSN_PROFILE is defined.
+ *
+ * \param depth pending actions
+ */
+#ifdef NS3_LWSN_PROFILE
+#define LWSN_PROFILE_DEPTH(depth) ns3::LwsnProfiler::Get ().RecordDepth (depth)
+#else
+#define LWSN_PROFILE_DEPTH(depth)
+#endif
+
+/**
+ * \ingroup network
+ *
+ * Count a MAC action left to the simulator as an event.  Expands to
+ * nothing unless NS3_LWSN_PROFILE is defined.
+ */
+#ifdef NS3_LWSN_PROFILE
+#define LWSN_PROFILE_DEFER() ns3::LwsnProfiler::Get ().RecordDefer ()
+#else
+#define LWSN_PROFILE_DEFER()
+#endif
+
+/**
+ * \ingroup network
+ *
+ * Record the number of MAC actions left to the simulator, as the event
+ * of one of them runs, and stop counting that one.  Expands to nothing
+ * unless NS3_LWSN_PROFILE is defined.
+ */
+#ifdef NS3_LWSN_PROFILE
+#define LWSN_PROFILE_DEFERRED_RUN() ns3::LwsnProfiler::Get ().RecordDeferredRun ()
+#else
+#define LWSN_PROFILE_DEFERRED_RUN()
+#endif
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Invocation counts and CPU time of the LWSN MAC handlers.
+ *
+ * One profiler serves the whole process.  Each handler, and each
+ * LwsnHeader type of the frames handled, gets an invocation count and
+ * the time spent in it, measured with the time stamp counter of the
+ * CPU where there is one and converted to seconds against the wall
+ * clock.  Times are inclusive: a handler that calls another is charged
+ * for both.  The profiler also records the number of pending MAC
+ * actions: those of the LwsnSlotScheduler at each of its ticks, and
+ * those SimpleNetDevice::ScheduleMac left to the simulator each time
+ * one of them runs, which without SlotScheduling is all of them.  The
+ * depth is sampled at most once per DepthInterval of simulated time.
+ *
+ * Everything is recorded through the LWSN_PROFILE macros, which compile
+ * to nothing unless NS3_LWSN_PROFILE is defined, so that a normal build
+ * pays nothing for the profiler.  The summary table is then printed to
+ * std::clog at Simulator::Destroy, and the counters start again from
+ * zero.
+ *
+ * A profiled run is meant to stay within 5% of the run time of a normal
+ * one.  Each profiled handler call costs two counter reads and the
+ * update of its counters: about 40 ns, or 80 ticks, measured on an
+ * x86-64 host.  The budget therefore holds while the handlers take at
+ * least 0.8 us per call on average.  The profiler measures that cost at
+ * start up and prints its estimated own share of the run with the
+ * summary, so that each run can be checked against the budget.
+ */
+class LwsnProfiler
+{
+public:
+  /// The profiled MAC handlers
+  enum Handler
+  {
+    RECEIVE_START,
+    RECEIVE_END,
+    RECEIVE_FRAME,
+    QUEUE_CHECK,
+    WAIT_SEND,
+    ACK_CHECK,
+    ORIGINAL_ACK_CHECK,
+    RESEND,
+    ORIGINAL_TRANSMISSION,
+    FORWARDING,
+    ACK_SEND,
+    AGGREGATE_SEND,
+    RECEIVE_AGGREGATE,
+    CODED_SEND,
+    CHANNEL_SEND,
+    SLOT_TICK,
+    N_HANDLERS
+  };
+
+  /// Number of LwsnHeader frame types counted separately
+  static const uint32_t N_TYPES = 7;
+
+  /// \returns the profiler of the process
+  static LwsnProfiler &Get (void);
+
+  /**
+   * \param handler the handler that ran
+   * \param type LwsnHeader type of its frame, N_TYPES if none
+   * \param ticks time spent in it, in counter ticks
+   */
+  void Record (Handler handler, uint32_t type, uint64_t ticks);
+  /**
+   * \param depth MAC actions pending now
+   */
+  void RecordDepth (uint64_t depth);
+  /// Count a MAC action left to the simulator
+  void RecordDefer (void);
+  /**
+   * Record the depth of the MAC actions left to the simulator, as one of
+   * them runs, then stop counting it.
+   */
+  void RecordDeferredRun (void);
+
+  /// \param interval simulated time between two depth samples, in s
+  void SetDepthInterval (double interval);
+
+  /**
+   * \param handler a handler
+   * \returns the number of times it ran
+   */
+  uint64_t GetNCalls (Handler handler) const;
+  /**
+   * \param handler a handler
+   * \returns the time spent in it, in s
+   */
+  double GetSeconds (Handler handler) const;
+
+  /**
+   * Print the summary table: per handler, then per frame type, then the
+   * depth of pending MAC actions and the estimated profiling overhead.
+   *
+   * \param os output stream
+   */
+  void Print (std::ostream &os) const;
+  /**
+   * Print the depth samples as "time,depth" CSV lines.
+   *
+   * \param os output stream
+   */
+  void PrintDepth (std::ostream &os) const;
+  /**
+   * Forget everything recorded so far.  The MAC actions left to the
+   * simulator are still counted, as their events are still pending.
+   */
+  void Reset (void);
+
+  /// \returns the time stamp counter, or nanoseconds where there is none
+  static uint64_t GetTicks (void);
+
+  /**
+   * \param handler a handler
+   * \returns its name, e.g. "AckCheck"
+   */
+  static const char *GetHandlerName (Handler handler);
+
+private:
+  LwsnProfiler ();
+  /// Print the summary to std::clog and reset, at Simulator::Destroy
+  void DoDestroy (void);
+  /// Make sure DoDestroy runs at the next Simulator::Destroy
+  void Arm (void);
+  /// \returns counter ticks per second, measured since the last Reset
+  double GetTicksPerSecond (void) const;
+  /// \returns the counter ticks one profiled handler call costs
+  static uint64_t MeasureScopeTicks (void);
+
+  /// Counters of a handler or of a frame type
+  struct Slot
+  {
+    uint64_t calls; //!< invocations
+    uint64_t ticks; //!< time spent, in counter ticks
+  };
+
+  Slot m_handlers[N_HANDLERS];   //!< per handler
+  Slot m_types[N_TYPES + 1];     //!< per frame type, unknown types last
+  uint64_t m_startTicks;         //!< counter at the last Reset
+  double m_startWall;            //!< wall clock at the last Reset, in s
+  bool m_armed;                  //!< DoDestroy is scheduled
+  double m_depthInterval;        //!< simulated time between depth samples, in s
+  double m_nextDepth;            //!< simulated time of the next depth sample, in s
+  uint64_t m_depthMax;           //!< largest depth seen
+  uint64_t m_depthSum;           //!< sum of the depths seen
+  uint64_t m_depthCount;         //!< depths seen
+  std::vector<std::pair<double, uint64_t> > m_depth; //!< (time, depth) samples
+  uint64_t m_nDeferred;          //!< MAC actions left to the simulator and not run yet
+  uint64_t m_scopeTicks;         //!< counter ticks of one profiled handler call
+};
+
+/**
+ * \ingroup network
+ *
+ * Charges the time from its construction to its destruction to a
+ * handler of the LwsnProfiler; see LWSN_PROFILE.
+ */
+class LwsnProfileScope
+{
+public:
+  /**
+   * \param handler the handler being run
+   * \param type LwsnHeader type of its frame, LwsnProfiler::N_TYPES if none
+   */
+  LwsnProfileScope (LwsnProfiler::Handler handler, uint32_t type)
+    : m_handler (handler),
+      m_type (type),
+      m_start (LwsnProfiler::GetTicks ())
+  {
+  }
+  ~LwsnProfileScope ()
+  {
+    LwsnProfiler::Get ().Record (m_handler, m_type, LwsnProfiler::GetTicks () - m_start);
+  }
+
+private:
+  LwsnProfiler::Handler m_handler; //!< handler being run
+  uint32_t m_type;                 //!< frame type
+  uint64_t m_start;                //!< counter at construction
+};
+
+} // namespace ns3
+
+#endif /* LWSN_PROFILER_H */
@@ -0,0 +1,448 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-radio-energy.h"
+#include "lwsn-checkpoint.h"
+#include "ns3/simulator.h"
+#include "ns3/double.h"
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/trace-source-accessor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnRadioEnergy");
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnRadioEnergy);
+
+TypeId
+LwsnRadioEnergy::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnRadioEnergy")
+    .SetParent<Object> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnRadioEnergy> ()
+    .AddAttribute ("TxDraw",
+                   "Power drawn while transmitting, in W.",
+                   DoubleValue (0.0522),
+                   MakeDoubleAccessor (&LwsnRadioEnergy::m_txDraw),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("RxDraw",
+                   "Power drawn while receiving, in W.",
+                   DoubleValue (0.0564),
+                   MakeDoubleAccessor (&LwsnRadioEnergy::m_rxDraw),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("IdleDraw",
+                   "Power drawn while awake and listening, in W.",
+                   DoubleValue (0.0564),
+                   MakeDoubleAccessor (&LwsnRadioEnergy::m_idleDraw),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("SleepDraw",
+                   "Power drawn while asleep, in W.",
+                   DoubleValue (0.00006),
+                   MakeDoubleAccessor (&LwsnRadioEnergy::m_sleepDraw),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("InitialEnergy",
+                   "Battery capacity in J; 0 means the battery never runs out.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&LwsnRadioEnergy::m_initialEnergy),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("WakePeriod",
+                   "Period of the wake schedule; 0 keeps the radio awake.",
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&LwsnRadioEnergy::m_wakePeriod),
+                   MakeTimeChecker ())
+    .AddAttribute ("WakeDuration",
+                   "Time the radio is awake at the start of every WakePeriod.",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&LwsnRadioEnergy::m_wakeDuration),
+                   MakeTimeChecker ())
+    .AddAttribute ("WakeOffset",
+                   "Start of the first awake time of the schedule.",
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&LwsnRadioEnergy::m_wakeOffset),
+                   MakeTimeChecker ())
+    .AddTraceSource ("EnergyDepleted",
+                     "The battery has run out and the radio is off for good.",
+                     MakeTraceSourceAccessor (&LwsnRadioEnergy::m_depletedTrace),
+                     "ns3::LwsnRadioEnergy::EnergyDepletedCallback")
+  ;
+  return tid;
+}
+
+LwsnRadioEnergy::LwsnRadioEnergy ()
+  : m_last (0),
+    m_txUntil (0),
+    m_rxCount (0),
+    m_depleted (false),
+    m_consumed (0.0)
+{
+  NS_LOG_FUNCTION (this);
+  m_secondsPerStep = TimeStep (1).GetSeconds ();
+  for (uint32_t i = 0; i <= OFF; i++)
+    {
+      m_steps[i] = 0;
+    }
+  // InitialEnergy is only known once the attributes are set
+  m_depletion = Simulator::ScheduleNow (&LwsnRadioEnergy::ScheduleDepletion, this);
+}
+
+void
+LwsnRadioEnergy::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_depletion.Cancel ();
+  Object::DoDispose ();
+}
+
+double
+LwsnRadioEnergy::GetDraw (State state) const
+{
+  switch (state)
+    {
+    case TX:
+      return m_txDraw;
+    case RX:
+      return m_rxDraw;
+    case IDLE:
+      return m_idleDraw;
+    case SLEEP:
+      return m_sleepDraw;
+    default:
+      return 0.0;
+    }
+}
+
+int64_t
+LwsnRadioEnergy::GetAwakeBefore (int64_t t) const
+{
+  int64_t period = m_wakePeriod.GetTimeStep ();
+  int64_t duration = std::min (m_wakeDuration.GetTimeStep (), period);
+  int64_t u = t - m_wakeOffset.GetTimeStep ();
+  int64_t cycles = u / period;
+  int64_t rest = u - cycles * period;
+  if (rest < 0)
+    {
+      cycles--;
+      rest += period;
+    }
+  return cycles * duration + std::min (rest, duration);
+}
+
+int64_t
+LwsnRadioEnergy::GetAwakeSteps (int64_t from, int64_t to) const
+{
+  if (!m_wakePeriod.IsStrictlyPositive ())
+    {
+      return to - from;
+    }
+  return GetAwakeBefore (to) - GetAwakeBefore (from);
+}
+
+void
+LwsnRadioEnergy::Account (State state, int64_t steps)
+{
+  m_steps[state] += steps;
+  m_consumed += GetDraw (state) * steps * m_secondsPerStep;
+}
+
+int64_t
+LwsnRadioEnergy::GetStepsFor (double draw, double energy) const
+{
+  return static_cast<int64_t> (std::ceil (energy / (draw * m_secondsPerStep)));
+}
+
+int64_t
+LwsnRadioEnergy::GetDepletionStep (void) const
+{
+  if (m_depleted || m_initialEnergy <= 0)
+    {
+      return -1;
+    }
+  double left = m_initialEnergy - m_consumed;
+  int64_t t = m_last;
+  if (left <= 0)
+    {
+      return t;
+    }
+  if (m_txUntil > t)
+    {
+      double used = m_txDraw * (m_txUntil - t) * m_secondsPerStep;
+      if (used >= left)
+        {
+          return t + GetStepsFor (m_txDraw, left);
+        }
+      left -= used;
+      t = m_txUntil;
+    }
+  if (m_rxCount > 0 || !m_wakePeriod.IsStrictlyPositive ())
+    {
+      double draw = m_rxCount > 0 ? m_rxDraw : m_idleDraw;
+      return draw > 0 ? t + GetStepsFor (draw, left) : -1;
+    }
+
+  int64_t period = m_wakePeriod.GetTimeStep ();
+  int64_t duration = std::min (m_wakeDuration.GetTimeStep (), period);
+  double perPeriod = (m_idleDraw * duration + m_sleepDraw * (period - duration)) * m_secondsPerStep;
+  if (perPeriod <= 0)
+    {
+      return -1;
+    }
+  // skip the whole periods, then walk the awake and asleep edges
+  int64_t periods = static_cast<int64_t> (left / perPeriod) - 1;
+  if (periods > 0)
+    {
+      t += periods * period;
+      left -= periods * perPeriod;
+    }
+  while (true)
+    {
+      int64_t rest = (t - m_wakeOffset.GetTimeStep ()) % period;
+      if (rest < 0)
+        {
+          rest += period;
+        }
+      bool awake = rest < duration;
+      int64_t end = t + (awake ? duration - rest : period - rest);
+      double draw = awake ? m_idleDraw : m_sleepDraw;
+      double used = draw * (end - t) * m_secondsPerStep;
+      if (used >= left && draw > 0)
+        {
+          return t + GetStepsFor (draw, left);
+        }
+      left -= used;
+      t = end;
+    }
+}
+
+void
+LwsnRadioEnergy::ScheduleDepletion (void)
+{
+  m_depletion.Cancel ();
+  int64_t empty = GetDepletionStep ();
+  if (empty < 0)
+    {
+      return;
+    }
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  m_depletion = Simulator::Schedule (TimeStep (std::max (empty - now, int64_t (0))),
+                                     &LwsnRadioEnergy::Deplete, this);
+}
+
+void
+LwsnRadioEnergy::Deplete (void)
+{
+  Update ();
+  if (!m_depleted)
+    {
+      // rounding moved the time step; try again there
+      ScheduleDepletion ();
+    }
+}
+
+void
+LwsnRadioEnergy::Update (void)
+{
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  int64_t empty = GetDepletionStep ();
+  if (empty >= 0 && empty <= now)
+    {
+      Advance (empty);
+      NS_LOG_LOGIC ("battery exhausted after " << m_consumed << " J");
+      m_depleted = true;
+      m_depletion.Cancel ();
+      m_depletedTrace ();
+    }
+  Advance (now);
+}
+
+void
+LwsnRadioEnergy::Advance (int64_t to)
+{
+  int64_t from = m_last;
+  if (to <= from)
+    {
+      return;
+    }
+  m_last = to;
+  if (m_depleted)
+    {
+      Account (OFF, to - from);
+      return;
+    }
+  if (m_txUntil > from)
+    {
+      int64_t end = std::min (to, m_txUntil);
+      Account (TX, end - from);
+      from = end;
+    }
+  if (from < to)
+    {
+      if (m_rxCount > 0)
+        {
+          Account (RX, to - from);
+        }
+      else
+        {
+          int64_t awake = GetAwakeSteps (from, to);
+          Account (IDLE, awake);
+          Account (SLEEP, to - from - awake);
+        }
+    }
+}
+
+bool
+LwsnRadioEnergy::IsDepleted (void)
+{
+  Update ();
+  return m_depleted;
+}
+
+bool
+LwsnRadioEnergy::IsAwake (void)
+{
+  Update ();
+  if (m_depleted)
+    {
+      return false;
+    }
+  if (!m_wakePeriod.IsStrictlyPositive ())
+    {
+      return true;
+    }
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  return GetAwakeSteps (now, now + 1) > 0;
+}
+
+void
+LwsnRadioEnergy::NotifyTx (Time duration)
+{
+  NS_LOG_FUNCTION (this << duration);
+  Update ();
+  m_txUntil = std::max (m_txUntil, m_last + duration.GetTimeStep ());
+  ScheduleDepletion ();
+}
+
+void
+LwsnRadioEnergy::NotifyRxStart (void)
+{
+  Update ();
+  m_rxCount++;
+  ScheduleDepletion ();
+}
+
+void
+LwsnRadioEnergy::NotifyRxEnd (void)
+{
+  Update ();
+  NS_ASSERT (m_rxCount > 0);
+  m_rxCount--;
+  ScheduleDepletion ();
+}
+
+LwsnRadioEnergy::State
+LwsnRadioEnergy::GetState (void)
+{
+  Update ();
+  if (m_depleted)
+    {
+      return OFF;
+    }
+  if (m_txUntil > m_last)
+    {
+      return TX;
+    }
+  if (m_rxCount > 0)
+    {
+      return RX;
+    }
+  return IsAwake () ? IDLE : SLEEP;
+}
+
+double
+LwsnRadioEnergy::GetConsumedEnergy (void)
+{
+  Update ();
+  return m_consumed;
+}
+
+double
+LwsnRadioEnergy::GetRemainingEnergy (void)
+{
+  Update ();
+  if (m_initialEnergy <= 0)
+    {
+      return -1;
+    }
+  return std::max (m_initialEnergy - m_consumed, 0.0);
+}
+
+Time
+LwsnRadioEnergy::GetStateTime (State state)
+{
+  Update ();
+  return TimeStep (m_steps[state]);
+}
+
+const char *
+LwsnRadioEnergy::GetStateName (State state)
+{
+  switch (state)
+    {
+    case TX:
+      return "TX";
+    case RX:
+      return "RX";
+    case IDLE:
+      return "IDLE";
+    case SLEEP:
+      return "SLEEP";
+    case OFF:
+      return "OFF";
+    }
+  return "UNKNOWN";
+}
+
+void
+LwsnRadioEnergy::Serialize (std::ostream &os)
+{
+  Update ();
+  LwsnCheckpoint::Write (os, m_last);
+  LwsnCheckpoint::Write (os, m_txUntil);
+  LwsnCheckpoint::Write (os, m_rxCount);
+  LwsnCheckpoint::Write (os, m_depleted);
+  LwsnCheckpoint::Write (os, m_consumed);
+  for (uint32_t i = 0; i <= OFF; i++)
+    {
+      LwsnCheckpoint::Write (os, m_steps[i]);
+    }
+}
+
+bool
+LwsnRadioEnergy::Deserialize (std::istream &is)
+{
+  NS_LOG_FUNCTION (this);
+  if (!LwsnCheckpoint::Read (is, m_last)
+      || !LwsnCheckpoint::Read (is, m_txUntil)
+      || !LwsnCheckpoint::Read (is, m_rxCount)
+      || !LwsnCheckpoint::Read (is, m_depleted)
+      || !LwsnCheckpoint::Read (is, m_consumed))
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i <= OFF; i++)
+    {
+      if (!LwsnCheckpoint::Read (is, m_steps[i]))
+        {
+          return false;
+        }
+    }
+  if (m_last > Simulator::Now ().GetTimeStep ())
+    {
+      return false;
+    }
+  ScheduleDepletion ();
+  return true;
+}
+
+} // namespace ns3
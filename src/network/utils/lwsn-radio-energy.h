@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_RADIO_ENERGY_H
+#define LWSN_RADIO_ENERGY_H
+
+#include <stdint.h>
+#include <istream>
+#include <ostream>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/event-id.h"
+#include "ns3/traced-callback.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Radio state and battery of a LWSN SimpleNetDevice.
+ *
+ * The radio is in one of five states:
+ *  - TX while a frame is on the air, whatever the schedule;
+ *  - RX while at least one reception addressed to the device is in
+ *    progress;
+ *  - otherwise IDLE or SLEEP, as given by the wake schedule: the radio
+ *    is awake for WakeDuration at the start of every WakePeriod,
+ *    shifted by WakeOffset, and always awake when WakePeriod is zero;
+ *  - OFF for good once InitialEnergy is used up.
+ *
+ * Each state draws a constant power.  Nothing is scheduled for the
+ * wake and sleep edges: the time spent awake and asleep between two
+ * updates follows from the schedule, so the energy is brought up to
+ * date only when the device transmits, receives or is queried.  For a
+ * slotted MAC the schedule times should be multiples of the slot.
+ *
+ * With a limited battery, the time step at which it runs out is worked
+ * out from the states ahead, and an event there turns the radio OFF
+ * and fires EnergyDepleted on time.  The event moves whenever a
+ * transmission or reception changes the states ahead; while it is
+ * pending, Simulator::Run does not return before the battery is empty.
+ */
+class LwsnRadioEnergy : public Object
+{
+public:
+  /// Radio states
+  enum State
+  {
+    TX,
+    RX,
+    IDLE,
+    SLEEP,
+    OFF
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LwsnRadioEnergy ();
+
+  /**
+   * \returns true if frames can be received now: the battery is not
+   * exhausted and the schedule has the radio awake
+   */
+  bool IsAwake (void);
+  /// \returns true once the battery is exhausted
+  bool IsDepleted (void);
+
+  /**
+   * A frame is sent now.
+   *
+   * \param duration time the frame is on the air
+   */
+  void NotifyTx (Time duration);
+  /// A reception addressed to the device starts now
+  void NotifyRxStart (void);
+  /// A reception started by NotifyRxStart ends now
+  void NotifyRxEnd (void);
+
+  /// \returns the state of the radio now
+  State GetState (void);
+  /// \returns the energy drawn so far, in J
+  double GetConsumedEnergy (void);
+  /// \returns the energy left, in J, or -1 if the battery is unlimited
+  double GetRemainingEnergy (void);
+  /**
+   * \param state a radio state
+   * \returns the time spent in it so far
+   */
+  Time GetStateTime (State state);
+
+  /**
+   * \param state a radio state
+   * \returns its name, e.g. "SLEEP"
+   */
+  static const char *GetStateName (State state);
+
+  /**
+   * Bring the radio up to date and write its state and energy as
+   * LwsnCheckpoint fields.
+   *
+   * \param os output stream
+   */
+  void Serialize (std::ostream &os);
+  /**
+   * Replace the state and energy of the radio with those written by
+   * Serialize, no later than now, and move the depletion event.
+   *
+   * \param is input stream
+   * \returns false if it does not hold a radio written by Serialize
+   */
+  bool Deserialize (std::istream &is);
+
+  /**
+   * TracedCallback signature for the EnergyDepleted trace source.
+   */
+  typedef void (* EnergyDepletedCallback)(void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * Account for the time from the last update to now, turning the radio
+   * OFF at the time step the battery ran out if it did.
+   */
+  void Update (void);
+  /**
+   * Account for the time from the last update to a later time step, in
+   * the states the radio was left in.
+   *
+   * \param to the time step to account up to
+   */
+  void Advance (int64_t to);
+  /**
+   * \returns the time step at which the battery runs out if the radio
+   * is left alone from the last update, or -1 if it never does
+   */
+  int64_t GetDepletionStep (void) const;
+  /**
+   * \param draw a power, W
+   * \param energy an energy, J
+   * \returns the time steps it takes draw to use up energy
+   */
+  int64_t GetStepsFor (double draw, double energy) const;
+  /// (Re)schedule the depletion event at GetDepletionStep
+  void ScheduleDepletion (void);
+  /// Depletion event: bring the radio up to date
+  void Deplete (void);
+  /**
+   * \param state the state the radio was in
+   * \param steps time spent in it, in time steps
+   */
+  void Account (State state, int64_t steps);
+  /**
+   * \param from start of the interval, in time steps
+   * \param to end of the interval, in time steps
+   * \returns the time the schedule keeps the radio awake in [from, to)
+   */
+  int64_t GetAwakeSteps (int64_t from, int64_t to) const;
+  /**
+   * \param t a time, in time steps
+   * \returns the time the schedule keeps the radio awake from WakeOffset
+   * up to t, negative before WakeOffset
+   */
+  int64_t GetAwakeBefore (int64_t t) const;
+
+  /**
+   * \param state a radio state
+   * \returns the power drawn in it, W
+   */
+  double GetDraw (State state) const;
+
+  double m_txDraw;          //!< power drawn in TX, W
+  double m_rxDraw;          //!< power drawn in RX, W
+  double m_idleDraw;        //!< power drawn in IDLE, W
+  double m_sleepDraw;       //!< power drawn in SLEEP, W
+  double m_initialEnergy;   //!< battery capacity, J, 0 for unlimited
+  Time m_wakePeriod;        //!< wake schedule period, 0 for always awake
+  Time m_wakeDuration;      //!< awake time per period
+  Time m_wakeOffset;        //!< start of the first awake time
+
+  double m_secondsPerStep;  //!< length of one time step, s
+  int64_t m_last;           //!< time of the last update, in time steps
+  int64_t m_txUntil;        //!< end of the frame on the air, in time steps
+  uint32_t m_rxCount;       //!< receptions in progress
+  bool m_depleted;          //!< battery exhausted
+  double m_consumed;        //!< energy drawn, J
+  int64_t m_steps[OFF + 1]; //!< time spent in each state, in time steps
+  EventId m_depletion;      //!< event at the time the battery runs out
+
+  TracedCallback<> m_depletedTrace; //!< EnergyDepleted trace source
+};
+
+} // namespace ns3
+
+#endif /* LWSN_RADIO_ENERGY_H */
@@ -0,0 +1,348 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-slot-scheduler.h"
+#include "simple-net-device.h"
+#include "lwsn-profiler.h"
+#include "ns3/simulator.h"
+#include "ns3/packet.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnSlotScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnSlotScheduler);
+
+namespace {
+
+/// \returns the greatest common divisor of a and b
+int64_t
+GetGcd (int64_t a, int64_t b)
+{
+  while (b != 0)
+    {
+      int64_t r = a % b;
+      a = b;
+      b = r;
+    }
+  return a;
+}
+
+} // anonymous namespace
+
+TypeId
+LwsnSlotScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnSlotScheduler")
+    .SetParent<Object> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnSlotScheduler> ()
+    .AddAttribute ("SlotLength",
+                   "Spacing of the grid the MAC timers fall on; zero takes it "
+                   "from the SlotLength and Guard of the LwsnSlotTiming of the channel.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&LwsnSlotScheduler::m_slotLength),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+LwsnSlotScheduler::Slot::Slot ()
+  : open (false)
+{
+}
+
+LwsnSlotScheduler::LwsnSlotScheduler ()
+  : m_nTicks (0),
+    m_nActions (0),
+    m_nPending (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LwsnSlotScheduler::SetSlotTiming (Ptr<LwsnSlotTiming> timing)
+{
+  NS_LOG_FUNCTION (this << timing);
+  m_slotTiming = timing;
+}
+
+Time
+LwsnSlotScheduler::GetGrid (void) const
+{
+  if (!m_slotLength.IsZero () || m_slotTiming == 0)
+    {
+      return m_slotLength;
+    }
+  return TimeStep (GetGcd (m_slotTiming->GetSlot ().GetTimeStep (), m_slotTiming->GetGuard ().GetTimeStep ()));
+}
+
+bool
+LwsnSlotScheduler::Schedule (Time delay, const LwsnMacAction &action)
+{
+  NS_LOG_FUNCTION (this << delay << action.type);
+  int64_t at = (Simulator::Now () + delay).GetTimeStep ();
+  int64_t slot = GetGrid ().GetTimeStep ();
+  if (delay.IsZero () || slot <= 0 || at % slot != 0)
+    {
+      return false;
+    }
+  Slot &pending = m_slots[at / slot];
+  if (!pending.open)
+    {
+      Simulator::Schedule (delay, &LwsnSlotScheduler::Tick, this);
+      pending.batches.push_back (std::vector<LwsnMacAction> ());
+      pending.open = true;
+    }
+  pending.batches.back ().push_back (action);
+  m_nPending++;
+  return true;
+}
+
+void
+LwsnSlotScheduler::Split (Time delay)
+{
+  NS_LOG_FUNCTION (this << delay);
+  // actions due now are left to the simulator, after the event
+  int64_t at = (Simulator::Now () + delay).GetTimeStep ();
+  int64_t slot = GetGrid ().GetTimeStep ();
+  if (delay.IsZero () || slot <= 0 || at % slot != 0)
+    {
+      return;
+    }
+  std::map<int64_t, Slot>::iterator it = m_slots.find (at / slot);
+  if (it != m_slots.end ())
+    {
+      it->second.open = false;
+    }
+}
+
+void
+LwsnSlotScheduler::Tick (void)
+{
+  NS_LOG_FUNCTION (this);
+  LWSN_PROFILE (SLOT_TICK);
+  LWSN_PROFILE_DEPTH (m_nPending);
+  NS_ASSERT (!m_slots.empty ());
+  std::map<int64_t, Slot>::iterator it = m_slots.begin ();
+  NS_ASSERT (it->first * GetGrid ().GetTimeStep () == Simulator::Now ().GetTimeStep ());
+  NS_ASSERT (!it->second.batches.empty ());
+
+  // actions only ever land in later slots, so the batch can be taken
+  // out before it is run.
+  m_running.swap (it->second.batches.front ());
+  it->second.batches.pop_front ();
+  if (it->second.batches.empty ())
+    {
+      m_slots.erase (it);
+    }
+  m_nPending -= m_running.size ();
+  m_nTicks++;
+  for (std::vector<LwsnMacAction>::const_iterator i = m_running.begin (); i != m_running.end (); ++i)
+    {
+      m_nActions++;
+      i->device->RunMacAction (*i);
+    }
+  m_running.clear ();
+}
+
+uint64_t
+LwsnSlotScheduler::GetNTicks (void) const
+{
+  return m_nTicks;
+}
+
+uint64_t
+LwsnSlotScheduler::GetNActions (void) const
+{
+  return m_nActions;
+}
+
+uint64_t
+LwsnSlotScheduler::GetNPending (void) const
+{
+  return m_nPending;
+}
+
+void
+LwsnSlotScheduler::WriteAddress (std::ostream &os, const std::vector<Ptr<SimpleNetDevice> > &devices,
+                                 Mac48Address address)
+{
+  for (uint32_t i = 0; i < devices.size (); i++)
+    {
+      if (Mac48Address::ConvertFrom (devices[i]->GetAddress ()) == address)
+        {
+          LwsnCheckpoint::Write<int32_t> (os, i);
+          return;
+        }
+    }
+  uint8_t buffer[6];
+  address.CopyTo (buffer);
+  LwsnCheckpoint::Write<int32_t> (os, -1);
+  os.write (reinterpret_cast<const char *> (buffer), sizeof (buffer));
+}
+
+bool
+LwsnSlotScheduler::ReadAddress (std::istream &is, const std::vector<Ptr<SimpleNetDevice> > &devices,
+                                Mac48Address &address)
+{
+  int32_t index;
+  if (!LwsnCheckpoint::Read (is, index) || index >= static_cast<int32_t> (devices.size ()))
+    {
+      return false;
+    }
+  if (index >= 0)
+    {
+      address = Mac48Address::ConvertFrom (devices[index]->GetAddress ());
+      return true;
+    }
+  uint8_t buffer[6];
+  if (index != -1 || is.read (reinterpret_cast<char *> (buffer), sizeof (buffer)).fail ())
+    {
+      return false;
+    }
+  address.CopyFrom (buffer);
+  return true;
+}
+
+bool
+LwsnSlotScheduler::ReadAction (std::istream &is, const std::vector<Ptr<SimpleNetDevice> > &devices,
+                               LwsnPacketTable &packets, LwsnMacAction &action)
+{
+  uint32_t device;
+  uint32_t type;
+  Ptr<Packet> packet;
+  if (!LwsnCheckpoint::Read (is, device) || device >= devices.size ()
+      || !LwsnCheckpoint::Read (is, type) || type > LwsnMacAction::FORWARD_QUEUED
+      || !packets.Read (is, packet)
+      || !LwsnCheckpoint::Read (is, action.reception)
+      || !LwsnCheckpoint::Read (is, action.protocol)
+      || !ReadAddress (is, devices, action.to)
+      || !ReadAddress (is, devices, action.from))
+    {
+      return false;
+    }
+  action.device = devices[device];
+  action.type = static_cast<LwsnMacAction::Type> (type);
+  action.packet = packet;
+  action.header = LwsnHeader ();
+  if (packet != 0 && packet->GetSize () >= action.header.GetSerializedSize ())
+    {
+      // as decoded by SimpleChannel::Send
+      packet->PeekHeader (action.header);
+    }
+  return true;
+}
+
+bool
+LwsnSlotScheduler::Save (std::ostream &os, const std::vector<Ptr<SimpleNetDevice> > &devices,
+                         LwsnPacketTable &packets) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_running.empty ());
+  std::map<Ptr<SimpleNetDevice>, uint32_t> index;
+  for (uint32_t i = 0; i < devices.size (); i++)
+    {
+      index[devices[i]] = i;
+    }
+  LwsnCheckpoint::Write (os, GetGrid ().GetTimeStep ());
+  LwsnCheckpoint::Write (os, m_nTicks);
+  LwsnCheckpoint::Write (os, m_nActions);
+  LwsnCheckpoint::Write<uint64_t> (os, m_slots.size ());
+  for (std::map<int64_t, Slot>::const_iterator it = m_slots.begin (); it != m_slots.end (); ++it)
+    {
+      LwsnCheckpoint::Write (os, it->first);
+      LwsnCheckpoint::Write (os, it->second.open);
+      LwsnCheckpoint::Write<uint64_t> (os, it->second.batches.size ());
+      for (std::deque<std::vector<LwsnMacAction> >::const_iterator batch = it->second.batches.begin ();
+           batch != it->second.batches.end (); ++batch)
+        {
+          LwsnCheckpoint::Write<uint64_t> (os, batch->size ());
+          for (std::vector<LwsnMacAction>::const_iterator i = batch->begin (); i != batch->end (); ++i)
+            {
+              std::map<Ptr<SimpleNetDevice>, uint32_t>::const_iterator device = index.find (i->device);
+              if (device == index.end ())
+                {
+                  return false;
+                }
+              LwsnCheckpoint::Write (os, device->second);
+              LwsnCheckpoint::Write<uint32_t> (os, i->type);
+              packets.Write (os, i->packet);
+              LwsnCheckpoint::Write (os, i->reception);
+              LwsnCheckpoint::Write (os, i->protocol);
+              WriteAddress (os, devices, i->to);
+              WriteAddress (os, devices, i->from);
+            }
+        }
+    }
+  return true;
+}
+
+bool
+LwsnSlotScheduler::Restore (std::istream &is, const std::vector<Ptr<SimpleNetDevice> > &devices,
+                            LwsnPacketTable &packets)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (m_running.empty ());
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  int64_t grid = GetGrid ().GetTimeStep ();
+  int64_t savedGrid;
+  uint64_t nSlots;
+  // the tick of a pending slot could not be taken back
+  if (!m_slots.empty ()
+      || !LwsnCheckpoint::Read (is, savedGrid) || savedGrid != grid
+      || !LwsnCheckpoint::Read (is, m_nTicks)
+      || !LwsnCheckpoint::Read (is, m_nActions)
+      || !LwsnCheckpoint::Read (is, nSlots))
+    {
+      return false;
+    }
+  for (uint64_t s = 0; s < nSlots; s++)
+    {
+      int64_t slot;
+      uint64_t nBatches;
+      if (!LwsnCheckpoint::Read (is, slot) || slot * grid < now)
+        {
+          return false;
+        }
+      Slot &pending = m_slots[slot];
+      if (!LwsnCheckpoint::Read (is, pending.open)
+          || !LwsnCheckpoint::Read (is, nBatches) || nBatches == 0)
+        {
+          return false;
+        }
+      pending.batches.resize (nBatches);
+      for (std::deque<std::vector<LwsnMacAction> >::iterator batch = pending.batches.begin ();
+           batch != pending.batches.end (); ++batch)
+        {
+          uint64_t nActions;
+          if (!LwsnCheckpoint::Read (is, nActions) || nActions == 0)
+            {
+              return false;
+            }
+          batch->resize (nActions);
+          for (std::vector<LwsnMacAction>::iterator i = batch->begin (); i != batch->end (); ++i)
+            {
+              if (!ReadAction (is, devices, packets, *i))
+                {
+                  return false;
+                }
+            }
+          Simulator::Schedule (TimeStep (slot * grid - now), &LwsnSlotScheduler::Tick, this);
+          m_nPending += nActions;
+        }
+    }
+  return true;
+}
+
+void
+LwsnSlotScheduler::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_slots.clear ();
+  m_running.clear ();
+  m_nPending = 0;
+  m_slotTiming = 0;
+  Object::DoDispose ();
+}
+
+} // namespace ns3
@@ -0,0 +1,224 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_SLOT_SCHEDULER_H
+#define LWSN_SLOT_SCHEDULER_H
+
+#include <stdint.h>
+#include <deque>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <vector>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/lwsn-header.h"
+#include "mac48-address.h"
+#include "lwsn-checkpoint.h"
+#include "lwsn-slot-timing.h"
+
+namespace ns3 {
+
+class SimpleNetDevice;
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * One deferred SimpleNetDevice MAC action, together with the arguments
+ * the matching SimpleNetDevice method is called with.
+ */
+struct LwsnMacAction
+{
+  /// The SimpleNetDevice method to run
+  enum Type
+  {
+    RECEIVE_END,
+    SET_SLEEP,
+    ACK_CHECK,
+    ORIGINAL_ACK_CHECK,
+    WAIT_SEND,
+    RESEND,
+    REORIGINAL_SEND,
+    ACK_SEND,
+    FORWARDING,
+    CODED_ACK_CHECK,
+    RECODED_SEND,
+    ANNOUNCE,
+    AGGREGATE_ACK_CHECK,
+    REAGGREGATE_SEND,
+    BLOCK_ACK_SEND,
+    FORWARD_QUEUED
+  };
+
+  Ptr<SimpleNetDevice> device; //!< device the action belongs to
+  Type type;                   //!< method to run
+  Ptr<const Packet> packet;    //!< packet argument, if any
+  LwsnHeader header;           //!< decoded header (RECEIVE_END only)
+  uint32_t reception;          //!< interference tracker id (RECEIVE_END only)
+  uint16_t protocol;           //!< protocol argument
+  Mac48Address to;             //!< destination argument
+  Mac48Address from;           //!< source argument
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Slot-driven engine for the SimpleNetDevice MAC timers.
+ *
+ * Every MAC timer of the slotted-ALOHA model falls on a fixed slot
+ * grid: the slots of the LwsnSlotTiming of the channel, and the end of
+ * the frames that fill a slot up to its Guard.  The grid is therefore
+ * the greatest common divisor of SlotLength and Guard, unless the
+ * SlotLength attribute of the scheduler gives it.  Instead of one
+ * simulator event per timer, the actions due in a
+ * slot are stored in a per-slot array and a single tick event runs
+ * them all, in the order they were scheduled.  Ticks are only scheduled
+ * for slots that have work.
+ *
+ * A tick is inserted when the first action of its batch is, so the
+ * actions run in the order the simulator would have run them as
+ * events, as long as no other event for the same slot is scheduled
+ * while the batch is filled.  Other events on the grid are therefore
+ * announced with Split, which closes the batch: the actions scheduled
+ * after them get a new batch and a new tick, which the simulator runs
+ * after them.  The run is then identical to the event-per-action mode.
+ * SimpleChannel::Send, LwsnTrafficApplication and the SimpleNetDevice
+ * StatsSnapshot events do so through SimpleChannel::SplitSlot, and so
+ * must anything else that schedules events while the simulation runs.
+ * Actions that are not on the grid, or that are due now, are left to
+ * the simulator.
+ */
+class LwsnSlotScheduler : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LwsnSlotScheduler ();
+
+  /**
+   * \param delay delay from now after which the action runs
+   * \param action the action to run
+   * \returns false if the action does not fall on the slot grid, in
+   * which case the caller has to schedule it itself
+   */
+  bool Schedule (Time delay, const LwsnMacAction &action);
+
+  /**
+   * Announce an event other than a MAC action.  If it falls on the
+   * grid, the actions scheduled for the same slot from now on run after
+   * it, as they would as events of their own.
+   *
+   * \param delay delay from now of the event
+   */
+  void Split (Time delay);
+
+  /**
+   * \param timing the slot timing of the channel, which gives the grid
+   * when SlotLength is zero
+   */
+  void SetSlotTiming (Ptr<LwsnSlotTiming> timing);
+  /**
+   * \returns the spacing of the grid the actions have to fall on
+   */
+  Time GetGrid (void) const;
+
+  /**
+   * \returns the number of tick events run so far
+   */
+  uint64_t GetNTicks (void) const;
+
+  /**
+   * \returns the number of actions run so far
+   */
+  uint64_t GetNActions (void) const;
+
+  /**
+   * \returns the number of actions scheduled and not run yet
+   */
+  uint64_t GetNPending (void) const;
+
+  /**
+   * Write the counters and the pending actions as LwsnCheckpoint fields.
+   * Devices, and addresses of devices, are written as their position in
+   * devices, so that the actions can be restored on another line of the
+   * same layout.
+   *
+   * \param os output stream
+   * \param devices the devices the actions may belong to
+   * \param packets packet table of the checkpoint
+   * \returns false if an action belongs to a device not in devices
+   */
+  bool Save (std::ostream &os, const std::vector<Ptr<SimpleNetDevice> > &devices,
+             LwsnPacketTable &packets) const;
+  /**
+   * Replace the counters with those written by Save and schedule its
+   * pending actions, with a tick for each batch.  No action may be
+   * pending yet.
+   *
+   * \param is input stream
+   * \param devices the devices the actions belong to, in the order given to Save
+   * \param packets packet table of the checkpoint
+   * \returns false if actions are already pending, if the stream does
+   * not hold actions written by Save on the same grid, or if it holds
+   * actions for a slot already over
+   */
+  bool Restore (std::istream &is, const std::vector<Ptr<SimpleNetDevice> > &devices,
+                LwsnPacketTable &packets);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  /**
+   * Run every action of the first batch of the earliest pending slot.
+   */
+  void Tick (void);
+
+  /**
+   * \param os output stream
+   * \param devices the devices of the checkpoint
+   * \param address an address, written as its device position if it
+   * is one of them
+   */
+  static void WriteAddress (std::ostream &os, const std::vector<Ptr<SimpleNetDevice> > &devices,
+                            Mac48Address address);
+  /**
+   * \param is input stream
+   * \param devices the devices of the checkpoint
+   * \param address set to the address read
+   * \returns false if the stream does not hold an address written by WriteAddress
+   */
+  static bool ReadAddress (std::istream &is, const std::vector<Ptr<SimpleNetDevice> > &devices,
+                           Mac48Address &address);
+  /**
+   * \param is input stream
+   * \param devices the devices of the checkpoint
+   * \param packets packet table of the checkpoint
+   * \param action set to the action read
+   * \returns false if the stream does not hold an action written by Save
+   */
+  static bool ReadAction (std::istream &is, const std::vector<Ptr<SimpleNetDevice> > &devices,
+                          LwsnPacketTable &packets, LwsnMacAction &action);
+
+  /// The actions pending in one slot, in batches run by one tick each
+  struct Slot
+  {
+    Slot ();
+    std::deque<std::vector<LwsnMacAction> > batches; //!< batches, in the order of their ticks
+    bool open; //!< the last batch still takes actions
+  };
+
+  Time m_slotLength; //!< slot grid spacing, zero to take it from m_slotTiming
+  Ptr<LwsnSlotTiming> m_slotTiming; //!< slot timing of the channel
+  std::map<int64_t, Slot> m_slots; //!< pending actions by slot index
+  std::vector<LwsnMacAction> m_running; //!< actions of the slot being run
+  uint64_t m_nTicks;   //!< tick events run
+  uint64_t m_nActions; //!< actions run
+  uint64_t m_nPending; //!< actions scheduled and not run yet
+};
+
+} // namespace ns3
+
+#endif /* LWSN_SLOT_SCHEDULER_H */
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-slot-timing.h"
+#include "ns3/uinteger.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include <algorithm>
+#include <limits>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnSlotTiming");
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnSlotTiming);
+
+TypeId
+LwsnSlotTiming::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnSlotTiming")
+    .SetParent<Object> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnSlotTiming> ()
+    .AddAttribute ("SlotLength",
+                   "Length of a MAC slot.",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&LwsnSlotTiming::m_slot),
+                   MakeTimeChecker ())
+    .AddAttribute ("Guard",
+                   "Time kept clear at the end of every slot for the radio "
+                   "turnaround.",
+                   TimeValue (MilliSeconds (100)),
+                   MakeTimeAccessor (&LwsnSlotTiming::m_guard),
+                   MakeTimeChecker ())
+    .AddAttribute ("DataRate",
+                   "Bit rate of the radio; zero makes every frame fill its "
+                   "slot up to the Guard.",
+                   DataRateValue (DataRate ("0b/s")),
+                   MakeDataRateAccessor (&LwsnSlotTiming::m_dataRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("AckOffset",
+                   "Slots a reply to the left neighbour waits after a reply "
+                   "to the right one would be sent.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&LwsnSlotTiming::m_ackOffset),
+                   MakeUintegerChecker<uint32_t> ())
+  ;
+  return tid;
+}
+
+LwsnSlotTiming::LwsnSlotTiming ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+Time
+LwsnSlotTiming::GetSlot (void) const
+{
+  return m_slot;
+}
+
+Time
+LwsnSlotTiming::GetSlots (uint32_t n) const
+{
+  return TimeStep (m_slot.GetTimeStep () * n);
+}
+
+Time
+LwsnSlotTiming::GetGuard (void) const
+{
+  return m_guard;
+}
+
+Time
+LwsnSlotTiming::GetAirtime (uint32_t bytes) const
+{
+  if (!(m_dataRate > DataRate (0)))
+    {
+      return m_slot - m_guard;
+    }
+  Time airtime = m_dataRate.CalculateBytesTxTime (bytes);
+  NS_ABORT_MSG_IF (airtime > m_slot - m_guard, "a frame of " << bytes << " bytes takes " << airtime
+                   << " at " << m_dataRate << ", more than SlotLength - Guard");
+  return airtime;
+}
+
+uint32_t
+LwsnSlotTiming::GetMaxBytes (void) const
+{
+  if (!(m_dataRate > DataRate (0)))
+    {
+      return std::numeric_limits<uint32_t>::max ();
+    }
+  double bytes = (m_slot - m_guard).GetSeconds () * m_dataRate.GetBitRate () / 8;
+  uint32_t max = static_cast<uint32_t> (std::min<double> (std::max (bytes, 0.0), std::numeric_limits<uint32_t>::max ()));
+  // the airtime is rounded to time steps
+  while (max > 0 && m_dataRate.CalculateBytesTxTime (max) > m_slot - m_guard)
+    {
+      max--;
+    }
+  return max;
+}
+
+Time
+LwsnSlotTiming::GetReplyDelay (uint32_t bytes, Time delay) const
+{
+  Time reply = m_slot - GetAirtime (bytes) - delay;
+  NS_ABORT_MSG_IF (reply.IsStrictlyNegative (), "a frame of " << bytes << " bytes delayed by " << delay
+                   << " ends after the slot");
+  return reply;
+}
+
+Time
+LwsnSlotTiming::GetAckOffset (void) const
+{
+  return GetSlots (m_ackOffset);
+}
+
+} // namespace ns3
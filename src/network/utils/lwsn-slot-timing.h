@@ -0,0 +1,78 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_SLOT_TIMING_H
+#define LWSN_SLOT_TIMING_H
+
+#include <stdint.h>
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/data-rate.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Slot timing of the LWSN MAC.
+ *
+ * Every frame is sent at the start of a slot and is on the air for its
+ * airtime.  The receiver replies (IACK, forward) at the start of the next
+ * slot, so its reply delay is what is left of the slot after the frame
+ * and its propagation delay.
+ * A reply to the left neighbour waits AckOffset more slots, so that the
+ * two replies of a relay do not collide.  Timeouts and backoffs are
+ * whole numbers of slots.
+ *
+ * With a DataRate of zero every frame fills the slot up to the Guard;
+ * otherwise the airtime is that of the frame at DataRate, and has to fit
+ * in SlotLength - Guard.  The propagation delay of the channel has to
+ * fit in what is left of the slot.  The defaults are the one-second
+ * slots the MAC was written for.
+ *
+ * One LwsnSlotTiming is shared by the devices of a SimpleChannel; see
+ * its SlotTiming attribute.
+ */
+class LwsnSlotTiming : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  LwsnSlotTiming ();
+
+  /// \returns the slot length
+  Time GetSlot (void) const;
+  /**
+   * \param n a number of slots
+   * \returns their length
+   */
+  Time GetSlots (uint32_t n) const;
+  /// \returns the time kept clear at the end of every slot
+  Time GetGuard (void) const;
+  /**
+   * \param bytes size of a frame, header included
+   * \returns the time the frame is on the air
+   */
+  Time GetAirtime (uint32_t bytes) const;
+  /// \returns the largest frame that fits in SlotLength - Guard, in bytes
+  uint32_t GetMaxBytes (void) const;
+  /**
+   * \param bytes size of the frame received, header included
+   * \param delay propagation delay of the frame
+   * \returns the time from the end of its reception to the next slot
+   */
+  Time GetReplyDelay (uint32_t bytes, Time delay = Time (0)) const;
+  /// \returns the extra wait of a reply to the left neighbour
+  Time GetAckOffset (void) const;
+
+private:
+  Time m_slot;          //!< slot length
+  Time m_guard;         //!< time kept clear at the end of a slot
+  DataRate m_dataRate;  //!< radio bit rate, 0 for frames filling the slot
+  uint32_t m_ackOffset; //!< slots a reply to the left neighbour waits
+};
+
+} // namespace ns3
+
+#endif /* LWSN_SLOT_TIMING_H */
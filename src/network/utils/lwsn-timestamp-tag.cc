@@ -0,0 +1,91 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-timestamp-tag.h"
+#include "ns3/log.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnTimestampTag");
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnTimestampTag);
+
+TypeId
+LwsnTimestampTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnTimestampTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Network")
+    .AddConstructor<LwsnTimestampTag> ()
+  ;
+  return tid;
+}
+TypeId
+LwsnTimestampTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+uint32_t
+LwsnTimestampTag::GetSerializedSize (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return 16;
+}
+void
+LwsnTimestampTag::Serialize (TagBuffer buf) const
+{
+  NS_LOG_FUNCTION (this << &buf);
+  buf.WriteU64 (m_origin.GetTimeStep ());
+  buf.WriteU64 (m_origin2.GetTimeStep ());
+}
+void
+LwsnTimestampTag::Deserialize (TagBuffer buf)
+{
+  NS_LOG_FUNCTION (this << &buf);
+  m_origin = TimeStep (buf.ReadU64 ());
+  m_origin2 = TimeStep (buf.ReadU64 ());
+}
+void
+LwsnTimestampTag::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this << &os);
+  os << "Origin=" << m_origin << " Origin2=" << m_origin2;
+}
+LwsnTimestampTag::LwsnTimestampTag ()
+  : Tag ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LwsnTimestampTag::LwsnTimestampTag (Time origin)
+  : Tag (),
+    m_origin (origin)
+{
+  NS_LOG_FUNCTION (this << origin);
+}
+
+void
+LwsnTimestampTag::SetOrigin (Time origin)
+{
+  NS_LOG_FUNCTION (this << origin);
+  m_origin = origin;
+}
+Time
+LwsnTimestampTag::GetOrigin (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_origin;
+}
+
+void
+LwsnTimestampTag::SetOrigin2 (Time origin)
+{
+  NS_LOG_FUNCTION (this << origin);
+  m_origin2 = origin;
+}
+Time
+LwsnTimestampTag::GetOrigin2 (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_origin2;
+}
+
+} // namespace ns3
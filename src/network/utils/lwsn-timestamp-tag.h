@@ -0,0 +1,65 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_TIMESTAMP_TAG_H
+#define LWSN_TIMESTAMP_TAG_H
+
+#include "ns3/tag.h"
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Full-resolution origin time of an LWSN reading.
+ *
+ * LwsnHeader only has room for the start time in whole seconds, on 16
+ * bits.  The originating sensor tags the reading with the exact time it
+ * was generated, and the tag follows every copy of the frame up to the
+ * gateway.  A NETWORK_CODING frame carries the origin of its left-bound
+ * half in the first field and that of its right-bound half in the
+ * second one, like StartTime and StartTime2 of its header.
+ */
+class LwsnTimestampTag : public Tag
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+  virtual TypeId GetInstanceTypeId (void) const;
+  virtual uint32_t GetSerializedSize (void) const;
+  virtual void Serialize (TagBuffer buf) const;
+  virtual void Deserialize (TagBuffer buf);
+  virtual void Print (std::ostream &os) const;
+  LwsnTimestampTag ();
+
+  /**
+   * \param origin time the reading was generated
+   */
+  LwsnTimestampTag (Time origin);
+
+  /**
+   * \param origin time the reading was generated
+   */
+  void SetOrigin (Time origin);
+  /**
+   * \returns the time the reading was generated
+   */
+  Time GetOrigin (void) const;
+  /**
+   * \param origin time the right-bound reading of a coded frame was generated
+   */
+  void SetOrigin2 (Time origin);
+  /**
+   * \returns the time the right-bound reading of a coded frame was generated
+   */
+  Time GetOrigin2 (void) const;
+private:
+  Time m_origin;  //!< origin of the reading
+  Time m_origin2; //!< origin of the right-bound half of a coded frame
+};
+
+} // namespace ns3
+
+#endif /* LWSN_TIMESTAMP_TAG_H */
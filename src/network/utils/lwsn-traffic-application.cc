@@ -0,0 +1,270 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#include "lwsn-traffic-application.h"
+#include "simple-net-device.h"
+#include "simple-channel.h"
+#include "ns3/log.h"
+#include "ns3/abort.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/string.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("LwsnTrafficApplication");
+
+NS_OBJECT_ENSURE_REGISTERED (LwsnTrafficApplication);
+
+TypeId
+LwsnTrafficApplication::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::LwsnTrafficApplication")
+    .SetParent<Application> ()
+    .SetGroupName("Network")
+    .AddConstructor<LwsnTrafficApplication> ()
+    .AddAttribute ("Process",
+                   "The arrival process of the readings.",
+                   EnumValue (LwsnTrafficApplication::POISSON),
+                   MakeEnumAccessor (&LwsnTrafficApplication::m_process),
+                   MakeEnumChecker (LwsnTrafficApplication::POISSON, "Poisson",
+                                    LwsnTrafficApplication::PERIODIC, "Periodic",
+                                    LwsnTrafficApplication::BURSTY, "Bursty",
+                                    LwsnTrafficApplication::TRACE, "Trace"))
+    .AddAttribute ("Interval",
+                   "Mean time between two readings (Poisson), period (Periodic) "
+                   "or mean time between two bursts (Bursty).",
+                   TimeValue (Seconds (10.0)),
+                   MakeTimeAccessor (&LwsnTrafficApplication::m_interval),
+                   MakeTimeChecker ())
+    .AddAttribute ("BurstSize",
+                   "Number of readings per burst (Bursty).",
+                   UintegerValue (5),
+                   MakeUintegerAccessor (&LwsnTrafficApplication::m_burstSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("BurstSpacing",
+                   "Time between two readings of a burst (Bursty).",
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&LwsnTrafficApplication::m_burstSpacing),
+                   MakeTimeChecker ())
+    .AddAttribute ("TraceFile",
+                   "File of arrival times in seconds, one per line, relative "
+                   "to the start of the application (Trace).",
+                   StringValue (""),
+                   MakeStringAccessor (&LwsnTrafficApplication::m_traceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("Granularity",
+                   "Arrivals are moved up to the next multiple of this time; "
+                   "zero leaves them where they fall.",
+                   TimeValue (Seconds (0.0)),
+                   MakeTimeAccessor (&LwsnTrafficApplication::m_granularity),
+                   MakeTimeChecker ())
+    .AddAttribute ("MaxPackets",
+                   "The maximum number of readings injected (zero means infinite).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&LwsnTrafficApplication::m_maxPackets),
+                   MakeUintegerChecker<uint64_t> ())
+    .AddAttribute ("PacketSize",
+                   "Payload size of the readings (bytes).",
+                   UintegerValue (100),
+                   MakeUintegerAccessor (&LwsnTrafficApplication::m_size),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddTraceSource ("Tx", "A reading has been injected",
+                     MakeTraceSourceAccessor (&LwsnTrafficApplication::m_txTrace),
+                     "ns3::Packet::TracedCallback")
+  ;
+  return tid;
+}
+
+LwsnTrafficApplication::LwsnTrafficApplication ()
+  : m_traceIndex (0),
+    m_burstLeft (0),
+    m_sent (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_gap = CreateObject<ExponentialRandomVariable> ();
+}
+
+LwsnTrafficApplication::~LwsnTrafficApplication ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+LwsnTrafficApplication::SetDevice (Ptr<SimpleNetDevice> device)
+{
+  NS_LOG_FUNCTION (this << device);
+  m_device = device;
+}
+
+Ptr<SimpleNetDevice>
+LwsnTrafficApplication::GetDevice (void) const
+{
+  return m_device;
+}
+
+void
+LwsnTrafficApplication::SetTrace (const std::vector<Time> &arrivals)
+{
+  NS_LOG_FUNCTION (this << arrivals.size ());
+  m_trace = arrivals;
+}
+
+uint64_t
+LwsnTrafficApplication::GetNSent (void) const
+{
+  return m_sent;
+}
+
+int64_t
+LwsnTrafficApplication::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_gap->SetStream (stream);
+  return 1;
+}
+
+void
+LwsnTrafficApplication::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_device = 0;
+  m_payload = 0;
+  m_gap = 0;
+  m_trace.clear ();
+  Application::DoDispose ();
+}
+
+void
+LwsnTrafficApplication::StartApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_device == 0)
+    {
+      for (uint32_t i = 0; i < GetNode ()->GetNDevices (); i++)
+        {
+          m_device = DynamicCast<SimpleNetDevice> (GetNode ()->GetDevice (i));
+          if (m_device != 0)
+            {
+              break;
+            }
+        }
+      NS_ABORT_MSG_IF (m_device == 0, "LwsnTrafficApplication needs a SimpleNetDevice on its node");
+    }
+  if (m_payload == 0 || m_payload->GetSize () != m_size)
+    {
+      m_payload = Create<Packet> (m_size);
+    }
+  m_gap->SetAttribute ("Mean", DoubleValue (m_interval.GetSeconds ()));
+  m_start = Simulator::Now ();
+  // the first periodic reading goes at once
+  m_last = (m_process == PERIODIC) ? m_start - m_interval : m_start;
+  m_burstLeft = 0;
+  m_traceIndex = 0;
+  if (m_process == TRACE && m_trace.empty ())
+    {
+      NS_ABORT_MSG_IF (m_traceFile.empty (), "The Trace process needs SetTrace or TraceFile");
+      m_traceStream.open (m_traceFile.c_str ());
+      NS_ABORT_MSG_UNLESS (m_traceStream.is_open (), "Cannot open " << m_traceFile);
+    }
+  ScheduleNext ();
+}
+
+void
+LwsnTrafficApplication::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+  Simulator::Cancel (m_sendEvent);
+  if (m_traceStream.is_open ())
+    {
+      m_traceStream.close ();
+    }
+}
+
+bool
+LwsnTrafficApplication::NextArrival (Time &at)
+{
+  switch (m_process)
+    {
+    case PERIODIC:
+      at = m_last + m_interval;
+      break;
+    case POISSON:
+      at = m_last + Seconds (m_gap->GetValue ());
+      break;
+    case BURSTY:
+      if (m_burstLeft > 0)
+        {
+          at = m_last + m_burstSpacing;
+          m_burstLeft--;
+        }
+      else
+        {
+          at = m_last + Seconds (m_gap->GetValue ());
+          m_burstLeft = m_burstSize - 1;
+        }
+      break;
+    case TRACE:
+      if (m_traceIndex < m_trace.size ())
+        {
+          at = m_start + m_trace[m_traceIndex++];
+        }
+      else
+        {
+          double seconds;
+          if (!m_traceStream.is_open () || !(m_traceStream >> seconds))
+            {
+              return false;
+            }
+          at = m_start + Seconds (seconds);
+        }
+      break;
+    }
+  m_last = at;
+  return true;
+}
+
+void
+LwsnTrafficApplication::ScheduleNext (void)
+{
+  if (m_maxPackets != 0 && m_sent >= m_maxPackets)
+    {
+      return;
+    }
+  Time at;
+  if (!NextArrival (at))
+    {
+      NS_LOG_LOGIC ("arrival process exhausted after " << m_sent << " readings");
+      return;
+    }
+  if (m_granularity.IsStrictlyPositive ())
+    {
+      int64_t grid = m_granularity.GetTimeStep ();
+      at = TimeStep ((at.GetTimeStep () + grid - 1) / grid * grid);
+    }
+  Time delay = at - Simulator::Now ();
+  if (delay.IsStrictlyNegative ())
+    {
+      delay = Time (0);
+    }
+  Ptr<SimpleChannel> channel = DynamicCast<SimpleChannel> (m_device->GetChannel ());
+  if (channel != 0)
+    {
+      channel->SplitSlot (delay);
+    }
+  m_sendEvent = Simulator::Schedule (delay, &LwsnTrafficApplication::Send, this);
+}
+
+void
+LwsnTrafficApplication::Send (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_device->OriginalTransmission (m_payload, 0, false);
+  m_sent++;
+  m_txTrace (m_payload);
+  ScheduleNext ();
+}
+
+} // namespace ns3
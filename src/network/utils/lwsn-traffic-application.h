@@ -0,0 +1,143 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LWSN_TRAFFIC_APPLICATION_H
+#define LWSN_TRAFFIC_APPLICATION_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include "ns3/random-variable-stream.h"
+
+namespace ns3 {
+
+class Packet;
+class SimpleNetDevice;
+
+/**
+ * \ingroup network
+ *
+ * \brief Source of sensor readings for a LWSN SimpleNetDevice.
+ *
+ * Each arrival hands the same payload packet to
+ * SimpleNetDevice::OriginalTransmission, which copies it before adding
+ * its header, so a run creates one payload per source however many
+ * readings it injects.  Arrivals are generated lazily: only the next one
+ * is scheduled, so a source costs one pending event whatever its rate
+ * or MaxPackets.
+ *
+ * The arrival process is one of:
+ *  - Poisson: exponential gaps of mean Interval;
+ *  - Periodic: one reading every Interval;
+ *  - Bursty: BurstSize readings BurstSpacing apart, bursts starting
+ *    with exponential gaps of mean Interval;
+ *  - Trace: the times given by SetTrace, or read one line at a time
+ *    from TraceFile (seconds, one per line), relative to the start of
+ *    the application.
+ *
+ * When Granularity is not zero every arrival is moved up to the next
+ * multiple of it, so that readings start on the MAC slot grid.
+ */
+class LwsnTrafficApplication : public Application
+{
+public:
+  /// Arrival process
+  enum Process
+  {
+    POISSON,
+    PERIODIC,
+    BURSTY,
+    TRACE
+  };
+
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  LwsnTrafficApplication ();
+  virtual ~LwsnTrafficApplication ();
+
+  /**
+   * \param device the sensor the readings are injected into; by default
+   * the first SimpleNetDevice of the node
+   */
+  void SetDevice (Ptr<SimpleNetDevice> device);
+  /// \returns the sensor the readings are injected into
+  Ptr<SimpleNetDevice> GetDevice (void) const;
+
+  /**
+   * Use these arrival times with the Trace process instead of TraceFile.
+   *
+   * \param arrivals arrival times, relative to the start of the
+   * application, in increasing order
+   */
+  void SetTrace (const std::vector<Time> &arrivals);
+
+  /// \returns the number of readings injected so far
+  uint64_t GetNSent (void) const;
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this application.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned
+   */
+  int64_t AssignStreams (int64_t stream);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  /**
+   * Inject one reading and schedule the next one.
+   */
+  void Send (void);
+  /**
+   * Schedule the next arrival, if any is left.
+   */
+  void ScheduleNext (void);
+  /**
+   * \param at set to the time of the next arrival, before rounding to
+   * the granularity
+   * \returns false once the arrival process is exhausted
+   */
+  bool NextArrival (Time &at);
+
+  Process m_process;      //!< arrival process
+  Time m_interval;        //!< mean or fixed time between arrivals or bursts
+  uint32_t m_burstSize;   //!< readings per burst
+  Time m_burstSpacing;    //!< time between the readings of a burst
+  Time m_granularity;     //!< arrival time grid, zero for none
+  uint64_t m_maxPackets;  //!< readings to inject, zero for no limit
+  uint32_t m_size;        //!< payload size, bytes
+  std::string m_traceFile; //!< arrival times file, Trace process
+
+  Ptr<SimpleNetDevice> m_device;      //!< sensor the readings go to
+  Ptr<Packet> m_payload;              //!< payload shared by every reading
+  Ptr<ExponentialRandomVariable> m_gap; //!< Poisson and burst gaps
+  std::vector<Time> m_trace;          //!< arrival times given by SetTrace
+  uint64_t m_traceIndex;              //!< next entry of m_trace
+  std::ifstream m_traceStream;        //!< TraceFile, read as needed
+  Time m_start;                       //!< time the application started
+  Time m_last;                        //!< last arrival time before rounding
+  uint32_t m_burstLeft;               //!< readings left in the burst
+  uint64_t m_sent;                    //!< readings injected
+  EventId m_sendEvent;                //!< next arrival
+
+  /// Traced Callback: readings injected
+  TracedCallback<Ptr<const Packet> > m_txTrace;
+};
+
+} // namespace ns3
+
+#endif /* LWSN_TRAFFIC_APPLICATION_H */
@@ -18,12 +18,19 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include <algorithm>
+#include <set>
 #include "simple-channel.h"
 #include "simple-net-device.h"
+#include "lwsn-profiler.h"
 #include "ns3/simulator.h"
 #include "ns3/packet.h"
 #include "ns3/node.h"
 #include "ns3/log.h"
+#include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/lwsn-header.h"
 
 namespace ns3 {
 
@@ -42,11 +49,36 @@ SimpleChannel::GetTypeId (void)
                    TimeValue (Seconds (0)),
                    MakeTimeAccessor (&SimpleChannel::m_delay),
                    MakeTimeChecker ())
+    .AddAttribute ("NeighbourDelivery",
+                   "Deliver frames only to the addressed device and to the "
+                   "devices within InterferenceRange hops of the sender.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SimpleChannel::m_neighbourDelivery),
+                   MakeBooleanChecker ())
+    .AddAttribute ("InterferenceRange",
+                   "Number of hops on each side of the sender that hear a frame "
+                   "when NeighbourDelivery is enabled.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SimpleChannel::m_interferenceRange),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("SlotScheduling",
+                   "Run the MAC timers of the attached devices from one "
+                   "LwsnSlotScheduler tick per slot instead of one event per timer.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SimpleChannel::m_slotScheduling),
+                   MakeBooleanChecker ())
+    .AddAttribute ("SlotTiming",
+                   "Slot length, guard and airtime of the MAC of the attached "
+                   "devices.",
+                   StringValue ("ns3::LwsnSlotTiming"),
+                   MakePointerAccessor (&SimpleChannel::m_slotTiming),
+                   MakePointerChecker<LwsnSlotTiming> ())
   ;
   return tid;
 }
 
 SimpleChannel::SimpleChannel ()
+  : m_neighboursValid (false)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -57,6 +89,58 @@ SimpleChannel::Send (Ptr<Packet> p, uint16_t protocol,
                      Ptr<SimpleNetDevice> sender)
 {
   NS_LOG_FUNCTION (this << p << protocol << to << from << sender);
+  LWSN_PROFILE (CHANNEL_SEND);
+  // every receiver gets a read-only view of the same frame along with
+  // its decoded header; receivers copy it only when they modify or
+  // queue it.
+  Ptr<const Packet> frame = p->Copy ();
+  LwsnHeader header;
+  if (frame->GetSize () >= header.GetSerializedSize ())
+    {
+      frame->PeekHeader (header);
+    }
+
+  // the receptions are events of their own, after the MAC actions
+  // already due at that time
+  SplitSlot (m_delay);
+
+  if (m_neighbourDelivery)
+    {
+      if (!m_neighboursValid)
+        {
+          BuildNeighbours ();
+        }
+      const std::vector<Ptr<SimpleNetDevice> > &neighbours = m_neighbours[sender];
+      bool addressedFound = false;
+      for (std::vector<Ptr<SimpleNetDevice> >::const_iterator i = neighbours.begin (); i != neighbours.end (); ++i)
+        {
+          Ptr<SimpleNetDevice> tmp = *i;
+          if (Mac48Address::ConvertFrom (tmp->GetAddress ()) == to)
+            {
+              addressedFound = true;
+            }
+          if (IsBlackListed (sender, tmp) || !tmp->IsRadioAwake ())
+            {
+              continue;
+            }
+          Simulator::ScheduleWithContext (tmp->GetNode ()->GetId (), m_delay,
+                                          &SimpleNetDevice::ReceiveStart, tmp, frame, header, protocol, to, from);
+        }
+      if (!addressedFound)
+        {
+          // the addressed device is out of range; it still gets the frame
+          // so that delivery matches the broadcast fan-out.
+          std::map<Mac48Address, Ptr<SimpleNetDevice> >::const_iterator it = m_addressIndex.find (to);
+          if (it != m_addressIndex.end () && it->second != sender && !IsBlackListed (sender, it->second)
+              && it->second->IsRadioAwake ())
+            {
+              Simulator::ScheduleWithContext (it->second->GetNode ()->GetId (), m_delay,
+                                              &SimpleNetDevice::ReceiveStart, it->second, frame, header, protocol, to, from);
+            }
+        }
+      return;
+    }
+
   for (std::vector<Ptr<SimpleNetDevice> >::const_iterator i = m_devices.begin (); i != m_devices.end (); ++i)
     {
       Ptr<SimpleNetDevice> tmp = *i;
@@ -64,17 +148,167 @@ SimpleChannel::Send (Ptr<Packet> p, uint16_t protocol,
         {
           continue;
         }
-      if (m_blackListedDevices.find (tmp) != m_blackListedDevices.end ())
+      if (IsBlackListed (sender, tmp) || !tmp->IsRadioAwake ())
+        {
+          // a sleeping radio does not hear the frame at all
+          continue;
+        }
+      Simulator::ScheduleWithContext (tmp->GetNode ()->GetId (), m_delay,
+                                      &SimpleNetDevice::ReceiveStart, tmp, frame, header, protocol, to, from);
+    }
+}
+
+bool
+SimpleChannel::IsBlackListed (Ptr<SimpleNetDevice> from, Ptr<SimpleNetDevice> to)
+{
+  std::map<Ptr<SimpleNetDevice>, std::vector<Ptr<SimpleNetDevice> > >::iterator it = m_blackListedDevices.find (to);
+  if (it == m_blackListedDevices.end ())
+    {
+      return false;
+    }
+  return find (it->second.begin (), it->second.end (), from) != it->second.end ();
+}
+
+void
+SimpleChannel::InvalidateNeighbours (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_neighboursValid = false;
+}
+
+Ptr<LwsnSlotScheduler>
+SimpleChannel::GetSlotScheduler (void)
+{
+  if (!m_slotScheduling)
+    {
+      return 0;
+    }
+  if (m_slotScheduler == 0)
+    {
+      m_slotScheduler = CreateObject<LwsnSlotScheduler> ();
+      m_slotScheduler->SetSlotTiming (m_slotTiming);
+    }
+  return m_slotScheduler;
+}
+
+void
+SimpleChannel::SplitSlot (Time delay)
+{
+  if (m_slotScheduling)
+    {
+      GetSlotScheduler ()->Split (delay);
+    }
+}
+
+Ptr<LwsnSlotTiming>
+SimpleChannel::GetSlotTiming (void) const
+{
+  return m_slotTiming;
+}
+
+Time
+SimpleChannel::GetDelay (void) const
+{
+  return m_delay;
+}
+
+double
+SimpleChannel::GetRxPower (Mac48Address from)
+{
+  if (!m_neighboursValid)
+    {
+      BuildNeighbours ();
+    }
+  std::map<Mac48Address, Ptr<SimpleNetDevice> >::const_iterator it = m_addressIndex.find (from);
+  if (it == m_addressIndex.end ())
+    {
+      return 0.0;
+    }
+  return it->second->GetTxPower ();
+}
+
+void
+SimpleChannel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_slotScheduler != 0)
+    {
+      m_slotScheduler->Dispose ();
+      m_slotScheduler = 0;
+    }
+  m_slotTiming = 0;
+  m_neighbours.clear ();
+  m_addressIndex.clear ();
+  m_devices.clear ();
+  m_blackListedDevices.clear ();
+  Channel::DoDispose ();
+}
+
+std::vector<Ptr<SimpleNetDevice> >
+SimpleChannel::GetNeighbours (Ptr<SimpleNetDevice> sender)
+{
+  NS_LOG_FUNCTION (this << sender);
+  if (!m_neighboursValid)
+    {
+      BuildNeighbours ();
+    }
+  return m_neighbours[sender];
+}
+
+void
+SimpleChannel::BuildNeighbours (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_addressIndex.clear ();
+  m_neighbours.clear ();
+  std::map<Ptr<SimpleNetDevice>, uint32_t> position;
+  for (uint32_t i = 0; i < m_devices.size (); i++)
+    {
+      m_addressIndex[Mac48Address::ConvertFrom (m_devices[i]->GetAddress ())] = m_devices[i];
+      position[m_devices[i]] = i;
+    }
+
+  // walk the line through the side addresses and collect everything
+  // within range; the hearing relation is made symmetric so that the
+  // gateways, which have no side addresses, still hear their sensors.
+  std::vector<std::set<uint32_t> > hears (m_devices.size ());
+  for (uint32_t i = 0; i < m_devices.size (); i++)
+    {
+      Ptr<SimpleNetDevice> left = m_devices[i];
+      Ptr<SimpleNetDevice> right = m_devices[i];
+      for (uint32_t hop = 0; hop < m_interferenceRange; hop++)
         {
-          if (find (m_blackListedDevices[tmp].begin (), m_blackListedDevices[tmp].end (), sender) !=
-              m_blackListedDevices[tmp].end () )
+          if (left != 0)
             {
-              continue;
+              std::map<Mac48Address, Ptr<SimpleNetDevice> >::const_iterator it = m_addressIndex.find (left->GetLaddress ());
+              left = (it != m_addressIndex.end ()) ? it->second : Ptr<SimpleNetDevice> (0);
+            }
+          if (right != 0)
+            {
+              std::map<Mac48Address, Ptr<SimpleNetDevice> >::const_iterator it = m_addressIndex.find (right->GetRaddress ());
+              right = (it != m_addressIndex.end ()) ? it->second : Ptr<SimpleNetDevice> (0);
+            }
+          if (left != 0 && left != m_devices[i])
+            {
+              hears[i].insert (position[left]);
+              hears[position[left]].insert (i);
+            }
+          if (right != 0 && right != m_devices[i])
+            {
+              hears[i].insert (position[right]);
+              hears[position[right]].insert (i);
             }
         }
-      Simulator::ScheduleWithContext (tmp->GetNode ()->GetId (), m_delay,
-                                      &SimpleNetDevice::ReceiveStart, tmp, p->Copy (), protocol, to, from);
     }
+  for (uint32_t i = 0; i < m_devices.size (); i++)
+    {
+      std::vector<Ptr<SimpleNetDevice> > &neighbours = m_neighbours[m_devices[i]];
+      for (std::set<uint32_t>::const_iterator j = hears[i].begin (); j != hears[i].end (); ++j)
+        {
+          neighbours.push_back (m_devices[*j]);
+        }
+    }
+  m_neighboursValid = true;
 }
 
 void
@@ -82,6 +316,7 @@ SimpleChannel::Add (Ptr<SimpleNetDevice> device)
 {
   NS_LOG_FUNCTION (this << device);
   m_devices.push_back (device);
+  m_neighboursValid = false;
 }
 
 uint32_t
@@ -23,6 +23,8 @@
 #include "ns3/channel.h"
 #include "ns3/nstime.h"
 #include "mac48-address.h"
+#include "lwsn-slot-scheduler.h"
+#include "lwsn-slot-timing.h"
 #include <vector>
 #include <map>
 
@@ -42,6 +44,13 @@ class Packet;
  * are using 48-bit MAC addresses.
  *
  * This channel is meant to be used by ns3::SimpleNetDevices.
+ *
+ * When the NeighbourDelivery attribute is set, a frame is only handed
+ * to the addressed device and to the devices within InterferenceRange
+ * hops of the sender along the line described by the devices' side
+ * addresses (see SimpleNetDevice::SetSideAddress).  In the LWSN model
+ * only those devices ever act on a frame, so this gives the same
+ * results as the default broadcast fan-out at a fraction of the cost.
  */
 class SimpleChannel : public Channel
 {
@@ -93,11 +102,84 @@ public:
    */
   virtual void UnBlackList (Ptr<SimpleNetDevice> from, Ptr<SimpleNetDevice> to);
 
+  /**
+   * Mark the neighbourhood index as stale.  Called by the attached
+   * devices whenever their own or their side addresses change.
+   */
+  void InvalidateNeighbours (void);
+
+  /**
+   * \param sender a device attached to the channel
+   * \returns the devices that hear frames sent by the sender when
+   * NeighbourDelivery is enabled, in attachment order
+   */
+  std::vector<Ptr<SimpleNetDevice> > GetNeighbours (Ptr<SimpleNetDevice> sender);
+
+  /**
+   * \returns the engine running the MAC timers of the attached devices
+   * when SlotScheduling is enabled, 0 otherwise
+   */
+  Ptr<LwsnSlotScheduler> GetSlotScheduler (void);
+
+  /**
+   * Announce to the slot scheduler, when SlotScheduling is enabled, an
+   * event other than a MAC action about to be scheduled, so that the
+   * MAC actions due at the same time run in the order they would as
+   * events of their own; see LwsnSlotScheduler::Split.
+   *
+   * \param delay delay from now of the event
+   */
+  void SplitSlot (Time delay);
+
+  /**
+   * \returns the slot timing shared by the attached devices
+   */
+  Ptr<LwsnSlotTiming> GetSlotTiming (void) const;
+
+  /**
+   * \returns the propagation delay of the frames, the Delay attribute
+   */
+  Time GetDelay (void) const;
+
+  /**
+   * The channel has no propagation loss: a frame is received with the
+   * transmit power of its sender.
+   *
+   * \param from address of the sending device
+   * \returns the power, in dBm, the frames of that device are received
+   * with, 0 if no attached device has that address
+   */
+  double GetRxPower (Mac48Address from);
+
   // inherited from ns3::Channel
   virtual uint32_t GetNDevices (void) const;
   virtual Ptr<NetDevice> GetDevice (uint32_t i) const;
 
+protected:
+  virtual void DoDispose (void);
+
 private:
+  /**
+   * Rebuild m_neighbours from the side addresses of the attached devices.
+   */
+  void BuildNeighbours (void);
+
+  /**
+   * \param from the sending device
+   * \param to the device that would receive the frame
+   * \returns true if to has blacklisted from
+   */
+  bool IsBlackListed (Ptr<SimpleNetDevice> from, Ptr<SimpleNetDevice> to);
+
+  bool m_slotScheduling; //!< run the device MAC timers from a slot scheduler
+  Ptr<LwsnSlotScheduler> m_slotScheduler; //!< the slot scheduler, created on first use
+  Ptr<LwsnSlotTiming> m_slotTiming; //!< slot timing of the attached devices
+  bool m_neighbourDelivery; //!< deliver only to neighbours and addressed devices
+  uint32_t m_interferenceRange; //!< number of hops a frame reaches on each side
+  bool m_neighboursValid; //!< true if m_neighbours matches the attached devices
+  std::map<Mac48Address, Ptr<SimpleNetDevice> > m_addressIndex; //!< attached devices by address
+  std::map<Ptr<SimpleNetDevice>, std::vector<Ptr<SimpleNetDevice> > > m_neighbours; //!< devices hearing each sender
+
   Time m_delay; //!< The assigned speed-of-light delay of the channel
   std::vector<Ptr<SimpleNetDevice> > m_devices; //!< devices connected by the channel
   std::map<Ptr<SimpleNetDevice>, std::vector<Ptr<SimpleNetDevice> > > m_blackListedDevices; //!< devices blocked on a device
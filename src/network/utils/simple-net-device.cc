@@ -26,11 +26,21 @@
 #include "ns3/error-model.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/boolean.h"
+#include "ns3/uinteger.h"
 #include "ns3/string.h"
+#include "ns3/enum.h"
+#include "ns3/double.h"
 #include "ns3/tag.h"
 #include "ns3/simulator.h"
+#include "ns3/abort.h"
 #include "ns3/drop-tail-queue.h"
+#include "lwsn-timestamp-tag.h"
+#include "lwsn-priority-queue.h"
+#include "lwsn-profiler.h"
+#include <algorithm>
 #include <cstdlib>
+#include <map>
+#include <vector>
 #include <ns3/object.h>
 
 namespace ns3 {
@@ -217,11 +227,103 @@ SimpleNetDevice::GetTypeId (void)
                      "by the device during reception",
                      MakeTraceSourceAccessor (&SimpleNetDevice::m_phyRxDropTrace),
                      "ns3::Packet::TracedCallback")
-    .AddAttribute ("temp_packet",
-                   "A queue to use as the transmit queue in the device.",
-                   StringValue ("ns3::DropTailQueue"),
-                   MakePointerAccessor (&SimpleNetDevice::temp_queue),
-                   MakePointerChecker<Queue> ())
+    .AddAttribute ("NetworkCoding",
+                   "XOR a forwarded packet with the next queued one travelling "
+                   "the other way and send both in one NETWORK_CODING frame.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SimpleNetDevice::m_networkCoding),
+                   MakeBooleanChecker ())
+    .AddAttribute ("ImplicitAck",
+                   "Skip the IACK of a forwarded packet: the previous hop "
+                   "overhears the forward instead, and only a copy of a "
+                   "packet already forwarded is acknowledged explicitly.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SimpleNetDevice::m_implicitAck),
+                   MakeBooleanChecker ())
+    .AddAttribute ("Aggregation",
+                   "Most queued readings a relay bundles into one AGGREGATE "
+                   "frame when they go the same way; the next hop takes them "
+                   "with one BLOCK_ACK.  1 sends every reading on its own.",
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SimpleNetDevice::m_aggregation),
+                   MakeUintegerChecker<uint16_t> (1, LwsnAggregate::MAX_FRAMES))
+    .AddAttribute ("Routing",
+                   "Where a sensor sends its own readings: both ways, toward "
+                   "the nearer gateway, or toward the gateway with the lowest "
+                   "distance weighted by the ACK loss seen on that side.  The "
+                   "directed modes need the gateway distances and fall back to "
+                   "both ways without them.",
+                   EnumValue (SimpleNetDevice::ROUTING_BOTH),
+                   MakeEnumAccessor (&SimpleNetDevice::m_routing),
+                   MakeEnumChecker (SimpleNetDevice::ROUTING_BOTH, "Both",
+                                    SimpleNetDevice::ROUTING_NEAREST, "Nearest",
+                                    SimpleNetDevice::ROUTING_BALANCED, "Balanced"))
+    .AddAttribute ("CongestionWeight",
+                   "With Balanced routing, the distance to a gateway is scaled "
+                   "by 1 + CongestionWeight * the ACK loss rate on its side.",
+                   DoubleValue (4.0),
+                   MakeDoubleAccessor (&SimpleNetDevice::m_congestionWeight),
+                   MakeDoubleChecker<double> (0.0))
+    .AddAttribute ("Round",
+                   "Backoff rounds a frame is retried before it is dropped.",
+                   UintegerValue (3),
+                   MakeUintegerAccessor (&SimpleNetDevice::round),
+                   MakeUintegerChecker<uint16_t> ())
+    .AddAttribute ("BackoffPolicy",
+                   "How long a frame waits before it is retransmitted, and when "
+                   "it is given up.",
+                   StringValue ("ns3::LwsnExponentialBackoffPolicy"),
+                   MakePointerAccessor (&SimpleNetDevice::SetBackoffPolicy,
+                                        &SimpleNetDevice::GetBackoffPolicy),
+                   MakePointerChecker<LwsnBackoffPolicy> ())
+    .AddAttribute ("CaptureModel",
+                   "How receptions overlapping at this device are resolved: "
+                   "all lost, the first one survives, or the strongest one "
+                   "survives if it exceeds every other by CaptureThreshold.",
+                   EnumValue (LwsnInterferenceTracker::CAPTURE_NONE),
+                   MakeEnumAccessor (&SimpleNetDevice::SetCaptureModel,
+                                     &SimpleNetDevice::GetCaptureModel),
+                   MakeEnumChecker (LwsnInterferenceTracker::CAPTURE_NONE, "None",
+                                    LwsnInterferenceTracker::CAPTURE_FIRST, "First",
+                                    LwsnInterferenceTracker::CAPTURE_STRONGEST, "Strongest"))
+    .AddAttribute ("CaptureThreshold",
+                   "Margin in dB a frame needs over every overlapping frame "
+                   "to be captured with the Strongest capture model.",
+                   DoubleValue (3.0),
+                   MakeDoubleAccessor (&SimpleNetDevice::SetCaptureThreshold,
+                                       &SimpleNetDevice::GetCaptureThreshold),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("TxPower",
+                   "Transmit power in dBm.  SimpleChannel has no loss model, "
+                   "so this is also the power the frames are received with.",
+                   DoubleValue (0.0),
+                   MakeDoubleAccessor (&SimpleNetDevice::m_txPower),
+                   MakeDoubleChecker<double> ())
+    .AddAttribute ("Radio",
+                   "The radio state machine and battery of the device.",
+                   StringValue ("ns3::LwsnRadioEnergy"),
+                   MakePointerAccessor (&SimpleNetDevice::m_radio),
+                   MakePointerChecker<LwsnRadioEnergy> ())
+    .AddAttribute ("MacTraceSize",
+                   "Number of MAC events kept in the binary event trace, 0 "
+                   "for none.  Events are only recorded in builds "
+                   "configured with --enable-lwsn-mac-trace.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SimpleNetDevice::SetMacTraceSize,
+                                         &SimpleNetDevice::GetMacTraceSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("RecordHops",
+                   "Append a LwsnHopTag to every frame sent, and have the "
+                   "gateways build per-hop delay and retry heatmaps from "
+                   "them (see GetHopStats).",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SimpleNetDevice::m_recordHops),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("StatsSnapshot",
+                     "Periodic snapshot of the MAC statistics, see "
+                     "SimpleNetDevice::ScheduleStatsSnapshots",
+                     MakeTraceSourceAccessor (&SimpleNetDevice::m_statsSnapshotTrace),
+                     "ns3::SimpleNetDevice::StatsSnapshotCallback")
   ;
   return tid;
 }
@@ -241,18 +343,23 @@ SimpleNetDevice::SimpleNetDevice ()
   send_flag = false;
   m_txPacket = 0;
   wait_ack = false;
-  receive_flag = false;
-  receive_flag_1 = false;
+  m_txPower = 0.0;
   last_node = false;
   ndid = 1;
-  m_count = 0;
-  m_retrans_count = 0;
-  m_collision = 0;
   temp_flag = true;
   txarray[0]=0;
   txarray[1]=0;
-  minTime = 0;
-  g_receive = 0;
+  m_gatewayHops = 0;
+  m_leftHops = 0;
+  m_rightHops = 0;
+  m_ackLoss[0] = 0.0;
+  m_ackLoss[1] = 0.0;
+  m_txRoute = ROUTE_BOTH;
+  m_failedOver = false;
+  m_recordHops = false;
+  m_aggregation = 1;
+  m_aggregateAcked = 0;
+  m_nDeferred = 0;
 }
 
 void
@@ -275,58 +382,175 @@ SimpleNetDevice::SetLastNode(bool x){
 	last_node = x;
 }
 
+bool
+SimpleNetDevice::IsLastNode (void) const
+{
+  return last_node;
+}
+
 void
-SimpleNetDevice::ReceiveStart(Ptr<Packet> packet, uint16_t protocol,
+SimpleNetDevice::ReceiveStart(Ptr<const Packet> packet, const LwsnHeader &header, uint16_t protocol,
                           Mac48Address to, Mac48Address from)
 {
-        if (to == m_address){ 
-	        if(receive_flag==true){
-		        receive_flag_1 = true;
-	        }else{
-		        receive_flag = true;
-                        Simulator::Schedule(Seconds(0.9),&SimpleNetDevice::ReceiveCheck,this,packet,protocol,to,from);
-	        }
+  LWSN_PROFILE_FRAME (RECEIVE_START, header.GetType ());
+        if (to == m_address || IsCodedForMe(header,to,from) || IsOverheardForward(header,to,from)
+            || IsOverheardAggregate(header,to,from) || IsAnnouncementForMe(header,to,from)){ 
+                Time rxDuration = GetSlotTiming()->GetAirtime(packet->GetSize());
+                double rxPower = 0.0;
+                if(m_interference.GetCaptureModel() == LwsnInterferenceTracker::CAPTURE_STRONGEST){
+                        rxPower = m_channel->GetRxPower(from);
+                }
+                int64_t now = Simulator::Now().GetTimeStep();
+                uint32_t reception = m_interference.Add(now, now + rxDuration.GetTimeStep(), rxPower);
+                if(m_radio != 0){
+                        m_radio->NotifyRxStart();
+                }
+                ScheduleMac(rxDuration,LwsnMacAction::RECEIVE_END,packet,protocol,to,from,header,reception);
 	}
 
 }
 
 void
-SimpleNetDevice::ReceiveCheck(Ptr<Packet> packet, uint16_t protocol,
-                          Mac48Address to, Mac48Address from)
+SimpleNetDevice::ReceiveEnd(Ptr<const Packet> packet, const LwsnHeader &header, uint16_t protocol,
+                          Mac48Address to, Mac48Address from, uint32_t reception)
 {
-	if(receive_flag_1==false){
-		Simulator::ScheduleNow(&SimpleNetDevice::Receive,this,packet,protocol,to,from);
+  LWSN_PROFILE_FRAME (RECEIVE_END, header.GetType ());
+	if(m_radio != 0){
+		m_radio->NotifyRxEnd();
+	}
+	bool survived = m_interference.End(reception);
+	m_backoffPolicy->NotifyReception(!survived);
+	if(survived){
+		LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::RX, m_sid, header.GetOsid(), header.GetDid(), header.GetType());
+		ReceiveFrame(packet,header,protocol,to,from);
 	}
   else{
-    m_collision++;
+    m_stats.NotifyCollision();
+    LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::COLLISION, m_sid, header.GetOsid(), header.GetDid(), 0);
     NS_LOG_FUNCTION("Sid : "<<m_sid<<"collison!");
   }
+}
+
+void
+SimpleNetDevice::SetCaptureModel (LwsnInterferenceTracker::CaptureModel model)
+{
+  m_interference.SetCaptureModel (model);
+}
+
+LwsnInterferenceTracker::CaptureModel
+SimpleNetDevice::GetCaptureModel (void) const
+{
+  return m_interference.GetCaptureModel ();
+}
+
+void
+SimpleNetDevice::SetCaptureThreshold (double threshold)
+{
+  m_interference.SetCaptureThreshold (threshold);
+}
+
+double
+SimpleNetDevice::GetCaptureThreshold (void) const
+{
+  return m_interference.GetCaptureThreshold ();
+}
+
+double
+SimpleNetDevice::GetTxPower (void) const
+{
+  return m_txPower;
+}
+
+void
+SimpleNetDevice::SetMacTraceSize (uint32_t size)
+{
+  m_macTrace.SetCapacity (size);
+}
+
+uint32_t
+SimpleNetDevice::GetMacTraceSize (void) const
+{
+  return m_macTrace.GetCapacity ();
+}
+
+const LwsnMacTrace &
+SimpleNetDevice::GetMacTrace (void) const
+{
+  return m_macTrace;
+}
+
+Ptr<LwsnSlotTiming>
+SimpleNetDevice::GetSlotTiming (void) const
+{
+  NS_ASSERT (m_channel != 0);
+  return m_channel->GetSlotTiming ();
+}
+
+const LwsnHopStats &
+SimpleNetDevice::GetHopStats (void) const
+{
+  return m_hopStats;
+}
+
+Ptr<LwsnRadioEnergy>
+SimpleNetDevice::GetRadio (void) const
+{
+  return m_radio;
+}
 
-	receive_flag = false;
-	receive_flag_1 = false;
+bool
+SimpleNetDevice::IsRadioAwake (void) const
+{
+  return m_radio == 0 || m_radio->IsAwake ();
 }
 
 void
 SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
                           Mac48Address to, Mac48Address from)
 {
+  LwsnHeader header;
+  packet->PeekHeader (header);
+  ReceiveFrame (packet, header, protocol, to, from);
+}
+
+void
+SimpleNetDevice::ReceiveFrame (Ptr<const Packet> packet, const LwsnHeader &receiveheader, uint16_t protocol,
+                               Mac48Address to, Mac48Address from)
+{
+  LWSN_PROFILE_FRAME (RECEIVE_FRAME, receiveheader.GetType ());
 //  NS_LOG_FUNCTION (this << packet << protocol << to << from);
   NetDevice::PacketType packetType;
 
-  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet) )
+  // the frame is shared by every receiver of the transmission: anything
+  // that mutates or keeps it below must work on its own copy.
+  if (m_receiveErrorModel && m_receiveErrorModel->IsCorrupt (packet->Copy ()) )
     {
       m_phyRxDropTrace (packet);
       return;
     }
-  if (to == m_address && send_flag==false)
+  if (IsOverheardForward (receiveheader, to, from))
+    {
+      // half duplex: a forward overheard while sending is lost
+      if (!send_flag)
+        {
+          OverhearForward (receiveheader, from);
+        }
+      return;
+    }
+  if (IsOverheardAggregate (receiveheader, to, from))
+    {
+      if (!send_flag)
+        {
+          OverhearAggregate (packet, from);
+        }
+      return;
+    }
+  bool addressed = to == m_address || IsCodedForMe (receiveheader, to, from)
+    || IsAnnouncementForMe (receiveheader, to, from);
+  if (addressed && send_flag==false)
     {
 
       packetType = NetDevice::PACKET_HOST;
-  	  
-  	  Ptr<Packet> p = packet->Copy ();
-
-      LwsnHeader receiveheader;
-      p ->PeekHeader(receiveheader);
 
       NS_LOG_FUNCTION ("Sid -> " << this->GetSid() << ": from -> " <<receiveheader.GetPsid() << "Packet Type :" << receiveheader.GetType());
       NS_LOG_FUNCTION("Sid->" <<m_sid << "Did -> "<<receiveheader.GetDid());
@@ -347,26 +571,32 @@ SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
             }
           }
           m_queue->Enqueue(Create<QueueItem> (packet));*/
-          g_receive++;
+          m_stats.NotifyGatewayReceive();
           int pre = m_queue->GetNPackets();
-          QueueCheck(packet);
+          QueueCheck(packet->Copy ());
           int post = m_queue->GetNPackets();
 
           if(pre<post){
 
-    	 	    //int time = Simulator::Now().GetSeconds();
-          	NS_LOG_UNCOND("---------------------------------------");
-          	NS_LOG_UNCOND("GateWay "<<m_gid<< " : Receive Sid ->"<<receiveheader.GetOsid() << " Did ->"<<receiveheader.GetDid());
-            NS_LOG_UNCOND("Start Time : "<<receiveheader.GetStartTime());
-            //NS_LOG_UNCOND("Total Time : "<<time-receiveheader.GetStartTime()+1);
-          	NS_LOG_UNCOND("Total Time : "<<receiveheader.GetStartTime2());
-          	NS_LOG_UNCOND("---------------------------------------");
+          	NS_LOG_INFO("GateWay "<<m_gid<< " : Receive Sid ->"<<receiveheader.GetOsid() << " Did ->"<<receiveheader.GetDid()
+          	            << " Start Time : "<<receiveheader.GetStartTime());
+          }
+        }
+        else if(receiveheader.GetType() == LwsnHeader::AGGREGATE){
+          // gateways do not acknowledge, bundled or not
+          std::vector<Ptr<Packet> > frames;
+          LwsnAggregate::Split(packet, frames);
+          for(uint32_t i = 0; i < frames.size(); i++){
+            m_stats.NotifyGatewayReceive();
+            QueueCheck(frames[i]);
           }
         }
  
       	return;
       }
 
+      // replies go out at the start of the next slot
+      Time reply = GetSlotTiming()->GetReplyDelay(packet->GetSize(),m_channel->GetDelay());
       if(receiveheader.GetType() == LwsnHeader::ORIGINAL_TRANSMISSION){    
 
       	if(wait_ack == false){
@@ -374,26 +604,29 @@ SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
       		
       		if(from == m_raddress){
 	      		//ack send
-	      		Simulator::Schedule(Seconds(0.1),&SimpleNetDevice::AckSend,this,packet,protocol,m_raddress);
+	      		if(NeedsExplicitAck(receiveheader)){
+	      			ScheduleMac(reply,LwsnMacAction::ACK_SEND,packet,protocol,m_raddress);
+	      		}
 		      	//forwarding
 		      	//NS_LOG_UNCOND("Sid ->"<<this->GetSid()<<"Forwading to "<<m_laddress);
-		      	Simulator::Schedule(Seconds(0.1),&SimpleNetDevice::Forwarding,this,packet,protocol,m_laddress); 		
+		      	ScheduleMac(reply,LwsnMacAction::FORWARDING,packet,protocol,m_laddress); 		
 	      	}
 
 	      	else if(from == m_laddress){
 	      		//ack send
-	      		Simulator::Schedule(Seconds(1.1),&SimpleNetDevice::AckSend,this,packet,protocol,m_laddress);
+	      		if(NeedsExplicitAck(receiveheader)){
+	      			ScheduleMac(reply + GetSlotTiming()->GetAckOffset(),LwsnMacAction::ACK_SEND,packet,protocol,m_laddress);
+	      		}
   	   			//forwarding
   	   			//NS_LOG_UNCOND("Sid ->"<<this->GetSid()<<"Forwading to "<<m_raddress);
-  	     		Simulator::Schedule(Seconds(1.1),&SimpleNetDevice::Forwarding,this,packet,protocol,m_raddress);
+  	     		ScheduleMac(reply + GetSlotTiming()->GetAckOffset(),LwsnMacAction::FORWARDING,packet,protocol,m_raddress);
 	      	}
 		}
 	 	else{
-			NS_LOG_UNCOND("Sid ->" << this->GetSid() << " not receive ");
+			NS_LOG_LOGIC("Sid ->" << this->GetSid() << " not receive ");
 			 if(m_txPacket != 0){
-	                Ptr<Packet> temp = m_txPacket -> Copy();
 	                LwsnHeader tempheader;
-	                temp -> PeekHeader(tempheader);
+	                m_txPacket->PeekHeader(tempheader);
 	                //temp->AddHeader(tempheader);
 
 	                if(tempheader.GetDid() != receiveheader.GetDid() || tempheader.GetOsid()!= receiveheader.GetOsid()){
@@ -408,16 +641,16 @@ SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
       			          //     	    m_queue->Enqueue (Create<QueueItem> (packet));
       			          //      	}
 
-                        QueueCheck(packet);
+                        QueueCheck(packet->Copy ());
       			         	}
       			           	else{
-      			               	m_queue->Enqueue (Create<QueueItem> (packet));
+      			               	EnqueuePacket (packet->Copy ());
       			            }       
       	              }
       	            }
 	            //m_txPacket == 0 
 	            else{
-                QueueCheck(packet);
+                QueueCheck(packet->Copy ());
 	              //   if(m_queue->GetNPackets () > 0){
 			       		   //  Ptr<Packet> queue_packet = m_queue->Peek()->GetPacket ();
 			            //   LwsnHeader tempheader_1;
@@ -438,65 +671,62 @@ SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
       	//본인이 원전송 혹은 재전송한 패킷을 나중에 다시 받을 수 있으니까 그때 큐를 확인하고 큐에서 제거 필요 
 	        
 	        //받아야하는 ACK가 있는 경우       
-       		if(wait_ack){
-       			Ptr<Packet> temp = m_txPacket->Copy();
-	            LwsnHeader tempheader;
-	            temp -> PeekHeader(tempheader);
-
-	            if(tempheader.GetDid() == receiveheader.GetDid() && tempheader.GetOsid() == receiveheader.GetOsid()){
-			         NS_LOG_UNCOND("Sid-> "<<this->GetSid()<<"  ACK RECEIVE");
+       		if(wait_ack && !m_aggregate.empty()){
+       			AckAggregated(receiveheader);
+       		}
+       		else if(wait_ack){
+       			LwsnHeader tempheader;
+	            m_txPacket->PeekHeader(tempheader);
+
+	            bool match = tempheader.GetDid() == receiveheader.GetDid() && tempheader.GetOsid() == receiveheader.GetOsid();
+	            if(tempheader.GetType() == LwsnHeader::NETWORK_CODING){
+	              // a coded frame is acked separately by the next hop of each
+	              // of its two packets
+	              match = (match && from == m_laddress)
+	                || (tempheader.GetDid2() == receiveheader.GetDid() && tempheader.GetOsid2() == receiveheader.GetOsid() && from == m_raddress);
+	            }
+	            if(match){
+			         NS_LOG_LOGIC("Sid-> "<<this->GetSid()<<"  ACK RECEIVE");
+			         LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::ACK, m_sid, receiveheader.GetOsid(), receiveheader.GetDid(), 0);
 			         AckReceive(true,from);
 			         //Simulator::ScheduleNow(&SimpleNetDevice::AckReceive,this,true,from);
 			         //Simulator::Schedule(Seconds(1.0),&SimpleNetDevice::SetSleep,this);
 			    }
     			    else{
-    			        NS_LOG_UNCOND("Sid ->" << this->GetSid() <<" not except packet,did"<<tempheader.GetDid());
+    			        NS_LOG_LOGIC("Sid ->" << this->GetSid() <<" not except packet,did"<<tempheader.GetDid());
     			    }
        		}
        		else{
-       			if(m_queue->GetNPackets() > 0){
-		        	Ptr<Packet> queue_packet = m_queue->Peek()->GetPacket ();
-				      LwsnHeader tempheader_1;
-				      queue_packet->PeekHeader(tempheader_1);
-	                //queue_packet->AddHeader(tempheader_1);
-  				    if(tempheader_1.GetDid()==receiveheader.GetDid() && tempheader_1.GetOsid()==receiveheader.GetOsid()){
-  				        queue_packet = m_queue->Dequeue()->GetPacket();
-  				    }
-		        }
+       			DequeueMatching(receiveheader.GetOsid(),receiveheader.GetDid());
        		}
 	  }
 
       else if(receiveheader.GetType() == LwsnHeader::FORWARDING){
       	if(wait_ack == false){
-      		if(m_queue->GetNPackets () > 0){
-		        Ptr<Packet> queue_packet = m_queue->Peek()->GetPacket ();
-		        LwsnHeader tempheader_1;
-		        queue_packet->PeekHeader(tempheader_1);
-
-		        if(tempheader_1.GetDid()==receiveheader.GetDid()&&tempheader_1.GetOsid()==receiveheader.GetOsid()){
-				      queue_packet = m_queue->Dequeue()->GetPacket();
-		        }   
-          }
+      		DequeueMatching(receiveheader.GetOsid(),receiveheader.GetDid());
       	send_flag = true;
 		    if(from == m_raddress){
 		  		//ack send
-		      Simulator::Schedule(Seconds(0.1),&SimpleNetDevice::AckSend,this,packet,protocol,m_raddress);
+		      if(NeedsExplicitAck(receiveheader)){
+		        ScheduleMac(reply,LwsnMacAction::ACK_SEND,packet,protocol,m_raddress);
+		      }
 		  		//forwarding
-		   		Simulator::Schedule(Seconds(0.1),&SimpleNetDevice::Forwarding,this,packet,protocol,m_laddress);
+		   		ScheduleMac(reply,LwsnMacAction::FORWARDING,packet,protocol,m_laddress);
 		    }
 		    else if(from == m_laddress){
 		      //ack send
-		      Simulator::Schedule(Seconds(0.1),&SimpleNetDevice::AckSend,this,packet,protocol,m_laddress);
+		      if(NeedsExplicitAck(receiveheader)){
+		        ScheduleMac(reply,LwsnMacAction::ACK_SEND,packet,protocol,m_laddress);
+		      }
 		      //forwarding
-		      Simulator::Schedule(Seconds(0.1),&SimpleNetDevice::Forwarding,this,packet,protocol,m_raddress);
+		      ScheduleMac(reply,LwsnMacAction::FORWARDING,packet,protocol,m_raddress);
 		    }
 		 }
 		 // ack를 기다리는 중일 경우, 패킷을 받는다?
 		 else{
 		    if(m_txPacket != 0){
-                Ptr<Packet> temp = m_txPacket -> Copy();
                 LwsnHeader tempheader;
-                temp -> PeekHeader(tempheader);
+                m_txPacket->PeekHeader(tempheader);
                 //temp->AddHeader(tempheader);
                 // 받아야 하는 패킷이면 큐에 넣는다 
                 if(tempheader.GetDid() != receiveheader.GetDid() || tempheader.GetOsid()!= receiveheader.GetOsid()){
@@ -510,10 +740,10 @@ SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
 		                // if(tempheader_1.GetDid()!=receiveheader.GetDid()||tempheader_1.GetOsid()!=receiveheader.GetOsid()){
                   //           m_queue->Enqueue (Create<QueueItem> (packet));                                
 		                //  }
-                      QueueCheck(packet);
+                      QueueCheck(packet->Copy ());
 		             }
     		            else{
-    		                m_queue->Enqueue (Create<QueueItem> (packet));
+    		                EnqueuePacket (packet->Copy ());
     		            }       
                 }
             }
@@ -530,16 +760,57 @@ SimpleNetDevice::Receive (Ptr<Packet> packet, uint16_t protocol,
     		    //     else{
     		    //         m_queue->Enqueue (Create<QueueItem> (packet));
     		    //     }
-              QueueCheck(packet);
+              QueueCheck(packet->Copy ());
             }           
 		}
     }
+      else if(receiveheader.GetType() == LwsnHeader::NETWORK_CODING){
+        LwsnHeader decodedheader;
+        Ptr<Packet> decoded = DecodeCodedFrame(packet, receiveheader, from, decodedheader);
+        if(decoded == 0){
+          m_stats.NotifyCodingFailure();
+          NS_LOG_FUNCTION("Sid -> " << m_sid << " cannot decode coded frame from " << receiveheader.GetPsid());
+          return;
+        }
+        m_stats.NotifyDecoded();
+        // the coded frame shows that the relay got the packet we hold,
+        // so it doubles as its IACK; the other half is a plain forward.
+        AckReceive(true,from);
+        if(wait_ack){
+          // still waiting, so the forward below only queues the other
+          // half: acknowledge it now, before the relay falls back to a
+          // plain retransmission.  Both neighbours answer the same
+          // frame, so a reply to the left waits the ack offset.
+          Time ack = from == m_raddress ? reply : reply + GetSlotTiming()->GetAckOffset();
+          ScheduleMac(ack,LwsnMacAction::ACK_SEND,decoded,protocol,from);
+        }
+        ReceiveFrame(decoded, decodedheader, protocol, m_address, from);
+        return;
+      }
+      else if(receiveheader.GetType() == LwsnHeader::AGGREGATE){
+        ReceiveAggregate(packet, protocol, from, reply);
+      }
+      else if(receiveheader.GetType() == LwsnHeader::BLOCK_ACK){
+        if(wait_ack && !m_aggregate.empty()){
+          LwsnHeader tempheader;
+          m_txPacket->PeekHeader(tempheader);
+          if(tempheader.GetOsid() == receiveheader.GetOsid() && tempheader.GetDid() == receiveheader.GetDid()){
+            NS_LOG_LOGIC("Sid-> "<<m_sid<<"  BLOCK ACK RECEIVE "<<receiveheader.GetE());
+            LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::ACK, m_sid, receiveheader.GetOsid(), receiveheader.GetDid(), 0);
+            m_aggregateAcked |= receiveheader.GetE();
+          }
+        }
+      }
+      else if(receiveheader.GetType() == LwsnHeader::G_ANC){
+        LearnGateway(packet, receiveheader, from);
+      }
       else {
-      		NS_LOG_UNCOND("UNDEFINE HEADER TYPE");
+      		NS_LOG_WARN("UNDEFINE HEADER TYPE");
       		}
    	 	
-	}else if(to == m_address && send_flag){
-    m_collision++;
+	}else if(addressed && send_flag){
+    m_stats.NotifyCollision();
+    LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::COLLISION, m_sid, receiveheader.GetOsid(), receiveheader.GetDid(), 1);
   }
 
 
@@ -584,11 +855,19 @@ SimpleNetDevice::GetQueue () const
   return m_queue;
 }
 
+int64_t
+SimpleNetDevice::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  return m_backoffPolicy->AssignStreams (stream);
+}
+
 void
 SimpleNetDevice::SetQueue (Ptr<Queue> q)
 {
   NS_LOG_FUNCTION (this << q);
   m_queue = q;
+  m_queueIndex.clear ();
 }
 
 void
@@ -621,6 +900,10 @@ SimpleNetDevice::SetAddress (Address address)
 {
   NS_LOG_FUNCTION (this << address);
   m_address = Mac48Address::ConvertFrom (address);
+  if (m_channel != 0)
+    {
+      m_channel->InvalidateNeighbours ();
+    }
 }
 Address 
 SimpleNetDevice::GetAddress (void) const
@@ -736,11 +1019,71 @@ SimpleNetDevice::GetGid()
 	return m_gid;
 }
 
+void
+SimpleNetDevice::SetGatewayHops (uint16_t hops)
+{
+  m_gatewayHops = hops;
+  if (m_backoffPolicy != 0)
+    {
+      m_backoffPolicy->SetGatewayHops (hops);
+    }
+}
+
+uint16_t
+SimpleNetDevice::GetGatewayHops (void) const
+{
+  return m_gatewayHops;
+}
+
+void
+SimpleNetDevice::SetBackoffPolicy (Ptr<LwsnBackoffPolicy> policy)
+{
+  NS_LOG_FUNCTION (this << policy);
+  m_backoffPolicy = policy;
+  m_backoffPolicy->SetGatewayHops (m_gatewayHops);
+}
+
+Ptr<LwsnBackoffPolicy>
+SimpleNetDevice::GetBackoffPolicy (void) const
+{
+  return m_backoffPolicy;
+}
+
+void
+SimpleNetDevice::SetGatewayDistances (uint16_t left, uint16_t right)
+{
+  m_leftHops = left;
+  m_rightHops = right;
+  if (left == 0 || right == 0)
+    {
+      SetGatewayHops (std::max (left, right));
+    }
+  else
+    {
+      SetGatewayHops (std::min (left, right));
+    }
+}
+
+uint16_t
+SimpleNetDevice::GetLeftGatewayHops (void) const
+{
+  return m_leftHops;
+}
+
+uint16_t
+SimpleNetDevice::GetRightGatewayHops (void) const
+{
+  return m_rightHops;
+}
+
 void
 SimpleNetDevice::SetSideAddress(Address laddress,Address raddress)
 {
 	m_laddress = Mac48Address::ConvertFrom(laddress);
 	m_raddress = Mac48Address::ConvertFrom(raddress);
+	if(m_channel != 0){
+		m_channel->InvalidateNeighbours();
+	}
 }
 
 Mac48Address
@@ -767,8 +1110,9 @@ SimpleNetDevice::AckReceive(bool x,Mac48Address from)
 	return ;
 }
 void
-SimpleNetDevice::AckSend(Ptr <Packet> p, uint16_t protocol,Mac48Address to)
+SimpleNetDevice::AckSend(Ptr<const Packet> p, uint16_t protocol,Mac48Address to)
 {
+  LWSN_PROFILE (ACK_SEND);
 	NS_LOG_FUNCTION("Sid -> " << this->GetSid() <<"AckSend  to " << to);
 	send_flag = true;
 
@@ -795,13 +1139,14 @@ SimpleNetDevice::AckSend(Ptr <Packet> p, uint16_t protocol,Mac48Address to)
 void
 SimpleNetDevice::WaitSend()
 {
+  LWSN_PROFILE (WAIT_SEND);
 	if(send_flag == false){
 		if(m_queue->GetNPackets()>0){
 
-		  NS_LOG_UNCOND("Sid"<<this->GetSid()<<" WaitSend Queue Packet #  "<<m_queue -> GetNPackets());
+		  NS_LOG_LOGIC("Sid"<<this->GetSid()<<" WaitSend Queue Packet #  "<<m_queue -> GetNPackets());
 
 			Ptr<Packet> packet;
-			packet = m_queue->Dequeue()->GetPacket();
+			packet = DequeuePacket();
 
 		  LwsnHeader tempheader;
 		  packet->RemoveHeader(tempheader);
@@ -833,142 +1178,407 @@ SimpleNetDevice::WaitSend()
 				OriginalTransmission(packet,0,true);
 			}
 			else if(sendheader.GetType()==LwsnHeader::FORWARDING){
+				if(m_networkCoding && TryCoding(packet, sendheader)){
+					return;
+				}
+				if(m_aggregation > 1 && TryAggregation(packet, sendheader)){
+					return;
+				}
+				bool ack = NeedsExplicitAck(sendheader);
 				if(sendheader.GetOsid() > this->GetSid()){
 					Forwarding(packet,0,m_laddress);
-					AckSend(packet,0,m_raddress);
+					if(ack){
+						AckSend(packet,0,m_raddress);
+					}
 				}
 				else{
 					Forwarding(packet,0,m_raddress);
-					AckSend(packet,0,m_laddress);
+					if(ack){
+						AckSend(packet,0,m_laddress);
+					}
 				}
 			}
 		}
 		else {
-			NS_LOG_UNCOND("SID" << m_sid << "  NO WAITING PACKET");
+			NS_LOG_LOGIC("SID" << m_sid << "  NO WAITING PACKET");
     }
 	}
 } 
 
-void
+bool
 SimpleNetDevice::QueueCheck(Ptr<Packet> p){
+  LWSN_PROFILE (QUEUE_CHECK);
   NS_LOG_FUNCTION("Sid =>"<<m_sid);
-  Ptr<Packet> receivepacket = p -> Copy();
   LwsnHeader receiveheader;
 
   if(m_sid == 0){
     p->RemoveHeader(receiveheader);
     int time = Simulator::Now().GetSeconds();
     receiveheader.SetStartTime2(time-receiveheader.GetStartTime()+1);
-    NS_LOG_UNCOND("time : "<<time);
-    NS_LOG_UNCOND("starttime2 : " <<receiveheader.GetStartTime2());
+    NS_LOG_LOGIC("time : "<<time<<" starttime2 : " <<receiveheader.GetStartTime2());
 
     p -> AddHeader(receiveheader);
-    Ptr<Packet> receivepacket = p -> Copy();
-
   }
-  receivepacket -> PeekHeader(receiveheader);
-  int t=0;
-  int n=0;
-    if(m_queue->GetNPackets () > 0){
-      while(m_queue->GetNPackets() > 0){
+  else{
+    p -> PeekHeader(receiveheader);
+  }
 
-        Ptr<Packet> queue_packet = m_queue->Dequeue()->GetPacket ();
-        LwsnHeader tempheader;
-        queue_packet->PeekHeader(tempheader);
+  // the index mirrors m_queue, so a hit here means the same frame is
+  // already waiting and the queue stays untouched.
+  if(IsQueued(receiveheader.GetOsid(), receiveheader.GetDid())){
+    NS_LOG_LOGIC("same packet Sid -> "<< receiveheader.GetOsid());
+    LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::DUP, m_sid, receiveheader.GetOsid(), receiveheader.GetDid(), 0);
+    return true;
+  }
+  if(!EnqueuePacket(p)){
+    return false;
+  }
+  if(m_sid == 0){
+    // StartTime2 is whole seconds only; the tag gives the exact latency
+    LwsnTimestampTag timestamp;
+    Time latency = Seconds(receiveheader.GetStartTime2());
+    bool tagged = p->PeekPacketTag(timestamp);
+    if(tagged){
+      latency = Simulator::Now() - timestamp.GetOrigin();
+    }
+    m_stats.NotifyDelivery(receiveheader.GetOsid(), latency);
+    if(m_recordHops && tagged){
+      m_hopStats.NotifyDelivery(p, receiveheader.GetOsid(), timestamp.GetOrigin());
+    }
+  }
+  return true;
+}
 
-        if(tempheader.GetDid()==receiveheader.GetDid() && tempheader.GetOsid()==receiveheader.GetOsid()){
-          n = 1;
-          temp_queue->Enqueue(Create<QueueItem> (queue_packet));
-          NS_LOG_UNCOND("------------same packet -----Sid -> "<< receiveheader.GetOsid()<<"-----");
-          break;       
-        }
-          else{          
-          temp_queue->Enqueue(Create<QueueItem> (queue_packet));
+void
+SimpleNetDevice::ScheduleMac (Time delay, LwsnMacAction::Type type, Ptr<const Packet> p, uint16_t protocol,
+                              Mac48Address to, Mac48Address from, const LwsnHeader &header,
+                              uint32_t reception)
+{
+  LwsnMacAction action;
+  action.device = this;
+  action.type = type;
+  action.packet = p;
+  action.header = header;
+  action.protocol = protocol;
+  action.to = to;
+  action.from = from;
+  action.reception = reception;
+  if (m_channel != 0)
+    {
+      Ptr<LwsnSlotScheduler> scheduler = m_channel->GetSlotScheduler ();
+      if (scheduler != 0 && scheduler->Schedule (delay, action))
+        {
+          return;
         }
-      }
-      if(n != 1){
-        m_queue -> Enqueue(Create<QueueItem> (p));
-      }
+    }
+  // counted, so that Save can tell that a simulator event is pending
+  m_nDeferred++;
+  LWSN_PROFILE_DEFER ();
+  Simulator::Schedule (delay, &SimpleNetDevice::RunDeferredAction, this, action);
+}
+
+void
+SimpleNetDevice::RunMacAction (const LwsnMacAction &action)
+{
+  switch (action.type)
+    {
+    case LwsnMacAction::RECEIVE_END:
+      ReceiveEnd (action.packet, action.header, action.protocol, action.to, action.from, action.reception);
+      break;
+    case LwsnMacAction::SET_SLEEP:
+      SetSleep ();
+      break;
+    case LwsnMacAction::ACK_CHECK:
+      AckCheck (ConstCast<Packet> (action.packet), action.protocol, action.to, action.from);
+      break;
+    case LwsnMacAction::ORIGINAL_ACK_CHECK:
+      OriginalAckCheck (ConstCast<Packet> (action.packet), action.protocol);
+      break;
+    case LwsnMacAction::WAIT_SEND:
+      WaitSend ();
+      break;
+    case LwsnMacAction::RESEND:
+      ReSend (ConstCast<Packet> (action.packet), action.protocol, action.to, action.from);
+      break;
+    case LwsnMacAction::REORIGINAL_SEND:
+      ReOriginalSend (ConstCast<Packet> (action.packet), action.protocol);
+      break;
+    case LwsnMacAction::ACK_SEND:
+      AckSend (action.packet, action.protocol, action.to);
+      break;
+    case LwsnMacAction::FORWARDING:
+      Forwarding (action.packet, action.protocol, action.to);
+      break;
+    case LwsnMacAction::CODED_ACK_CHECK:
+      CodedAckCheck (ConstCast<Packet> (action.packet), action.protocol);
+      break;
+    case LwsnMacAction::RECODED_SEND:
+      ReCodedSend (ConstCast<Packet> (action.packet), action.protocol);
+      break;
+    case LwsnMacAction::ANNOUNCE:
+      SendAnnouncement (action.packet);
+      break;
+    case LwsnMacAction::AGGREGATE_ACK_CHECK:
+      AggregateAckCheck (ConstCast<Packet> (action.packet), action.protocol, action.to);
+      break;
+    case LwsnMacAction::REAGGREGATE_SEND:
+      ReAggregateSend (ConstCast<Packet> (action.packet), action.protocol, action.to);
+      break;
+    case LwsnMacAction::BLOCK_ACK_SEND:
+      BlockAckSend (action.packet, action.protocol, action.to);
+      break;
+    case LwsnMacAction::FORWARD_QUEUED:
+      ForwardQueued ();
+      break;
+    }
+}
+
+void
+SimpleNetDevice::RunDeferredAction (const LwsnMacAction &action)
+{
+  LWSN_PROFILE_DEFERRED_RUN ();
+  m_nDeferred--;
+  RunMacAction (action);
+}
 
-      if(m_queue->GetNPackets()==0){
-        t = temp_queue ->GetNPackets();
-        for(int i =0; i < t; i++){        
+void
+SimpleNetDevice::Save (std::ostream &os, LwsnPacketTable &packets)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (m_nDeferred > 0, "SimpleNetDevice::Save: " << m_nDeferred
+                   << " MAC actions of sensor " << m_sid << " are simulator events; "
+                   "save a line run with SlotScheduling, between two slots");
+  Ptr<LwsnPriorityQueue> priorityQueue = DynamicCast<LwsnPriorityQueue> (m_queue);
+  Ptr<DropTailQueue> dropTailQueue = DynamicCast<DropTailQueue> (m_queue);
+  NS_ABORT_MSG_IF (priorityQueue == 0 && dropTailQueue == 0, "SimpleNetDevice::Save: cannot read a TxQueue of type "
+                   << m_queue->GetInstanceTypeId ().GetName ());
+  LwsnCheckpoint::Write (os, rack_flag);
+  LwsnCheckpoint::Write (os, lack_flag);
+  LwsnCheckpoint::Write (os, send_flag);
+  LwsnCheckpoint::Write (os, wait_ack);
+  LwsnCheckpoint::Write (os, temp_flag);
+  LwsnCheckpoint::Write (os, last_node);
+  LwsnCheckpoint::Write (os, k);
+  LwsnCheckpoint::Write (os, txarray[0]);
+  LwsnCheckpoint::Write (os, txarray[1]);
+  LwsnCheckpoint::Write (os, ndid);
+  LwsnCheckpoint::Write (os, m_leftHops);
+  LwsnCheckpoint::Write (os, m_rightHops);
+  LwsnCheckpoint::Write (os, m_gatewayHops);
+  LwsnCheckpoint::Write (os, m_ackLoss[0]);
+  LwsnCheckpoint::Write (os, m_ackLoss[1]);
+  LwsnCheckpoint::Write<uint32_t> (os, m_txRoute);
+  LwsnCheckpoint::Write (os, m_failedOver);
+  LwsnCheckpoint::Write (os, m_aggregateAcked);
+  packets.Write (os, m_txPacket);
+  packets.Write (os, m_codedLeft);
+  packets.Write (os, m_codedRight);
+  LwsnCheckpoint::Write<uint32_t> (os, m_aggregate.size ());
+  for (std::vector<Ptr<Packet> >::const_iterator i = m_aggregate.begin (); i != m_aggregate.end (); ++i)
+    {
+      packets.Write (os, *i);
+    }
 
-          Ptr<Packet> temp = temp_queue->Dequeue()->GetPacket ();
+  // read in place, so that the queue, its counters and its traces are
+  // left as they are
+  LwsnCheckpoint::Write<uint32_t> (os, m_queue->GetNPackets ());
+  for (uint32_t i = 0; i < m_queue->GetNPackets (); i++)
+    {
+      Ptr<const QueueItem> item = priorityQueue != 0 ? priorityQueue->GetItem (i) : dropTailQueue->GetItem (i);
+      packets.Write (os, item->GetPacket ());
+    }
+  if (priorityQueue != 0)
+    {
+      priorityQueue->Serialize (os);
+    }
 
-          m_queue->Enqueue(Create<QueueItem> (temp));
+  m_interference.Serialize (os);
+  m_stats.Serialize (os);
+  LwsnCheckpoint::Write (os, m_radio != 0);
+  if (m_radio != 0)
+    {
+      m_radio->Serialize (os);
+    }
+  m_backoffPolicy->Serialize (os);
+}
 
+bool
+SimpleNetDevice::Restore (std::istream &is, LwsnPacketTable &packets)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t route;
+  uint32_t count;
+  if (!LwsnCheckpoint::Read (is, rack_flag)
+      || !LwsnCheckpoint::Read (is, lack_flag)
+      || !LwsnCheckpoint::Read (is, send_flag)
+      || !LwsnCheckpoint::Read (is, wait_ack)
+      || !LwsnCheckpoint::Read (is, temp_flag)
+      || !LwsnCheckpoint::Read (is, last_node)
+      || !LwsnCheckpoint::Read (is, k)
+      || !LwsnCheckpoint::Read (is, txarray[0])
+      || !LwsnCheckpoint::Read (is, txarray[1])
+      || !LwsnCheckpoint::Read (is, ndid)
+      || !LwsnCheckpoint::Read (is, m_leftHops)
+      || !LwsnCheckpoint::Read (is, m_rightHops)
+      || !LwsnCheckpoint::Read (is, m_gatewayHops)
+      || !LwsnCheckpoint::Read (is, m_ackLoss[0])
+      || !LwsnCheckpoint::Read (is, m_ackLoss[1])
+      || !LwsnCheckpoint::Read (is, route) || route > ROUTE_RIGHT
+      || !LwsnCheckpoint::Read (is, m_failedOver)
+      || !LwsnCheckpoint::Read (is, m_aggregateAcked)
+      || !packets.Read (is, m_txPacket)
+      || !packets.Read (is, m_codedLeft)
+      || !packets.Read (is, m_codedRight)
+      || !LwsnCheckpoint::Read (is, count))
+    {
+      return false;
+    }
+  m_txRoute = static_cast<RouteSide> (route);
+  SetGatewayHops (m_gatewayHops);
+  m_aggregate.resize (count);
+  for (std::vector<Ptr<Packet> >::iterator i = m_aggregate.begin (); i != m_aggregate.end (); ++i)
+    {
+      if (!packets.Read (is, *i) || *i == 0)
+        {
+          return false;
         }
-      }else{
-        t = m_queue->GetNPackets();
-        for(int i = 0; i < t;i++){                  
-          Ptr<Packet> temp = m_queue->Dequeue()->GetPacket ();
+    }
 
-          temp_queue->Enqueue(Create<QueueItem> (temp));
+  while (DequeuePacket () != 0)
+    {
+    }
+  m_queueIndex.clear ();
+  if (!LwsnCheckpoint::Read (is, count))
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < count; i++)
+    {
+      Ptr<Packet> p;
+      if (!packets.Read (is, p) || p == 0 || !EnqueuePacket (p))
+        {
+          return false;
         }
-        t = temp_queue->GetNPackets();
-        for(int i = 0; i < t; i++){
+    }
+  Ptr<LwsnPriorityQueue> priorityQueue = DynamicCast<LwsnPriorityQueue> (m_queue);
+  if (priorityQueue != 0 && !priorityQueue->Deserialize (is))
+    {
+      return false;
+    }
+
+  // after the queue, which updates the statistics
+  bool radio;
+  if (!m_interference.Deserialize (is)
+      || !m_stats.Deserialize (is)
+      || !LwsnCheckpoint::Read (is, radio) || radio != (m_radio != 0)
+      || (radio && !m_radio->Deserialize (is)))
+    {
+      return false;
+    }
+  return m_backoffPolicy->Deserialize (is);
+}
 
-          Ptr<Packet> temp1 = temp_queue->Dequeue()->GetPacket ();
+uint32_t
+SimpleNetDevice::GetQueueKey (uint16_t osid, uint16_t did)
+{
+  return (static_cast<uint32_t> (osid) << 16) | did;
+}
 
-          m_queue->Enqueue(Create<QueueItem> (temp1));
-        }
-      }
-    }else{
-      m_queue->Enqueue(Create<QueueItem>(p));
+bool
+SimpleNetDevice::IsQueued (uint16_t osid, uint16_t did) const
+{
+  return m_queueIndex.find (GetQueueKey (osid, did)) != m_queueIndex.end ();
+}
+
+bool
+SimpleNetDevice::EnqueuePacket (Ptr<Packet> p)
+{
+  LwsnHeader header;
+  p->PeekHeader (header);
+  Ptr<LwsnPriorityQueue> priorityQueue = DynamicCast<LwsnPriorityQueue> (m_queue);
+  if (priorityQueue)
+    {
+      priorityQueue->SetPosition (m_sid, m_leftHops, m_rightHops);
+    }
+  if (!m_queue->Enqueue (Create<QueueItem> (p)))
+    {
+      LWSN_MAC_TRACE (m_macTrace, LwsnMacTrace::DROP, m_sid, header.GetOsid (), header.GetDid (), 0);
+      return false;
     }
+  m_queueIndex[GetQueueKey (header.GetOsid (), header.GetDid ())]++;
+  m_stats.NotifyQueueLength (m_queue->GetNPackets ());
+  return true;
 }
 
-int 
-SimpleNetDevice::RandTime()
+Ptr<Packet>
+SimpleNetDevice::DequeuePacket (void)
 {
-  
-	if(k>round)
-	{
-		k = 1;
-		return 100;
-	}
-	/*else if (k==0)
-	{
-		if(rand()%2 == 0)
-		{	
-			k++;
-			NS_LOG_UNCOND("Sid : "<<m_sid<<" rand time -> 0");
-			return 0;
-		}
-		else
-		{	
-			k++;
-			NS_LOG_UNCOND("Sid : "<<m_sid<<"rand time -> 1");
-			return 1;
-		}
-    // maxTime = 1;
-
-    // r->SetAttribute ("Min", DoubleValue (minTime));
-    // r->SetAttribute ("Max", DoubleValue (maxTime));
-    // int x = r->GetInteger();
-    // NS_LOG_UNCOND("Sid : " << m_sid <<"rand time -> " << x );
-    // return x;
-
-	}*/
-	else
-	{
-    Ptr<UniformRandomVariable> r = CreateObject<UniformRandomVariable> ();
-    maxTime = pow(2,k++)-1;
-    r->SetAttribute ("Min", DoubleValue (minTime));
-    r->SetAttribute ("Max", DoubleValue (maxTime));
-    int x = r->GetInteger();
-    // int x = (int)(rand()%(int)(pow(2,k)-1));
-		NS_LOG_UNCOND("Sid : " << m_sid <<"rand time -> " << x );
-		return x;
-	}
+  Ptr<QueueItem> item = m_queue->Dequeue ();
+  if (item == 0)
+    {
+      return 0;
+    }
+  Ptr<Packet> p = item->GetPacket ();
+  LwsnHeader header;
+  p->PeekHeader (header);
+  sgi::hash_map<uint32_t, uint32_t>::iterator it = m_queueIndex.find (GetQueueKey (header.GetOsid (), header.GetDid ()));
+  if (it != m_queueIndex.end () && --it->second == 0)
+    {
+      m_queueIndex.erase (it);
+    }
+  return p;
+}
 
+bool
+SimpleNetDevice::DequeueMatching (uint16_t osid, uint16_t did)
+{
+  if (m_queue->GetNPackets () == 0)
+    {
+      return false;
+    }
+  Ptr<LwsnPriorityQueue> priorityQueue = DynamicCast<LwsnPriorityQueue> (m_queue);
+  if (priorityQueue)
+    {
+      if (!priorityQueue->MoveToFront (osid, did))
+        {
+          return false;
+        }
+    }
+  else
+    {
+      LwsnHeader header;
+      m_queue->Peek ()->GetPacket ()->PeekHeader (header);
+      if (header.GetOsid () != osid || header.GetDid () != did)
+        {
+          return false;
+        }
+    }
+  DequeuePacket ();
+  return true;
+}
 
+LwsnBackoff
+SimpleNetDevice::RandTime()
+{
+  LwsnBackoff backoff = m_backoffPolicy->Next(k, round);
+  if(backoff.giveUp){
+    k = 1;
+    m_stats.NotifyGiveUp();
+    LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::DROP, m_sid, 0, 0, 1);
+    return backoff;
+  }
+  k++;
+  m_stats.NotifyBackoff(backoff.slots);
+  LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::BACKOFF, m_sid, 0, 0, backoff.slots);
+  NS_LOG_LOGIC("Sid : " << m_sid <<"rand time -> " << backoff.slots);
+  return backoff;
 }
 void
 SimpleNetDevice::AckCheck(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from){
+  LWSN_PROFILE (ACK_CHECK);
 
 	if (to == m_raddress){
+	    NoteAckOutcome(true, rack_flag);
 	    if(rack_flag){
 				NS_LOG_FUNCTION("Sid -> " << this->GetSid() <<"AckReceive Success to " << to);
 	    	rack_flag = false;
@@ -983,8 +1593,11 @@ SimpleNetDevice::AckCheck(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac
 	        //random time
           LwsnHeader temp;
           p->PeekHeader(temp);
-	        uint16_t delay = RandTime();
-	        if(delay == 100) {
+	        LwsnBackoff delay = RandTime();
+	        if(delay.giveUp && temp.GetOsid() == m_sid && Failover(p,protocol,true)) {
+	        	return;
+	        }
+	        if(delay.giveUp) {
 	        	NS_LOG_FUNCTION("---------------------------");
 	        	NS_LOG_FUNCTION("Sid -> " << this->GetSid()<< "Send Fail to" << to << "  Osid :" << temp.GetOsid());
 	        	NS_LOG_FUNCTION("---------------------------");
@@ -996,11 +1609,12 @@ SimpleNetDevice::AckCheck(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac
 	        }
 	        else{
             NS_LOG_FUNCTION("Sid->" <<m_sid << "Did -> "<<temp.GetDid());
-	        	Simulator::Schedule(Seconds(delay),&SimpleNetDevice::ReSend,this,p,protocol,to,from);
+	        	ScheduleMac(GetSlotTiming()->GetSlots(delay.slots),LwsnMacAction::RESEND,p,protocol,to,from);
 	    	}
 	    }
 	}
 	else if (to == m_laddress){
+		NoteAckOutcome(false, lack_flag);
 		if(lack_flag){
 			NS_LOG_FUNCTION("Sid -> " << this->GetSid() <<"AckReceive Success to " << to);
 			lack_flag = false;
@@ -1012,10 +1626,13 @@ SimpleNetDevice::AckCheck(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac
 	    else{
 	        //retransmission
 	        //random time
-	        uint16_t delay = RandTime();
+	        LwsnBackoff delay = RandTime();
           LwsnHeader temp;
           p->PeekHeader(temp);
-	        if(delay == 100) {
+	        if(delay.giveUp && temp.GetOsid() == m_sid && Failover(p,protocol,false)) {
+	        	return;
+	        }
+	        if(delay.giveUp) {
 	        	NS_LOG_FUNCTION("---------------------------");	        	
 	        	NS_LOG_FUNCTION("Sid -> " << this->GetSid()<< "Send Fail to" << to<< "  Osid :" << temp.GetOsid());
 	        	NS_LOG_FUNCTION("---------------------------");
@@ -1029,7 +1646,7 @@ SimpleNetDevice::AckCheck(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac
         		LwsnHeader temp;
             p->PeekHeader(temp);
             NS_LOG_FUNCTION("Sid->" <<m_sid << "Did -> "<<temp.GetDid());
-	        	Simulator::Schedule(Seconds(delay),&SimpleNetDevice::ReSend,this,p,protocol,to,from);
+	        	ScheduleMac(GetSlotTiming()->GetSlots(delay.slots),LwsnMacAction::RESEND,p,protocol,to,from);
 	        }
 	    }
 	}
@@ -1037,11 +1654,12 @@ SimpleNetDevice::AckCheck(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac
 
 void
 SimpleNetDevice::OriginalAckCheck(Ptr<Packet> p, uint16_t protocol){
+  LWSN_PROFILE (ORIGINAL_ACK_CHECK);
 
   NS_LOG_FUNCTION("sid -> " << m_sid);
 	if((rack_flag==false)&&(lack_flag==false)){
-		uint16_t delay = RandTime();
-	    if(delay == 100) {
+		LwsnBackoff delay = RandTime();
+	    if(delay.giveUp) {
 	        NS_LOG_FUNCTION("---------------------------");
 	     	NS_LOG_FUNCTION("Sid -> " << this->GetSid()<< "Send Fail to" << m_raddress <<", "<<m_laddress);
 	        NS_LOG_FUNCTION("---------------------------");
@@ -1053,10 +1671,13 @@ SimpleNetDevice::OriginalAckCheck(Ptr<Packet> p, uint16_t protocol){
             lack_flag = false;
 	    }
 	    else{
-	    	Simulator::Schedule(Seconds(delay),&SimpleNetDevice::ReOriginalSend,this,p,0);
+	    	ScheduleMac(GetSlotTiming()->GetSlots(delay.slots),LwsnMacAction::REORIGINAL_SEND,p,0);
 	    }
 	}
 	else if((rack_flag)&&(lack_flag)){
+		 if(m_txRoute != ROUTE_BOTH){
+		   NoteAckOutcome(m_txRoute == ROUTE_RIGHT, true);
+		 }
 		 NS_LOG_FUNCTION("Sid -> " << this->GetSid() <<"AckReceive Success to " << m_raddress);
 		 NS_LOG_FUNCTION("Sid -> " << this->GetSid() <<"AckReceive Success to " << m_laddress);
 		 rack_flag = false;	lack_flag = false;
@@ -1071,8 +1692,12 @@ SimpleNetDevice::OriginalAckCheck(Ptr<Packet> p, uint16_t protocol){
 		if(!rack_flag){
 			//retransmission
 		    //random time
-		    uint16_t delay = RandTime();
-		    if(delay == 100) {
+		    NoteAckOutcome(true, false);
+		    LwsnBackoff delay = RandTime();
+		    if(delay.giveUp && Failover(p,protocol,true)) {
+		      return;
+		    }
+		    if(delay.giveUp) {
 	        	NS_LOG_FUNCTION("---------------------------");
 		     	  NS_LOG_FUNCTION("Sid -> " << this->GetSid()<< "Send Fail to" << m_raddress<< "  Osid :" << temp.GetOsid());
 	        	NS_LOG_FUNCTION("---------------------------");
@@ -1082,14 +1707,18 @@ SimpleNetDevice::OriginalAckCheck(Ptr<Packet> p, uint16_t protocol){
 	         	WaitSend();
 		   	}
         else{
-		   	  Simulator::Schedule(Seconds(delay),&SimpleNetDevice::ReSend,this,p,protocol,m_raddress,m_address);
+		   	  ScheduleMac(GetSlotTiming()->GetSlots(delay.slots),LwsnMacAction::RESEND,p,protocol,m_raddress,m_address);
         }
 		}
 		else if(!lack_flag){
 		    //retransmission
 		    //random time
-		    uint16_t delay = RandTime();
-	        if(delay == 100) {
+		    NoteAckOutcome(false, false);
+		    LwsnBackoff delay = RandTime();
+	        if(delay.giveUp && Failover(p,protocol,false)) {
+	          return;
+	        }
+	        if(delay.giveUp) {
 	        	NS_LOG_FUNCTION("---------------------------");
 	        	NS_LOG_FUNCTION("Sid -> " << this->GetSid()<< "Send Fail to" << m_laddress<< "  Osid :" << temp.GetOsid());
 	        	NS_LOG_FUNCTION("---------------------------");
@@ -1099,7 +1728,7 @@ SimpleNetDevice::OriginalAckCheck(Ptr<Packet> p, uint16_t protocol){
 	         	WaitSend();
 	        }
 	        else{
-	        	Simulator::Schedule(Seconds(delay),&SimpleNetDevice::ReSend,this,p,protocol,m_laddress,m_address);
+	        	ScheduleMac(GetSlotTiming()->GetSlots(delay.slots),LwsnMacAction::RESEND,p,protocol,m_laddress,m_address);
 	        }
 		    
 		}
@@ -1113,21 +1742,20 @@ SimpleNetDevice::OriginalWaitAck(Ptr<Packet> p, uint16_t protocol, Mac48Address
 
 	wait_ack = true;
 
-	if(last_node){
-		if(m_sid == 1){
-			lack_flag = true;
-			rack_flag = false;
-		}
-		else{
-			rack_flag = true;
-			lack_flag = false;
-		}
+	if(m_txRoute != ROUTE_BOTH){
+		// only the side sent to answers, and a gateway never does
+		rack_flag = m_txRoute == ROUTE_LEFT || m_rightHops == 1;
+		lack_flag = m_txRoute == ROUTE_RIGHT || m_leftHops == 1;
+	}
+	else if(last_node){
+		lack_flag = IsGatewayNeighbour(m_laddress);
+		rack_flag = IsGatewayNeighbour(m_raddress);
 	}
 	else{
 		lack_flag = false;
 		rack_flag = false;
 	}
-	Simulator::Schedule(Seconds(3.0),&SimpleNetDevice::OriginalAckCheck,this,p,protocol);
+	ScheduleMac(GetSlotTiming()->GetSlots(3),LwsnMacAction::ORIGINAL_ACK_CHECK,p,protocol);
 }
 
 void
@@ -1136,41 +1764,21 @@ SimpleNetDevice::WaitAck(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac4
   NS_LOG_FUNCTION("Sid ->"<<m_sid);
 	lack_flag = false;
 	rack_flag = false;
-	if(!last_node){
+	if(!last_node || !IsGatewayNeighbour(to)){
 		wait_ack = true;
-		Simulator::Schedule(Seconds(2.0),&SimpleNetDevice::AckCheck,this,p,protocol,to,from);
+		ScheduleMac(GetSlotTiming()->GetSlots(2),LwsnMacAction::ACK_CHECK,p,protocol,to,from);
 	}	
   else{
-     if(m_sid == 1){
-       if(to == m_raddress){
-        wait_ack = true;
-        Simulator::Schedule(Seconds(2.0),&SimpleNetDevice::AckCheck,this,p,protocol,to,from);
-       }
-       else{
-        NS_LOG_FUNCTION("Sid : "<<m_sid<<"Wait Send");
-        m_txPacket=0;
-        Simulator::Schedule(Seconds(2.0),&SimpleNetDevice::WaitSend,this);
-       }
-
-    }
-     else{
-      if(to==m_laddress){
-        wait_ack = true;
-        Simulator::Schedule(Seconds(2.0),&SimpleNetDevice::AckCheck,this,p,protocol,to,from);
-      }
-      else{
-        NS_LOG_FUNCTION("Sid : "<<m_sid<<"Wait Send");
-        m_txPacket=0;
-        Simulator::Schedule(Seconds(2.0),&SimpleNetDevice::WaitSend,this);
-
-      }
-     }
+    NS_LOG_FUNCTION("Sid : "<<m_sid<<"Wait Send");
+    m_txPacket=0;
+    ScheduleMac(GetSlotTiming()->GetSlots(2),LwsnMacAction::WAIT_SEND);
   }
 	
 }
 void
 SimpleNetDevice::ReSend(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from)
 {
+  LWSN_PROFILE (RESEND);
 
   if(to == m_raddress){
     if(rack_flag){
@@ -1194,7 +1802,7 @@ SimpleNetDevice::ReSend(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48
   }
 
 	send_flag = true;
-  m_retrans_count++;
+  m_stats.NotifyRetransmission();
 
 
 	NS_LOG_FUNCTION ("Sid -> "<<this->GetSid() << "  retransmission to :"<< to);
@@ -1227,8 +1835,15 @@ SimpleNetDevice::ReSend(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48
 
 	repacket->AddHeader(retransheader);
   ackpacket->AddHeader(ackheader);
+  if(m_recordHops){
+    LwsnHopTag::Append(repacket, m_sid);
+  }
 
-    if(to == m_laddress){
+    if(m_implicitAck){
+      // the previous hop overhears the retransmitted forward
+      m_stats.NotifyIackSaved();
+    }
+    else if(to == m_laddress){
       ChannelSend(ackpacket,protocol,m_raddress,from);      
     }
     else{
@@ -1261,7 +1876,7 @@ SimpleNetDevice::ReOriginalSend(Ptr<Packet> p, uint16_t protocol){
   }
 
 	send_flag = true;
-  m_retrans_count++;
+  m_stats.NotifyRetransmission();
 	
 	NS_LOG_FUNCTION ("Sid -> "<<this->GetSid() << "  retransmission OriginalTransmission ");    
 
@@ -1279,6 +1894,9 @@ SimpleNetDevice::ReOriginalSend(Ptr<Packet> p, uint16_t protocol){
 	retransheader.SetStartTime(tempheader.GetStartTime()); 
 
 	repacket->AddHeader(retransheader);
+  if(m_recordHops){
+    LwsnHopTag::Append(repacket, m_sid);
+  }
 
 	Mac48Address r_to = Mac48Address::ConvertFrom (m_raddress);
 	Mac48Address from = Mac48Address::ConvertFrom (m_address);
@@ -1290,16 +1908,606 @@ SimpleNetDevice::ReOriginalSend(Ptr<Packet> p, uint16_t protocol){
 	OriginalWaitAck(repacket,0,from);
 }
 
+bool
+SimpleNetDevice::IsCodedForMe(const LwsnHeader &header, Mac48Address to, Mac48Address from) const
+{
+  return to.IsBroadcast() && header.GetType() == LwsnHeader::NETWORK_CODING
+    && (from == m_laddress || from == m_raddress);
+}
+
+SimpleNetDevice::RouteSide
+SimpleNetDevice::ChooseRoute(const LwsnHeader &header) const
+{
+  if(m_routing == ROUTING_BOTH || m_leftHops == 0 || m_rightHops == 0){
+    return ROUTE_BOTH;
+  }
+  double left = m_leftHops;
+  double right = m_rightHops;
+  if(m_routing == ROUTING_BALANCED){
+    left *= 1 + m_congestionWeight * m_ackLoss[0];
+    right *= 1 + m_congestionWeight * m_ackLoss[1];
+  }
+  if(left != right){
+    return left < right ? ROUTE_LEFT : ROUTE_RIGHT;
+  }
+  // halfway between the gateways: alternate readings
+  return header.GetDid() % 2 ? ROUTE_RIGHT : ROUTE_LEFT;
+}
+
+bool
+SimpleNetDevice::Failover(Ptr<Packet> p, uint16_t protocol, bool failedRight)
+{
+  if(m_txRoute == ROUTE_BOTH || m_failedOver){
+    return false;
+  }
+  NS_LOG_LOGIC("Sid -> " << m_sid << " fails over to the " << (failedRight ? "left" : "right"));
+  m_failedOver = true;
+  m_txRoute = failedRight ? ROUTE_LEFT : ROUTE_RIGHT;
+  m_stats.NotifyFailover();
+  if(failedRight){
+    lack_flag = false;
+    ReSend(p,protocol,m_laddress,m_address);
+  }
+  else{
+    rack_flag = false;
+    ReSend(p,protocol,m_raddress,m_address);
+  }
+  return true;
+}
+
+void
+SimpleNetDevice::NoteAckOutcome(bool right, bool acked)
+{
+  // the same 1/8 gain as the smoothed RTT of TCP
+  double &loss = m_ackLoss[right ? 1 : 0];
+  loss += ((acked ? 0.0 : 1.0) - loss) / 8;
+}
+
+bool
+SimpleNetDevice::IsAnnouncementForMe(const LwsnHeader &header, Mac48Address to, Mac48Address from) const
+{
+  return m_sid != 0 && to.IsBroadcast() && header.GetType() == LwsnHeader::G_ANC
+    && (from == m_laddress || from == m_raddress);
+}
+
+void
+SimpleNetDevice::AnnounceGateway()
+{
+  NS_ASSERT_MSG(m_sid == 0, "only gateways announce themselves");
+  LwsnHeader header;
+  header.SetType(LwsnHeader::G_ANC);
+  header.SetOsid(m_gid);
+  header.SetPsid(0);
+  header.SetE(0);
+  header.SetR(0);
+  header.SetDid(0);
+  header.SetStartTime(Simulator::Now().GetSeconds());
+  Ptr<Packet> p = Create<Packet>();
+  p->AddHeader(header);
+  SendAnnouncement(p);
+}
+
+void
+SimpleNetDevice::LearnGateway(Ptr<const Packet> packet, const LwsnHeader &header, Mac48Address from)
+{
+  uint16_t hops = header.GetDid() + 1;
+  uint16_t &known = from == m_raddress ? m_rightHops : m_leftHops;
+  if(known != 0 && known <= hops){
+    return;
+  }
+  NS_LOG_LOGIC("Sid -> " << m_sid << " gateway " << header.GetOsid() << " is " << hops << " hops to the "
+               << (from == m_raddress ? "right" : "left"));
+  known = hops;
+  SetGatewayDistances(m_leftHops, m_rightHops);
+
+  Ptr<Packet> p = packet->Copy();
+  LwsnHeader relayheader;
+  p->RemoveHeader(relayheader);
+  relayheader.SetPsid(m_sid);
+  relayheader.SetDid(hops);
+  p->AddHeader(relayheader);
+  ScheduleMac(GetSlotTiming()->GetReplyDelay(packet->GetSize(),m_channel->GetDelay()),LwsnMacAction::ANNOUNCE,p);
+}
+
+void
+SimpleNetDevice::SendAnnouncement(Ptr<const Packet> p)
+{
+  send_flag = true;
+  ChannelSend(p->Copy(),0,Mac48Address::GetBroadcast(),m_address);
+}
+
+bool
+SimpleNetDevice::IsGatewayNeighbour(Mac48Address to) const
+{
+  if(m_leftHops == 0 && m_rightHops == 0){
+    return last_node && to == (m_sid == 1 ? m_laddress : m_raddress);
+  }
+  return (to == m_laddress && m_leftHops == 1) || (to == m_raddress && m_rightHops == 1);
+}
+
+bool
+SimpleNetDevice::IsOverheardForward(const LwsnHeader &header, Mac48Address to, Mac48Address from) const
+{
+  return m_implicitAck && m_sid != 0 && to != m_address
+    && header.GetType() == LwsnHeader::FORWARDING
+    && (from == m_laddress || from == m_raddress);
+}
+
+void
+SimpleNetDevice::OverhearForward(const LwsnHeader &header, Mac48Address from)
+{
+  if(wait_ack && !m_aggregate.empty()){
+    if(AckAggregated(header)){
+      m_stats.NotifyImplicitAck();
+    }
+    return;
+  }
+  if(wait_ack){
+    LwsnHeader tempheader;
+    m_txPacket->PeekHeader(tempheader);
+    if(tempheader.GetType() != LwsnHeader::NETWORK_CODING
+       && tempheader.GetOsid() == header.GetOsid() && tempheader.GetDid() == header.GetDid()){
+      NS_LOG_LOGIC("Sid-> "<<m_sid<<"  forward overheard, Osid "<<header.GetOsid()<<" Did "<<header.GetDid());
+      m_stats.NotifyImplicitAck();
+      LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::ACK, m_sid, header.GetOsid(), header.GetDid(), 1);
+      AckReceive(true,from);
+    }
+    return;
+  }
+  // same as a late IACK: the packet went on, do not send it again
+  DequeueMatching(header.GetOsid(), header.GetDid());
+}
+
+bool
+SimpleNetDevice::NeedsExplicitAck(const LwsnHeader &header)
+{
+  if(!m_implicitAck){
+    return true;
+  }
+  if(txarray[0] == header.GetOsid() && txarray[1] == header.GetDid()){
+    return true;
+  }
+  m_stats.NotifyIackSaved();
+  return false;
+}
+
+Ptr<Packet>
+SimpleNetDevice::XorPayload(Ptr<const Packet> a, Ptr<const Packet> b)
+{
+  LwsnHeader header;
+  Ptr<Packet> pa = a->Copy();
+  pa->RemoveHeader(header);
+  Ptr<Packet> pb = b->Copy();
+  pb->RemoveHeader(header);
+
+  uint32_t size = pa->GetSize();
+  NS_ASSERT(pb->GetSize() == size);
+  if(size == 0){
+    return Create<Packet>();
+  }
+  std::vector<uint8_t> x(size);
+  std::vector<uint8_t> y(size);
+  pa->CopyData(&x[0], size);
+  pb->CopyData(&y[0], size);
+  for(uint32_t i = 0; i < size; i++){
+    x[i] ^= y[i];
+  }
+  return Create<Packet>(&x[0], size);
+}
+
+bool
+SimpleNetDevice::TryCoding(Ptr<Packet> packet, const LwsnHeader &sendheader)
+{
+  // the gateways cannot decode, so the last nodes never code
+  if(last_node || m_queue->GetNPackets() == 0){
+    return false;
+  }
+  Ptr<const Packet> next = m_queue->Peek()->GetPacket();
+  LwsnHeader nextheader;
+  next->PeekHeader(nextheader);
+  if(nextheader.GetOsid() == m_sid
+     || (nextheader.GetType() != LwsnHeader::ORIGINAL_TRANSMISSION && nextheader.GetType() != LwsnHeader::FORWARDING)){
+    return false;
+  }
+  bool leftbound = sendheader.GetOsid() > m_sid;
+  if((nextheader.GetOsid() > m_sid) == leftbound || next->GetSize() != packet->GetSize()){
+    return false;
+  }
+
+  Ptr<Packet> other = DequeuePacket();
+  other->RemoveHeader(nextheader);
+  LwsnHeader otherheader;
+  otherheader.SetOsid(nextheader.GetOsid());
+  otherheader.SetPsid(m_sid);
+  otherheader.SetE(0);
+  otherheader.SetR(0);
+  otherheader.SetDid(nextheader.GetDid());
+  otherheader.SetType(LwsnHeader::FORWARDING);
+  otherheader.SetStartTime(nextheader.GetStartTime());
+  other->AddHeader(otherheader);
+
+  m_codedLeft = leftbound ? packet : other;
+  m_codedRight = leftbound ? other : packet;
+  LwsnHeader lheader;
+  LwsnHeader rheader;
+  m_codedLeft->PeekHeader(lheader);
+  m_codedRight->PeekHeader(rheader);
+
+  LwsnHeader codedheader;
+  codedheader.SetType(LwsnHeader::NETWORK_CODING);
+  codedheader.SetPsid(m_sid);
+  codedheader.SetE(0);
+  codedheader.SetR(0);
+  codedheader.SetOsid(lheader.GetOsid());
+  codedheader.SetDid(lheader.GetDid());
+  codedheader.SetStartTime(lheader.GetStartTime());
+  codedheader.SetOsid2(rheader.GetOsid());
+  codedheader.SetDid2(rheader.GetDid());
+  codedheader.SetStartTime2(rheader.GetStartTime());
+
+  Ptr<Packet> coded = XorPayload(m_codedLeft, m_codedRight);
+  coded->AddHeader(codedheader);
+  LwsnTimestampTag ltag;
+  LwsnTimestampTag rtag;
+  m_codedLeft->PeekPacketTag(ltag);
+  m_codedRight->PeekPacketTag(rtag);
+  LwsnTimestampTag codedtag(ltag.GetOrigin());
+  codedtag.SetOrigin2(rtag.GetOrigin());
+  coded->AddPacketTag(codedtag);
+  NS_LOG_FUNCTION("Sid -> " << m_sid << " coding Osid " << lheader.GetOsid() << " with Osid " << rheader.GetOsid());
+  m_stats.NotifyCoded();
+  CodedSend(coded, 0);
+  return true;
+}
+
+Ptr<Packet>
+SimpleNetDevice::DecodeCodedFrame(Ptr<const Packet> packet, const LwsnHeader &header, Mac48Address from, LwsnHeader &decodedheader)
+{
+  if(m_txPacket == 0){
+    return 0;
+  }
+  LwsnHeader held;
+  m_txPacket->PeekHeader(held);
+
+  // the left-bound packet of a coded frame came from the relay's right
+  // neighbour and the right-bound one from its left neighbour.
+  bool holdLeftbound = from == m_laddress && held.GetOsid() == header.GetOsid() && held.GetDid() == header.GetDid();
+  bool holdRightbound = from == m_raddress && held.GetOsid() == header.GetOsid2() && held.GetDid() == header.GetDid2();
+  if(!holdLeftbound && !holdRightbound){
+    return 0;
+  }
+  if(m_txPacket->GetSize() != packet->GetSize()){
+    return 0;
+  }
+
+  decodedheader.SetType(LwsnHeader::FORWARDING);
+  decodedheader.SetPsid(header.GetPsid());
+  decodedheader.SetE(0);
+  decodedheader.SetR(0);
+  if(holdLeftbound){
+    decodedheader.SetOsid(header.GetOsid2());
+    decodedheader.SetDid(header.GetDid2());
+    decodedheader.SetStartTime(header.GetStartTime2());
+  }
+  else{
+    decodedheader.SetOsid(header.GetOsid());
+    decodedheader.SetDid(header.GetDid());
+    decodedheader.SetStartTime(header.GetStartTime());
+  }
+
+  Ptr<Packet> decoded = XorPayload(packet, m_txPacket);
+  decoded->AddHeader(decodedheader);
+  LwsnTimestampTag codedtag;
+  if(packet->PeekPacketTag(codedtag)){
+    LwsnTimestampTag timestamp(holdLeftbound ? codedtag.GetOrigin2() : codedtag.GetOrigin());
+    decoded->AddPacketTag(timestamp);
+  }
+  return decoded;
+}
+
+void
+SimpleNetDevice::CodedSend(Ptr<Packet> coded, uint16_t protocol)
+{
+  LWSN_PROFILE_FRAME (CODED_SEND, LwsnHeader::NETWORK_CODING);
+  send_flag = true;
+  wait_ack = true;
+  lack_flag = false;
+  rack_flag = false;
+  m_txPacket = coded->Copy();
+
+  ChannelSend(coded,protocol,Mac48Address::GetBroadcast(),m_address);
+  ScheduleMac(GetSlotTiming()->GetSlots(2),LwsnMacAction::CODED_ACK_CHECK,coded,protocol);
+}
+
+void
+SimpleNetDevice::CodedAckCheck(Ptr<Packet> p, uint16_t protocol)
+{
+  NS_LOG_FUNCTION("Sid -> " << m_sid);
+  if(lack_flag && rack_flag){
+    lack_flag = false;
+    rack_flag = false;
+    wait_ack = false;
+    k = 1;
+    m_txPacket = 0;
+    m_codedLeft = 0;
+    m_codedRight = 0;
+    WaitSend();
+    return;
+  }
+
+  LwsnBackoff delay = RandTime();
+  if(delay.giveUp){
+    NS_LOG_FUNCTION("Sid -> " << m_sid << " coded Send Fail");
+    lack_flag = false;
+    rack_flag = false;
+    wait_ack = false;
+    k = 1;
+    m_txPacket = 0;
+    m_codedLeft = 0;
+    m_codedRight = 0;
+    WaitSend();
+    return;
+  }
+
+  if(!lack_flag && !rack_flag){
+    ScheduleMac(GetSlotTiming()->GetSlots(delay.slots),LwsnMacAction::RECODED_SEND,p,protocol);
+  }
+  else if(!lack_flag){
+    // only one half got through: fall back to a plain retransmission
+    m_txPacket = m_codedLeft->Copy();
+    ScheduleMac(GetSlotTiming()->GetSlots(delay.slots),LwsnMacAction::RESEND,m_codedLeft,protocol,m_laddress,m_address);
+  }
+  else{
+    m_txPacket = m_codedRight->Copy();
+    ScheduleMac(GetSlotTiming()->GetSlots(delay.slots),LwsnMacAction::RESEND,m_codedRight,protocol,m_raddress,m_address);
+  }
+}
+
+void
+SimpleNetDevice::ReCodedSend(Ptr<Packet> p, uint16_t protocol)
+{
+  if(lack_flag && rack_flag){
+    CodedAckCheck(p, protocol);
+    return;
+  }
+  else if(lack_flag){
+    m_txPacket = m_codedRight->Copy();
+    ReSend(m_codedRight,protocol,m_raddress,m_address);
+    return;
+  }
+  else if(rack_flag){
+    m_txPacket = m_codedLeft->Copy();
+    ReSend(m_codedLeft,protocol,m_laddress,m_address);
+    return;
+  }
+  m_stats.NotifyRetransmission();
+  CodedSend(p, protocol);
+}
+
+bool
+SimpleNetDevice::TryAggregation(Ptr<Packet> packet, const LwsnHeader &sendheader)
+{
+  bool leftbound = sendheader.GetOsid() > m_sid;
+  uint32_t max = std::min<uint32_t>(m_mtu, GetSlotTiming()->GetMaxBytes());
+  uint32_t size = LwsnHeader().GetSerializedSize() + LwsnAggregate::GetFrameSize(packet);
+  std::vector<Ptr<Packet> > frames;
+  frames.push_back(packet);
+  while(frames.size() < m_aggregation && m_queue->GetNPackets() > 0){
+    Ptr<const Packet> next = m_queue->Peek()->GetPacket();
+    LwsnHeader nextheader;
+    next->PeekHeader(nextheader);
+    if(nextheader.GetOsid() == m_sid || (nextheader.GetOsid() > m_sid) != leftbound
+       || (nextheader.GetType() != LwsnHeader::ORIGINAL_TRANSMISSION && nextheader.GetType() != LwsnHeader::FORWARDING)
+       || size + LwsnAggregate::GetFrameSize(next) > max){
+      break;
+    }
+    size += LwsnAggregate::GetFrameSize(next);
+
+    Ptr<Packet> other = DequeuePacket();
+    other->RemoveHeader(nextheader);
+    LwsnHeader otherheader;
+    otherheader.SetOsid(nextheader.GetOsid());
+    otherheader.SetPsid(m_sid);
+    otherheader.SetE(0);
+    otherheader.SetR(0);
+    otherheader.SetDid(nextheader.GetDid());
+    otherheader.SetType(LwsnHeader::FORWARDING);
+    otherheader.SetStartTime(nextheader.GetStartTime());
+    other->AddHeader(otherheader);
+    frames.push_back(other);
+  }
+  if(frames.size() < 2){
+    return false;
+  }
+
+  m_aggregate = frames;
+  if(m_recordHops){
+    for(uint32_t i = 0; i < m_aggregate.size(); i++){
+      LwsnHopTag::Append(m_aggregate[i], m_sid);
+    }
+  }
+  NS_LOG_FUNCTION("Sid -> " << m_sid << " bundling " << m_aggregate.size() << " readings, " << size << " bytes");
+  AggregateSend(LwsnAggregate::Build(m_aggregate, m_sid, false), 0, leftbound ? m_laddress : m_raddress);
+  return true;
+}
+
+void
+SimpleNetDevice::AggregateSend(Ptr<Packet> aggregate, uint16_t protocol, Mac48Address to)
+{
+  LWSN_PROFILE_FRAME (AGGREGATE_SEND, LwsnHeader::AGGREGATE);
+  send_flag = true;
+  lack_flag = false;
+  rack_flag = false;
+  m_aggregateAcked = 0;
+  m_stats.NotifyAggregate(m_aggregate.size());
+  m_txPacket = aggregate->Copy();
+
+  ChannelSend(aggregate,protocol,to,m_address);
+  if(last_node && IsGatewayNeighbour(to)){
+    // the gateway does not acknowledge
+    m_txPacket = 0;
+    m_aggregate.clear();
+    ScheduleMac(GetSlotTiming()->GetSlots(2),LwsnMacAction::WAIT_SEND);
+    return;
+  }
+  // the BLOCK_ACK comes AckOffset after the forward of the readings
+  wait_ack = true;
+  ScheduleMac(GetSlotTiming()->GetSlots(2) + GetSlotTiming()->GetAckOffset(),LwsnMacAction::AGGREGATE_ACK_CHECK,aggregate,protocol,to);
+}
+
+void
+SimpleNetDevice::AggregateAckCheck(Ptr<Packet> p, uint16_t protocol, Mac48Address to)
+{
+  NS_LOG_FUNCTION("Sid -> " << m_sid << " acked " << m_aggregateAcked);
+  uint16_t all = (1 << m_aggregate.size()) - 1;
+  NoteAckOutcome(to == m_raddress, m_aggregateAcked != 0);
+  if((m_aggregateAcked & all) == all){
+    wait_ack = false;
+    k = 1;
+    m_txPacket = 0;
+    m_aggregate.clear();
+    WaitSend();
+    return;
+  }
+
+  LwsnBackoff delay = RandTime();
+  if(delay.giveUp){
+    NS_LOG_FUNCTION("Sid -> " << m_sid << " aggregate Send Fail to " << to);
+    wait_ack = false;
+    k = 1;
+    m_txPacket = 0;
+    m_aggregate.clear();
+    WaitSend();
+    return;
+  }
+  ScheduleMac(GetSlotTiming()->GetSlots(delay.slots),LwsnMacAction::REAGGREGATE_SEND,p,protocol,to);
+}
+
+void
+SimpleNetDevice::ReAggregateSend(Ptr<Packet> p, uint16_t protocol, Mac48Address to)
+{
+  // readings acknowledged during the backoff are left out
+  std::vector<Ptr<Packet> > left;
+  for(uint32_t i = 0; i < m_aggregate.size(); i++){
+    if(!(m_aggregateAcked & (1 << i))){
+      left.push_back(m_aggregate[i]);
+    }
+  }
+  if(left.empty()){
+    AggregateAckCheck(p, protocol, to);
+    return;
+  }
+  if(left.size() == 1){
+    // fall back to a plain retransmission
+    m_aggregate.clear();
+    m_txPacket = left[0]->Copy();
+    ReSend(left[0],protocol,to,m_address);
+    return;
+  }
+  m_aggregate = left;
+  if(m_recordHops){
+    for(uint32_t i = 0; i < m_aggregate.size(); i++){
+      LwsnHopTag::Append(m_aggregate[i], m_sid);
+    }
+  }
+  m_stats.NotifyRetransmission();
+  AggregateSend(LwsnAggregate::Build(m_aggregate, m_sid, true), protocol, to);
+}
+
+void
+SimpleNetDevice::ReceiveAggregate(Ptr<const Packet> packet, uint16_t protocol, Mac48Address from, Time reply)
+{
+  LWSN_PROFILE (RECEIVE_AGGREGATE);
+  std::vector<Ptr<Packet> > frames;
+  if(!LwsnAggregate::Split(packet, frames)){
+    return;
+  }
+  // a reading already queued counts as taken
+  uint16_t bitmap = 0;
+  for(uint32_t i = 0; i < frames.size(); i++){
+    if(QueueCheck(frames[i])){
+      bitmap |= 1 << i;
+    }
+  }
+  if(wait_ack){
+    // like a single frame received now, the readings wait unacknowledged
+    // for the frame in flight; the sender learns from our forward of them
+    return;
+  }
+  // the readings go on at once, as a single forward would, and the
+  // sender may already take that for their ACK; the BLOCK_ACK follows
+  // AckOffset later so that it does not reach the sender on top of it.
+  LwsnHeader header;
+  packet->PeekHeader(header);
+  send_flag = true;
+  ScheduleMac(reply,LwsnMacAction::FORWARD_QUEUED);
+  ScheduleMac(reply + GetSlotTiming()->GetAckOffset(),LwsnMacAction::BLOCK_ACK_SEND,
+              LwsnAggregate::BuildBlockAck(header, m_sid, bitmap),protocol,from);
+}
+
+void
+SimpleNetDevice::BlockAckSend(Ptr<const Packet> blockack, uint16_t protocol, Mac48Address to)
+{
+  NS_LOG_FUNCTION("Sid -> " << m_sid << " BlockAckSend to " << to);
+  send_flag = true;
+  ChannelSend(blockack->Copy(),protocol,to,m_address);
+}
+
+void
+SimpleNetDevice::ForwardQueued()
+{
+  if(wait_ack){
+    return;
+  }
+  send_flag = false;
+  WaitSend();
+}
+
+bool
+SimpleNetDevice::IsOverheardAggregate(const LwsnHeader &header, Mac48Address to, Mac48Address from) const
+{
+  return m_sid != 0 && to != m_address
+    && header.GetType() == LwsnHeader::AGGREGATE
+    && (from == m_laddress || from == m_raddress);
+}
+
+void
+SimpleNetDevice::OverhearAggregate(Ptr<const Packet> packet, Mac48Address from)
+{
+  std::vector<Ptr<Packet> > frames;
+  LwsnAggregate::Split(packet, frames);
+  for(uint32_t i = 0; i < frames.size(); i++){
+    LwsnHeader header;
+    frames[i]->PeekHeader(header);
+    OverhearForward(header, from);
+  }
+}
+
+bool
+SimpleNetDevice::AckAggregated(const LwsnHeader &header)
+{
+  for(uint32_t i = 0; i < m_aggregate.size(); i++){
+    LwsnHeader bundled;
+    m_aggregate[i]->PeekHeader(bundled);
+    if(bundled.GetOsid() == header.GetOsid() && bundled.GetDid() == header.GetDid()){
+      m_aggregateAcked |= 1 << i;
+      return true;
+    }
+  }
+  return false;
+}
+
 void
 SimpleNetDevice::SetSleep()
 {
   if(m_queue -> GetNPackets() >0)
-  	NS_LOG_UNCOND("Sid ->"<<this->GetSid()<<"ONE MORE PACKET IS WAITING");
+  	NS_LOG_LOGIC("Sid ->"<<this->GetSid()<<"ONE MORE PACKET IS WAITING");
   send_flag = false;
 }
 
 bool
 SimpleNetDevice::OriginalTransmission(Ptr<Packet> p, uint16_t protocolNumber,bool header){
+  LWSN_PROFILE_FRAME (ORIGINAL_TRANSMISSION, LwsnHeader::ORIGINAL_TRANSMISSION);
 
 
 	  Ptr<Packet> packet = p->Copy ();
@@ -1318,6 +2526,8 @@ SimpleNetDevice::OriginalTransmission(Ptr<Packet> p, uint16_t protocolNumber,boo
       sendheader.SetType(LwsnHeader::ORIGINAL_TRANSMISSION);
       sendheader.SetStartTime(time);
       sendheader.SetDid(ndid++);
+      LwsnTimestampTag timestamp(Simulator::Now());
+      packet->ReplacePacketTag(timestamp);
     }
     else{   
       LwsnHeader header;
@@ -1332,21 +2542,21 @@ SimpleNetDevice::OriginalTransmission(Ptr<Packet> p, uint16_t protocolNumber,boo
     }
 	  packet->AddHeader(sendheader);
 
-	  NS_LOG_UNCOND("Sid"<<this->GetSid()<<" OriginalTransmission Queue Packet #  "<<m_queue -> GetNPackets());
+	  NS_LOG_LOGIC("Sid"<<this->GetSid()<<" OriginalTransmission Queue Packet #  "<<m_queue -> GetNPackets());
 
 	  if( send_flag == true || wait_ack ){
 
-	  	m_queue->Enqueue (Create<QueueItem> (packet));
+	  	EnqueuePacket (packet);
 
-	  	NS_LOG_UNCOND("Sid"<<this->GetSid()<<"  SendFrom Function m_queue packet # 1 more");
+	  	NS_LOG_LOGIC("Sid"<<this->GetSid()<<"  SendFrom Function m_queue packet # 1 more");
 	  	
 	  	return 0;
 	  }
 
-	  if (m_queue->Enqueue (Create<QueueItem> (packet)))
+	  if (EnqueuePacket (packet))
 	    {
 	       send_flag = true;
-	       p = m_queue->Dequeue()->GetPacket ();
+	       p = DequeuePacket ();
 
 	       Time txTime = Time (0);
 	       if (m_bps > DataRate (0))
@@ -1356,8 +2566,17 @@ SimpleNetDevice::OriginalTransmission(Ptr<Packet> p, uint16_t protocolNumber,boo
 	       m_txPacket = p -> Copy();
          txarray[0] = m_sid;
          txarray[1] = ndid-1;
-         ChannelSend(p,protocolNumber,r_to,from);
-         ChannelSend(p,protocolNumber,l_to,from);
+         m_txRoute = ChooseRoute(sendheader);
+         m_failedOver = false;
+         if(m_recordHops){
+           LwsnHopTag::Append(p, m_sid);
+         }
+         if(m_txRoute != ROUTE_LEFT){
+           ChannelSend(p,protocolNumber,r_to,from);
+         }
+         if(m_txRoute != ROUTE_RIGHT){
+           ChannelSend(p,protocolNumber,l_to,from);
+         }
 
          OriginalWaitAck(p,0,from);
 	        
@@ -1369,8 +2588,9 @@ SimpleNetDevice::OriginalTransmission(Ptr<Packet> p, uint16_t protocolNumber,boo
 }
 
 void
-SimpleNetDevice::Forwarding(Ptr<Packet> p,uint16_t protocol, Mac48Address to)
+SimpleNetDevice::Forwarding(Ptr<const Packet> p,uint16_t protocol, Mac48Address to)
 {
+  LWSN_PROFILE_FRAME (FORWARDING, LwsnHeader::FORWARDING);
 	send_flag = true;
 
   Ptr<Packet> packet = p->Copy();
@@ -1379,7 +2599,7 @@ SimpleNetDevice::Forwarding(Ptr<Packet> p,uint16_t protocol, Mac48Address to)
 
   if(txarray[0] == receiveheader.GetOsid()){
     if(txarray[1] == receiveheader.GetDid()){
-      m_retrans_count++;
+      m_stats.NotifyRetransmission();
       AckSend(p,0,to);
       return;
     }
@@ -1400,6 +2620,9 @@ SimpleNetDevice::Forwarding(Ptr<Packet> p,uint16_t protocol, Mac48Address to)
   txarray[1] = forwardingheader.GetDid();
 
 	packet->AddHeader(forwardingheader);
+  if(m_recordHops){
+    LwsnHopTag::Append(packet, m_sid);
+  }
 
 	Mac48Address from = Mac48Address::ConvertFrom (this->GetAddress());
 
@@ -1414,35 +2637,104 @@ SimpleNetDevice::Forwarding(Ptr<Packet> p,uint16_t protocol, Mac48Address to)
 void
 SimpleNetDevice::ChannelSend(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from)
 {
-	NS_LOG_FUNCTION ("Sid ->"<<this->GetSid() <<"ChannelSend to  " << to << "m_count : "<<m_count<<"  m_retrans_count"<<m_retrans_count);
-  m_count++;
+	NS_LOG_FUNCTION ("Sid ->"<<this->GetSid() <<"ChannelSend to  " << to);
+  if(m_radio != 0 && m_radio->IsDepleted()){
+    // the battery is out: the MAC still times out, but nothing is sent
+    ScheduleMac(GetSlotTiming()->GetSlot(),LwsnMacAction::SET_SLEEP);
+    return;
+  }
+  if(m_radio != 0){
+    m_radio->NotifyTx(GetSlotTiming()->GetAirtime(p->GetSize()));
+  }
+  LwsnHeader header;
+  p->PeekHeader(header);
+  m_stats.NotifyTx(header.GetType());
+  LWSN_MAC_TRACE(m_macTrace, LwsnMacTrace::TX, m_sid, header.GetOsid(), header.GetDid(), header.GetType());
 	m_channel -> Send(p,protocol,to,from,this);
-	Simulator::Schedule(Seconds(1.0),&SimpleNetDevice::SetSleep,this);
+	ScheduleMac(GetSlotTiming()->GetSlot(),LwsnMacAction::SET_SLEEP);
 }
 
 void
 SimpleNetDevice::Print()
 {
+  // m_queue of a gateway holds the delivered readings; they are
+  // reported from the stats block so that Print leaves it untouched.
   if(m_sid == 0){
     NS_LOG_UNCOND("============================");
-    NS_LOG_UNCOND("GateWay : "<<m_gid<<"receive packet : " << m_queue->GetNPackets());
-    int j = m_queue->GetNPackets();
-    for(int i =0; i<j;i++){
-      LwsnHeader temp;
-      Ptr<Packet> p = m_queue->Dequeue()->GetPacket();
-
-      p->RemoveHeader(temp);
-      NS_LOG_UNCOND(i+1 << " :: packet Osid : "<<temp.GetOsid()<<" Did : "<<temp.GetDid()<<" Start Time: "<<temp.GetStartTime()<<"  Total Time : " <<temp.GetStartTime2());
+    NS_LOG_UNCOND("GateWay : "<<m_gid<<"receive packet : " << m_stats.GetNDelivered());
+    const std::map<uint16_t, LwsnLatencyHistogram> &flows = m_stats.GetFlows();
+    for(std::map<uint16_t, LwsnLatencyHistogram>::const_iterator i = flows.begin(); i != flows.end(); ++i){
+      NS_LOG_UNCOND("Osid : "<<i->first<<" Delivered : "<<i->second.GetCount()
+                    <<"  Mean Time : "<<i->second.GetMean().GetSeconds()
+                    <<"  p50 : "<<i->second.GetQuantile(0.5).GetSeconds()
+                    <<"  p99 : "<<i->second.GetQuantile(0.99).GetSeconds()
+                    <<"  Max Time : "<<i->second.GetMax().GetSeconds());
     }
     NS_LOG_UNCOND("============================");
   }
   else{
     NS_LOG_UNCOND("============================");
-    NS_LOG_UNCOND("Sid : "<<m_sid<<"Send Count : " << m_count/2 << "  RESend Count : "<<m_retrans_count);
+    NS_LOG_UNCOND("Sid : "<<m_sid<<"Send Count : " << m_stats.GetNTx(LwsnHeader::ORIGINAL_TRANSMISSION) + m_stats.GetNTx(LwsnHeader::FORWARDING)
+                  << "  RESend Count : "<<m_stats.GetNRetransmissions());
+    if(m_networkCoding){
+      // each coded frame replaces two forwards and two IACKs
+      NS_LOG_UNCOND("Sid : "<<m_sid<<"Coded : " << m_stats.GetNCoded() << "  Decoded : " << m_stats.GetNDecoded()
+                    << "  Undecodable : " << m_stats.GetNCodingFailures() << "  Coding gain : " << 3*m_stats.GetNCoded());
+    }
+    if(m_aggregation > 1){
+      NS_LOG_UNCOND("Sid : "<<m_sid<<"Aggregates : " << m_stats.GetNTx(LwsnHeader::AGGREGATE) << "  Readings : " << m_stats.GetNAggregated()
+                    << "  Block ACK : " << m_stats.GetNTx(LwsnHeader::BLOCK_ACK));
+    }
+    if(m_implicitAck){
+      NS_LOG_UNCOND("Sid : "<<m_sid<<"IACK saved : " << m_stats.GetNIacksSaved() << "  Implicit ACK : " << m_stats.GetNImplicitAcks()
+                    << "  Collision : " << m_stats.GetNCollisions());
+    }
     NS_LOG_UNCOND("============================");
   }
 }
 
+const LwsnMacStats &
+SimpleNetDevice::GetStats (void) const
+{
+  return m_stats;
+}
+
+void
+SimpleNetDevice::ResetStats (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_stats.Reset ();
+  m_hopStats.Reset ();
+}
+
+void
+SimpleNetDevice::ScheduleStatsSnapshots (Time interval, Time stop)
+{
+  NS_LOG_FUNCTION (this << interval << stop);
+  NS_ASSERT (interval.IsStrictlyPositive ());
+  m_statsInterval = interval;
+  m_statsStop = stop;
+  if (m_channel != 0)
+    {
+      m_channel->SplitSlot (interval);
+    }
+  Simulator::Schedule (interval, &SimpleNetDevice::StatsSnapshot, this);
+}
+
+void
+SimpleNetDevice::StatsSnapshot (void)
+{
+  m_statsSnapshotTrace (m_stats);
+  if (Simulator::Now () + m_statsInterval <= m_statsStop)
+    {
+      if (m_channel != 0)
+        {
+          m_channel->SplitSlot (m_statsInterval);
+        }
+      Simulator::Schedule (m_statsInterval, &SimpleNetDevice::StatsSnapshot, this);
+    }
+}
+
 bool 
 SimpleNetDevice::Send (Ptr<Packet> packet, const Address& dest, uint16_t protocolNumber)
 {
@@ -1479,7 +2771,7 @@ SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address&
   	else{
   		Simulator::ScheduleNow(&SimpleNetDevice::WaitAck,this,p,source,dest,protocolNumber);
   	}*/
-  	NS_LOG_UNCOND("Sid"<<this->GetSid()<<"  SendFrom Function m_queue packet # 1 more");
+  	NS_LOG_LOGIC("Sid"<<this->GetSid()<<"  SendFrom Function m_queue packet # 1 more");
   	
   	return 0;
   }
@@ -1499,7 +2791,8 @@ SimpleNetDevice::SendFrom (Ptr<Packet> p, const Address& source, const Address&
           //TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
           m_txPacket = p -> Copy();
           Simulator::ScheduleNow(&SimpleNetDevice::ChannelSend,this,p,protocolNumber,to,from);
-          Simulator::Schedule(Seconds(1.0),&SimpleNetDevice::WaitAck,this,p,protocolNumber,to,from);
+          m_channel->SplitSlot(GetSlotTiming()->GetSlot());
+          Simulator::Schedule(GetSlotTiming()->GetSlot(),&SimpleNetDevice::WaitAck,this,p,protocolNumber,to,from);
 
         }
       return true;
@@ -1539,6 +2832,7 @@ SimpleNetDevice::TransmitComplete ()
         {
           txTime = m_bps.CalculateBytesTxTime (packet->GetSize ());
         }
+      m_channel->SplitSlot (txTime);
       TransmitCompleteEvent = Simulator::Schedule (txTime, &SimpleNetDevice::TransmitComplete, this);
     }
 
@@ -1581,7 +2875,12 @@ SimpleNetDevice::DoDispose (void)
   m_channel = 0;
   m_node = 0;
   m_receiveErrorModel = 0;
+  m_backoffPolicy = 0;
+  m_radio = 0;
   m_queue->DequeueAll ();
+  m_queueIndex.clear ();
+  m_aggregate.clear ();
+  m_interference.Clear ();
   if (TransmitCompleteEvent.IsRunning ())
     {
       TransmitCompleteEvent.Cancel ();
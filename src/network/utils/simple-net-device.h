@@ -21,7 +21,10 @@
 #define SIMPLE_NET_DEVICE_H
 
 #include <stdint.h>
+#include <istream>
+#include <ostream>
 #include <string>
+#include <vector>
 #include "ns3/traced-callback.h"
 #include "ns3/net-device.h"
 #include "ns3/queue.h"
@@ -30,6 +33,17 @@
 #include "ns3/event-id.h"
 #include "ns3/lwsn-header.h"
 #include "mac48-address.h"
+#include "lwsn-slot-scheduler.h"
+#include "lwsn-mac-stats.h"
+#include "lwsn-interference-tracker.h"
+#include "lwsn-mac-trace.h"
+#include "lwsn-radio-energy.h"
+#include "lwsn-backoff-policy.h"
+#include "lwsn-hop-tag.h"
+#include "lwsn-slot-timing.h"
+#include "lwsn-aggregate.h"
+#include "lwsn-checkpoint.h"
+#include "sgi-hashmap.h"
 
 namespace ns3 {
 
@@ -54,6 +68,14 @@ class ErrorModel;
 class SimpleNetDevice : public NetDevice
 {
 public:
+  /// Where a sensor sends its own readings
+  enum Routing
+  {
+    ROUTING_BOTH,     //!< both ways, to both gateways
+    ROUTING_NEAREST,  //!< toward the gateway fewer hops away
+    ROUTING_BALANCED  //!< toward the gateway with the lowest congestion-weighted distance
+  };
+
   /**
    * \brief Get the type ID.
    * \return the object TypeId
@@ -72,6 +94,21 @@ public:
    * \param from address packet was sent from
    */
   void Receive (Ptr<Packet> packet, uint16_t protocol, Mac48Address to, Mac48Address from);
+
+  /**
+   * Receive a frame whose LwsnHeader has already been decoded.  The
+   * frame may be shared with other receivers of the same transmission,
+   * so it is never modified; it is only copied when it has to be
+   * queued or rewritten.
+   *
+   * \param packet Packet received on the channel
+   * \param receiveheader the LwsnHeader at the start of the packet
+   * \param protocol protocol number
+   * \param to address packet should be sent to
+   * \param from address packet was sent from
+   */
+  void ReceiveFrame (Ptr<const Packet> packet, const LwsnHeader &receiveheader, uint16_t protocol,
+                     Mac48Address to, Mac48Address from);
   
   /**
    * Attach a channel to this net device.  This will be the 
@@ -96,6 +133,16 @@ public:
    */
   Ptr<Queue> GetQueue (void) const;
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.  Return the number of streams (possibly zero) that
+   * have been assigned.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
   /**
    * Attach a receive ErrorModel to the SimpleNetDevice.
    *
@@ -141,10 +188,16 @@ public:
   virtual Mac48Address GetLaddress();
   virtual Mac48Address GetRaddress();
   virtual void AckReceive(bool x, Mac48Address from);
-  virtual void AckSend(Ptr <Packet> p, uint16_t protocol, Mac48Address to);
+  virtual void AckSend(Ptr<const Packet> p, uint16_t protocol, Mac48Address to);
   virtual void WaitSend();
-  virtual void Forwarding(Ptr<Packet> p,uint16_t protocol,Mac48Address to);
-  virtual int RandTime();
+  virtual void Forwarding(Ptr<const Packet> p,uint16_t protocol,Mac48Address to);
+  /**
+   * Draw the backoff after a failed attempt of the frame in flight, or
+   * give the frame up once the Round attempts are used.
+   *
+   * \returns the backoff decided by the BackoffPolicy
+   */
+  virtual LwsnBackoff RandTime();
   virtual void WaitAck(Ptr<Packet> p, uint16_t protocol, Mac48Address to, Mac48Address from);
   virtual void ReSend(Ptr<Packet> p, uint16_t protocol, Mac48Address to,Mac48Address from);
   virtual void SetSleep();
@@ -154,20 +207,265 @@ public:
   virtual bool OriginalTransmission(Ptr<Packet> p, uint16_t protocolNumber,bool header);
   virtual void OriginalAckCheck(Ptr<Packet> p, uint16_t protocol);
   virtual void ReOriginalSend(Ptr<Packet> p, uint16_t protocol);  
+
+  /**
+   * Send a NETWORK_CODING frame to both neighbours and wait for the
+   * IACKs of the two packets it carries.
+   *
+   * \param coded the coded frame
+   * \param protocol protocol number
+   */
+  void CodedSend(Ptr<Packet> coded, uint16_t protocol);
+  /**
+   * Check the IACKs of a coded frame; retransmit it, or the half that
+   * was not acknowledged, after a backoff.
+   *
+   * \param p the coded frame
+   * \param protocol protocol number
+   */
+  void CodedAckCheck(Ptr<Packet> p, uint16_t protocol);
+  /**
+   * Retransmit a coded frame unless an IACK arrived during the backoff.
+   *
+   * \param p the coded frame
+   * \param protocol protocol number
+   */
+  void ReCodedSend(Ptr<Packet> p, uint16_t protocol);
+  /**
+   * Send an AGGREGATE frame built from m_aggregate to a neighbour and
+   * wait for its BLOCK_ACK, unless the neighbour is a gateway.
+   *
+   * \param aggregate the AGGREGATE frame
+   * \param protocol protocol number
+   * \param to the neighbour
+   */
+  void AggregateSend(Ptr<Packet> aggregate, uint16_t protocol, Mac48Address to);
+  /**
+   * Check the BLOCK_ACK of an AGGREGATE frame; resend the readings it
+   * left out after a backoff.
+   *
+   * \param p the AGGREGATE frame
+   * \param protocol protocol number
+   * \param to the neighbour it was sent to
+   */
+  void AggregateAckCheck(Ptr<Packet> p, uint16_t protocol, Mac48Address to);
+  /**
+   * Resend, in a new AGGREGATE frame, the readings of m_aggregate that
+   * are still not acknowledged; a single one is resent as a plain
+   * forward.
+   *
+   * \param p the last AGGREGATE frame
+   * \param protocol protocol number
+   * \param to the neighbour it was sent to
+   */
+  void ReAggregateSend(Ptr<Packet> p, uint16_t protocol, Mac48Address to);
+  /**
+   * \param blockack the BLOCK_ACK frame
+   * \param protocol protocol number
+   * \param to the sender of the AGGREGATE frame acknowledged
+   */
+  void BlockAckSend(Ptr<const Packet> blockack, uint16_t protocol, Mac48Address to);
+  /**
+   * Send on the readings of an AGGREGATE frame just received, and
+   * whatever is queued with them, unless a frame of this device is
+   * waiting for its ACK.
+   */
+  void ForwardQueued();
   Ptr<Packet> GetTxPacket(void) const;
   void SetTxPacket(Ptr<Packet> p);
-  void ReceiveStart(Ptr<Packet> packet, uint16_t protocol,Mac48Address to, Mac48Address from);
-  void ReceiveCheck(Ptr<Packet> packet, uint16_t protocol,Mac48Address to, Mac48Address from);
+  void ReceiveStart(Ptr<const Packet> packet, const LwsnHeader &header, uint16_t protocol,Mac48Address to, Mac48Address from);
+  /**
+   * End a reception started by ReceiveStart: hand the frame to
+   * ReceiveFrame if it survived the receptions it overlapped, count a
+   * collision otherwise.
+   *
+   * \param packet the frame
+   * \param header its decoded header
+   * \param protocol protocol number
+   * \param to destination address
+   * \param from source address
+   * \param reception the interference tracker id of the reception
+   */
+  void ReceiveEnd(Ptr<const Packet> packet, const LwsnHeader &header, uint16_t protocol,Mac48Address to, Mac48Address from,
+                  uint32_t reception);
+  /**
+   * \param model how overlapping receptions are resolved
+   */
+  void SetCaptureModel (LwsnInterferenceTracker::CaptureModel model);
+  /**
+   * \returns how overlapping receptions are resolved
+   */
+  LwsnInterferenceTracker::CaptureModel GetCaptureModel (void) const;
+  /**
+   * \param threshold power margin, in dB, a frame needs over every
+   * overlapping one to be captured
+   */
+  void SetCaptureThreshold (double threshold);
+  /**
+   * \returns the capture threshold, in dB
+   */
+  double GetCaptureThreshold (void) const;
+  /**
+   * \returns the transmit power, in dBm
+   */
+  double GetTxPower (void) const;
+  /**
+   * \returns the radio state machine and battery of this device
+   */
+  Ptr<LwsnRadioEnergy> GetRadio (void) const;
+  /**
+   * \returns true if the radio can hear a frame sent now; the channel
+   * does not deliver frames to devices whose radio is asleep or dead
+   */
+  bool IsRadioAwake (void) const;
+  /**
+   * \param size number of MAC events kept by the trace, 0 for none
+   */
+  void SetMacTraceSize (uint32_t size);
+  /**
+   * \returns the number of MAC events kept by the trace
+   */
+  uint32_t GetMacTraceSize (void) const;
   void SetRound(int x);
   void SetLastNode(bool x);
+  /**
+   * \returns true if a gateway is one of the neighbours of this sensor
+   */
+  bool IsLastNode (void) const;
   void SetGid(int x);
   int GetGid();
+  /**
+   * \param hops distance of this sensor to the nearest gateway, 0 if
+   * unknown; set by LwsnTopologyHelper
+   */
+  void SetGatewayHops (uint16_t hops);
+  /**
+   * \returns the distance of this sensor to the nearest gateway
+   */
+  uint16_t GetGatewayHops (void) const;
+  /**
+   * \param left hops to the gateway on the left, 0 if unknown
+   * \param right hops to the gateway on the right, 0 if unknown
+   */
+  void SetGatewayDistances (uint16_t left, uint16_t right);
+  /**
+   * \returns the hops to the gateway on the left, 0 if unknown
+   */
+  uint16_t GetLeftGatewayHops (void) const;
+  /**
+   * \returns the hops to the gateway on the right, 0 if unknown
+   */
+  uint16_t GetRightGatewayHops (void) const;
+  /**
+   * Broadcast a G_ANC frame from this gateway.  The sensors learn
+   * their distance to it from the frame and pass it on along the line,
+   * so that the Routing attribute can work without LwsnTopologyHelper.
+   * Announcements from both gateways should not be sent in the same
+   * slot.
+   */
+  void AnnounceGateway (void);
+  /**
+   * \param policy the retransmission backoff of this device
+   */
+  void SetBackoffPolicy (Ptr<LwsnBackoffPolicy> policy);
+  /**
+   * \returns the retransmission backoff of this device
+   */
+  Ptr<LwsnBackoffPolicy> GetBackoffPolicy (void) const;
   void Print();
-  void QueueCheck(Ptr<Packet> p); 
-  int m_count;
-  int m_retrans_count;
-  int m_collision;
-  int g_receive;
+  /**
+   * Queue a received reading unless it is already waiting.  A gateway
+   * counts it as delivered.
+   *
+   * \param p the reading, starting with its LwsnHeader
+   * \returns true if the reading is now in m_queue
+   */
+  bool QueueCheck(Ptr<Packet> p); 
+  /**
+   * \param osid the originating sensor id
+   * \param did the data id
+   * \returns true if a packet with this (Osid, Did) is waiting in m_queue
+   */
+  bool IsQueued (uint16_t osid, uint16_t did) const;
+
+  /**
+   * Run a MAC action deferred by ScheduleMac.  Called by the
+   * LwsnSlotScheduler of the channel, or by the simulator event
+   * scheduled in its place.
+   *
+   * \param action the action to run
+   */
+  void RunMacAction (const LwsnMacAction &action);
+
+  /**
+   * Write the MAC state of the device as LwsnCheckpoint fields: the
+   * flags and counters of the frames in flight, the queue, the
+   * receptions in progress, the statistics, the radio and the position
+   * of the backoff stream.  The queue is read in place, so its counters
+   * and traces are untouched; TxQueue must be a DropTailQueue or a
+   * LwsnPriorityQueue.  The MAC trace and the hop statistics are left
+   * out.  Its pending MAC actions are saved with the LwsnSlotScheduler
+   * of the channel, see LwsnTopologyHelper::Save.
+   *
+   * Aborts if a MAC action of the device is a simulator event, which
+   * cannot be saved: this is every action without the SlotScheduling
+   * channel attribute, and with it an action off the slot grid of the
+   * LwsnSlotScheduler.
+   *
+   * \param os output stream
+   * \param packets packet table of the checkpoint
+   */
+  void Save (std::ostream &os, LwsnPacketTable &packets);
+  /**
+   * Replace the MAC state of the device with one written by Save.
+   *
+   * \param is input stream
+   * \param packets packet table of the checkpoint
+   * \returns false if it does not hold a device written by Save
+   */
+  bool Restore (std::istream &is, LwsnPacketTable &packets);
+
+  /**
+   * \returns the slot timing of the channel the device is attached to
+   */
+  Ptr<LwsnSlotTiming> GetSlotTiming (void) const;
+
+  /**
+   * \returns the MAC statistics of this device
+   */
+  const LwsnMacStats &GetStats (void) const;
+
+  /**
+   * Clear the MAC statistics of this device.
+   */
+  void ResetStats (void);
+
+  /**
+   * \returns the per-hop delays and retries of the readings delivered
+   * to this gateway; it stays empty unless RecordHops is set
+   */
+  const LwsnHopStats &GetHopStats (void) const;
+
+  /**
+   * \returns the MAC event trace of this device; it stays empty unless
+   * the build defines NS3_LWSN_MAC_TRACE and MacTraceSize is not zero
+   */
+  const LwsnMacTrace &GetMacTrace (void) const;
+
+  /**
+   * Fire the StatsSnapshot trace source every interval, up to stop.
+   *
+   * \param interval time between two snapshots
+   * \param stop time after which no snapshot is taken
+   */
+  void ScheduleStatsSnapshots (Time interval, Time stop);
+
+  /**
+   * TracedCallback signature for the MAC statistics snapshots.
+   *
+   * \param [in] stats the statistics block of the device
+   */
+  typedef void (* StatsSnapshotCallback)(const LwsnMacStats &stats);
 protected:
   virtual void DoDispose (void);
 private:
@@ -190,12 +488,254 @@ private:
    */
   TracedCallback<Ptr<const Packet> > m_phyRxDropTrace;
 
+  LwsnMacStats m_stats; //!< MAC statistics
+  LwsnMacTrace m_macTrace; //!< MAC event records
+  LwsnHopStats m_hopStats; //!< per-hop delays of the readings delivered here
+  bool m_recordHops; //!< tag the frames sent with LwsnHopTag records
+  Ptr<LwsnRadioEnergy> m_radio; //!< radio state and battery
+  Time m_statsInterval; //!< time between two StatsSnapshot traces
+  Time m_statsStop;     //!< no StatsSnapshot trace after this time
+  TracedCallback<const LwsnMacStats &> m_statsSnapshotTrace; //!< StatsSnapshot trace source
+
+  /**
+   * Fire the StatsSnapshot trace source and schedule the next one.
+   */
+  void StatsSnapshot (void);
+
   /**
    * The TransmitComplete method is used internally to finish the process
    * of sending a packet out on the channel.
    */
   void TransmitComplete (void);
 
+  /**
+   * Enqueue a packet on m_queue and record its (Osid, Did) in the
+   * duplicate index.
+   *
+   * \param p the packet, which must start with an LwsnHeader
+   * \returns true if the queue accepted the packet
+   */
+  bool EnqueuePacket (Ptr<Packet> p);
+
+  /**
+   * Dequeue the head of m_queue and drop its (Osid, Did) from the
+   * duplicate index.
+   *
+   * \returns the dequeued packet, or 0 if the queue is empty
+   */
+  Ptr<Packet> DequeuePacket (void);
+
+  /**
+   * Dequeue the packet (Osid, Did) once it is known to have moved on.
+   * A FIFO queue is only checked at its head; a LwsnPriorityQueue is
+   * searched through its index.
+   *
+   * \param osid Osid of the packet
+   * \param did Did of the packet
+   * \returns true if the packet was waiting and is gone
+   */
+  bool DequeueMatching (uint16_t osid, uint16_t did);
+
+  /**
+   * \param osid the originating sensor id
+   * \param did the data id
+   * \returns the key used by the duplicate index
+   */
+  static uint32_t GetQueueKey (uint16_t osid, uint16_t did);
+
+  /**
+   * \param header the decoded header of a received frame
+   * \param to the destination of the frame
+   * \param from the sender of the frame
+   * \returns true if the frame is a coded broadcast from a neighbour
+   */
+  bool IsCodedForMe (const LwsnHeader &header, Mac48Address to, Mac48Address from) const;
+
+  /**
+   * \param to a neighbour of this device
+   * \returns true if it is a gateway, which never acknowledges; without
+   * gateway distances, the gateway of a last node is taken to be on the
+   * left of sensor 1 and on the right of any other
+   */
+  bool IsGatewayNeighbour (Mac48Address to) const;
+
+  /**
+   * \param header the decoded header of a received frame
+   * \param to the destination of the frame
+   * \param from the sender of the frame
+   * \returns true if, in implicit-ACK mode, the frame is a neighbour
+   * forwarding a packet away from this device
+   */
+  bool IsOverheardForward (const LwsnHeader &header, Mac48Address to, Mac48Address from) const;
+  /**
+   * Take an overheard forward as the IACK of the same packet.
+   *
+   * \param header the header of the forward
+   * \param from the neighbour that forwarded it
+   */
+  void OverhearForward (const LwsnHeader &header, Mac48Address from);
+  /**
+   * In implicit-ACK mode the forward of a packet acknowledges it, so an
+   * IACK is only sent for a copy of the packet forwarded last: the
+   * previous hop then missed the forward.
+   *
+   * \param header the header of the packet received or about to be forwarded
+   * \returns true if an IACK must be sent
+   */
+  bool NeedsExplicitAck (const LwsnHeader &header);
+
+  /// Side an original is sent to
+  enum RouteSide
+  {
+    ROUTE_BOTH,
+    ROUTE_LEFT,
+    ROUTE_RIGHT
+  };
+  /**
+   * \param header the header of an original about to be sent
+   * \returns the side to send it to, as chosen by the Routing attribute
+   */
+  RouteSide ChooseRoute (const LwsnHeader &header) const;
+  /**
+   * Once the retries of an original sent one way are used up, send it
+   * the other way, at most once per original.
+   *
+   * \param p the original
+   * \param protocol protocol number
+   * \param failedRight true if the right side did not acknowledge it
+   * \returns true if the original is now sent the other way
+   */
+  bool Failover (Ptr<Packet> p, uint16_t protocol, bool failedRight);
+  /**
+   * \param right the side the frame was sent to
+   * \param acked true if it was acknowledged in time
+   */
+  void NoteAckOutcome (bool right, bool acked);
+  /**
+   * \param header the decoded header of a received frame
+   * \param to the destination of the frame
+   * \param from the sender of the frame
+   * \returns true if the frame is a G_ANC broadcast from a neighbour
+   */
+  bool IsAnnouncementForMe (const LwsnHeader &header, Mac48Address to, Mac48Address from) const;
+  /**
+   * Learn the distance to a gateway from a G_ANC frame and pass the
+   * frame on if it improves it.
+   *
+   * \param packet the G_ANC frame
+   * \param header its header: Osid is the Gid, Did the hops travelled
+   * \param from the neighbour that sent it
+   */
+  void LearnGateway (Ptr<const Packet> packet, const LwsnHeader &header, Mac48Address from);
+  /**
+   * Broadcast a G_ANC frame to the neighbours.
+   *
+   * \param p the G_ANC frame, its header already rewritten
+   */
+  void SendAnnouncement (Ptr<const Packet> p);
+
+  /**
+   * If the packet after the one being forwarded travels the other way,
+   * XOR both into one NETWORK_CODING frame and send it.
+   *
+   * \param packet the forwarded packet, with its new header
+   * \param sendheader the header of packet
+   * \returns true if a coded frame was sent
+   */
+  bool TryCoding (Ptr<Packet> packet, const LwsnHeader &sendheader);
+
+  /**
+   * Recover the packet a coded frame carries for this device, using
+   * the copy of the other packet held in m_txPacket.
+   *
+   * \param packet the coded frame
+   * \param header the header of the coded frame
+   * \param from the relay that sent it
+   * \param decodedheader set to the header of the recovered packet
+   * \returns the recovered packet, or 0 if m_txPacket does not match
+   */
+  Ptr<Packet> DecodeCodedFrame (Ptr<const Packet> packet, const LwsnHeader &header, Mac48Address from,
+                                LwsnHeader &decodedheader);
+
+  /**
+   * \param a a packet starting with an LwsnHeader
+   * \param b a packet starting with an LwsnHeader, same size as a
+   * \returns a packet holding the XOR of both payloads
+   */
+  static Ptr<Packet> XorPayload (Ptr<const Packet> a, Ptr<const Packet> b);
+
+  /**
+   * Bundle the forwarded packet with the packets queued behind it that
+   * go the same way, up to Aggregation of them and to the MTU, and send
+   * them in one AGGREGATE frame.
+   *
+   * \param packet the forwarded packet, with its new header
+   * \param sendheader the header of packet
+   * \returns true if an AGGREGATE frame was sent
+   */
+  bool TryAggregation (Ptr<Packet> packet, const LwsnHeader &sendheader);
+  /**
+   * Queue the readings of an AGGREGATE frame received from a neighbour
+   * and, if no frame of this device waits for its ACK, send them on in
+   * the next slot and acknowledge them with a BLOCK_ACK AckOffset later.
+   *
+   * \param packet the AGGREGATE frame
+   * \param protocol protocol number
+   * \param from the neighbour that sent it
+   * \param reply delay to the next slot
+   */
+  void ReceiveAggregate (Ptr<const Packet> packet, uint16_t protocol, Mac48Address from, Time reply);
+  /**
+   * \param header the decoded header of a received frame
+   * \param to the destination of the frame
+   * \param from the sender of the frame
+   * \returns true if the frame is a neighbour sending an AGGREGATE frame
+   * away from this device
+   */
+  bool IsOverheardAggregate (const LwsnHeader &header, Mac48Address to, Mac48Address from) const;
+  /**
+   * Take the readings of an overheard AGGREGATE frame as overheard
+   * forwards: no IACK is sent for a bundled reading, so this is how the
+   * previous hop of a reading queued unacknowledged learns it moved on.
+   *
+   * \param packet the AGGREGATE frame
+   * \param from the neighbour that sent it
+   */
+  void OverhearAggregate (Ptr<const Packet> packet, Mac48Address from);
+  /**
+   * Mark the reading (Osid, Did) of the AGGREGATE frame in flight as
+   * acknowledged.
+   *
+   * \param header a header naming the reading
+   * \returns true if the reading is in the frame
+   */
+  bool AckAggregated (const LwsnHeader &header);
+
+  /**
+   * Defer a MAC action.  If the channel runs a slot scheduler the
+   * action is handed to it, otherwise a simulator event is scheduled
+   * to run it.
+   *
+   * \param delay delay from now
+   * \param type the method to run
+   * \param p the packet argument
+   * \param protocol the protocol argument
+   * \param to the destination argument
+   * \param from the source argument
+   * \param header the decoded header (RECEIVE_END only)
+   * \param reception the interference tracker id (RECEIVE_END only)
+   */
+  void ScheduleMac (Time delay, LwsnMacAction::Type type, Ptr<const Packet> p = 0, uint16_t protocol = 0,
+                    Mac48Address to = Mac48Address (), Mac48Address from = Mac48Address (),
+                    const LwsnHeader &header = LwsnHeader (), uint32_t reception = 0);
+  /**
+   * Run a MAC action ScheduleMac left to the simulator.
+   *
+   * \param action the action to run
+   */
+  void RunDeferredAction (const LwsnMacAction &action);
+  uint32_t m_nDeferred; //!< actions left to the simulator and not run yet
+
   bool m_linkUp; //!< Flag indicating whether or not the link is up
 
   /**
@@ -222,16 +762,34 @@ private:
   uint16_t k;
   Ptr<Packet> m_txPacket;
   int txarray[2];
-  Ptr<Queue> temp_queue;
+  /**
+   * Number of packets in m_queue for each (Osid, Did) key, so that
+   * QueueCheck does not have to walk the queue.
+   */
+  sgi::hash_map<uint32_t, uint32_t> m_queueIndex;
   bool wait_ack;
-  bool receive_flag;
-  bool receive_flag_1;
+  LwsnInterferenceTracker m_interference; //!< receptions in progress
+  double m_txPower; //!< transmit power, dBm
   bool last_node;
   int m_gid;
   int ndid;
   bool temp_flag;
-  double minTime;
-  double maxTime;
+  bool m_networkCoding; //!< XOR opposite-direction forwards into one frame
+  bool m_implicitAck; //!< overheard forwards replace the IACK frames
+  Routing m_routing; //!< where own readings are sent
+  double m_congestionWeight; //!< weight of the ACK loss rate in ROUTING_BALANCED
+  uint16_t m_leftHops;  //!< hops to the gateway on the left, 0 if unknown
+  uint16_t m_rightHops; //!< hops to the gateway on the right, 0 if unknown
+  double m_ackLoss[2];  //!< average ACK loss to the left [0] and right [1]
+  RouteSide m_txRoute;  //!< side the original in flight was sent to
+  bool m_failedOver;    //!< the original in flight already changed sides
+  Ptr<Packet> m_codedLeft;  //!< left-bound half of the pending coded frame
+  Ptr<Packet> m_codedRight; //!< right-bound half of the pending coded frame
+  uint16_t m_aggregation; //!< most readings in one AGGREGATE frame, 1 for none
+  std::vector<Ptr<Packet> > m_aggregate; //!< readings of the AGGREGATE frame in flight
+  uint16_t m_aggregateAcked; //!< readings of m_aggregate acknowledged, bit i for the i-th
+  Ptr<LwsnBackoffPolicy> m_backoffPolicy; //!< retransmission backoff
+  uint16_t m_gatewayHops; //!< distance to the nearest gateway
 };
 
 } // namespace ns3